@@ -35,7 +35,7 @@ std::string GetFilesDir(struct android_app* app) {
 namespace Mai {
   namespace {
 	/**
-	* ̓̓Cxg܂B
+	* 次の入力イベントを処理します。
 	*/
 	int32_t InputHandler(struct android_app* app, AInputEvent* event) {
 	  AndroidWindow* window = reinterpret_cast<AndroidWindow*>(app->userData);
@@ -43,7 +43,7 @@ namespace Mai {
 	}
 
 	/**
-	* ̃C R}h܂B
+	* 次のメイン コマンドを処理します。
 	*/
 	void CommandHandler(struct android_app* app, int32_t cmd) {
 	  AndroidWindow* window = reinterpret_cast<AndroidWindow*>(app->userData);
@@ -211,7 +211,7 @@ namespace Mai {
 		break;
 	  };
 
-	  // I邩ǂmF܂B
+	  // 終了するかどうか確認します。
 	  if (app->destroyRequested != 0) {
 		Event event;
 		event.Type = Event::EVENT_CLOSED;
@@ -249,7 +249,7 @@ namespace Mai {
 
 	ANativeActivity_setWindowFlags(app->activity, AWINDOW_FLAG_FULLSCREEN | AWINDOW_FLAG_KEEP_SCREEN_ON, 0);
 
-	// ZT[̊Ď̏
+	// センサーの監視の準備
 	static const int sensorTypeList[] = {
 	  ASENSOR_TYPE_ACCELEROMETER,
 	  ASENSOR_TYPE_MAGNETIC_FIELD,
@@ -409,10 +409,10 @@ namespace Mai {
 	} else if (sensor[SensorType_Magnet]) {
 	  fusedOrientation = accMagOrientation;
 	} else {
-	  /* 003SH̓dlKɐݒ.
-	  accel: foCXupxNg.
-	  foCX x=(E+), y=(オ+), z=O㎲(O+).
-	  ̉]ołȂ.
+	  /* 003SHの動作仕様から適当に設定.
+	  accel: デバイスのupベクトル.
+	  デバイス垂直時 x=水平軸(右が+), y=垂直軸(上が+), z=前後軸(前が+).
+	  垂直軸周りの回転を検出できない.
 	  */
 	  fusedOrientation.x = 0.0f;
 	  fusedOrientation.y = -accel.y * 0.1f * boost::math::constants::pi<float>() * 0.5f;
@@ -428,11 +428,11 @@ namespace Mai {
   void AndroidWindow::CommandHandler(int32_t cmd) {
 	switch (cmd) {
 	case APP_CMD_SAVE_STATE:
-	  // ݂̏Ԃۑ悤VXeɂėv܂BۑĂB
+	  // 現在の状態を保存するようシステムによって要求されました。保存してください。
 	  SaveState();
 	  break;
 	case APP_CMD_INIT_WINDOW:
-	  // EBhE\Ă܂BĂB
+	  // ウィンドウが表示されています。準備してください。
 	  if (app->window != NULL) {
 		Event event;
 		event.Type = Event::EVENT_INIT_WINDOW;
@@ -441,7 +441,7 @@ namespace Mai {
 	  }
 	  break;
 	case APP_CMD_TERM_WINDOW: {
-	  // EBhE\܂͕Ă܂BN[ AbvĂB
+	  // ウィンドウが非表示または閉じています。クリーン アップしてください。
 	  Event event;
 	  event.Type = Event::EVENT_TERM_WINDOW;
 	  event.Time = uptimeMillis();
@@ -449,18 +449,18 @@ namespace Mai {
 	  break;
 	}
 	case APP_CMD_GAINED_FOCUS:
-	  // AvtH[JX擾ƁAxv̊ĎJn܂B
+	  // アプリがフォーカスを取得すると、加速度計の監視を開始します。
 	  for (int i = 0; i < SensorType_MAX; ++i) {
 		if (sensor[i]) {
 		  ASensorEventQueue_enableSensor(sensorEventQueue[i], sensor[i]);
-		  // ڕW 1 bƂ 60 ̃Cxg擾邱Ƃł (č)B
+		  // 目標は 1 秒ごとに 60 のイベントを取得することです (米国)。
 		  ASensorEventQueue_setEventRate(sensorEventQueue[i], sensor[i], (1000L / 60) * 1000);
 		}
 	  }
 	  break;
 	case APP_CMD_LOST_FOCUS:
-	  // AvtH[JXƁAxv̊Ď~܂B
-	  // ɂAgpĂȂƂ̃obe[ߖł܂B
+	  // アプリがフォーカスを失うと、加速度計の監視を停止します。
+	  // これにより、使用していないときのバッテリーを節約できます。
 	  for (int i = 0; i < SensorType_MAX; ++i) {
 		if (sensor[i]) {
 		  ASensorEventQueue_disableSensor(sensorEventQueue[i], sensor[i]);
@@ -599,7 +599,7 @@ namespace Mai {
   }
 
   void AndroidWindow::LoadState() {
-	// ȑO̕ۑԂŊJn܂BĂB
+	// 以前の保存状態で開始します。復元してください。
 	if (app->savedState != NULL) {
 	  savedState = *static_cast<const SavedState*>(app->savedState);
 	}
@@ -0,0 +1,242 @@
+#include "AnimationClip.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Mai {
+
+  namespace {
+
+	/** Get the angle between two rotations.
+	*/
+	float GetRotationError(const Quaternion& a, const Quaternion& b)
+	{
+	  return 2.0f * std::acos(std::min(1.0f, std::abs(a.Dot(b))));
+	}
+
+	/** Get the distance between two translations.
+	*/
+	float GetTranslationError(const Vector3F& a, const Vector3F& b)
+	{
+	  return (a - b).Length();
+	}
+
+	/** Select the keys that reproduce all keys within the tolerance.
+
+	  The first and the last keys are always kept. If all keys are same as the first key,
+	  only the first key is kept.
+
+	  @param keys       The keys of the channel.
+	  @param get        The function to get the value of the key.
+	  @param lerp       The function to interpolate two values.
+	  @param error      The function to get the error between two values.
+	  @param tolerance  The maximum error.
+
+	  @return The indices of the kept keys.
+	*/
+	template<typename T, typename Get, typename Lerp, typename Error>
+	std::vector<uint32_t> ReduceKeys(const std::vector<Animation::Element>& keys, Get get, Lerp lerp, Error error, float tolerance)
+	{
+	  const uint32_t count = static_cast<uint32_t>(keys.size());
+	  std::vector<uint32_t> result;
+	  result.push_back(0);
+	  if (count < 2) {
+		return result;
+	  }
+	  const T first = get(keys[0]);
+	  bool isConstant = true;
+	  for (uint32_t i = 1; i < count; ++i) {
+		if (error(first, get(keys[i])) > tolerance) {
+		  isConstant = false;
+		  break;
+		}
+	  }
+	  if (isConstant) {
+		return result;
+	  }
+
+	  // Extend the segment from the anchor while the skipped keys are reproduced.
+	  uint32_t anchor = 0;
+	  for (uint32_t end = 2; end < count; ++end) {
+		const T a = get(keys[anchor]);
+		const T b = get(keys[end]);
+		const float timeRange = keys[end].time - keys[anchor].time;
+		for (uint32_t i = anchor + 1; i < end; ++i) {
+		  const float ratio = timeRange > 0.0f ? (keys[i].time - keys[anchor].time) / timeRange : 0.0f;
+		  if (error(lerp(a, b, ratio), get(keys[i])) > tolerance) {
+			anchor = end - 1;
+			result.push_back(anchor);
+			break;
+		  }
+		}
+	  }
+	  result.push_back(count - 1);
+	  return result;
+	}
+
+	/** Quantize the time of the key.
+	*/
+	uint16_t QuantizeTime(float time, float timeScale)
+	{
+	  return static_cast<uint16_t>(std::min(65535.0f, std::max(0.0f, std::floor(time / timeScale + 0.5f))));
+	}
+
+	/** Quantize the component of the quaternion to 15bit.
+	*/
+	uint64_t QuantizeRotationComponent(float v)
+	{
+	  return static_cast<uint64_t>(std::min(32767.0f, std::max(0.0f, std::floor(v * (32767.0f / 1.41421356f) + 0.5f) + 16383.0f)));
+	}
+
+	/** Encode the quaternion by the smallest three method.
+
+	  @param q    The normalized quaternion.
+	  @param out  The three values are stored.
+	*/
+	void EncodeRotation(const Quaternion& q, uint16_t* out)
+	{
+	  float v[4] = { q.x, q.y, q.z, q.w };
+	  int largest = 0;
+	  for (int i = 1; i < 4; ++i) {
+		if (std::abs(v[i]) > std::abs(v[largest])) {
+		  largest = i;
+		}
+	  }
+	  // q and -q are the same rotation, so the dropped component is always positive.
+	  if (v[largest] < 0.0f) {
+		for (auto& e : v) {
+		  e = -e;
+		}
+	  }
+	  uint64_t bits = static_cast<uint64_t>(largest) << 45;
+	  int shift = 30;
+	  for (int i = 0; i < 4; ++i) {
+		if (i != largest) {
+		  bits |= QuantizeRotationComponent(v[i]) << shift;
+		  shift -= 15;
+		}
+	  }
+	  out[0] = static_cast<uint16_t>(bits);
+	  out[1] = static_cast<uint16_t>(bits >> 16);
+	  out[2] = static_cast<uint16_t>(bits >> 32);
+	}
+
+  } // unnamed namespace
+
+  /** The spherical linear interpolation of the quaternions.
+
+    @ref http://www.willperone.net/Code/quaternion.php
+  */
+  Quaternion Sleap(const Quaternion& qa, const Quaternion& qb, float t)
+  {
+	Quaternion tmp;
+	float cosHalfTheta = qa.Dot(qb);
+	if (cosHalfTheta < 0.0f) {
+	  cosHalfTheta = -cosHalfTheta;
+	  tmp = -qb;
+	} else {
+	  tmp = qb;
+	}
+	if (cosHalfTheta < 0.95f) {
+	  const float halfTheta = std::acos(cosHalfTheta);
+	  const float sinHalfTheta = std::sin(halfTheta);
+	  const float ratioA = std::sin((1.0f - t) * halfTheta) / sinHalfTheta;
+	  const float ratioB = std::sin(t * halfTheta) / sinHalfTheta;
+	  return (qa * ratioA + tmp * ratioB).Normalize();
+	} else {
+	  return (qa * (1.0f - t) + tmp * t).Normalize();
+	}
+  }
+
+  /** Get the memory size of the clip.
+
+    @return The byte size of the clip, including the arrays.
+  */
+  size_t AnimationClip::GetByteSize() const
+  {
+	return sizeof(AnimationClip) +
+	  trackList.size() * sizeof(Track) +
+	  timeList.size() * sizeof(uint16_t) +
+	  valueList.size() * sizeof(uint16_t);
+  }
+
+  /** Build the compressed clip from the raw key data.
+
+    The raw key data is released after the compression.
+
+	@param rotTolerance    The maximum angle error of the removed rotation keys in radians.
+	@param transTolerance  The maximum distance error of the removed translation keys.
+  */
+  void Animation::Compress(float rotTolerance, float transTolerance)
+  {
+	clip = AnimationClip();
+	int trackCount = 0;
+	float maxTime = 0.0f;
+	for (const auto& e : data) {
+	  if (e.first >= 0 && !e.second.empty()) {
+		trackCount = std::max(trackCount, e.first + 1);
+		maxTime = std::max(maxTime, e.second.back().time);
+	  }
+	}
+	clip.timeScale = maxTime > 0.0f ? maxTime / 65535.0f : 1.0f;
+	clip.trackList.resize(trackCount, AnimationClip::Track{ { 0, 0 }, { 0, 0 }, Vector3F(0, 0, 0), Vector3F(0, 0, 0) });
+
+	for (const auto& e : data) {
+	  if (e.first < 0 || e.second.empty()) {
+		continue;
+	  }
+	  AnimationClip::Track& track = clip.trackList[e.first];
+	  if (track.rot.count) {
+		continue; // the first track of the joint is used.
+	  }
+	  const std::vector<Element>& keys = e.second;
+
+	  const std::vector<uint32_t> rotKeys = ReduceKeys<Quaternion>(
+		keys,
+		[](const Element& k) { return k.pose.rot; },
+		[](const Quaternion& a, const Quaternion& b, float t) { return Sleap(a, b, t); },
+		GetRotationError,
+		rotTolerance
+	  );
+	  track.rot.offset = static_cast<uint32_t>(clip.timeList.size());
+	  track.rot.count = static_cast<uint32_t>(rotKeys.size());
+	  for (auto i : rotKeys) {
+		clip.timeList.push_back(QuantizeTime(keys[i].time, clip.timeScale));
+		clip.valueList.resize(clip.valueList.size() + 3);
+		EncodeRotation(keys[i].pose.rot, &clip.valueList[clip.valueList.size() - 3]);
+	  }
+
+	  const std::vector<uint32_t> transKeys = ReduceKeys<Vector3F>(
+		keys,
+		[](const Element& k) { return k.pose.trans; },
+		[](const Vector3F& a, const Vector3F& b, float t) { return a * (1.0f - t) + b * t; },
+		GetTranslationError,
+		transTolerance
+	  );
+	  Vector3F transMin = keys[transKeys[0]].pose.trans;
+	  Vector3F transMax = transMin;
+	  for (auto i : transKeys) {
+		const Vector3F& v = keys[i].pose.trans;
+		transMin = Vector3F(std::min(transMin.x, v.x), std::min(transMin.y, v.y), std::min(transMin.z, v.z));
+		transMax = Vector3F(std::max(transMax.x, v.x), std::max(transMax.y, v.y), std::max(transMax.z, v.z));
+	  }
+	  track.transMin = transMin;
+	  track.transScale = (transMax - transMin) * (1.0f / 65535.0f);
+	  track.trans.offset = static_cast<uint32_t>(clip.timeList.size());
+	  track.trans.count = static_cast<uint32_t>(transKeys.size());
+	  const float* pMin = &transMin.x;
+	  const float* pScale = &track.transScale.x;
+	  for (auto i : transKeys) {
+		clip.timeList.push_back(QuantizeTime(keys[i].time, clip.timeScale));
+		const float* pValue = &keys[i].pose.trans.x;
+		for (int axis = 0; axis < 3; ++axis) {
+		  const float q = pScale[axis] > 0.0f ? std::floor((pValue[axis] - pMin[axis]) / pScale[axis] + 0.5f) : 0.0f;
+		  clip.valueList.push_back(static_cast<uint16_t>(std::min(65535.0f, std::max(0.0f, q))));
+		}
+	  }
+	}
+
+	std::vector<ElementList>().swap(data);
+  }
+
+} // namespace Mai
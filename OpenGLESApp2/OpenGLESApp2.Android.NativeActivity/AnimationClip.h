@@ -0,0 +1,101 @@
+#ifndef ANIMATIONCLIP_H_INCLUDED
+#define ANIMATIONCLIP_H_INCLUDED
+#include "../../Shared/Vector.h"
+#include "../../Shared/Quaternion.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
+namespace Mai {
+
+  /** The compressed animation data.
+
+    Each joint has the rotation channel and the translation channel, and each channel
+	has its own keys. A key is composed of 16bit time and three 16bit values.
+
+	- The time is quantized against the maximum key time of the clip.
+	- The rotation is encoded by the smallest three method. The largest component is dropped,
+	  and the other three components are quantized to 15bit in [-1/sqrt(2), 1/sqrt(2)].
+	- The translation is quantized to 16bit against the range of each track.
+
+	The constant channel has only one key, and the keys that can be reproduced by
+	the interpolation of its neighbours are removed.
+
+	@sa Animation::Compress(), AnimationSampler.
+  */
+  struct AnimationClip {
+	/** The range of the keys in timeList and valueList.
+	*/
+	struct Channel {
+	  uint32_t offset; ///< The index of the first key.
+	  uint32_t count; ///< The number of the keys. 0 means that the joint has no channel.
+	};
+
+	/** The channels of a joint.
+	*/
+	struct Track {
+	  Channel rot;
+	  Channel trans;
+	  Vector3F transMin; ///< The minimum value of the translation.
+	  Vector3F transScale; ///< The scale to decode the quantized translation.
+	};
+
+	AnimationClip() : timeScale(0) {}
+	size_t GetByteSize() const;
+
+	/** Get the time of the key.
+
+	  @param key  The index of the key.
+
+	  @return The time of the key in the quantized unit. Multiply timeScale to get the time in seconds.
+	*/
+	float GetTime(uint32_t key) const { return static_cast<float>(timeList[key]); }
+
+	/** Decode the rotation of the key.
+
+	  @param key  The index of the key in the rotation channel.
+
+	  @return The normalized quaternion.
+	*/
+	Quaternion GetRotation(uint32_t key) const {
+	  const uint16_t* p = &valueList[key * 3];
+	  const uint64_t bits = p[0] | (static_cast<uint64_t>(p[1]) << 16) | (static_cast<uint64_t>(p[2]) << 32);
+	  static const float scale = 1.41421356f / 32767.0f;
+	  const float a = static_cast<float>(static_cast<int32_t>((bits >> 30) & 0x7fff) - 16383) * scale;
+	  const float b = static_cast<float>(static_cast<int32_t>((bits >> 15) & 0x7fff) - 16383) * scale;
+	  const float c = static_cast<float>(static_cast<int32_t>(bits & 0x7fff) - 16383) * scale;
+	  const float d = std::sqrt(std::max(0.0f, 1.0f - (a * a + b * b + c * c)));
+	  switch (bits >> 45) {
+	  case 0: return Quaternion(d, a, b, c);
+	  case 1: return Quaternion(a, d, b, c);
+	  case 2: return Quaternion(a, b, d, c);
+	  default: return Quaternion(a, b, c, d);
+	  }
+	}
+
+	/** Decode the translation of the key.
+
+	  @param track  The track that has the key.
+	  @param key    The index of the key in the translation channel.
+
+	  @return The translation.
+	*/
+	Vector3F GetTranslation(const Track& track, uint32_t key) const {
+	  const uint16_t* p = &valueList[key * 3];
+	  return Vector3F(
+		track.transMin.x + static_cast<float>(p[0]) * track.transScale.x,
+		track.transMin.y + static_cast<float>(p[1]) * track.transScale.y,
+		track.transMin.z + static_cast<float>(p[2]) * track.transScale.z
+	  );
+	}
+
+	std::vector<Track> trackList; ///< The track of each joint.
+	std::vector<uint16_t> timeList; ///< The quantized time of all keys.
+	std::vector<uint16_t> valueList; ///< The quantized values of all keys. Three values per key.
+	float timeScale; ///< The time in seconds per the quantized unit.
+  };
+
+} // namespace Mai
+
+#endif // ANIMATIONCLIP_H_INCLUDED
@@ -0,0 +1,219 @@
+#include "AnimationSampler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Mai {
+
+  namespace {
+
+	/** Find the keys of the channel at the specified time, and decode them.
+
+	  Before the first key, the default value at time 0 and the first key are returned.
+	  After the last key, the last key is returned as the pair.
+
+	  @param clip          The clip that has the channel.
+	  @param channel       The channel to sample.
+	  @param t             The time in the quantized unit of the clip.
+	  @param cursor        The cursor of the channel. It is updated to the first key after \e t.
+	  @param defaultValue  The value used if the channel has no key.
+	  @param decode        The function to decode the key.
+	  @param pair          The pair of the decoded keys is stored.
+	  @param ratio         The interpolation ratio between the pair is stored.
+	*/
+	template<typename T, typename Decode>
+	void FindKeys(const AnimationClip& clip, const AnimationClip::Channel& channel, float t, uint32_t& cursor, const T& defaultValue, Decode decode, T* pair, float& ratio)
+	{
+	  if (!channel.count) {
+		pair[0] = pair[1] = defaultValue;
+		ratio = 0.0f;
+		return;
+	  }
+	  const uint16_t* times = &clip.timeList[channel.offset];
+	  const uint32_t keyCount = channel.count;
+	  uint32_t n = cursor;
+	  if (n > 0 && t < times[n - 1]) {
+		n = static_cast<uint32_t>(std::upper_bound(times, times + keyCount, t, [](float lhs, uint16_t rhs) { return lhs < rhs; }) - times);
+	  } else {
+		while (n < keyCount && times[n] <= t) {
+		  ++n;
+		}
+	  }
+	  cursor = n;
+	  float timeA;
+	  float timeB;
+	  if (n == 0) {
+		pair[0] = defaultValue;
+		pair[1] = decode(channel.offset);
+		timeA = 0.0f;
+		timeB = clip.GetTime(channel.offset);
+	  } else if (n == keyCount) {
+		pair[0] = pair[1] = decode(channel.offset + keyCount - 1);
+		ratio = 0.0f;
+		return;
+	  } else {
+		pair[0] = decode(channel.offset + n - 1);
+		pair[1] = decode(channel.offset + n);
+		timeA = clip.GetTime(channel.offset + n - 1);
+		timeB = clip.GetTime(channel.offset + n);
+	  }
+	  const float timeRange = timeB - timeA;
+	  ratio = timeRange > 0.0f ? (t - timeA) / timeRange : 0.0f;
+	}
+
+	/** Interpolate the translation linearly.
+	*/
+	Vector3F Lerp(const Vector3F& a, const Vector3F& b, float ratio)
+	{
+	  return a * (1.0f - ratio) + b * ratio;
+	}
+
+  } // unnamed namespace
+
+  /** Set the animation to sample.
+
+    The work buffers are allocated here.
+
+	@param p      The animation. nullptr means no animation.
+	@param count  The number of the joints of the mesh.
+  */
+  void AnimationSampler::Reset(const Animation* p, size_t count)
+  {
+	pAnime = p;
+	jointCount = count;
+	cursorList.assign(count * 2, 0);
+	rotKeyList.resize(count * 2);
+	transKeyList.resize(count * 2);
+	ratioList.resize(count * 2);
+  }
+
+  /** Sample the pose at the specified time.
+
+    The joint without the track is the unit pose.
+
+	@param t     The time in the animation.
+	@param pose  The pose of each joint is stored. It is resized to the number of the joints.
+  */
+  void AnimationSampler::Sample(float t, PoseBuffer& pose)
+  {
+	pose.Resize(jointCount);
+	if (!pAnime) {
+	  std::fill(pose.rot.begin(), pose.rot.end(), RotTrans::Unit().rot);
+	  std::fill(pose.trans.begin(), pose.trans.end(), RotTrans::Unit().trans);
+	  return;
+	}
+
+	// Find and decode the keys of each joint from the cursor.
+	static const AnimationClip::Channel emptyChannel = { 0, 0 };
+	const AnimationClip& clip = pAnime->clip;
+	const float quantizedTime = t / clip.timeScale;
+	const size_t trackCount = std::min(jointCount, clip.trackList.size());
+	for (size_t i = 0; i < jointCount; ++i) {
+	  const AnimationClip::Track* pTrack = i < trackCount ? &clip.trackList[i] : nullptr;
+	  FindKeys(clip, pTrack ? pTrack->rot : emptyChannel, quantizedTime, cursorList[i * 2], Quaternion::Unit(),
+		[&clip](uint32_t key) { return clip.GetRotation(key); },
+		&rotKeyList[i * 2], ratioList[i * 2]);
+	  FindKeys(clip, pTrack ? pTrack->trans : emptyChannel, quantizedTime, cursorList[i * 2 + 1], Vector3F(0, 0, 0),
+		[&clip, pTrack](uint32_t key) { return clip.GetTranslation(*pTrack, key); },
+		&transKeyList[i * 2], ratioList[i * 2 + 1]);
+	}
+
+	// Interpolate all joints in the batch.
+	for (size_t i = 0; i < jointCount; ++i) {
+	  pose.rot[i] = Sleap(rotKeyList[i * 2], rotKeyList[i * 2 + 1], ratioList[i * 2]);
+	}
+	for (size_t i = 0; i < jointCount; ++i) {
+	  pose.trans[i] = Lerp(transKeyList[i * 2], transKeyList[i * 2 + 1], ratioList[i * 2 + 1]);
+	}
+  }
+
+  /** Blend the pose with the other pose.
+
+    The same interpolation as the keys in AnimationSampler::Sample() is used.
+
+	@param pose   The pose to be blended. The result is stored.
+	@param other  The pose to blend. It must have the same number of the joints as \e pose.
+	@param ratio  The weight of \e other in [0, 1].
+  */
+  void BlendPose(PoseBuffer& pose, const PoseBuffer& other, float ratio)
+  {
+	const size_t jointCount = std::min(pose.Size(), other.Size());
+	for (size_t i = 0; i < jointCount; ++i) {
+	  pose.rot[i] = Sleap(pose.rot[i], other.rot[i], ratio);
+	}
+	for (size_t i = 0; i < jointCount; ++i) {
+	  pose.trans[i] = Lerp(pose.trans[i], other.trans[i], ratio);
+	}
+  }
+
+  /** Convert the pose to the dual quaternions of the skinning.
+
+	@param pose  The pose of each joint.
+	@param out   The real and the dual parts of each joint are stored. It must have pose.Size() * 2 elements.
+  */
+  void ToDualQuaternions(const PoseBuffer& pose, Vector4F* out)
+  {
+	for (size_t i = 0; i < pose.Size(); ++i) {
+	  const Quaternion& r = pose.rot[i];
+	  const Vector3F& v = pose.trans[i];
+	  out[i * 2] = Vector4F(r.x, r.y, r.z, r.w);
+	  // dual = 0.5 * (v, 0) * r
+	  out[i * 2 + 1] = Vector4F(
+		0.5f * (r.w * v.x + v.y * r.z - v.z * r.y),
+		0.5f * (r.w * v.y + v.z * r.x - v.x * r.z),
+		0.5f * (r.w * v.z + v.x * r.y - v.y * r.x),
+		-0.5f * (v.x * r.x + v.y * r.y + v.z * r.z)
+	  );
+	}
+  }
+
+  const float PoseCache::timeStep = 1.0f / 120.0f;
+
+  /** Get the pose of the animation at the specified time.
+
+    If the pose isn't cached, it is sampled by \e sampler and stored into the cache.
+
+	@param p        The animation.
+	@param t        The time in the animation.
+	@param sampler  The sampler used when the pose isn't cached.
+	                It is reset if it isn't set to \e p and \e count.
+	@param count    The number of the joints of the mesh.
+
+	@return The pose of each joint. It is valid until the next call.
+  */
+  const PoseBuffer& PoseCache::Get(const Animation* p, float t, AnimationSampler& sampler, size_t count)
+  {
+	const uint32_t tick = static_cast<uint32_t>(std::floor(std::max(0.0f, t) / timeStep + 0.5f));
+	for (const auto& e : entryList) {
+	  if (e.pAnime == p && e.jointCount == count && e.tick == tick) {
+		++hitCount;
+		return e.pose;
+	  }
+	}
+	++missCount;
+	if (entryList.size() < capacity) {
+	  entryList.push_back(Entry());
+	  nextEntry = entryList.size() - 1;
+	}
+	Entry& e = entryList[nextEntry];
+	nextEntry = (nextEntry + 1) % capacity;
+	e.pAnime = p;
+	e.jointCount = count;
+	e.tick = tick;
+	if (sampler.GetAnimation() != p || sampler.GetJointCount() != count) {
+	  sampler.Reset(p, count);
+	}
+	sampler.Sample(static_cast<float>(tick) * timeStep, e.pose);
+	return e.pose;
+  }
+
+  /** Remove all entries.
+
+    This must be called before the animations are released.
+  */
+  void PoseCache::Clear()
+  {
+	entryList.clear();
+	nextEntry = 0;
+  }
+
+} // namespace Mai
@@ -0,0 +1,94 @@
+#ifndef ANIMATIONSAMPLER_H_INCLUDED
+#define ANIMATIONSAMPLER_H_INCLUDED
+#include "Mesh.h"
+#include "../../Shared/Vector.h"
+#include "../../Shared/Quaternion.h"
+#include <vector>
+#include <stdint.h>
+
+namespace Mai {
+
+  /** The pose of the joints in the structure of arrays.
+
+    The buffer is owned by the caller and reused every frame, so the sampling
+	doesn't allocate the memory once it has enough capacity.
+  */
+  struct PoseBuffer {
+	void Resize(size_t n) {
+	  rot.resize(n);
+	  trans.resize(n);
+	}
+	size_t Size() const { return rot.size(); }
+
+	std::vector<Quaternion> rot; ///< The rotation of each joint.
+	std::vector<Vector3F> trans; ///< The translation of each joint.
+  };
+
+  void BlendPose(PoseBuffer& pose, const PoseBuffer& other, float ratio);
+  void ToDualQuaternions(const PoseBuffer& pose, Vector4F* out);
+
+  /** The animation sampler that caches the keyframe cursor of each channel.
+
+    The cursor is the first key after the previous sample time. In the forward
+	playback it moves only a few keys each frame, so the sampling is O(1) amortized.
+	When the time goes back, e.g. by the loop, the cursor is found by the binary search.
+	The keys are decoded from Animation::clip only when they are interpolated.
+  */
+  class AnimationSampler {
+  public:
+	AnimationSampler() : pAnime(nullptr), jointCount(0) {}
+	void Reset(const Animation* p, size_t count);
+	void Sample(float t, PoseBuffer& pose);
+	const Animation* GetAnimation() const { return pAnime; }
+	size_t GetJointCount() const { return jointCount; }
+
+  private:
+	const Animation* pAnime;
+	size_t jointCount;
+	std::vector<uint32_t> cursorList; ///< The cursor of the rotation and the translation channels of each joint.
+
+	// The work buffers to interpolate all joints in the batch.
+	std::vector<Quaternion> rotKeyList; ///< The pair of the decoded rotations of each joint.
+	std::vector<Vector3F> transKeyList; ///< The pair of the decoded translations of each joint.
+	std::vector<float> ratioList; ///< The interpolation ratio of the rotation and the translation of each joint.
+  };
+
+  /** The cache of the sampled poses shared by the objects that play the same animation.
+
+    The pose is keyed by the animation, the number of the joints and the time quantized
+	by timeStep. The objects that play the same animation in sync find the same entry,
+	so the pose is sampled only once and each object applies its own model matrix.
+	The pose of the key is always sampled at the quantized time, so the entry is valid
+	until the animation is unloaded, and the oldest entry is replaced when the cache is full.
+  */
+  class PoseCache {
+  public:
+	static const size_t capacity = 32;
+	static const float timeStep; ///< The time resolution of the key in seconds.
+
+	PoseCache() : nextEntry(0), hitCount(0), missCount(0) {}
+	const PoseBuffer& Get(const Animation* p, float t, AnimationSampler& sampler, size_t count);
+	void Clear();
+	uint32_t GetHitCount() const { return hitCount; }
+	uint32_t GetMissCount() const { return missCount; }
+	float GetHitRate() const {
+	  const uint32_t total = hitCount + missCount;
+	  return total ? static_cast<float>(hitCount) / static_cast<float>(total) : 0.0f;
+	}
+
+  private:
+	struct Entry {
+	  const Animation* pAnime;
+	  size_t jointCount;
+	  uint32_t tick;
+	  PoseBuffer pose;
+	};
+	std::vector<Entry> entryList;
+	size_t nextEntry; ///< The index of the entry to be replaced next.
+	uint32_t hitCount;
+	uint32_t missCount;
+  };
+
+} // namespace Mai
+
+#endif // ANIMATIONSAMPLER_H_INCLUDED
@@ -0,0 +1,220 @@
+#include "AssetLoader.h"
+#include <chrono>
+#include <limits>
+#include <algorithm>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, "Mai.AssetLoader", __VA_ARGS__))
+#define LOGW(...) ((void)__android_log_print(ANDROID_LOG_WARN, "Mai.AssetLoader", __VA_ARGS__))
+#else
+#include <stdio.h>
+#define LOGI(...) ((void)printf(__VA_ARGS__), (void)printf("\n"))
+#define LOGW(...) ((void)printf(__VA_ARGS__), (void)printf("\n"))
+#endif // __ANDROID__
+
+namespace Mai {
+
+  AssetLoader::AssetLoader() : requestCount(0), finishedCount(0), failedCount(0), isStopping(false)
+  {
+  }
+
+  AssetLoader::~AssetLoader()
+  {
+	Stop();
+  }
+
+  /** Start the worker threads.
+
+    @param threadCount  The number of the worker threads. It is 1 at least.
+  */
+  void AssetLoader::Start(size_t threadCount)
+  {
+	Stop();
+	failedCount = 0;
+	threadCount = std::max<size_t>(1, threadCount);
+	threadList.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i) {
+	  threadList.emplace_back(&AssetLoader::Work, this);
+	}
+	LOGI("AssetLoader: start %d threads", static_cast<int>(threadCount));
+  }
+
+  /** Stop the worker threads.
+
+    The unfinished requests are discarded, and their state becomes AssetState::Failed.
+	The request being prepared is finished before the worker stops.
+  */
+  void AssetLoader::Stop()
+  {
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  isStopping = true;
+	}
+	condition.notify_all();
+	for (auto& e : threadList) {
+	  e.join();
+	}
+	threadList.clear();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& e : uploadQueue) {
+	  e->prepare = nullptr;
+	  e->upload = nullptr;
+	  e->state = static_cast<int>(AssetState::Failed);
+	}
+	prepareQueue.clear();
+	uploadQueue.clear();
+	requestCount = 0;
+	finishedCount = 0;
+	isStopping = false;
+  }
+
+  /** Add the request.
+
+    @param name  The name of the asset for the log.
+	@param func  The prepare step. It is called on the worker thread, and returns the upload step.
+	             If it fails, it should return the empty function.
+
+	@return The handle to poll the state of the request.
+  */
+  AssetHandle AssetLoader::Add(const char* name, const AssetRequest::PrepareFunc& func)
+  {
+	std::shared_ptr<AssetRequest> p = std::make_shared<AssetRequest>(name, func);
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  if (uploadQueue.empty()) {
+		requestCount = 0;
+		finishedCount = 0;
+	  }
+	  prepareQueue.push_back(p);
+	  uploadQueue.push_back(p);
+	  ++requestCount;
+	}
+	condition.notify_one();
+	return p;
+  }
+
+  /** Call the upload steps of the prepared requests.
+
+    This should be called on the GL thread once in each frame.
+	The requests are uploaded in the order of Add(), and it stops at the first request
+	that isn't prepared yet, or when the elapsed time exceeds the budget.
+	At least one request is uploaded if it has been prepared.
+
+	@param timeBudget  The maximum time to spend(unit:nsec).
+
+	@return The number of the finished requests.
+  */
+  size_t AssetLoader::ProcessUploads(int64_t timeBudget)
+  {
+	const auto startTime = std::chrono::steady_clock::now();
+	size_t count = 0;
+	for (;;) {
+	  std::shared_ptr<AssetRequest> p;
+	  {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (uploadQueue.empty() || uploadQueue.front()->State() == AssetState::Pending) {
+		  break;
+		}
+		p = uploadQueue.front();
+		uploadQueue.pop_front();
+	  }
+	  if (p->State() == AssetState::Ready) {
+		const bool result = p->upload();
+		p->upload = nullptr;
+		p->state = static_cast<int>(result ? AssetState::Done : AssetState::Failed);
+	  }
+	  if (p->State() == AssetState::Failed) {
+		LOGW("AssetLoader: can't load '%s'", p->name.c_str());
+		++failedCount;
+	  }
+	  ++count;
+	  {
+		std::lock_guard<std::mutex> lock(mutex);
+		++finishedCount;
+	  }
+	  const int64_t elapsedTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+	  if (elapsedTime >= timeBudget) {
+		break;
+	  }
+	}
+	return count;
+  }
+
+  /** Wait for all requests and upload them.
+
+    This should be called on the GL thread.
+	If the worker threads haven't been started, the prepare steps are called on the calling thread.
+  */
+  void AssetLoader::Flush()
+  {
+	for (;;) {
+	  ProcessUploads(std::numeric_limits<int64_t>::max());
+	  std::unique_lock<std::mutex> lock(mutex);
+	  if (uploadQueue.empty()) {
+		break;
+	  }
+	  if (threadList.empty()) {
+		for (auto& e : prepareQueue) {
+		  e->upload = e->prepare();
+		  e->prepare = nullptr;
+		  e->state = static_cast<int>(e->upload ? AssetState::Ready : AssetState::Failed);
+		}
+		prepareQueue.clear();
+		continue;
+	  }
+	  readyCondition.wait(lock, [this]() { return uploadQueue.front()->State() != AssetState::Pending; });
+	}
+  }
+
+  /** Get the progress of the requests.
+
+    The progress is counted from the time when the loader became idle last.
+
+	@return The ratio of the finished requests in the range [0, 1]. 1 if there is no request.
+  */
+  float AssetLoader::Progress() const
+  {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!requestCount) {
+	  return 1.0f;
+	}
+	return static_cast<float>(finishedCount) / static_cast<float>(requestCount);
+  }
+
+  /** Check whether all requests have been finished.
+  */
+  bool AssetLoader::IsCompleted() const
+  {
+	std::lock_guard<std::mutex> lock(mutex);
+	return uploadQueue.empty();
+  }
+
+  /** The main loop of the worker thread.
+  */
+  void AssetLoader::Work()
+  {
+	for (;;) {
+	  std::shared_ptr<AssetRequest> p;
+	  {
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [this]() { return isStopping || !prepareQueue.empty(); });
+		if (isStopping) {
+		  return;
+		}
+		p = prepareQueue.front();
+		prepareQueue.pop_front();
+	  }
+	  AssetRequest::UploadFunc upload = p->prepare();
+	  {
+		std::lock_guard<std::mutex> lock(mutex);
+		p->prepare = nullptr;
+		p->upload = std::move(upload);
+		p->state = static_cast<int>(p->upload ? AssetState::Ready : AssetState::Failed);
+	  }
+	  readyCondition.notify_all();
+	}
+  }
+
+} // namespace Mai
@@ -0,0 +1,90 @@
+#ifndef ASSETLOADER_H_INCLUDED
+#define ASSETLOADER_H_INCLUDED
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdint.h>
+
+namespace Mai {
+
+  /** The state of the asset request.
+  */
+  enum class AssetState {
+	Pending, ///< Waiting for the worker thread, or being prepared.
+	Ready, ///< Prepared, and waiting for the upload on the GL thread.
+	Done, ///< Uploaded.
+	Failed, ///< Failed to prepare or upload.
+  };
+
+  /** The asset request shared by the loader and the requester.
+
+    The requester can poll the state like a future.
+  */
+  class AssetRequest {
+  public:
+	typedef std::function<bool()> UploadFunc;
+	typedef std::function<UploadFunc()> PrepareFunc;
+
+	explicit AssetRequest(const char* n, const PrepareFunc& f) : name(n), state(static_cast<int>(AssetState::Pending)), prepare(f) {}
+	const std::string& Name() const { return name; }
+	AssetState State() const { return static_cast<AssetState>(state.load()); }
+	bool IsFinished() const { return State() == AssetState::Done || State() == AssetState::Failed; }
+
+  private:
+	friend class AssetLoader;
+	std::string name;
+	std::atomic<int> state;
+	PrepareFunc prepare;
+	UploadFunc upload;
+  };
+  typedef std::shared_ptr<const AssetRequest> AssetHandle;
+
+  /** The asynchronous asset loader.
+
+    The request is split into two steps. The prepare step runs on the worker threads,
+	and does all work that doesn't need the GL context, such as reading and parsing the file.
+	It returns the upload step, which is called on the GL thread by ProcessUploads().
+
+	The upload steps are called in the order of Add(), so the request can depend on
+	the result of the previous requests.
+  */
+  class AssetLoader
+  {
+  public:
+	AssetLoader();
+	~AssetLoader();
+	void Start(size_t threadCount);
+	void Stop();
+	AssetHandle Add(const char* name, const AssetRequest::PrepareFunc& func);
+	size_t ProcessUploads(int64_t timeBudget);
+	void Flush();
+
+	float Progress() const;
+	bool IsCompleted() const;
+	size_t FailedCount() const { return failedCount; }
+
+  private:
+	void Work();
+
+  private:
+	std::vector<std::thread> threadList;
+	mutable std::mutex mutex;
+	std::condition_variable condition;
+	std::condition_variable readyCondition;
+	std::deque<std::shared_ptr<AssetRequest>> prepareQueue; ///< The requests that wait for the worker.
+	std::deque<std::shared_ptr<AssetRequest>> uploadQueue; ///< All unfinished requests in the order of Add().
+	size_t requestCount; ///< The number of the requests since the loader became idle.
+	size_t finishedCount; ///< The number of the finished requests in requestCount.
+	size_t failedCount; ///< The number of the failed requests since Start().
+	bool isStopping;
+  };
+
+} // namespace Mai
+
+#endif // ASSETLOADER_H_INCLUDED
@@ -94,7 +94,7 @@ namespace Mai {
 		  return Result();
 		}
 		if (t < 0.0f) {
-		  // dȂĂꍇ̑Ώ.
+		  // 重なっていた場合の対処.
 		  const Vector3F m = sphereB.shape.center - sphereA.shape.center;
 		  const Vector3F n = Vector3F(m).Normalize();
 		  const float c = m.LengthSq() - r * r;
@@ -124,13 +124,13 @@ namespace Mai {
 	  const float distance = plane.shape.normal.Dot(sphere.shape.center - plane.shape.point);
 	  const Vector3F v = sphere.v - plane.v;
 	  const float denom = plane.shape.normal.Dot(v);
-	  // s邢͉悤ɈړĂꍇAՓ˂͋NȂ.
+	  // 平行あるいは遠ざかるように移動している場合、衝突は起こらない.
 	  if (denom * distance >= 0.0f) {
 		return Result();
 	  }
 	  const float c = std::abs(distance);
 	  if (c < sphere.shape.radius) {
-		// łɏdȂĂ.
+		// すでに重なっている.
 		const float f = std::min(0.001f * c, 0.001f);
 		sphere.v += plane.shape.normal * f;
 		t = 0.0f;
@@ -497,12 +497,12 @@ namespace Mai {
 		v.y -= g * delta;
 
 		// solve air friction.
-		// XJC_CrȌI[x50m/s`85m/s炵.
-		// "Poynter, D. and Turoff, M., The Skydiver's Handbook, (2004), pp.191 - 193"ɕϓIȏI[xĂ炵.
+		// スカイダイビングの終端加速度は50m/s～85m/sらしい.
+		// "Poynter, D. and Turoff, M., The Skydiver's Handbook, (2004), pp.191 - 193"に平均的な終端速度が書いてあるらしい.
 		const float f = v.Length();
 		if (f > FLT_EPSILON) {
-		  static float Cd = 0.24f; // ǂŃXJC_Co[̍R͌W0.24炢ƏĂ. {̂Ƃ͕s.
-		  // Cxp̋ߎ͂̂gĂ @ref http://kinkink.web.fc2.com/contents/density/index.html
+		  static float Cd = 0.24f; // どこかでスカイダイバーの抗力係数は0.24くらいと書いてあった. 本当のところは不明.
+		  // 空気密度pの近似式はここのを使っている @ref http://kinkink.web.fc2.com/contents/density/index.html
 		  const float z = e.Position().y * 0.001f;
 		  const float z2 = z * z;
 		  const float p = -0.0000171f * z2 * z + 0.002978f * z2 - 0.10975f * z + 1.225f;
@@ -519,6 +519,7 @@ namespace Mai {
 		e.v = e.accel * delta;
 		e.innerEnergy = 0;
 		e.hasLatestCollision = false;
+		e.hasMoved = false;
 	  }
 	  RigidBody* pLatestCollider = nullptr;
 	  for (auto itrL = bodies.begin(); itrL != bodies.end();) {
@@ -532,7 +533,7 @@ namespace Mai {
 			continue;
 		  }
 		  if (auto r = dispatcherList[rhs.shapeID][lhs.shapeID](lhs, rhs)) {
-			// ɉĉx炷(Cۂ).
+			// 当たり方に応じて加速度を減らす(摩擦っぽい処理).
 			const Vector3F& normal = r->normal;
 			if (lhs.accel.LengthSq()) {
 			  const float friction = 0.9f - Normalize(lhs.accel).Dot(normal) * 0.125f;
@@ -552,12 +553,13 @@ namespace Mai {
 		  }
 		}
 		if (!collisionCount || lhs.v.LengthSq() <= 0.0f) {
+		  lhs.hasMoved = lhs.v.LengthSq() > 0.0f;
 		  lhs.Move(lhs.v);
 		  lhs.v = Vector3F::Unit();
 		  pLatestCollider = nullptr;
 		  ++itrL;
 		}
-		// d͂ɂU.
+		// 重力による振動をおさえる.
 		else if (collisionCount == 1 && lhs.accel.y > 0.0f && lhs.accel.y <= g * delta) {
 		  const float v = lhs.accel.Length();
 		  if (lhs.accel.y / v >= 0.8f) {
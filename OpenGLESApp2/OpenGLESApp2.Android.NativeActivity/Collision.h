@@ -71,6 +71,7 @@ namespace Mai {
 		: shapeID(sid)
 		, materialID(mid)
 		, hasLatestCollision(false)
+		, hasMoved(false)
 		, isStatic(true)
 		, m(kg)
 		, thrust(Vector3F::Unit())
@@ -89,6 +90,7 @@ namespace Mai {
 
 	  uint8_t materialID;
 	  bool hasLatestCollision;
+	  bool hasMoved; ///< true if the body is moved by the latest World::Step().
 	  bool isStatic;
 	  float m;
 	  Vector3F thrust;
@@ -0,0 +1,698 @@
+#include "ImageBasedLighting.h"
+#include "Parallel.h"
+#include "texture.h"
+#include "../../Shared/Window.h"
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define IBL_USE_NEON
+#elif defined(__SSE__) || defined(_M_IX86) || defined(_M_X64)
+#include <xmmintrin.h>
+#define IBL_USE_SSE
+#endif
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, "Mai.IBL", __VA_ARGS__))
+#else
+#include <stdio.h>
+#define LOGI(...) ((void)printf(__VA_ARGS__), (void)printf("\n"))
+#endif // __ANDROID__
+
+namespace Mai {
+
+  namespace {
+
+	const char brdfLUTFilename[] = "brdflut.bin";
+
+	/// The header of the BRDF LUT cache file.
+	struct BRDFLUTHeader {
+	  char magic[4];
+	  uint16_t size;
+	  uint16_t sampleCount;
+	};
+
+	/** Get the i-th point of the Hammersley sequence.
+	*/
+	void Hammersley(uint32_t i, uint32_t n, float& x, float& y)
+	{
+	  uint32_t bits = i;
+	  bits = (bits << 16) | (bits >> 16);
+	  bits = ((bits & 0x55555555) << 1) | ((bits & 0xAAAAAAAA) >> 1);
+	  bits = ((bits & 0x33333333) << 2) | ((bits & 0xCCCCCCCC) >> 2);
+	  bits = ((bits & 0x0F0F0F0F) << 4) | ((bits & 0xF0F0F0F0) >> 4);
+	  bits = ((bits & 0x00FF00FF) << 8) | ((bits & 0xFF00FF00) >> 8);
+	  x = static_cast<float>(i) / static_cast<float>(n);
+	  y = static_cast<float>(bits) * 2.3283064365386963e-10f;
+	}
+
+	/** Integrate the environment BRDF for one texel.
+
+	  @param dotNV        The cosine of the angle between the normal and the eye vector.
+	  @param roughness    The perceptual roughness.
+	  @param sampleCount  The number of the importance samples.
+	  @param scale        The scale to F0 is stored.
+	  @param bias         The bias to F0 is stored.
+	*/
+	void IntegrateBRDF(float dotNV, float roughness, int sampleCount, float& scale, float& bias)
+	{
+	  const float vx = std::sqrt(1.0f - dotNV * dotNV);
+	  const float vz = dotNV;
+	  const float a = roughness * roughness;
+	  const float k = a * 0.5f; // the Schlick-Smith geometry term for IBL.
+	  float A = 0.0f;
+	  float B = 0.0f;
+	  for (int i = 0; i < sampleCount; ++i) {
+		float e1, e2;
+		Hammersley(i, sampleCount, e1, e2);
+		const float phi = 2.0f * 3.14159265358979f * e1;
+		const float cosTheta = std::sqrt((1.0f - e2) / (1.0f + (a * a - 1.0f) * e2));
+		const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+		const float hx = sinTheta * std::cos(phi);
+		const float hz = cosTheta;
+		const float dotVH = vx * hx + vz * hz;
+		const float lz = 2.0f * dotVH * hz - vz;
+		const float dotNL = std::min(1.0f, lz);
+		if (dotNL > 0.0f && dotVH > 0.0f) {
+		  const float dotNH = std::max(0.0f, hz);
+		  const float g = (dotNV / (dotNV * (1.0f - k) + k)) * (dotNL / (dotNL * (1.0f - k) + k));
+		  const float gVis = g * dotVH / (dotNH * dotNV);
+		  const float fc = std::pow(1.0f - dotVH, 5.0f);
+		  A += (1.0f - fc) * gVis;
+		  B += fc * gVis;
+		}
+	  }
+	  scale = A / static_cast<float>(sampleCount);
+	  bias = B / static_cast<float>(sampleCount);
+	}
+
+	uint8_t ToUnorm8(float f) {
+	  return static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, f * 255.0f + 0.5f)));
+	}
+
+	/// The header of the irradiance SH cache file.
+	struct IrradianceSHHeader {
+	  char magic[4];
+	  uint32_t sourceHash; ///< The hash of the source cube map.
+	};
+
+	/// The header of the specular IBL cache file.
+	struct SpecularIBLHeader {
+	  char magic[4];
+	  uint32_t sourceHash; ///< The hash of the source cube map.
+	  uint16_t size; ///< The face size of the source cube map.
+	  uint16_t levelCount;
+	  uint16_t sampleCount;
+	  uint16_t reserved;
+	};
+
+	const float pi = 3.14159265358979f;
+
+	/** Get the direction of the texel of the cube map.
+
+	  @param face  The face index in the order of GL_TEXTURE_CUBE_MAP_POSITIVE_X to NEGATIVE_Z.
+	  @param u     The horizontal position in the face(-1 to 1).
+	  @param v     The vertical position in the face(-1 to 1). The first row is -1.
+	  @param dir   The unnormalized direction is stored.
+	*/
+	void CubeMapDirection(int face, float u, float v, float* dir)
+	{
+	  switch (face) {
+	  case 0: dir[0] = 1; dir[1] = -v; dir[2] = -u; break;
+	  case 1: dir[0] = -1; dir[1] = -v; dir[2] = u; break;
+	  case 2: dir[0] = u; dir[1] = 1; dir[2] = v; break;
+	  case 3: dir[0] = u; dir[1] = -1; dir[2] = -v; break;
+	  case 4: dir[0] = u; dir[1] = -v; dir[2] = 1; break;
+	  default: dir[0] = -u; dir[1] = -v; dir[2] = -1; break;
+	  }
+	}
+
+	void Normalize(float* v)
+	{
+	  const float invLen = 1.0f / std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	  v[0] *= invLen;
+	  v[1] *= invLen;
+	  v[2] *= invLen;
+	}
+
+	/** Make the orthonormal basis around the normal.
+	*/
+	void TangentFrame(const float* n, float* t, float* b)
+	{
+	  const float up[3] = { 0.0f, std::abs(n[1]) < 0.999f ? 1.0f : 0.0f, std::abs(n[1]) < 0.999f ? 0.0f : 1.0f };
+	  t[0] = up[1] * n[2] - up[2] * n[1];
+	  t[1] = up[2] * n[0] - up[0] * n[2];
+	  t[2] = up[0] * n[1] - up[1] * n[0];
+	  Normalize(t);
+	  b[0] = n[1] * t[2] - n[2] * t[1];
+	  b[1] = n[2] * t[0] - n[0] * t[2];
+	  b[2] = n[0] * t[1] - n[1] * t[0];
+	}
+
+	/** Transform the directions from the tangent space to the world space.
+
+	  @param x, y, z     The directions in the tangent space as the structure of arrays.
+	  @param n           The element count. It should be a multiple of 4.
+	  @param t, b, nrm   The tangent, binormal and normal vector.
+	  @param ox, oy, oz  The transformed directions are stored.
+	*/
+	void TransformDirections(const float* x, const float* y, const float* z, size_t n,
+	  const float* t, const float* b, const float* nrm, float* ox, float* oy, float* oz)
+	{
+	  size_t i = 0;
+#if defined(IBL_USE_NEON)
+	  for (; i + 4 <= n; i += 4) {
+		const float32x4_t vx = vld1q_f32(x + i), vy = vld1q_f32(y + i), vz = vld1q_f32(z + i);
+		vst1q_f32(ox + i, vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vx, t[0]), vy, b[0]), vz, nrm[0]));
+		vst1q_f32(oy + i, vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vx, t[1]), vy, b[1]), vz, nrm[1]));
+		vst1q_f32(oz + i, vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vx, t[2]), vy, b[2]), vz, nrm[2]));
+	  }
+#elif defined(IBL_USE_SSE)
+	  for (; i + 4 <= n; i += 4) {
+		const __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+		for (int c = 0; c < 3; ++c) {
+		  const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(t[c])), _mm_mul_ps(vy, _mm_set1_ps(b[c]))), _mm_mul_ps(vz, _mm_set1_ps(nrm[c])));
+		  _mm_storeu_ps((c == 0 ? ox : (c == 1 ? oy : oz)) + i, r);
+		}
+	  }
+#endif
+	  for (; i < n; ++i) {
+		ox[i] = x[i] * t[0] + y[i] * b[0] + z[i] * nrm[0];
+		oy[i] = x[i] * t[1] + y[i] * b[1] + z[i] * nrm[1];
+		oz[i] = x[i] * t[2] + y[i] * b[2] + z[i] * nrm[2];
+	  }
+	}
+
+	/// The importance samples in the tangent space.
+	struct SampleList {
+	  std::vector<float> x, y, z;
+	  std::vector<float> weight; ///< dot(N, L). The invalid sample has 0.
+	  std::vector<float> lod; ///< The mip level of the source to fetch.
+	};
+
+	/// The linear radiance cube map for the prefiltering.
+	struct FloatCubeMap {
+	  int size;
+	  std::vector<float> rgb; ///< The faces are stored sequentially.
+	};
+
+	/** Decode the cube map and make its mip chain down to 1x1 by the box filter.
+	*/
+	std::vector<FloatCubeMap> CreateFloatCubeMapChain(const uint32_t* pixels, int size)
+	{
+	  std::vector<FloatCubeMap> chain;
+	  chain.push_back(FloatCubeMap());
+	  chain.back().size = size;
+	  chain.back().rgb.resize(size * size * 6 * 3);
+	  float* dst = &chain.back().rgb[0];
+	  for (const uint32_t* p = pixels, *end = pixels + size * size * 6; p != end; ++p) {
+		const float scale = 1.0f / std::max(static_cast<float>(*p >> 24), 1.0f);
+		*(dst++) = static_cast<float>(*p & 0xff) * scale;
+		*(dst++) = static_cast<float>((*p >> 8) & 0xff) * scale;
+		*(dst++) = static_cast<float>((*p >> 16) & 0xff) * scale;
+	  }
+	  while (chain.back().size > 1) {
+		const FloatCubeMap& src = chain.back();
+		FloatCubeMap m;
+		m.size = src.size / 2;
+		m.rgb.resize(m.size * m.size * 6 * 3);
+		float* d = &m.rgb[0];
+		for (int face = 0; face < 6; ++face) {
+		  for (int y = 0; y < m.size; ++y) {
+			const float* s0 = &src.rgb[((face * src.size + y * 2) * src.size) * 3];
+			const float* s1 = s0 + src.size * 3;
+			for (int x = 0; x < m.size; ++x, s0 += 6, s1 += 6) {
+			  for (int c = 0; c < 3; ++c) {
+				*(d++) = (s0[c] + s0[c + 3] + s1[c] + s1[c + 3]) * 0.25f;
+			  }
+			}
+		  }
+		}
+		chain.push_back(std::move(m));
+	  }
+	  return chain;
+	}
+
+	/** Fetch the cube map by the bilinear filter.
+
+	  The edges of the faces are clamped.
+	*/
+	void SampleCubeMap(const FloatCubeMap& m, float x, float y, float z, float* out)
+	{
+	  const float ax = std::abs(x), ay = std::abs(y), az = std::abs(z);
+	  int face;
+	  float ma, sc, tc;
+	  if (ax >= ay && ax >= az) {
+		face = x > 0 ? 0 : 1; ma = ax; sc = x > 0 ? -z : z; tc = -y;
+	  } else if (ay >= az) {
+		face = y > 0 ? 2 : 3; ma = ay; sc = x; tc = y > 0 ? z : -z;
+	  } else {
+		face = z > 0 ? 4 : 5; ma = az; sc = z > 0 ? x : -x; tc = -y;
+	  }
+	  const float fsize = static_cast<float>(m.size);
+	  const float fx = std::min(fsize - 1.0f, std::max(0.0f, (sc / ma + 1.0f) * 0.5f * fsize - 0.5f));
+	  const float fy = std::min(fsize - 1.0f, std::max(0.0f, (tc / ma + 1.0f) * 0.5f * fsize - 0.5f));
+	  const int x0 = static_cast<int>(fx), y0 = static_cast<int>(fy);
+	  const int x1 = std::min(x0 + 1, m.size - 1), y1 = std::min(y0 + 1, m.size - 1);
+	  const float rx = fx - static_cast<float>(x0), ry = fy - static_cast<float>(y0);
+	  const float* base = &m.rgb[face * m.size * m.size * 3];
+	  const float* p00 = base + (y0 * m.size + x0) * 3;
+	  const float* p01 = base + (y0 * m.size + x1) * 3;
+	  const float* p10 = base + (y1 * m.size + x0) * 3;
+	  const float* p11 = base + (y1 * m.size + x1) * 3;
+	  for (int c = 0; c < 3; ++c) {
+		const float top = p00[c] + (p01[c] - p00[c]) * rx;
+		const float bottom = p10[c] + (p11[c] - p10[c]) * rx;
+		out[c] = top + (bottom - top) * ry;
+	  }
+	}
+
+	/** Fetch the mip chain by the trilinear filter.
+	*/
+	void SampleCubeMapChain(const std::vector<FloatCubeMap>& chain, float x, float y, float z, float lod, float* out)
+	{
+	  const int l0 = static_cast<int>(lod);
+	  SampleCubeMap(chain[l0], x, y, z, out);
+	  const float r = lod - static_cast<float>(l0);
+	  if (r > 0.0f && l0 + 1 < static_cast<int>(chain.size())) {
+		float c[3];
+		SampleCubeMap(chain[l0 + 1], x, y, z, c);
+		for (int i = 0; i < 3; ++i) {
+		  out[i] += (c[i] - out[i]) * r;
+		}
+	  }
+	}
+
+	/** Encode the radiance to RGBA8 as rgb / a.
+
+	  The alpha is as large as possible to keep the precision.
+	*/
+	uint32_t EncodeRadiance(float r, float g, float b)
+	{
+	  const float maxValue = std::max(1.0f, std::max(r, std::max(g, b)));
+	  const int a = std::max(1, std::min(255, static_cast<int>(255.0f / maxValue)));
+	  const float fa = static_cast<float>(a);
+	  const uint32_t ir = std::min(255, static_cast<int>(r * fa + 0.5f));
+	  const uint32_t ig = std::min(255, static_cast<int>(g * fa + 0.5f));
+	  const uint32_t ib = std::min(255, static_cast<int>(b * fa + 0.5f));
+	  return ir | (ig << 8) | (ib << 16) | (static_cast<uint32_t>(a) << 24);
+	}
+
+  } // unnamed namespace
+
+  /** Generate the environment BRDF lookup table.
+
+    The rows are calculated on the multiple threads.
+
+	@param size         The width and height of the table.
+	@param sampleCount  The number of the importance samples per texel.
+
+	@return The table image in GL_LUMINANCE_ALPHA format.
+	        The u axis is dot(N, V), and the v axis is the roughness.
+  */
+  std::vector<uint8_t> GenerateBRDFLUT(int size, int sampleCount)
+  {
+	std::vector<uint8_t> image(size * size * 2);
+	ParallelFor(size, [&image, size, sampleCount](size_t begin, size_t end) {
+	  for (size_t y = begin; y < end; ++y) {
+		const float roughness = (static_cast<float>(y) + 0.5f) / static_cast<float>(size);
+		uint8_t* p = &image[y * size * 2];
+		for (int x = 0; x < size; ++x) {
+		  const float dotNV = (static_cast<float>(x) + 0.5f) / static_cast<float>(size);
+		  float scale, bias;
+		  IntegrateBRDF(dotNV, roughness, sampleCount, scale, bias);
+		  *(p++) = ToUnorm8(scale);
+		  *(p++) = ToUnorm8(bias);
+		}
+	  }
+	});
+	return image;
+  }
+
+  /** Load the environment BRDF lookup table.
+
+    If the cache file is available, the table is read from it.
+	Otherwise the table is generated and saved to the cache file.
+
+	@param window  The window object to access the user files.
+
+	@return The table image that has brdfLUTSize x brdfLUTSize texels.
+	        @sa GenerateBRDFLUT()
+  */
+  std::vector<uint8_t> LoadBRDFLUT(const Window& window)
+  {
+	const size_t imageSize = brdfLUTSize * brdfLUTSize * 2;
+	std::vector<uint8_t> buf;
+	if (window.GetUserFileSize(brdfLUTFilename) == sizeof(BRDFLUTHeader) + imageSize) {
+	  buf.resize(sizeof(BRDFLUTHeader) + imageSize);
+	  if (window.LoadUserFile(brdfLUTFilename, &buf[0], buf.size())) {
+		BRDFLUTHeader header;
+		memcpy(&header, &buf[0], sizeof(header));
+		if (memcmp(header.magic, "BRDF", 4) == 0 && header.size == brdfLUTSize && header.sampleCount == brdfLUTSampleCount) {
+		  LOGI("Load BRDF LUT from the cache.");
+		  return std::vector<uint8_t>(buf.begin() + sizeof(BRDFLUTHeader), buf.end());
+		}
+	  }
+	}
+
+	std::vector<uint8_t> image = GenerateBRDFLUT(brdfLUTSize, brdfLUTSampleCount);
+	const BRDFLUTHeader header = { { 'B', 'R', 'D', 'F' }, brdfLUTSize, brdfLUTSampleCount };
+	buf.resize(sizeof(BRDFLUTHeader));
+	memcpy(&buf[0], &header, sizeof(header));
+	buf.insert(buf.end(), image.begin(), image.end());
+	if (!window.SaveUserFile(brdfLUTFilename, &buf[0], buf.size())) {
+	  LOGI("Can't save the BRDF LUT cache.");
+	}
+	LOGI("Generate BRDF LUT(%dx%d, %d samples).", brdfLUTSize, brdfLUTSize, brdfLUTSampleCount);
+	return image;
+  }
+
+  /** Project the radiance cube map to the irradiance SH.
+
+    The rows of all faces are processed on the multiple threads.
+
+	@param pixels  The RGBA8 pixels of 6 faces. The radiance is encoded as rgb / a.
+	@param size    The width and height of each face.
+
+	@return The irradiance SH. @sa IrradianceSH.
+  */
+  IrradianceSH ProjectIrradianceSH(const uint32_t* pixels, int size)
+  {
+	// the partial sum of each row is reduced in order to get the same result by any thread count.
+	const size_t rowCount = size * 6;
+	std::vector<std::array<float, 9 * 3 + 1> > rowSumList(rowCount);
+	ParallelFor(rowCount, [pixels, size, &rowSumList](size_t begin, size_t end) {
+	  const float invSize = 2.0f / static_cast<float>(size);
+	  for (size_t row = begin; row < end; ++row) {
+		std::array<float, 9 * 3 + 1>& sum = rowSumList[row];
+		sum.fill(0.0f);
+		const int face = static_cast<int>(row / size);
+		const float v = (static_cast<float>(row % size) + 0.5f) * invSize - 1.0f;
+		const uint32_t* p = pixels + row * size;
+		for (int x = 0; x < size; ++x, ++p) {
+		  const float u = (static_cast<float>(x) + 0.5f) * invSize - 1.0f;
+		  float d[3];
+		  CubeMapDirection(face, u, v, d);
+		  const float lenSq = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+		  const float invLen = 1.0f / std::sqrt(lenSq);
+		  const float nx = d[0] * invLen, ny = d[1] * invLen, nz = d[2] * invLen;
+		  const float weight = 1.0f / (lenSq * std::sqrt(lenSq)); // the solid angle of the texel.
+		  const float a = std::max(static_cast<float>(*p >> 24), 1.0f);
+		  const float scale = weight / a;
+		  const float rgb[3] = {
+			static_cast<float>(*p & 0xff) * scale,
+			static_cast<float>((*p >> 8) & 0xff) * scale,
+			static_cast<float>((*p >> 16) & 0xff) * scale
+		  };
+		  const float basis[9] = {
+			0.282095f,
+			0.488603f * ny,
+			0.488603f * nz,
+			0.488603f * nx,
+			1.092548f * nx * ny,
+			1.092548f * ny * nz,
+			0.315392f * (3.0f * nz * nz - 1.0f),
+			1.092548f * nx * nz,
+			0.546274f * (nx * nx - ny * ny),
+		  };
+		  for (int i = 0; i < 9; ++i) {
+			sum[i * 3 + 0] += rgb[0] * basis[i];
+			sum[i * 3 + 1] += rgb[1] * basis[i];
+			sum[i * 3 + 2] += rgb[2] * basis[i];
+		  }
+		  sum[9 * 3] += weight;
+		}
+	  }
+	});
+
+	std::array<float, 9 * 3 + 1> total;
+	total.fill(0.0f);
+	for (const auto& e : rowSumList) {
+	  for (size_t i = 0; i < total.size(); ++i) {
+		total[i] += e[i];
+	  }
+	}
+
+	// the cosine lobe convolution divided by PI, and the constant factor of the basis.
+	static const float factorList[9] = {
+	  1.0f * 0.282095f,
+	  (2.0f / 3.0f) * 0.488603f, (2.0f / 3.0f) * 0.488603f, (2.0f / 3.0f) * 0.488603f,
+	  0.25f * 1.092548f, 0.25f * 1.092548f, 0.25f * 0.315392f, 0.25f * 1.092548f, 0.25f * 0.546274f,
+	};
+	const float normalizer = 4.0f * 3.14159265358979f / std::max(total[9 * 3], 1e-6f);
+	IrradianceSH sh;
+	for (int i = 0; i < 9; ++i) {
+	  const float f = factorList[i] * normalizer;
+	  sh[i] = Vector3F(total[i * 3 + 0] * f, total[i * 3 + 1] * f, total[i * 3 + 2] * f);
+	}
+	return sh;
+  }
+
+  /** Load the irradiance SH.
+
+    If the cache file made from the same source is available, the coefficients are read from it.
+	Otherwise the radiance cube map is projected and the result is saved to the cache file.
+
+	@param window      The window object to access the user files.
+	@param cacheName   The cache file name.
+	@param source      The radiance cube map.
+	@param sourceHash  The hash of the source. @sa HashImage().
+	@param sh          The irradiance SH is stored.
+
+	@retval true   success.
+	@retval false  the source isn't a cube map.
+  */
+  bool LoadIrradianceSH(const Window& window, const char* cacheName, const Texture::ImageData& source, uint32_t sourceHash, IrradianceSH& sh)
+  {
+	// the cache file is read and written as the coefficients in the vector, to avoid the unaligned access.
+	const size_t coefficientCount = std::tuple_size<IrradianceSH>::value * 3;
+	const size_t fileSize = sizeof(IrradianceSHHeader) + sizeof(float) * coefficientCount;
+	std::vector<uint8_t> buf(fileSize);
+	std::vector<float> coefficients(coefficientCount);
+	IrradianceSHHeader header;
+	if (window.GetUserFileSize(cacheName) == fileSize && window.LoadUserFile(cacheName, &buf[0], fileSize)) {
+	  memcpy(&header, &buf[0], sizeof(header));
+	  if (memcmp(header.magic, "SH9 ", 4) == 0 && header.sourceHash == sourceHash) {
+		memcpy(&coefficients[0], &buf[sizeof(header)], sizeof(float) * coefficientCount);
+		for (size_t i = 0; i < sh.size(); ++i) {
+		  sh[i] = Vector3F(coefficients[i * 3], coefficients[i * 3 + 1], coefficients[i * 3 + 2]);
+		}
+		return true;
+	  }
+	}
+
+	if (source.faceCount != 6 || source.width != source.height) {
+	  return false;
+	}
+	sh = ProjectIrradianceSH(&source.pixels[0], source.width);
+	memcpy(header.magic, "SH9 ", 4);
+	header.sourceHash = sourceHash;
+	for (size_t i = 0; i < sh.size(); ++i) {
+	  coefficients[i * 3] = sh[i].x;
+	  coefficients[i * 3 + 1] = sh[i].y;
+	  coefficients[i * 3 + 2] = sh[i].z;
+	}
+	memcpy(&buf[0], &header, sizeof(header));
+	memcpy(&buf[sizeof(header)], &coefficients[0], sizeof(float) * coefficientCount);
+	if (!window.SaveUserFile(cacheName, &buf[0], fileSize)) {
+	  LOGI("Can't save the irradiance SH cache:'%s'", cacheName);
+	}
+	LOGI("Project irradiance SH(%dx%d).", source.width, source.height);
+	return true;
+  }
+
+  /** Calculate the FNV-1a hash of the image.
+
+    It is used as the key of the cache files made from the image.
+  */
+  uint32_t HashImage(const Texture::ImageData& image)
+  {
+	uint32_t hash = 2166136261U;
+	const auto add = [&hash](const uint8_t* p, size_t n) {
+	  for (const uint8_t* end = p + n; p != end; ++p) {
+		hash = (hash ^ *p) * 16777619U;
+	  }
+	};
+	const int32_t header[3] = { image.width, image.height, image.faceCount };
+	add(reinterpret_cast<const uint8_t*>(header), sizeof(header));
+	if (!image.pixels.empty()) {
+	  add(reinterpret_cast<const uint8_t*>(&image.pixels[0]), image.pixels.size() * sizeof(uint32_t));
+	}
+	return hash;
+  }
+
+  /** Prefilter the specular IBL cube maps from the radiance cube map.
+
+    The radiance is convolved with the GGX distribution by the importance sampling.
+	To reduce the sample count, each sample fetches the mip level of the source that
+	matches the solid angle of the sample(the filtered importance sampling).
+	The rows of all faces are processed on the multiple threads, and the sample
+	directions are transformed by SIMD.
+
+	@param pixels       The RGBA8 pixels of 6 faces. The radiance is encoded as rgb / a.
+	@param size         The width and height of each face.
+	@param levelCount   The number of the cube maps to generate.
+	@param sampleCount  The number of the importance samples per texel.
+
+	@return The cube maps in the same format as the source. The level i has the size
+	        size >> i and is filtered by the roughness i / (levelCount - 1).
+			The level 0 is the copy of the source.
+  */
+  CubeMapLevelList PrefilterSpecularIBL(const uint32_t* pixels, int size, int levelCount, int sampleCount)
+  {
+	CubeMapLevelList levelList;
+	levelList.reserve(levelCount);
+	levelList.push_back(std::vector<uint32_t>(pixels, pixels + size * size * 6));
+	if (levelCount <= 1) {
+	  return levelList;
+	}
+
+	const std::vector<FloatCubeMap> source = CreateFloatCubeMapChain(pixels, size);
+	const float texelSolidAngle = 4.0f * pi / (6.0f * static_cast<float>(size * size));
+	const float maxLod = static_cast<float>(source.size() - 1);
+	const size_t paddedCount = (sampleCount + 3) & ~3;
+	for (int level = 1; level < levelCount; ++level) {
+	  const int levelSize = std::max(1, size >> level);
+	  const float roughness = static_cast<float>(level) / static_cast<float>(levelCount - 1);
+	  const float a = roughness * roughness;
+
+	  // the sample directions in the tangent space are shared by all texels, because of N = V = R.
+	  SampleList samples;
+	  samples.x.assign(paddedCount, 0.0f);
+	  samples.y.assign(paddedCount, 0.0f);
+	  samples.z.assign(paddedCount, 0.0f);
+	  samples.weight.assign(paddedCount, 0.0f);
+	  samples.lod.assign(paddedCount, 0.0f);
+	  float totalWeight = 0.0f;
+	  for (int i = 0; i < sampleCount; ++i) {
+		float e1, e2;
+		Hammersley(i, sampleCount, e1, e2);
+		const float phi = 2.0f * pi * e1;
+		const float cosTheta = std::sqrt((1.0f - e2) / (1.0f + (a * a - 1.0f) * e2));
+		const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+		const float hx = sinTheta * std::cos(phi);
+		const float hy = sinTheta * std::sin(phi);
+		const float hz = cosTheta;
+		const float dotNL = 2.0f * hz * hz - 1.0f;
+		if (dotNL <= 0.0f) {
+		  continue;
+		}
+		samples.x[i] = 2.0f * hz * hx;
+		samples.y[i] = 2.0f * hz * hy;
+		samples.z[i] = dotNL;
+		samples.weight[i] = dotNL;
+		const float d = (hz * hz) * (a * a - 1.0f) + 1.0f;
+		const float pdf = (a * a) / (pi * d * d) * 0.25f;
+		const float sampleSolidAngle = 1.0f / (static_cast<float>(sampleCount) * pdf + 0.0001f);
+		samples.lod[i] = std::min(maxLod, std::max(0.0f, 0.5f * std::log(sampleSolidAngle / texelSolidAngle) * 1.442695f + 1.0f));
+		totalWeight += dotNL;
+	  }
+	  const float invTotalWeight = 1.0f / std::max(totalWeight, 0.0001f);
+
+	  std::vector<uint32_t> image(levelSize * levelSize * 6);
+	  ParallelFor(levelSize * 6, [&](size_t begin, size_t end) {
+		std::vector<float> wx(paddedCount), wy(paddedCount), wz(paddedCount);
+		const float invSize = 2.0f / static_cast<float>(levelSize);
+		for (size_t row = begin; row < end; ++row) {
+		  const int face = static_cast<int>(row / levelSize);
+		  const float v = (static_cast<float>(row % levelSize) + 0.5f) * invSize - 1.0f;
+		  uint32_t* p = &image[row * levelSize];
+		  for (int x = 0; x < levelSize; ++x, ++p) {
+			const float u = (static_cast<float>(x) + 0.5f) * invSize - 1.0f;
+			float n[3];
+			CubeMapDirection(face, u, v, n);
+			Normalize(n);
+			float t[3], b[3];
+			TangentFrame(n, t, b);
+			TransformDirections(&samples.x[0], &samples.y[0], &samples.z[0], paddedCount, t, b, n, &wx[0], &wy[0], &wz[0]);
+			float sum[3] = { 0, 0, 0 };
+			for (size_t i = 0; i < paddedCount; ++i) {
+			  if (samples.weight[i] > 0.0f) {
+				float c[3];
+				SampleCubeMapChain(source, wx[i], wy[i], wz[i], samples.lod[i], c);
+				sum[0] += c[0] * samples.weight[i];
+				sum[1] += c[1] * samples.weight[i];
+				sum[2] += c[2] * samples.weight[i];
+			  }
+			}
+			*p = EncodeRadiance(sum[0] * invTotalWeight, sum[1] * invTotalWeight, sum[2] * invTotalWeight);
+		  }
+		}
+	  });
+	  levelList.push_back(std::move(image));
+	}
+	return levelList;
+  }
+
+  /** Load the specular IBL cube maps.
+
+    If the cache file made from the same source is available, the cube maps are read from it.
+	Otherwise they are prefiltered and saved to the cache file.
+
+	@param window      The window object to access the user files.
+	@param cacheName   The cache file name.
+	@param source      The radiance cube map.
+	@param sourceHash  The hash of the source. @sa HashImage().
+	@param levelCount  The number of the cube maps.
+	@param levelList   The cube maps are stored. @sa PrefilterSpecularIBL().
+
+	@retval true   success.
+	@retval false  the source isn't a cube map.
+  */
+  bool LoadSpecularIBL(const Window& window, const char* cacheName, const Texture::ImageData& source, uint32_t sourceHash, int levelCount, CubeMapLevelList& levelList)
+  {
+	if (source.faceCount != 6 || source.width != source.height) {
+	  return false;
+	}
+	const int size = source.width;
+	size_t pixelCount = 0;
+	for (int i = 1; i < levelCount; ++i) {
+	  const int levelSize = std::max(1, size >> i);
+	  pixelCount += levelSize * levelSize * 6;
+	}
+	const size_t fileSize = sizeof(SpecularIBLHeader) + pixelCount * sizeof(uint32_t);
+	if (window.GetUserFileSize(cacheName) == fileSize) {
+	  std::vector<uint8_t> buf(fileSize);
+	  if (window.LoadUserFile(cacheName, &buf[0], fileSize)) {
+		SpecularIBLHeader header;
+		memcpy(&header, &buf[0], sizeof(header));
+		if (memcmp(header.magic, "IBLS", 4) == 0 && header.sourceHash == sourceHash && header.size == size
+		  && header.levelCount == levelCount && header.sampleCount == iblSpecularSampleCount) {
+		  levelList.clear();
+		  levelList.push_back(source.pixels);
+		  size_t offset = sizeof(header);
+		  for (int i = 1; i < levelCount; ++i) {
+			const int levelSize = std::max(1, size >> i);
+			levelList.push_back(std::vector<uint32_t>(levelSize * levelSize * 6));
+			memcpy(&levelList.back()[0], &buf[offset], levelList.back().size() * sizeof(uint32_t));
+			offset += levelList.back().size() * sizeof(uint32_t);
+		  }
+		  LOGI("Load specular IBL from the cache:'%s'", cacheName);
+		  return true;
+		}
+	  }
+	}
+
+	levelList = PrefilterSpecularIBL(&source.pixels[0], size, levelCount, iblSpecularSampleCount);
+	std::vector<uint8_t> buf(sizeof(SpecularIBLHeader));
+	buf.reserve(fileSize);
+	const SpecularIBLHeader header = {
+	  { 'I', 'B', 'L', 'S' }, sourceHash,
+	  static_cast<uint16_t>(size), static_cast<uint16_t>(levelCount), static_cast<uint16_t>(iblSpecularSampleCount), 0
+	};
+	memcpy(&buf[0], &header, sizeof(header));
+	for (int i = 1; i < levelCount; ++i) {
+	  const uint8_t* p = reinterpret_cast<const uint8_t*>(&levelList[i][0]);
+	  buf.insert(buf.end(), p, p + levelList[i].size() * sizeof(uint32_t));
+	}
+	if (!window.SaveUserFile(cacheName, &buf[0], buf.size())) {
+	  LOGI("Can't save the specular IBL cache:'%s'", cacheName);
+	}
+	LOGI("Prefilter specular IBL(%dx%d, %d levels).", size, size, levelCount);
+	return true;
+  }
+
+} // namespace Mai
@@ -0,0 +1,55 @@
+#ifndef IMAGEBASEDLIGHTING_H_INCLUDED
+#define IMAGEBASEDLIGHTING_H_INCLUDED
+#include "../../Shared/Vector.h"
+#include <vector>
+#include <array>
+#include <stdint.h>
+
+namespace Texture {
+  struct ImageData;
+}
+
+namespace Mai {
+
+  class Window;
+
+  /** The parameter of the environment BRDF lookup table.
+
+    The table is indexed by (dot(N, V), roughness) and stores the scale and the bias
+	to F0 of the split sum approximation, as 8bit luminance and alpha.
+  */
+  static const int brdfLUTSize = 64;
+  static const int brdfLUTSampleCount = 256;
+
+  std::vector<uint8_t> GenerateBRDFLUT(int size, int sampleCount);
+  std::vector<uint8_t> LoadBRDFLUT(const Window&);
+
+  /** The irradiance represented by the 2nd order spherical harmonics.
+
+    The coefficients are already convolved with the cosine lobe, divided by PI and
+	multiplied by the constant factor of each basis function. Thus the diffuse color
+	in the direction 'n' is evaluated as:
+
+	  c[0] + c[1] * n.y + c[2] * n.z + c[3] * n.x
+	  + c[4] * n.x * n.y + c[5] * n.y * n.z + c[6] * (3 * n.z * n.z - 1)
+	  + c[7] * n.x * n.z + c[8] * (n.x * n.x - n.y * n.y)
+  */
+  typedef std::array<Vector3F, 9> IrradianceSH;
+
+  IrradianceSH ProjectIrradianceSH(const uint32_t* pixels, int size);
+  bool LoadIrradianceSH(const Window&, const char* cacheName, const Texture::ImageData& source, uint32_t sourceHash, IrradianceSH&);
+
+  /** The prefiltered specular IBL cube maps.
+
+    Each element is the RGBA8 pixels of 6 faces, and has the half size of the previous one.
+  */
+  typedef std::vector<std::vector<uint32_t> > CubeMapLevelList;
+  static const int iblSpecularSampleCount = 64;
+
+  uint32_t HashImage(const Texture::ImageData&);
+  CubeMapLevelList PrefilterSpecularIBL(const uint32_t* pixels, int size, int levelCount, int sampleCount);
+  bool LoadSpecularIBL(const Window&, const char* cacheName, const Texture::ImageData& source, uint32_t sourceHash, int levelCount, CubeMapLevelList&);
+
+} // namespace Mai
+
+#endif // IMAGEBASEDLIGHTING_H_INCLUDED
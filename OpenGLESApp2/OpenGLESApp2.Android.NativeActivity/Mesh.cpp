@@ -2,6 +2,7 @@
 #include <GLES2/gl2.h>
 #include <algorithm>
 #include <numeric>
+#include <cmath>
 
 //#define DEBUG_LOG_VERBOSE
 
@@ -19,6 +20,9 @@ namespace Mesh {
 
   namespace {
 
+	const float animationRotationTolerance = 0.001f; ///< The maximum angle error of the compressed animation in radians.
+	const float animationTranslationTolerance = 0.001f; ///< The maximum distance error of the compressed animation.
+
 	/**
 	  Get a uint32_t value from raw memory.
 	*/
@@ -42,6 +46,115 @@ namespace Mesh {
 	  return *reinterpret_cast<const float*>(&tmp);
 	}
 
+	/**
+	  Split the materials into the batches that refer the limited number of joints.
+
+	  The triangles are kept in the order, so each batch is a contiguous range of the material.
+	  The bone IDs of the vertices are remapped to the index of the palette of the batch.
+	  The vertex shared by the multiple batches is duplicated.
+
+	  @param pVBO                The vertices in the MSH data.
+	  @param vertexCount         The number of the vertices.
+	  @param pIBO                The indices in the MSH data.
+	  @param indexCount          The number of the indices including the padding.
+	  @param jointCount          The number of the joints.
+	  @param maxBonePaletteSize  The maximum number of the joints that a batch refers.
+	  @param parsed              The rewritten geometry and the split materials are stored.
+
+	  @retval true  The meshes are split.
+	  @retval false The number of the vertices exceeds the range of the 16bit index.
+	*/
+	bool SplitBonePalette(const Vertex* pVBO, size_t vertexCount, const GLushort* pIBO, size_t indexCount, size_t jointCount, size_t maxBonePaletteSize, ParsedMesh& parsed)
+	{
+	  std::vector<Vertex>& vertexList = parsed.vertexList;
+	  std::vector<GLushort>& indexList = parsed.indexList;
+	  vertexList.assign(pVBO, pVBO + vertexCount);
+	  indexList.assign(pIBO, pIBO + indexCount);
+
+	  // The arrays are stamped by the batch id instead of clearing them for each batch.
+	  std::vector<int32_t> ownerList(vertexCount, -1); // the batch that remapped the vertex in place.
+	  std::vector<int32_t> remapStampList(vertexCount, -1);
+	  std::vector<GLushort> remapIndexList(vertexCount);
+	  std::vector<int32_t> jointStampList(jointCount, -1);
+	  std::vector<GLubyte> localIndexList(jointCount);
+
+	  int32_t batchId = 0;
+	  for (auto& m : parsed.mesh.meshes) {
+		std::vector<Mesh::MeshMaterial> batchList;
+		for (const auto& mm : m.materialList) {
+		  const size_t begin = mm.iboOffset / sizeof(GLushort);
+		  const size_t end = std::min(indexCount, begin + mm.iboSize);
+		  size_t batchBegin = begin;
+		  Mesh::BonePalette palette;
+		  for (size_t i = begin;;) {
+			// Collect the joints that the triangle adds to the palette.
+			const bool isLast = i + 3 > end;
+			if (!isLast) {
+			  GLushort newJoints[3 * 4];
+			  size_t newJointCount = 0;
+			  for (size_t n = i; n < i + 3; ++n) {
+				const Vertex& v = pVBO[pIBO[n]];
+				for (int k = 0; k < 4; ++k) {
+				  const GLushort joint = v.boneID[k];
+				  if (v.weight[k] && joint < jointCount && jointStampList[joint] != batchId && std::find(newJoints, newJoints + newJointCount, joint) == newJoints + newJointCount) {
+					newJoints[newJointCount++] = joint;
+				  }
+				}
+			  }
+			  if (palette.empty() || palette.size() + newJointCount <= maxBonePaletteSize) {
+				for (size_t n = 0; n < newJointCount; ++n) {
+				  jointStampList[newJoints[n]] = batchId;
+				  localIndexList[newJoints[n]] = static_cast<GLubyte>(palette.size());
+				  palette.push_back(newJoints[n]);
+				}
+				i += 3;
+				continue;
+			  }
+			}
+
+			// Close the batch, and remap the vertices in it.
+			const size_t batchEnd = isLast ? end : i;
+			for (size_t n = batchBegin; n < batchEnd; ++n) {
+			  const GLushort index = pIBO[n];
+			  if (remapStampList[index] != batchId) {
+				Vertex v = pVBO[index];
+				for (int k = 0; k < 4; ++k) {
+				  v.boneID[k] = (v.weight[k] && v.boneID[k] < jointCount) ? localIndexList[v.boneID[k]] : 0;
+				}
+				if (ownerList[index] < 0) {
+				  ownerList[index] = batchId;
+				  vertexList[index] = v;
+				  remapIndexList[index] = index;
+				} else {
+				  if (vertexList.size() > 0xffff) {
+					return false;
+				  }
+				  remapIndexList[index] = static_cast<GLushort>(vertexList.size());
+				  vertexList.push_back(v);
+				}
+				remapStampList[index] = batchId;
+			  }
+			  indexList[n] = remapIndexList[index];
+			}
+			Mesh::MeshMaterial batch = mm;
+			batch.iboOffset = static_cast<int32_t>(batchBegin * sizeof(GLushort));
+			batch.iboSize = static_cast<int32_t>(batchEnd - batchBegin);
+			batch.bonePalette = static_cast<int32_t>(m.bonePaletteList.size());
+			batchList.push_back(batch);
+			m.bonePaletteList.push_back(palette);
+			++batchId;
+			if (isLast) {
+			  break;
+			}
+			palette.clear();
+			batchBegin = i; // the triangle is retried in the new batch.
+		  }
+		}
+		m.materialList.swap(batchList);
+	  }
+	  return true;
+	}
+
   } // unnamed namespace
 
   /**
@@ -103,16 +216,29 @@ namespace Mesh {
 	  ] x (key frame count)
 	] x (animation count)
   */
-#ifdef SHOW_TANGENT_SPACE
-  ImportMeshResult ImportMesh(const RawBuffer& data, GLuint& vbo, GLintptr& vboEnd, GLuint& ibo, GLintptr& iboEnd, GLuint vboTBN, GLintptr& vboTBNEnd)
-#else
-  ImportMeshResult ImportMesh(const RawBuffer& data, GLuint& vbo, GLintptr& vboEnd, GLuint& ibo, GLintptr& iboEnd)
-#endif //  SHOW_TANGENT_SPACE
+  /**
+  * Parse MSH data without OpenGL.
+  *
+  * This can be called on the worker thread. The geometry is kept in \e data, and
+  * the index offsets of the materials are relative to the top of the index data.
+  * UploadMesh() copies the geometry to the buffer objects and relocates the offsets.
+  *
+  * If the meshes refer more joints than \e maxBonePaletteSize, the materials are split into
+  * the batches that refer at most \e maxBonePaletteSize joints, and each batch has the bone palette.
+  * In that case, the rewritten geometry is stored to ParsedMesh::vertexList and ParsedMesh::indexList.
+  *
+  * @param data                The MSH data.
+  * @param maxBonePaletteSize  The maximum number of the bone matrices that the shader can receive.
+  *
+  * @return If succeeded, ParsedMesh::mesh.result is \e success.
+  *         Otherwise, it is an error code indicating the cause of the failure.
+  */
+  ParsedMesh ParseMesh(const RawBuffer& data, size_t maxBonePaletteSize)
   {
 	const uint8_t* p = &data[0];
 	const uint8_t* pEnd = p + data.size();
 	if (p[0] != 'M' || p[1] != 'S' || p[2] != 'H') {
-	  return ImportMeshResult(Result::invalidHeader);
+	  return ParsedMesh(Result::invalidHeader);
 	}
 	p += 3;
 	const int count = *p;
@@ -121,11 +247,12 @@ namespace Mesh {
 	const uint32_t vboByteSize = GetValue(p, 4); p += 4;
 	const uint32_t iboByteSize = GetValue(p, 4); p += 4;
 	if (p >= pEnd) {
-	  return ImportMeshResult(Result::noData);
+	  return ParsedMesh(Result::noData);
 	}
 
-	GLuint iboBaseOffset = iboEnd;
-	ImportMeshResult  result(Result::success);
+	GLuint iboBaseOffset = 0;
+	ParsedMesh parsed(Result::success);
+	ImportMeshResult& result = parsed.mesh;
 	result.meshes.reserve(count);
 	for (int i = 0; i < count; ++i) {
 	  Mesh m;
@@ -147,97 +274,46 @@ namespace Mesh {
 	  }
 	  result.meshes.push_back(m);
 	  if (p >= pEnd) {
-		return ImportMeshResult(Result::invalidMeshInfo);
+		return ParsedMesh(Result::invalidMeshInfo);
 	  }
 	}
 
-#ifdef SHOW_TANGENT_SPACE
-	const Vertex* pVBO = reinterpret_cast<const Vertex*>(reinterpret_cast<const void*>(p));
-#endif // SHOW_TANGENT_SPACE
-
-	glBufferSubData(GL_ARRAY_BUFFER, vboEnd, vboByteSize, p);
+	parsed.vboOffset = p - &data[0];
+	parsed.vboByteSize = vboByteSize;
 	p += vboByteSize;
 	if (p >= pEnd) {
-	  return ImportMeshResult(Result::invalidVBO);
-	}
-
-#ifdef SHOW_TANGENT_SPACE
-	const GLushort* pIBO = reinterpret_cast<const GLushort*>(reinterpret_cast<const void*>(p));
-#endif // SHOW_TANGENT_SPACE
-
-	std::vector<GLushort>  indices;
-	indices.reserve(iboByteSize / sizeof(GLushort));
-	const uint32_t offsetTmp = vboEnd / sizeof(Vertex);
-	if (offsetTmp > 0xffff) {
-	  return ImportMeshResult(Result::indexOverflow);
+	  return ParsedMesh(Result::invalidVBO);
 	}
-	const GLushort offset = static_cast<GLushort>(offsetTmp);
-	for (uint32_t i = 0; i < iboByteSize; i += sizeof(GLushort)) {
-	  indices.push_back(*reinterpret_cast<const GLushort*>(p) + offset);
-	  p += sizeof(GLushort);
-	  if (p >= pEnd) {
-		return ImportMeshResult(Result::invalidIBO);
-	  }
+	parsed.iboOffset = p - &data[0];
+	parsed.iboByteSize = iboByteSize;
+	p += iboByteSize;
+	if (p >= pEnd) {
+	  return ParsedMesh(Result::invalidIBO);
 	}
-	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, iboEnd, iboByteSize, &indices[0]);
 
-#ifdef SHOW_TANGENT_SPACE
-	if (vboTBN) {
+	{
+	  // the bounding radius of each mesh.
+	  const Vertex* pVBO = reinterpret_cast<const Vertex*>(reinterpret_cast<const void*>(&data[parsed.vboOffset]));
+	  const GLushort* pIBO = reinterpret_cast<const GLushort*>(reinterpret_cast<const void*>(&data[parsed.iboOffset]));
+	  const size_t vertexCount = vboByteSize / sizeof(Vertex);
 	  for (auto& m : result.meshes) {
-		std::vector<GLushort> indexList;
-		indexList.reserve(3000);
-		for (auto mm : m.materialList) {
-		  const GLushort* p = pIBO + (mm.iboOffset - iboEnd) / sizeof(GLushort);
-		  const GLushort* const end = p + mm.iboSize;
-		  indexList.insert(indexList.end(), p, end);
-		}
-		std::sort(indexList.begin(), indexList.end());
-		indexList.erase(std::unique(indexList.begin(), indexList.end()), indexList.end());
-
-		const size_t tbnCount = indexList.size() * 3 * 2;
-		if (vboTBNEnd + tbnCount * sizeof(TBNVertex) < vboTBNBufferSize) {
-		  m.vboTBNOffset = vboTBNEnd / sizeof(TBNVertex);
-		  m.vboTBNCount = tbnCount;
-		} else {
-		  m.vboTBNOffset = 0;
-		  m.vboTBNCount = 0;
-		  continue;
-		}
-
-		static const Color4B red(255, 0, 0, 255), green(0, 255, 0, 255), blue(0, 0, 255, 255);
-		static const float lentgh = 0.2f;
-		std::vector<TBNVertex> tbn;
-		tbn.reserve(tbnCount);
-		for (auto e : indexList) {
-		  const Vertex& v = *(pVBO + e);
-		  const Vector3F t = v.tangent.ToVec3();
-		  const Vector3F b = v.normal.Cross(t).Normalize() * v.tangent.w;
-		  tbn.push_back(TBNVertex(v.position, green, v.boneID, v.weight));
-		  tbn.push_back(TBNVertex(v.position + b * lentgh, green, v.boneID, v.weight));
-		  tbn.push_back(TBNVertex(v.position, red, v.boneID, v.weight));
-		  tbn.push_back(TBNVertex(v.position + t * lentgh, red, v.boneID, v.weight));
-		  tbn.push_back(TBNVertex(v.position, blue, v.boneID, v.weight));
-		  tbn.push_back(TBNVertex(v.position + v.normal * lentgh, blue, v.boneID, v.weight));
+		float radiusSq = 0.0f;
+		for (const auto& e : m.materialList) {
+		  const GLushort* pIndex = pIBO + e.iboOffset / sizeof(GLushort);
+		  for (const GLushort* const end = pIndex + e.iboSize; pIndex != end; ++pIndex) {
+			if (*pIndex < vertexCount) {
+			  const Position3F& v = pVBO[*pIndex].position;
+			  radiusSq = std::max(radiusSq, v.x * v.x + v.y * v.y + v.z * v.z);
+			}
+		  }
 		}
-		glBindBuffer(GL_ARRAY_BUFFER, vboTBN);
-		glBufferSubData(GL_ARRAY_BUFFER, vboTBNEnd, tbn.size() * sizeof(TBNVertex), &tbn[0]);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		vboTBNEnd += tbn.size() * sizeof(TBNVertex);
-	  }
-	} else {
-	  for (auto& m : result.meshes) {
-		m.vboTBNOffset = 0;
-		m.vboTBNCount = 0;
+		m.boundingRadius = std::sqrt(radiusSq);
 	  }
 	}
-#endif // SHOW_TANGENT_SPACE
-
-	vboEnd += vboByteSize;
-	iboEnd += iboByteSize;
 
 	p += (4 - (reinterpret_cast<intptr_t>(p) % 4)) % 4;
 	if (p >= pEnd) {
-	  return result;
+	  return parsed;
 	}
 
 	const uint32_t boneCount = GetValue(p, 2); p += 2;
@@ -250,7 +326,7 @@ namespace Mesh {
 	  parentIndexList.resize(boneCount);
 	  for (uint32_t i = 0; i < boneCount; ++i) {
 		if (p >= pEnd) {
-		  return ImportMeshResult(Result::invalidJointInfo);
+		  return ParsedMesh(Result::invalidJointInfo);
 		}
 		Joint& e = joints[i];
 		e.invBindPose.rot.x = GetFloat(p);
@@ -299,6 +375,16 @@ namespace Mesh {
 	  for (auto& e : result.meshes) {
 		e.jointList = joints;
 	  }
+	  if (boneCount > maxBonePaletteSize) {
+		const Vertex* pVBO = reinterpret_cast<const Vertex*>(reinterpret_cast<const void*>(&data[parsed.vboOffset]));
+		const GLushort* pIBO = reinterpret_cast<const GLushort*>(reinterpret_cast<const void*>(&data[parsed.iboOffset]));
+		const size_t vertexCount = vboByteSize / sizeof(Vertex);
+		if (!SplitBonePalette(pVBO, vertexCount, pIBO, iboByteSize / sizeof(GLushort), boneCount, maxBonePaletteSize, parsed)) {
+		  return ParsedMesh(Result::indexOverflow);
+		}
+		parsed.vboByteSize = static_cast<uint32_t>(parsed.vertexList.size() * sizeof(Vertex));
+		LOGI("ImportMesh - Split bone palette: %d joints, %d vertices added", boneCount, static_cast<int>(parsed.vertexList.size() - vertexCount));
+	  }
 	}
 
 	if (animationCount) {
@@ -327,7 +413,7 @@ namespace Mesh {
 #endif // DEBUG_LOG_VERBOSE
 		  for (uint32_t bone = 0; bone < boneCount; ++bone) {
 			if (p >= pEnd) {
-			  return ImportMeshResult(Result::invalidAnimationInfo);
+			  return ParsedMesh(Result::invalidAnimationInfo);
 			}
 			Animation::Element elem;
 			elem.time = time;
@@ -345,13 +431,136 @@ namespace Mesh {
 #endif // DEBUG_LOG_VERBOSE
 		  }
 		}
-		result.animations.push_back(anm);
+		const size_t rawByteSize = keyframeCount * boneCount * sizeof(Animation::Element);
+		anm.Compress(animationRotationTolerance, animationTranslationTolerance);
+		const size_t compressedByteSize = anm.clip.GetByteSize();
+		LOGI("%s: %d bytes -> %d bytes, %d bytes saved", anm.id.c_str(), static_cast<int>(rawByteSize), static_cast<int>(compressedByteSize), static_cast<int>(rawByteSize) - static_cast<int>(compressedByteSize));
+		result.animations.push_back(std::move(anm));
+	  }
+	}
+
+	return parsed;
+  }
+
+  /**
+  * Copy the geometry parsed by ParseMesh() to the buffer objects.
+  *
+  * The vertex and index buffer objects must be bound to GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER.
+  *
+  * @param data    The MSH data passed to ParseMesh().
+  * @param parsed  The result of ParseMesh(). Its mesh and animations are moved to the return value.
+  *
+  * @return If succeeded, ImportMeshResult::result is \e success.
+  *         Otherwise, it is an error code indicating the cause of the failure.
+  */
+#ifdef SHOW_TANGENT_SPACE
+  ImportMeshResult UploadMesh(const RawBuffer& data, ParsedMesh& parsed, GLuint& vbo, GLintptr& vboEnd, GLuint& ibo, GLintptr& iboEnd, GLuint vboTBN, GLintptr& vboTBNEnd)
+#else
+  ImportMeshResult UploadMesh(const RawBuffer& data, ParsedMesh& parsed, GLuint& vbo, GLintptr& vboEnd, GLuint& ibo, GLintptr& iboEnd)
+#endif //  SHOW_TANGENT_SPACE
+  {
+	if (parsed.mesh.result != Result::success) {
+	  return ImportMeshResult(parsed.mesh.result);
+	}
+	const uint32_t offsetTmp = vboEnd / sizeof(Vertex);
+	if (offsetTmp > 0xffff) {
+	  return ImportMeshResult(Result::indexOverflow);
+	}
+	const GLushort offset = static_cast<GLushort>(offsetTmp);
+	const uint32_t vboByteSize = parsed.vboByteSize;
+	const uint32_t iboByteSize = parsed.iboByteSize;
+	const Vertex* pVBO = parsed.vertexList.empty() ? reinterpret_cast<const Vertex*>(reinterpret_cast<const void*>(&data[parsed.vboOffset])) : &parsed.vertexList[0];
+	const GLushort* pIBO = parsed.indexList.empty() ? reinterpret_cast<const GLushort*>(reinterpret_cast<const void*>(&data[parsed.iboOffset])) : &parsed.indexList[0];
+
+	glBufferSubData(GL_ARRAY_BUFFER, vboEnd, vboByteSize, pVBO);
+	std::vector<GLushort>  indices(pIBO, pIBO + iboByteSize / sizeof(GLushort));
+	for (auto& e : indices) {
+	  e += offset;
+	}
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, iboEnd, iboByteSize, &indices[0]);
+
+	ImportMeshResult result(std::move(parsed.mesh));
+	for (auto& m : result.meshes) {
+	  for (auto& e : m.materialList) {
+		e.iboOffset += iboEnd;
+	  }
+	}
+
+#ifdef SHOW_TANGENT_SPACE
+	if (vboTBN) {
+	  for (auto& m : result.meshes) {
+		std::vector<GLushort> indexList;
+		indexList.reserve(3000);
+		for (auto mm : m.materialList) {
+		  const GLushort* p = pIBO + (mm.iboOffset - iboEnd) / sizeof(GLushort);
+		  const GLushort* const end = p + mm.iboSize;
+		  indexList.insert(indexList.end(), p, end);
+		}
+		std::sort(indexList.begin(), indexList.end());
+		indexList.erase(std::unique(indexList.begin(), indexList.end()), indexList.end());
+
+		const size_t tbnCount = indexList.size() * 3 * 2;
+		if (vboTBNEnd + tbnCount * sizeof(TBNVertex) < vboTBNBufferSize) {
+		  m.vboTBNOffset = vboTBNEnd / sizeof(TBNVertex);
+		  m.vboTBNCount = tbnCount;
+		} else {
+		  m.vboTBNOffset = 0;
+		  m.vboTBNCount = 0;
+		  continue;
+		}
+
+		static const Color4B red(255, 0, 0, 255), green(0, 255, 0, 255), blue(0, 0, 255, 255);
+		static const float lentgh = 0.2f;
+		std::vector<TBNVertex> tbn;
+		tbn.reserve(tbnCount);
+		for (auto e : indexList) {
+		  const Vertex& v = *(pVBO + e);
+		  const Vector3F t = v.tangent.ToVec3();
+		  const Vector3F b = v.normal.Cross(t).Normalize() * v.tangent.w;
+		  tbn.push_back(TBNVertex(v.position, green, v.boneID, v.weight));
+		  tbn.push_back(TBNVertex(v.position + b * lentgh, green, v.boneID, v.weight));
+		  tbn.push_back(TBNVertex(v.position, red, v.boneID, v.weight));
+		  tbn.push_back(TBNVertex(v.position + t * lentgh, red, v.boneID, v.weight));
+		  tbn.push_back(TBNVertex(v.position, blue, v.boneID, v.weight));
+		  tbn.push_back(TBNVertex(v.position + v.normal * lentgh, blue, v.boneID, v.weight));
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, vboTBN);
+		glBufferSubData(GL_ARRAY_BUFFER, vboTBNEnd, tbn.size() * sizeof(TBNVertex), &tbn[0]);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		vboTBNEnd += tbn.size() * sizeof(TBNVertex);
+	  }
+	} else {
+	  for (auto& m : result.meshes) {
+		m.vboTBNOffset = 0;
+		m.vboTBNCount = 0;
 	  }
 	}
+#endif // SHOW_TANGENT_SPACE
 
+	vboEnd += vboByteSize;
+	iboEnd += iboByteSize;
 	return result;
   }
 
+  /**
+  * Import the mesh from MSH data to the buffer objects.
+  *
+  * This is same as UploadMesh(ParseMesh()).
+  */
+#ifdef SHOW_TANGENT_SPACE
+  ImportMeshResult ImportMesh(const RawBuffer& data, size_t maxBonePaletteSize, GLuint& vbo, GLintptr& vboEnd, GLuint& ibo, GLintptr& iboEnd, GLuint vboTBN, GLintptr& vboTBNEnd)
+  {
+	ParsedMesh parsed = ParseMesh(data, maxBonePaletteSize);
+	return UploadMesh(data, parsed, vbo, vboEnd, ibo, iboEnd, vboTBN, vboTBNEnd);
+  }
+#else
+  ImportMeshResult ImportMesh(const RawBuffer& data, size_t maxBonePaletteSize, GLuint& vbo, GLintptr& vboEnd, GLuint& ibo, GLintptr& iboEnd)
+  {
+	ParsedMesh parsed = ParseMesh(data, maxBonePaletteSize);
+	return UploadMesh(data, parsed, vbo, vboEnd, ibo, iboEnd);
+  }
+#endif //  SHOW_TANGENT_SPACE
+
   /**
   * Import tha geometry from MSH data.
   *
@@ -6,6 +6,7 @@
 #include "../../Shared/Quaternion.h"
 #include "../../Shared/Matrix.h"
 #include "texture.h"
+#include "AnimationClip.h"
 #include <vector>
 
 namespace Mai {
@@ -20,12 +21,12 @@ typedef std::vector<uint8_t> RawBuffer;
 * The vertex format.
 */
 struct Vertex {
-  Position3F  position; ///< _W. 12
-  GLubyte     weight[4]; ///< _ufBȌd. 255 = 1.0Ƃėʎqli[. 4
-  Vector3F    normal; ///< _m[}. 12
-  GLubyte     boneID[4]; ///< _ufBÕ{[ID. 4
-  Position2S  texCoord[VERTEX_TEXTURE_COUNT_MAX]; ///< fBt[Y(with^lX)}bvW, m[}(withtlX)}bvW. 8
-  Vector4F    tangent; ///< _^WFg. 16
+  Position3F  position; ///< 頂点座標. 12
+  GLubyte     weight[4]; ///< 頂点ブレンディングの重み. 255 = 1.0として量子化した値を格納する. 4
+  Vector3F    normal; ///< 頂点ノーマル. 12
+  GLubyte     boneID[4]; ///< 頂点ブレンディングのボーンID. 4
+  Position2S  texCoord[VERTEX_TEXTURE_COUNT_MAX]; ///< ディフューズ(withメタルネス)マップ座標, ノーマル(withラフネス)マップ座標. 8
+  Vector4F    tangent; ///< 頂点タンジェント. 16
 
   Vertex() {}
 };
@@ -69,13 +70,13 @@ struct RotTrans {
 Matrix4x3 ToMatrix(const RotTrans& rt);
 
 /**
-* 1. eWCǧ݂̎pvZ(initialɃAj[Vɂs|). ̍s̓WCg[JȕϊsƂȂ.
-* 2. WCg[JȕϊsɁAg烋[gWCg܂ł̑SĂ̐e̎ps|邱ƂŁAf[Jȕϊs𓾂.
-* 3. f[JȕϊsɋtoCh|[Ys|AŏIIȕϊs𓾂.
-* ̕ϊśAf[JWnɂ钸_WCg[JWnɈړA
-* ݂̎pɂĕϊAĂуf[JWnɖ߂Ƃs.
+* 1. 各ジョイントの現在の姿勢を計算する(initialにアニメーション等による行列を掛ける). この行列はジョイントローカルな変換行列となる.
+* 2. ジョイントローカルな変換行列に、自身からルートジョイントまでの全ての親の姿勢行列を掛けることで、モデルローカルな変換行列を得る.
+* 3. モデルローカルな変換行列に逆バインドポーズ行列を掛け、最終的な変換行列を得る.
+* この変換行列は、モデルローカル座標系にある頂点をジョイントローカル座標系に移動し、
+* 現在の姿勢によって変換し、再びモデルローカル座標系に戻すという操作を行う.
 *
-* toCh|[Ys = Inverse(ps)
+* 逆バインドポーズ行列 = Inverse(初期姿勢行列)
 */
 struct Joint {
   RotTrans invBindPose;
@@ -89,6 +90,7 @@ typedef std::vector<Joint> JointList;
 * An animation data.
 *
 * It hold one animation data.
+* The importer stores the raw keys to \e data, and Compress() converts them to \e clip.
 */
 struct Animation {
   struct Element {
@@ -96,14 +98,14 @@ struct Animation {
 	GLfloat time;
   };
   typedef std::pair<int/* index of the target joint */, std::vector<Element>/* the animation sequence */ > ElementList;
-  typedef std::pair<const Element*, const Element*> ElementPair;
 
   std::string id;
   GLfloat totalTime;
   bool loopFlag;
-  std::vector<ElementList> data;
+  std::vector<ElementList> data; ///< The raw keys. It is empty after Compress().
+  AnimationClip clip; ///< The compressed keys.
 
-  ElementPair GetElementByTime(int index, float t) const;
+  void Compress(float rotTolerance, float transTolerance);
 };
 
 /**
@@ -118,9 +120,9 @@ namespace Mesh {
   * Each range is composed an offset and size.
   */
   struct Mesh {
-	Mesh() {}
-	Mesh(const std::string& name, int32_t offset, int32_t size) : id(name) {
-	  materialList.push_back({ Material(Color4B(255, 255, 255, 255), 0, 1), offset, size });
+	Mesh() : texCoordScaleOffset(1, 1, 0, 0), boundingRadius(0) {}
+	Mesh(const std::string& name, int32_t offset, int32_t size) : id(name), texCoordScaleOffset(1, 1, 0, 0), boundingRadius(0) {
+	  materialList.push_back({ Material(Color4B(255, 255, 255, 255), 0, 1), offset, size, 0 });
 #ifdef SHOW_TANGENT_SPACE
 	  vboTBNOffset = 0;
 	  vboTBNCount = 0;
@@ -136,14 +138,19 @@ namespace Mesh {
 	  Material material;
 	  int32_t iboOffset;
 	  int32_t iboSize;
+	  int32_t bonePalette; ///< The index of bonePaletteList. It is used only if bonePaletteList isn't empty.
 	};
+	typedef std::vector<GLushort> BonePalette; ///< The joint index of each bone ID in the vertices.
 
 	std::vector<MeshMaterial> materialList;
 	std::string id;
 	std::vector<std::string> jointNameList;
 	JointList jointList;
+	std::vector<BonePalette> bonePaletteList; ///< Empty if the bone IDs are the joint indices.
 	Texture::TexturePtr texDiffuse;
 	Texture::TexturePtr texNormal;
+	Vector4F texCoordScaleOffset; ///< The region of the textures in the atlas. xy: scale, zw: offset.
+	float boundingRadius; ///< The radius of the sphere around the origin that contains the vertices in the bind pose. 0 means unknown.
 #ifdef SHOW_TANGENT_SPACE
 	int32_t vboTBNOffset;
 	int32_t vboTBNCount;
@@ -181,19 +188,41 @@ namespace Mesh {
 	std::vector<Animation> animations;
   };
 
+  /**
+  * The result type of ParseMesh().
+  *
+  * The geometry isn't copied, so it refers the range of the MSH data by the offsets.
+  *
+  * @sa ParseMesh(), UploadMesh()
+  */
+  struct ParsedMesh {
+	explicit ParsedMesh(Result r) : vboOffset(0), vboByteSize(0), iboOffset(0), iboByteSize(0), mesh(r) {}
+
+	size_t vboOffset; ///< The offset of the vertex data in the MSH data.
+	uint32_t vboByteSize;
+	size_t iboOffset; ///< The offset of the index data in the MSH data.
+	uint32_t iboByteSize;
+	ImportMeshResult mesh; ///< The index offsets of the materials are relative to the top of the index data.
+	std::vector<Vertex> vertexList; ///< The vertices rewritten by the bone palette splitting. If empty, the MSH data is used.
+	std::vector<GLushort> indexList; ///< The indices rewritten by the bone palette splitting. If empty, the MSH data is used.
+  };
+
+  ParsedMesh ParseMesh(const RawBuffer& data, size_t maxBonePaletteSize);
 #ifdef SHOW_TANGENT_SPACE
-  ImportMeshResult ImportMesh(const RawBuffer& data, GLuint& vbo, GLintptr& vboEnd, GLuint& ibo, GLintptr& iboEnd, GLuint vboTBN, GLintptr& vboTBNEnd);
+  ImportMeshResult UploadMesh(const RawBuffer& data, ParsedMesh& parsed, GLuint& vbo, GLintptr& vboEnd, GLuint& ibo, GLintptr& iboEnd, GLuint vboTBN, GLintptr& vboTBNEnd);
+  ImportMeshResult ImportMesh(const RawBuffer& data, size_t maxBonePaletteSize, GLuint& vbo, GLintptr& vboEnd, GLuint& ibo, GLintptr& iboEnd, GLuint vboTBN, GLintptr& vboTBNEnd);
 #else
-  ImportMeshResult ImportMesh(const RawBuffer& data, GLuint& vbo, GLintptr& vboEnd, GLuint& ibo, GLintptr& iboEnd);
+  ImportMeshResult UploadMesh(const RawBuffer& data, ParsedMesh& parsed, GLuint& vbo, GLintptr& vboEnd, GLuint& ibo, GLintptr& iboEnd);
+  ImportMeshResult ImportMesh(const RawBuffer& data, size_t maxBonePaletteSize, GLuint& vbo, GLintptr& vboEnd, GLuint& ibo, GLintptr& iboEnd);
 #endif // SHOW_TANGENT_SPACE
 
   /**
   * The vertex data structure for Geometry.
   */
   struct SimpleVertex {
-	Position3F  position; ///< _W. 12
-	Vector3F    normal; ///< _m[}. 12
-	Vector4F    tangent; ///< _^WFg. 16
+	Position3F  position; ///< 頂点座標. 12
+	Vector3F    normal; ///< 頂点ノーマル. 12
+	Vector4F    tangent; ///< 頂点タンジェント. 16
   };
 
   /**
@@ -0,0 +1,218 @@
+#include "ObjectStore.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Mai {
+
+  namespace {
+
+	/** Get the bounding radius of the mesh scaled by the object.
+	*/
+	float GetScaledBoundingRadius(const Mesh::Mesh* m, const Vector3F& s)
+	{
+	  if (!m) {
+		return 0.0f;
+	  }
+	  return m->boundingRadius * std::max(std::abs(s.x), std::max(std::abs(s.y), std::abs(s.z)));
+	}
+
+  } // unnamed namespace
+
+  /** Add the object.
+
+    @param rt   The rotation and the translation.
+	@param m    The mesh. nullptr means no mesh.
+	@param mat  The material.
+	@param s    The shader. nullptr means no shader.
+	@param shaderId  The name of the shader. It is used to resolve the shader again after ResetHandles().
+	@param sc   The shadow capability.
+
+	@return The ID of the new object.
+  */
+  ObjectId ObjectStore::Add(const RotTrans& rt, const Mesh::Mesh* m, const Material& mat, const Shader* s, const std::string& shaderId, ShadowCapability sc)
+  {
+	ObjectId id;
+	if (!freeList.empty()) {
+	  id = freeList.back();
+	  freeList.pop_back();
+	} else {
+	  id = static_cast<ObjectId>(rotTransList.size());
+	  rotTransList.push_back(rt);
+	  localRotTransList.push_back(rt);
+	  parentList.push_back(invalidObjectId);
+	  worldVersionList.push_back(0);
+	  parentVersionList.push_back(0);
+	  dirtyList.push_back(0);
+	  scaleList.push_back(Vector3F(1, 1, 1));
+	  boundingRadiusList.push_back(0.0f);
+	  materialList.push_back(mat);
+	  meshList.push_back(nullptr);
+	  shaderList.push_back(nullptr);
+	  meshIdList.push_back(std::string());
+	  shaderIdList.push_back(std::string());
+	  validList.push_back(0);
+	  shadowCapabilityList.push_back(sc);
+	  boneList.push_back(std::vector<Matrix4x3>());
+	  boneDualQuaternionList.push_back(std::vector<Vector4F>());
+	  boneModelMatrixList.push_back(Matrix4x3::Unit());
+	}
+	rotTransList[id] = rt;
+	parentList[id] = invalidObjectId;
+	++worldVersionList[id];
+	dirtyList[id] = 0;
+	scaleList[id] = Vector3F(1, 1, 1);
+	boundingRadiusList[id] = GetScaledBoundingRadius(m, scaleList[id]);
+	materialList[id] = mat;
+	meshList[id] = m;
+	shaderList[id] = s;
+	meshIdList[id] = m ? m->id : "";
+	shaderIdList[id] = shaderId;
+	validList[id] = m && s;
+	shadowCapabilityList[id] = sc;
+	const size_t jointCount = m ? m->jointList.size() : 0;
+	boneList[id].assign(jointCount, Matrix4x3::Unit());
+	boneDualQuaternionList[id].assign(jointCount * 2, Vector4F(0, 0, 0, 0));
+	for (size_t i = 0; i < boneDualQuaternionList[id].size(); i += 2) {
+	  boneDualQuaternionList[id][i].w = 1;
+	}
+	boneModelMatrixList[id] = Matrix4x3::Unit();
+	return id;
+  }
+
+  /** Remove the object.
+
+    The slot is reused by the next Add(). The children of the object are detached
+	with keeping their world transforms.
+
+	@param id  The ID of the object.
+  */
+  void ObjectStore::Remove(ObjectId id)
+  {
+	SetParent(id, invalidObjectId);
+	for (size_t i = 0; i < hierarchyOrder.size();) {
+	  if (parentList[hierarchyOrder[i]] == id) {
+		SetParent(hierarchyOrder[i], invalidObjectId);
+	  } else {
+		++i;
+	  }
+	}
+	meshList[id] = nullptr;
+	shaderList[id] = nullptr;
+	validList[id] = 0;
+	std::vector<Matrix4x3>().swap(boneList[id]);
+	std::vector<Vector4F>().swap(boneDualQuaternionList[id]);
+	freeList.push_back(id);
+  }
+
+  /** Set the parent of the object.
+
+    When the object is attached, its current world transform is used as the transform
+	relative to the parent. When it is detached, its world transform is kept.
+
+	@param id      The ID of the object.
+	@param parent  The ID of the parent. invalidObjectId detaches the object.
+
+	@retval true   The parent is changed.
+	@retval false  \e parent is \e id or its descendant.
+  */
+  bool ObjectStore::SetParent(ObjectId id, ObjectId parent)
+  {
+	for (ObjectId p = parent; p != invalidObjectId; p = parentList[p]) {
+	  if (p == id) {
+		return false;
+	  }
+	}
+	if (parentList[id] == parent) {
+	  return true;
+	}
+	const RotTrans current = GetRotTrans(id);
+	if (parent == invalidObjectId) {
+	  hierarchyOrder.erase(std::find(hierarchyOrder.begin(), hierarchyOrder.end(), id));
+	  rotTransList[id] = current;
+	  ++worldVersionList[id];
+	} else {
+	  if (parentList[id] == invalidObjectId) {
+		hierarchyOrder.push_back(id);
+	  }
+	  localRotTransList[id] = current;
+	  dirtyList[id] = 1;
+	}
+	parentList[id] = parent;
+	isHierarchyOrderDirty = true;
+	return true;
+  }
+
+  /** Recompute the world transforms of all children.
+
+    hierarchyOrder is sorted by the depth only when the hierarchy is changed,
+	so each child finds that its parent is already up to date.
+  */
+  void ObjectStore::UpdateTransforms()
+  {
+	if (isHierarchyOrderDirty) {
+	  const auto getDepth = [this](ObjectId id) {
+		int depth = 0;
+		for (ObjectId p = parentList[id]; p != invalidObjectId; p = parentList[p]) {
+		  ++depth;
+		}
+		return depth;
+	  };
+	  std::stable_sort(hierarchyOrder.begin(), hierarchyOrder.end(), [&getDepth](ObjectId lhs, ObjectId rhs) {
+		return getDepth(lhs) < getDepth(rhs);
+	  });
+	  isHierarchyOrderDirty = false;
+	}
+	for (ObjectId id : hierarchyOrder) {
+	  UpdateRotTrans(id);
+	}
+  }
+
+  /** Recompute the world transform of the child if it is out of date.
+
+    @param id  The ID of the object that has the parent.
+  */
+  void ObjectStore::UpdateRotTrans(ObjectId id)
+  {
+	const ObjectId parent = parentList[id];
+	const RotTrans& parentRotTrans = GetRotTrans(parent);
+	if (dirtyList[id] || parentVersionList[id] != worldVersionList[parent]) {
+	  rotTransList[id] = parentRotTrans * localRotTransList[id];
+	  parentVersionList[id] = worldVersionList[parent];
+	  dirtyList[id] = 0;
+	  ++worldVersionList[id];
+	}
+  }
+
+  /** Drop the cached mesh and shader pointers.
+
+    This must be called before the renderer releases the meshes and the shaders.
+  */
+  void ObjectStore::ResetHandles()
+  {
+	std::fill(meshList.begin(), meshList.end(), nullptr);
+	std::fill(shaderList.begin(), shaderList.end(), nullptr);
+  }
+
+  /** Set the scale of the object.
+
+    @param id  The ID of the object.
+	@param s   The scale.
+  */
+  void ObjectStore::SetScale(ObjectId id, const Vector3F& s)
+  {
+	scaleList[id] = s;
+	boundingRadiusList[id] = GetScaledBoundingRadius(meshList[id], s);
+  }
+
+  /** Set the resolved mesh of the object.
+
+    @param id  The ID of the object.
+	@param m   The mesh that has the same name as meshIdList[id].
+  */
+  void ObjectStore::SetMesh(ObjectId id, const Mesh::Mesh* m)
+  {
+	meshList[id] = m;
+	boundingRadiusList[id] = GetScaledBoundingRadius(m, scaleList[id]);
+  }
+
+} // namespace Mai
@@ -0,0 +1,119 @@
+#ifndef OBJECTSTORE_H_INCLUDED
+#define OBJECTSTORE_H_INCLUDED
+#include "Mesh.h"
+#include "../../Shared/Vector.h"
+#include "../../Shared/Quaternion.h"
+#include "../../Shared/Matrix.h"
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <assert.h>
+
+namespace Mai {
+
+  struct Shader;
+
+  typedef uint32_t ObjectId; ///< The index of the object in ObjectStore.
+  static const ObjectId invalidObjectId = 0xffffffff;
+
+  /// Whether the object casts the shadow.
+  enum class ShadowCapability : int8_t {
+	Disable, ///< Not drawn in the shadow pass.
+	Enable, ///< Drawn in the shadow pass and the color pass.
+	ShadowOnly, ///< Drawn only in the shadow pass.
+  };
+
+  /** The storage of the object states in the structure of arrays.
+
+    Each object has a slot in the arrays, and it is identified by ObjectId.
+	The ID is stable while the object is alive, and it is reused after Remove().
+	Object is the handle of the slot. The renderer takes the IDs, and the culling and
+	the submission read the arrays by the ID instead of chasing the pointer of each object.
+	The bones are kept here too, so only the animation state stays in Object.
+
+	The mesh and the shader are cached as the pointers. They are dropped by ResetHandles()
+	when the renderer releases the resources, and resolved again by the name.
+
+	The object can have the parent. The transform of the child is set to localRotTransList,
+	and the world transform in rotTransList is recomputed lazily by GetRotTrans() when
+	the local transform or the world transform of the parent has changed.
+	UpdateTransforms() resolves all children in one linear pass sorted by the depth.
+
+	The store must outlive all objects that refer it. The destructor checks that
+	all slots have been removed.
+  */
+  class ObjectStore {
+  public:
+	ObjectStore() : isHierarchyOrderDirty(false) {}
+	~ObjectStore() { assert(Size() == 0 && "ObjectPtr must be released before ObjectStore"); }
+	ObjectStore(const ObjectStore&) = delete;
+	ObjectStore& operator=(const ObjectStore&) = delete;
+	ObjectId Add(const RotTrans& rt, const Mesh::Mesh* m, const Material& mat, const Shader* s, const std::string& shaderId, ShadowCapability sc);
+	void Remove(ObjectId id);
+	bool SetParent(ObjectId id, ObjectId parent);
+	void UpdateTransforms();
+
+	/** Get the world transform.
+
+	  @param id  The ID of the object.
+
+	  @return The world transform. If the object has the parent, it is recomputed if needed.
+	*/
+	const RotTrans& GetRotTrans(ObjectId id) {
+	  if (parentList[id] != invalidObjectId) {
+		UpdateRotTrans(id);
+	  }
+	  return rotTransList[id];
+	}
+
+	/** Get the transform to modify.
+
+	  @param id  The ID of the object.
+
+	  @return The transform relative to the parent, or the world transform if the object has no parent.
+	*/
+	RotTrans& GetLocalRotTrans(ObjectId id) {
+	  if (parentList[id] != invalidObjectId) {
+		dirtyList[id] = 1;
+		return localRotTransList[id];
+	  }
+	  ++worldVersionList[id];
+	  return rotTransList[id];
+	}
+
+	void ResetHandles();
+	void SetScale(ObjectId id, const Vector3F& s);
+	void SetMesh(ObjectId id, const Mesh::Mesh* m);
+	size_t Size() const { return rotTransList.size() - freeList.size(); }
+	size_t Capacity() const { return rotTransList.size(); }
+
+	std::vector<RotTrans> rotTransList; ///< The world transform.
+	std::vector<RotTrans> localRotTransList; ///< The transform relative to the parent. It is used only if the object has the parent.
+	std::vector<ObjectId> parentList; ///< invalidObjectId if the object has no parent.
+	std::vector<uint32_t> worldVersionList; ///< It is incremented when the world transform is changed.
+	std::vector<uint32_t> parentVersionList; ///< The world version of the parent when the world transform was computed.
+	std::vector<uint8_t> dirtyList; ///< Non zero if the local transform is changed after the world transform was computed.
+	std::vector<Vector3F> scaleList;
+	std::vector<float> boundingRadiusList; ///< The bounding radius of the mesh scaled by the object. 0 means unknown.
+	std::vector<Material> materialList;
+	std::vector<const Mesh::Mesh*> meshList; ///< nullptr if the mesh isn't resolved.
+	std::vector<const Shader*> shaderList; ///< nullptr if the shader isn't resolved.
+	std::vector<std::string> meshIdList; ///< The name to resolve the mesh.
+	std::vector<std::string> shaderIdList; ///< The name to resolve the shader.
+	std::vector<uint8_t> validList; ///< Non zero if the object was created with the mesh and the shader.
+	std::vector<ShadowCapability> shadowCapabilityList;
+	std::vector<std::vector<Matrix4x3>> boneList; ///< The bone matrices of the skinned mesh. Empty if the mesh has no joint.
+	std::vector<std::vector<Vector4F>> boneDualQuaternionList; ///< The real and the dual parts of each joint for the dual quaternion skinning.
+	std::vector<Matrix4x3> boneModelMatrixList; ///< The model matrix for the dual quaternion skinning.
+
+  private:
+	void UpdateRotTrans(ObjectId id);
+
+	std::vector<ObjectId> freeList; ///< The removed slots.
+	std::vector<ObjectId> hierarchyOrder; ///< The objects that have the parent. The parent precedes its children.
+	bool isHierarchyOrderDirty; ///< true if hierarchyOrder needs to be sorted.
+  };
+
+} // namespace Mai
+
+#endif // OBJECTSTORE_H_INCLUDED
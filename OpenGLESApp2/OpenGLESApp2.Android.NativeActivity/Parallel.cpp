@@ -0,0 +1,171 @@
+#include "Parallel.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+namespace Mai {
+
+  namespace {
+
+	const size_t blocksPerThread = 4; ///< Divide the range more finely than the threads to balance the load.
+
+	/** The range shared by the calling thread and the workers.
+
+	  The blocks are taken by 'nextBlock' in any order, and 'userCount' is the number of
+	  the workers that refer this job. It is owned by the caller of ParallelFor(), so
+	  the caller waits until all blocks are done and no worker refers it.
+	*/
+	struct Job {
+	  const std::function<void(size_t begin, size_t end)>* func;
+	  size_t count;
+	  size_t blockSize;
+	  size_t blockCount;
+	  std::atomic<size_t> nextBlock;
+	  std::atomic<size_t> doneBlock;
+	  int userCount; ///< guarded by WorkerPool::mutex.
+	};
+
+	/// Process the blocks of the job until no block is left.
+	void RunBlocks(Job& job)
+	{
+	  for (;;) {
+		const size_t i = job.nextBlock.fetch_add(1);
+		if (i >= job.blockCount) {
+		  return;
+		}
+		const size_t begin = i * job.blockSize;
+		(*job.func)(begin, std::min(begin + job.blockSize, job.count));
+		job.doneBlock.fetch_add(1);
+	  }
+	}
+
+	/** The persistent worker threads of ParallelFor().
+
+	  The threads are created at the first call of ParallelFor(), and kept until the exit.
+	  Since the caller also processes the blocks, the job is completed even if all workers
+	  are busy. So ParallelFor() can be called from the multiple threads, including
+	  the workers of AssetLoader.
+	*/
+	class WorkerPool
+	{
+	public:
+	  explicit WorkerPool(size_t threadCount) : isStopping(false) {
+		threadList.reserve(threadCount);
+		for (size_t i = 0; i < threadCount; ++i) {
+		  threadList.emplace_back(&WorkerPool::Work, this);
+		}
+	  }
+
+	  ~WorkerPool() {
+		{
+		  std::lock_guard<std::mutex> lock(mutex);
+		  isStopping = true;
+		}
+		condition.notify_all();
+		for (auto& e : threadList) {
+		  e.join();
+		}
+	  }
+
+	  void Run(Job& job) {
+		{
+		  std::lock_guard<std::mutex> lock(mutex);
+		  jobList.push_back(&job);
+		}
+		condition.notify_all();
+		RunBlocks(job);
+		std::unique_lock<std::mutex> lock(mutex);
+		const auto itr = std::find(jobList.begin(), jobList.end(), &job);
+		if (itr != jobList.end()) {
+		  jobList.erase(itr);
+		}
+		doneCondition.wait(lock, [&job]() { return job.userCount == 0 && job.doneBlock.load() == job.blockCount; });
+	  }
+
+	private:
+	  void Work() {
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;) {
+		  condition.wait(lock, [this]() { return isStopping || !jobList.empty(); });
+		  if (isStopping) {
+			return;
+		  }
+		  Job* pJob = jobList.front();
+		  if (pJob->nextBlock.load() >= pJob->blockCount) {
+			jobList.pop_front();
+			continue;
+		  }
+		  ++pJob->userCount;
+		  lock.unlock();
+		  RunBlocks(*pJob);
+		  lock.lock();
+		  --pJob->userCount;
+		  const auto itr = std::find(jobList.begin(), jobList.end(), pJob);
+		  if (itr != jobList.end()) {
+			jobList.erase(itr);
+		  }
+		  doneCondition.notify_all();
+		}
+	  }
+
+	private:
+	  std::vector<std::thread> threadList;
+	  std::mutex mutex;
+	  std::condition_variable condition;
+	  std::condition_variable doneCondition;
+	  std::deque<Job*> jobList; ///< The jobs that may have the remaining blocks.
+	  bool isStopping;
+	};
+
+	WorkerPool& GetWorkerPool()
+	{
+	  static WorkerPool pool(GetHardwareThreadCount() - 1);
+	  return pool;
+	}
+
+  } // unnamed namespace
+
+  /** Get the number of the threads that can run concurrently.
+
+    @return The number of the hardware threads. It is 1 at least.
+  */
+  size_t GetHardwareThreadCount()
+  {
+	return std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+
+  /** Run the function over the range [0, count) on the multiple threads.
+
+    The range is divided into the contiguous blocks, and they are processed by
+	the persistent worker threads and the calling thread. This function returns
+	after all blocks have been processed.
+
+	@param count  The number of the elements.
+	@param func   The function that processes the elements [begin, end).
+  */
+  void ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& func)
+  {
+	const size_t threadCount = std::min(GetHardwareThreadCount(), count);
+	if (threadCount <= 1) {
+	  if (count) {
+		func(0, count);
+	  }
+	  return;
+	}
+	const size_t blockCount = std::min(count, threadCount * blocksPerThread);
+	Job job;
+	job.func = &func;
+	job.count = count;
+	job.blockSize = (count + blockCount - 1) / blockCount;
+	job.blockCount = (count + job.blockSize - 1) / job.blockSize;
+	job.nextBlock = 0;
+	job.doneBlock = 0;
+	job.userCount = 0;
+	GetWorkerPool().Run(job);
+  }
+
+} // namespace Mai
@@ -0,0 +1,13 @@
+#ifndef PARALLEL_H_INCLUDED
+#define PARALLEL_H_INCLUDED
+#include <functional>
+#include <stddef.h>
+
+namespace Mai {
+
+  size_t GetHardwareThreadCount();
+  void ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& func);
+
+} // namespace Mai
+
+#endif // PARALLEL_H_INCLUDED
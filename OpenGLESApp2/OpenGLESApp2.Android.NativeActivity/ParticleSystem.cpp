@@ -0,0 +1,383 @@
+#include "ParticleSystem.h"
+#include <boost/random/uniform_real_distribution.hpp>
+#include <algorithm>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PARTICLE_USE_NEON
+#elif defined(__SSE__) || defined(_M_IX86) || defined(_M_X64)
+#include <xmmintrin.h>
+#define PARTICLE_USE_SSE
+#endif
+
+namespace Mai {
+
+  namespace {
+
+	const size_t defaultMaxEmissionPerFrame = 256;
+	const size_t defaultMaxTotalParticleCount = ParticleSystem::maxParticleCount * ParticleMaterial_Count;
+
+	const ParticleEmitterParameter effectParameterList[] = {
+	  // ParticleEffect_CheckPoint
+	  {
+		ParticleMaterial_Additive,
+		Vector3F(0, 0, 0), Vector3F(24, 6, 24), Vector3F(4, 1, 4), Vector3F(0, 0, 0),
+		0.8f, 0.4f,
+		1.2f, 0.1f,
+		Color4B(255, 220, 120, 255), Color4B(255, 120, 40, 0),
+		0.0f, 0.0f, 192
+	  },
+	  // ParticleEffect_EggBreak
+	  {
+		ParticleMaterial_Alpha,
+		Vector3F(0, 5, 0), Vector3F(4, 3, 4), Vector3F(0.5f, 0.2f, 0.5f), Vector3F(0, -9.8f, 0),
+		1.0f, 0.3f,
+		0.12f, 0.08f,
+		Color4B(255, 250, 235, 255), Color4B(240, 230, 210, 0),
+		0.0f, 0.0f, 64
+	  },
+	  // ParticleEffect_Wind
+	  {
+		ParticleMaterial_Alpha,
+		Vector3F(0, 0, 0), Vector3F(0.5f, 0.5f, 0.5f), Vector3F(12, 4, 12), Vector3F(0, 0, 0),
+		0.6f, 0.2f,
+		0.25f, 0.25f,
+		Color4B(255, 255, 255, 96), Color4B(255, 255, 255, 0),
+		48.0f, -1.0f, 0
+	  },
+	};
+	static_assert(sizeof(effectParameterList) / sizeof(effectParameterList[0]) == ParticleEffect_Count, "effectParameterList should have all effects");
+
+	/** Calculate dst[i] += src[i] * k.
+
+	  @param dst  The destination array.
+	  @param src  The source array.
+	  @param k    The coefficient.
+	  @param n    The element count.
+	*/
+	void MultiplyAdd(float* dst, const float* src, float k, size_t n)
+	{
+	  size_t i = 0;
+#if defined(PARTICLE_USE_NEON)
+	  const float32x4_t kk = vdupq_n_f32(k);
+	  for (; i + 4 <= n; i += 4) {
+		vst1q_f32(dst + i, vmlaq_f32(vld1q_f32(dst + i), vld1q_f32(src + i), kk));
+	  }
+#elif defined(PARTICLE_USE_SSE)
+	  const __m128 kk = _mm_set1_ps(k);
+	  for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), kk)));
+	  }
+#endif
+	  for (; i < n; ++i) {
+		dst[i] += src[i] * k;
+	  }
+	}
+
+	GLubyte Lerp(GLubyte a, GLubyte b, int t) {
+	  return static_cast<GLubyte>(a + (((b - a) * t) >> 8));
+	}
+
+  } // unnamed namespace
+
+  /** Get the parameter of the predefined effect.
+
+    @param e  The effect type.
+
+	@return The emitter parameter of 'e'.
+  */
+  const ParticleEmitterParameter& GetParticleEffectParameter(ParticleEffect e)
+  {
+	return effectParameterList[e];
+  }
+
+  ParticleSystem::ParticleSystem()
+	: poolList(ParticleMaterial_Count)
+	, maxEmissionPerFrame(defaultMaxEmissionPerFrame)
+	, maxTotalParticleCount(defaultMaxTotalParticleCount)
+	, emissionBudget(0)
+	, droppedCount(0)
+  {
+	for (auto& e : emitterList) {
+	  e.generation = 0;
+	  e.active = false;
+	}
+	Clear();
+  }
+
+  /** Set the upper bound of the cost in each frame.
+
+    @param emission  The maximum number of the particles emitted in one frame.
+	@param total     The maximum number of the living particles.
+	                 It is clamped to the capacity of the pools.
+  */
+  void ParticleSystem::SetBudget(size_t emission, size_t total)
+  {
+	maxEmissionPerFrame = emission;
+	maxTotalParticleCount = std::min(total, defaultMaxTotalParticleCount);
+  }
+
+  /** Add the new emitter.
+
+    @param param  The emitter parameter.
+	@param pos    The emitter position in world space.
+
+	@return The emitter ID. If there is no free emitter, invalidEmitterId is returned.
+  */
+  int ParticleSystem::AddEmitter(const ParticleEmitterParameter& param, const Position3F& pos)
+  {
+	for (size_t i = 0; i < maxEmitterCount; ++i) {
+	  Emitter& e = emitterList[i];
+	  if (!e.active) {
+		e.param = param;
+		e.position = pos;
+		e.time = 0.0f;
+		e.emissionAccum = 0.0f;
+		++e.generation;
+		e.active = true;
+		return static_cast<int>((e.generation << 8) | i);
+	  }
+	}
+	return invalidEmitterId;
+  }
+
+  /** Find the active emitter by ID.
+
+    @param id  The emitter ID returned by AddEmitter().
+
+	@return The pointer to the emitter. nullptr if it was already released.
+  */
+  ParticleSystem::Emitter* ParticleSystem::FindEmitter(int id)
+  {
+	if (id < 0 || static_cast<size_t>(id & 0xff) >= maxEmitterCount) {
+	  return nullptr;
+	}
+	Emitter& e = emitterList[id & 0xff];
+	if (!e.active || e.generation != static_cast<uint16_t>(id >> 8)) {
+	  return nullptr;
+	}
+	return &e;
+  }
+
+  /** Move the emitter.
+
+    @param id   The emitter ID returned by AddEmitter().
+	@param pos  The new position in world space.
+
+	@retval true   success.
+	@retval false  the emitter was already released.
+  */
+  bool ParticleSystem::SetEmitterPosition(int id, const Position3F& pos)
+  {
+	if (Emitter* p = FindEmitter(id)) {
+	  p->position = pos;
+	  return true;
+	}
+	return false;
+  }
+
+  /** Release the emitter.
+
+    The particles emitted by it are kept until they die.
+
+	@param id  The emitter ID returned by AddEmitter().
+  */
+  void ParticleSystem::RemoveEmitter(int id)
+  {
+	if (Emitter* p = FindEmitter(id)) {
+	  p->active = false;
+	}
+  }
+
+  /** Release all emitters and particles.
+  */
+  void ParticleSystem::Clear()
+  {
+	for (auto& e : emitterList) {
+	  e.active = false;
+	}
+	for (auto& e : poolList) {
+	  e.count = 0;
+	}
+	droppedCount = 0;
+  }
+
+  /** Update the emitters and the particles.
+
+    @param dTime  The time from the previous frame(unit:sec).
+  */
+  void ParticleSystem::Update(float dTime)
+  {
+	for (auto& e : poolList) {
+	  Integrate(e, dTime);
+	  RemoveDeadParticles(e);
+	}
+
+	emissionBudget = maxEmissionPerFrame;
+	for (auto& e : emitterList) {
+	  if (!e.active) {
+		continue;
+	  }
+	  int count = 0;
+	  if (e.time == 0.0f) {
+		count += e.param.burstCount;
+	  }
+	  e.emissionAccum += e.param.emissionRate * dTime;
+	  const int n = static_cast<int>(e.emissionAccum);
+	  e.emissionAccum -= static_cast<float>(n);
+	  count += n;
+	  Emit(e, count);
+	  e.time += dTime;
+	  if (e.param.duration >= 0.0f && e.time >= e.param.duration) {
+		e.active = false;
+	  }
+	}
+  }
+
+  /** Emit the particles within the budget.
+
+    @param e      The emitter.
+	@param count  The number of the particles to emit.
+  */
+  void ParticleSystem::Emit(const Emitter& e, int count)
+  {
+	if (count <= 0) {
+	  return;
+	}
+	Pool& pool = poolList[e.param.material];
+	const size_t total = ParticleCount();
+	const size_t freeCount = std::min(maxParticleCount - pool.count, maxTotalParticleCount - std::min(total, maxTotalParticleCount));
+	const size_t n = std::min(std::min(static_cast<size_t>(count), emissionBudget), freeCount);
+	droppedCount += count - n;
+	emissionBudget -= n;
+
+	const ParticleEmitterParameter& p = e.param;
+	boost::random::uniform_real_distribution<float> rand(-1.0f, 1.0f);
+	for (size_t i = pool.count; i < pool.count + n; ++i) {
+	  pool.posX[i] = e.position.x + p.positionRange.x * rand(random);
+	  pool.posY[i] = e.position.y + p.positionRange.y * rand(random);
+	  pool.posZ[i] = e.position.z + p.positionRange.z * rand(random);
+	  pool.velX[i] = p.velocity.x + p.velocityRange.x * rand(random);
+	  pool.velY[i] = p.velocity.y + p.velocityRange.y * rand(random);
+	  pool.velZ[i] = p.velocity.z + p.velocityRange.z * rand(random);
+	  pool.accX[i] = p.acceleration.x;
+	  pool.accY[i] = p.acceleration.y;
+	  pool.accZ[i] = p.acceleration.z;
+	  pool.age[i] = 0.0f;
+	  pool.invLifeTime[i] = 1.0f / std::max(0.01f, p.lifeTime + p.lifeTimeRange * rand(random));
+	  pool.startSize[i] = p.startSize;
+	  pool.endSize[i] = p.endSize;
+	  pool.startColor[i] = p.startColor;
+	  pool.endColor[i] = p.endColor;
+	}
+	pool.count += n;
+  }
+
+  /** Move the particles and increase their age.
+
+    @param pool   The particle pool.
+	@param dTime  The time from the previous frame(unit:sec).
+  */
+  void ParticleSystem::Integrate(Pool& pool, float dTime)
+  {
+	const size_t n = pool.count;
+	MultiplyAdd(&pool.velX[0], &pool.accX[0], dTime, n);
+	MultiplyAdd(&pool.velY[0], &pool.accY[0], dTime, n);
+	MultiplyAdd(&pool.velZ[0], &pool.accZ[0], dTime, n);
+	MultiplyAdd(&pool.posX[0], &pool.velX[0], dTime, n);
+	MultiplyAdd(&pool.posY[0], &pool.velY[0], dTime, n);
+	MultiplyAdd(&pool.posZ[0], &pool.velZ[0], dTime, n);
+	MultiplyAdd(&pool.age[0], &pool.invLifeTime[0], dTime, n);
+  }
+
+  /** Remove the dead particles by moving the last particle to its place.
+
+    @param pool  The particle pool.
+  */
+  void ParticleSystem::RemoveDeadParticles(Pool& pool)
+  {
+	size_t i = 0;
+	while (i < pool.count) {
+	  if (pool.age[i] < 1.0f) {
+		++i;
+		continue;
+	  }
+	  const size_t last = --pool.count;
+	  pool.posX[i] = pool.posX[last];
+	  pool.posY[i] = pool.posY[last];
+	  pool.posZ[i] = pool.posZ[last];
+	  pool.velX[i] = pool.velX[last];
+	  pool.velY[i] = pool.velY[last];
+	  pool.velZ[i] = pool.velZ[last];
+	  pool.accX[i] = pool.accX[last];
+	  pool.accY[i] = pool.accY[last];
+	  pool.accZ[i] = pool.accZ[last];
+	  pool.age[i] = pool.age[last];
+	  pool.invLifeTime[i] = pool.invLifeTime[last];
+	  pool.startSize[i] = pool.startSize[last];
+	  pool.endSize[i] = pool.endSize[last];
+	  pool.startColor[i] = pool.startColor[last];
+	  pool.endColor[i] = pool.endColor[last];
+	}
+  }
+
+  /** Build the camera facing rectangles of all particles.
+
+    The vertices are packed by the material. Each rectangle has 4 vertices that
+	is ordered as (left, bottom), (right, bottom), (left, top), (right, top).
+
+    @param buffer     The destination buffer. It should have maxVertexCount elements.
+	@param right      The right vector of the camera in world space.
+	@param up         The up vector of the camera in world space.
+	@param rangeList  The vertex range of each material is stored.
+
+	@return The number of the vertices.
+  */
+  size_t ParticleSystem::BuildVertices(ParticleVertex* buffer, const Vector3F& right, const Vector3F& up, DrawRangeList& rangeList) const
+  {
+	static const Position2S texCoordList[4] = {
+	  Position2S(0, 0xffff), Position2S(0xffff, 0xffff), Position2S(0, 0), Position2S(0xffff, 0)
+	};
+	const Vector3F offsetList[4] = { -right - up, right - up, -right + up, right + up };
+	ParticleVertex* p = buffer;
+	for (int m = 0; m < ParticleMaterial_Count; ++m) {
+	  const Pool& pool = poolList[m];
+	  rangeList[m].first = p - buffer;
+	  rangeList[m].particleCount = pool.count;
+	  for (size_t i = 0; i < pool.count; ++i) {
+		const float t = std::min(pool.age[i], 1.0f);
+		const float size = pool.startSize[i] + (pool.endSize[i] - pool.startSize[i]) * t;
+		const int ti = static_cast<int>(t * 256.0f);
+		const Color4B c0 = pool.startColor[i];
+		const Color4B c1 = pool.endColor[i];
+		const Color4B color(Lerp(c0.r, c1.r, ti), Lerp(c0.g, c1.g, ti), Lerp(c0.b, c1.b, ti), Lerp(c0.a, c1.a, ti));
+		const Position3F pos(pool.posX[i], pool.posY[i], pool.posZ[i]);
+		for (int v = 0; v < 4; ++v, ++p) {
+		  p->position = pos + offsetList[v] * size;
+		  p->texCoord = texCoordList[v];
+		  p->color = color;
+		}
+	  }
+	}
+	return p - buffer;
+  }
+
+  /** Get the number of the living particles.
+  */
+  size_t ParticleSystem::ParticleCount() const
+  {
+	size_t n = 0;
+	for (const auto& e : poolList) {
+	  n += e.count;
+	}
+	return n;
+  }
+
+  /** Get the number of the active emitters.
+  */
+  size_t ParticleSystem::EmitterCount() const
+  {
+	return std::count_if(emitterList.begin(), emitterList.end(), [](const Emitter& e) { return e.active; });
+  }
+
+} // namespace Mai
@@ -0,0 +1,141 @@
+#ifndef PARTICLESYSTEM_H_INCLUDED
+#define PARTICLESYSTEM_H_INCLUDED
+#include "../../Shared/Vector.h"
+#include <boost/random/mersenne_twister.hpp>
+#include <vector>
+#include <array>
+#include <stdint.h>
+
+namespace Mai {
+
+  /** The vertex format of the particle.
+
+    The particles are expanded to the camera facing rectangles on CPU.
+  */
+  struct ParticleVertex {
+	Position3F position;
+	Position2S texCoord;
+	Color4B color;
+  };
+
+  /** The blending type of the particles.
+
+    All particles that have same material are drawn by one draw call.
+  */
+  enum ParticleMaterial {
+	ParticleMaterial_Alpha, ///< Alpha blending.
+	ParticleMaterial_Additive, ///< Additive blending.
+	ParticleMaterial_Count,
+  };
+
+  /** The predefined effects.
+
+    @sa GetParticleEffectParameter()
+  */
+  enum ParticleEffect {
+	ParticleEffect_CheckPoint, ///< The ring of sparks when the player passes the check point.
+	ParticleEffect_EggBreak, ///< The splash of the shell fragments when the egg is broken.
+	ParticleEffect_Wind, ///< The streaks around the falling player.
+	ParticleEffect_Count,
+  };
+
+  /** The emitter parameter.
+  */
+  struct ParticleEmitterParameter {
+	ParticleMaterial material;
+	Vector3F velocity; ///< The initial velocity(unit:m/s).
+	Vector3F velocityRange; ///< The random range added to the initial velocity.
+	Vector3F positionRange; ///< The random range added to the emitter position.
+	Vector3F acceleration; ///< The constant acceleration(unit:m/s^2).
+	float lifeTime; ///< The life time of the particle(unit:sec).
+	float lifeTimeRange; ///< The random range added to the life time.
+	float startSize; ///< The half size of the particle at the birth(unit:m).
+	float endSize; ///< The half size of the particle at the death(unit:m).
+	Color4B startColor; ///< The color at the birth.
+	Color4B endColor; ///< The color at the death.
+	float emissionRate; ///< The number of the particles emitted per second.
+	float duration; ///< The emission time(unit:sec). The emitter is released after it. Negative value means infinity.
+	int burstCount; ///< The number of the particles emitted at the start.
+  };
+
+  const ParticleEmitterParameter& GetParticleEffectParameter(ParticleEffect);
+
+  /** The pooled particle system.
+
+    The emitters and the particles are allocated from the fixed size pools, so that
+	no memory allocation occurs while playing.
+	The particles are stored as the structure of arrays for each material, and
+	integrated by SIMD.
+
+	The cost in each frame is limited by the emission budget and the total particle budget.
+	When the budget is exhausted, the new particles are dropped.
+  */
+  class ParticleSystem
+  {
+  public:
+	static const size_t maxEmitterCount = 32;
+	static const size_t maxParticleCount = 1024; ///< The capacity for each material.
+	static const size_t maxVertexCount = maxParticleCount * 4 * ParticleMaterial_Count;
+	static const int invalidEmitterId = -1;
+
+	/// The vertex range of each material built by BuildVertices().
+	struct DrawRange {
+	  size_t first; ///< The first vertex.
+	  size_t particleCount;
+	};
+	typedef std::array<DrawRange, ParticleMaterial_Count> DrawRangeList;
+
+	ParticleSystem();
+	int AddEmitter(const ParticleEmitterParameter&, const Position3F&);
+	int AddEmitter(ParticleEffect e, const Position3F& pos) { return AddEmitter(GetParticleEffectParameter(e), pos); }
+	bool SetEmitterPosition(int id, const Position3F&);
+	void RemoveEmitter(int id);
+	void Clear();
+	void Update(float dTime);
+	size_t BuildVertices(ParticleVertex* buffer, const Vector3F& right, const Vector3F& up, DrawRangeList& rangeList) const;
+
+	void SetBudget(size_t maxEmissionPerFrame, size_t maxTotalParticleCount);
+	size_t ParticleCount() const;
+	size_t EmitterCount() const;
+	size_t DroppedCount() const { return droppedCount; }
+
+  private:
+	/// The particle storage as the structure of arrays.
+	struct Pool {
+	  size_t count;
+	  std::array<float, maxParticleCount> posX, posY, posZ;
+	  std::array<float, maxParticleCount> velX, velY, velZ;
+	  std::array<float, maxParticleCount> accX, accY, accZ;
+	  std::array<float, maxParticleCount> age; ///< The normalized age. The particle dies when it reaches 1.
+	  std::array<float, maxParticleCount> invLifeTime;
+	  std::array<float, maxParticleCount> startSize, endSize;
+	  std::array<Color4B, maxParticleCount> startColor, endColor;
+	};
+
+	struct Emitter {
+	  ParticleEmitterParameter param;
+	  Position3F position;
+	  float time;
+	  float emissionAccum; ///< The fraction of the particle count that will be emitted.
+	  uint16_t generation; ///< The counter to distinguish the reused emitter slot.
+	  bool active;
+	};
+
+	Emitter* FindEmitter(int id);
+	void Emit(const Emitter&, int count);
+	static void Integrate(Pool&, float dTime);
+	static void RemoveDeadParticles(Pool&);
+
+  private:
+	std::vector<Pool> poolList; ///< It is allocated by the constructor only.
+	std::array<Emitter, maxEmitterCount> emitterList;
+	boost::random::mt19937 random;
+	size_t maxEmissionPerFrame;
+	size_t maxTotalParticleCount;
+	size_t emissionBudget; ///< The rest of the emission count in the current frame.
+	size_t droppedCount; ///< The number of the dropped particles by the budget.
+  };
+
+} // namespace Mai
+
+#endif // PARTICLESYSTEM_H_INCLUDED
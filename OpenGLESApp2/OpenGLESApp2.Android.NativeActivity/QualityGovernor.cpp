@@ -0,0 +1,153 @@
+#include "QualityGovernor.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, "Mai.QualityGovernor", __VA_ARGS__))
+#else
+#include <stdio.h>
+#define LOGI(...) ((void)printf(__VA_ARGS__), (void)printf("\n"))
+#endif // __ANDROID__
+
+namespace Mai {
+
+  namespace {
+
+	const float frameTimeSmoothingFactor = 0.1f;
+	const float costSmoothingFactor = 0.5f;
+	const float upperMargin = 1.1f; ///< Degrade if the frame time exceeds 110% of the target.
+	const float lowerMargin = 0.9f; ///< Restore if the predicted frame time is below 90% of the target.
+	const int settleFrames = 30; ///< The frame count to wait for the frame time to settle after the change.
+	const int baseRestoreWait = 120;
+	const int maxRestoreWait = 30 * 60;
+
+	/** The information of each feature.
+
+	  'initialCost' is used until the cost is learned by switching the feature.
+	*/
+	const struct {
+	  const char* name;
+	  float initialCost;
+	} featureInfoList[] = {
+	  { "ShadowBlur", 0.0010f },
+	  { "ShadowMapSize", 0.0020f },
+	  { "Bloom", 0.0030f },
+	  { "CloudResolution", 0.0020f },
+	  { "LodBias", 0.0015f },
+	  { "RenderScale", 0.0050f },
+	};
+	static_assert(sizeof(featureInfoList) / sizeof(featureInfoList[0]) == QualityFeature_Count, "featureInfoList should have all features");
+
+  } // unnamed namespace
+
+  QualityGovernor::QualityGovernor()
+  {
+	Reset(1.0f / 30.0f);
+  }
+
+  /** Restore the full quality and forget the learned costs.
+
+    @param target  The target frame time(unit:sec).
+  */
+  void QualityGovernor::Reset(float target)
+  {
+	targetFrameTime = target;
+	averageFrameTime = target;
+	averageMeasuredTime = target;
+	measuredTimeBeforeChange = target;
+	level = 0;
+	stableFrames = 0;
+	changedFeature = -1;
+	hasRestored = false;
+	frameNo = 0;
+	for (int i = 0; i < QualityFeature_Count; ++i) {
+	  costList[i] = featureInfoList[i].initialCost;
+	  restoreWaitList[i] = baseRestoreWait;
+	}
+  }
+
+  /** Update the cost model and the quality level.
+
+    @param frameTime     The time from the previous frame(unit:sec).
+	@param passTimeList  The array of the time of each pass(unit:sec) that has
+	                     QualityPass_Count elements. nullptr if it is not measured.
+  */
+  void QualityGovernor::Update(float frameTime, const float* passTimeList)
+  {
+	++frameNo;
+	++stableFrames;
+	if (!(frameTime > 0.0f) || frameTime > 1.0f) {
+	  return; // ignore the pause and the resume.
+	}
+	averageFrameTime += (frameTime - averageFrameTime) * frameTimeSmoothingFactor;
+
+	float measuredTime = frameTime;
+	if (passTimeList) {
+	  measuredTime = 0.0f;
+	  for (int i = 0; i < QualityPass_Count; ++i) {
+		measuredTime += passTimeList[i];
+	  }
+	}
+	averageMeasuredTime += (measuredTime - averageMeasuredTime) * frameTimeSmoothingFactor;
+
+	if (stableFrames == settleFrames && changedFeature >= 0) {
+	  // the difference is the cost of the switched feature only, because the other features are not changed.
+	  const float diff = hasRestored ? averageMeasuredTime - measuredTimeBeforeChange : measuredTimeBeforeChange - averageMeasuredTime;
+	  if (diff > 0.0f) {
+		costList[changedFeature] += (diff - costList[changedFeature]) * costSmoothingFactor;
+	  }
+	}
+
+	if (stableFrames < settleFrames) {
+	  return;
+	}
+	if (averageFrameTime > targetFrameTime * upperMargin) {
+	  if (level < QualityFeature_Count) {
+		if (hasRestored && changedFeature == level && stableFrames < restoreWaitList[level] * 2) {
+		  // the last restoring was failed. wait longer before the next try.
+		  restoreWaitList[level] = std::min(restoreWaitList[level] * 2, maxRestoreWait);
+		}
+		ChangeLevel(level + 1, "over");
+	  }
+	} else if (level > 0) {
+	  const int f = level - 1;
+	  const float predicted = averageFrameTime + costList[f];
+	  if (stableFrames >= restoreWaitList[f] && predicted < targetFrameTime * lowerMargin) {
+		ChangeLevel(level - 1, "under");
+	  }
+	}
+	if (hasRestored && changedFeature >= 0 && stableFrames == restoreWaitList[changedFeature] * 2) {
+	  // the last restoring was succeeded.
+	  restoreWaitList[changedFeature] = baseRestoreWait;
+	}
+  }
+
+  /** Change the quality level and log the decision.
+
+	The log is formatted as the comma separated values for offline analysis:
+	"QG,frame,average frame time(ms),target(ms),old level,new level,feature,cost(ms),reason".
+
+	@param newLevel  The new quality level.
+	@param reason    The reason of this change.
+  */
+  void QualityGovernor::ChangeLevel(int newLevel, const char* reason)
+  {
+	hasRestored = newLevel < level;
+	changedFeature = hasRestored ? newLevel : level;
+	LOGI("QG,%u,%.2f,%.2f,%d,%d,%s,%.2f,%s",
+	  frameNo,
+	  averageFrameTime * 1000.0f,
+	  targetFrameTime * 1000.0f,
+	  level,
+	  newLevel,
+	  featureInfoList[changedFeature].name,
+	  costList[changedFeature] * 1000.0f,
+	  reason
+	);
+	measuredTimeBeforeChange = averageMeasuredTime;
+	level = newLevel;
+	stableFrames = 0;
+  }
+
+} // namespace Mai
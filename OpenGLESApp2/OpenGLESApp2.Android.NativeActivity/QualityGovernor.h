@@ -0,0 +1,80 @@
+#ifndef QUALITYGOVERNOR_H_INCLUDED
+#define QUALITYGOVERNOR_H_INCLUDED
+#include <array>
+#include <stdint.h>
+
+namespace Mai {
+
+  /** The quality features controlled by QualityGovernor.
+
+    The features are ordered by the priority of degradation.
+	The first one is degraded first, and restored last.
+  */
+  enum QualityFeature {
+	QualityFeature_ShadowBlur, ///< Filter the shadow map with bilinear4x4, or copy it only.
+	QualityFeature_ShadowMapSize, ///< Render the shadow map with full size, or half size.
+	QualityFeature_Bloom, ///< Apply HDR bloom, or not.
+	QualityFeature_CloudResolution, ///< Draw all clouds, or half of them.
+	QualityFeature_LodBias, ///< Sample the textures with no mip bias, or with the coarser mip level.
+	QualityFeature_RenderScale, ///< Render the color path with full size, or reduced size.
+	QualityFeature_Count,
+  };
+
+  /** The render passes that are measured by the GPU timer.
+
+    It should keep the same order as the fence list in Renderer::Render().
+  */
+  enum QualityPass {
+	QualityPass_Shadow,
+	QualityPass_ShadowFilter,
+	QualityPass_Color,
+	QualityPass_HDR,
+	QualityPass_Final,
+	QualityPass_Count,
+  };
+
+  /** Keep the frame time under the target by degrading the quality features.
+
+    The quality level is the number of the degraded features. Level 0 is the full quality.
+	When the average frame time exceeds the target, the next feature is degraded.
+	When the predicted frame time with restoring the last degraded feature is enough
+	lower than the target, it is restored.
+
+	The cost of each feature is learned by the change of the measured frame time when
+	the feature is switched. The measured frame time is the sum of the pass times if the
+	GPU timer is available, because it isn't rounded by the vsync. Otherwise it is the
+	frame time. Since only one feature is switched at once, the features that share the
+	same pass are separated.
+  */
+  class QualityGovernor
+  {
+  public:
+	QualityGovernor();
+	void Reset(float targetFrameTime);
+	void Update(float frameTime, const float* passTimeList = nullptr);
+	bool IsEnabled(QualityFeature f) const { return f >= level; }
+	int Level() const { return level; }
+	float Cost(QualityFeature f) const { return costList[f]; }
+	float AverageFrameTime() const { return averageFrameTime; }
+	float AverageMeasuredTime() const { return averageMeasuredTime; }
+
+  private:
+	void ChangeLevel(int newLevel, const char* reason);
+
+  private:
+	float targetFrameTime;
+	float averageFrameTime;
+	float averageMeasuredTime; ///< The average of the sum of the pass times, or the frame time.
+	float measuredTimeBeforeChange; ///< The average measured time when the last level change occured.
+	int level;
+	int stableFrames; ///< The frame count since the last level change.
+	int changedFeature; ///< The feature switched by the last level change. -1 if nothing.
+	bool hasRestored; ///< true if the last level change restored 'changedFeature'.
+	uint32_t frameNo;
+	std::array<float, QualityFeature_Count> costList; ///< The learned cost(sec) of each feature.
+	std::array<int, QualityFeature_Count> restoreWaitList; ///< The frame count to wait before restoring each feature.
+  };
+
+} // namespace Mai
+
+#endif // QUALITYGOVERNOR_H_INCLUDED
@@ -1,4 +1,6 @@
 #include "Renderer.h"
+#include "ImageBasedLighting.h"
+#include "Parallel.h"
 #include "../../Shared/File.h"
 #include "../../Shared/Window.h"
 #include "../../Shared/FontInfo.h"
@@ -64,6 +66,8 @@ static char debugLogBuffer[16][256];
 static const Vector2F referenceViewportSize(480, 800);
 static const size_t vboBufferSize = sizeof(Vertex) * 1024 * 11;
 static const size_t iboBufferSize = sizeof(GLushort) * 1024 * 10 * 3;
+/// The distance that the objects use the finest mip level. The level increases each time the distance doubles.
+static const float textureStreamingDistance = 64.0f;
 #define MAX_FONT_RENDERING_COUNT 512
 
 namespace {
@@ -76,6 +80,7 @@ namespace {
 	PFNGLFINISHFENCENVPROC glFinishFenceNV;
 	PFNGLSETFENCENVPROC glSetFenceNV;
 	PFNGLTESTFENCENVPROC glTestFenceNV;
+	PFNGLDISCARDFRAMEBUFFEREXTPROC glDiscardFramebufferEXT;
   }
   GLvoid GL_APIENTRY dummy_glDeleteFencesNV(GLsizei, const GLuint*) {}
   GLvoid GL_APIENTRY dummy_glGenFencesNV(GLsizei, GLuint*) {}
@@ -85,9 +90,17 @@ namespace {
   GLvoid GL_APIENTRY dummy_glSetFenceNV(GLuint, GLenum) {}
   GLboolean GL_APIENTRY dummy_glTestFenceNV(GLuint) { return false; }
 
-  void InitNVFenceExtention(bool hasNVfenceExtension)
+  /** Initialize GL_NV_fence functions.
+
+	This is enabled in the release build too, because QualityGovernor learns the cost
+	of the quality features by the pass time measured with the fences.
+
+	@param hasNVfenceExtension  true if GL_NV_fence is supported.
+
+	@return true if the fence functions are available, otherwise false.
+  */
+  bool InitNVFenceExtention(bool hasNVfenceExtension)
   {
-#ifndef NDEBUG
 	if (hasNVfenceExtension) {
 	  Local::glDeleteFencesNV = (PFNGLDELETEFENCESNVPROC)eglGetProcAddress("glDeleteFencesNV");
 	  Local::glGenFencesNV = (PFNGLGENFENCESNVPROC)eglGetProcAddress("glGenFencesNV");
@@ -96,18 +109,12 @@ namespace {
 	  Local::glFinishFenceNV = (PFNGLFINISHFENCENVPROC)eglGetProcAddress("glFinishFenceNV");
 	  Local::glSetFenceNV = (PFNGLSETFENCENVPROC)eglGetProcAddress("glSetFenceNV");
 	  Local::glTestFenceNV = (PFNGLTESTFENCENVPROC)eglGetProcAddress("glTestFenceNV");
-	  LOGI("Enable GL_NV_fence");
-	} else {
-	  Local::glDeleteFencesNV = dummy_glDeleteFencesNV;
-	  Local::glGenFencesNV = dummy_glGenFencesNV;
-	  Local::glGetFenceivNV = dummy_glGetFenceivNV;
-	  Local::glIsFenceNV = dummy_glIsFenceNV;
-	  Local::glFinishFenceNV = dummy_glFinishFenceNV;
-	  Local::glSetFenceNV = dummy_glSetFenceNV;
-	  Local::glTestFenceNV = dummy_glTestFenceNV;
-	  LOGI("Disable GL_NV_fence");
+	  if (Local::glDeleteFencesNV && Local::glGenFencesNV && Local::glGetFenceivNV && Local::glIsFenceNV &&
+		Local::glFinishFenceNV && Local::glSetFenceNV && Local::glTestFenceNV) {
+		LOGI("Enable GL_NV_fence");
+		return true;
+	  }
 	}
-#else
 	Local::glDeleteFencesNV = dummy_glDeleteFencesNV;
 	Local::glGenFencesNV = dummy_glGenFencesNV;
 	Local::glGetFenceivNV = dummy_glGetFenceivNV;
@@ -116,7 +123,32 @@ namespace {
 	Local::glSetFenceNV = dummy_glSetFenceNV;
 	Local::glTestFenceNV = dummy_glTestFenceNV;
 	LOGI("Disable GL_NV_fence");
-#endif // NDEBUG
+	return false;
+  }
+
+  GLvoid GL_APIENTRY dummy_glDiscardFramebufferEXT(GLenum, GLsizei, const GLenum*) {}
+
+  /** Initialize GL_EXT_discard_framebuffer function.
+
+	This is enabled in the release build too, because it reduces the memory bandwidth
+	on the tile based GPU.
+
+	@param hasDiscardFramebufferExtension  true if GL_EXT_discard_framebuffer is supported.
+
+	@return true if glDiscardFramebufferEXT is available, otherwise false.
+  */
+  bool InitDiscardFramebufferExtension(bool hasDiscardFramebufferExtension)
+  {
+	if (hasDiscardFramebufferExtension) {
+	  Local::glDiscardFramebufferEXT = (PFNGLDISCARDFRAMEBUFFEREXTPROC)eglGetProcAddress("glDiscardFramebufferEXT");
+	}
+	if (!hasDiscardFramebufferExtension || !Local::glDiscardFramebufferEXT) {
+	  Local::glDiscardFramebufferEXT = dummy_glDiscardFramebufferEXT;
+	  LOGI("Disable GL_EXT_discard_framebuffer");
+	  return false;
+	}
+	LOGI("Enable GL_EXT_discard_framebuffer");
+	return true;
   }
 
   int64_t GetCurrentTime()
@@ -159,7 +191,16 @@ namespace {
 		}
 	}
 
-	GLuint LoadShader(GLenum shaderType, const char* path, const std::string& additionalDefineList) {
+	/** Compile the shader.
+
+	  @param shaderType            GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
+	  @param path                  The path of the shader source.
+	  @param additionalDefineList  The definitions inserted before the source.
+	  @param library               The common functions inserted between the definitions and the source.
+
+	  @return The shader object. 0 if failed.
+	*/
+	GLuint LoadShader(GLenum shaderType, const char* path, const std::string& additionalDefineList, const std::string& library) {
 		GLuint shader = 0;
 		if (auto buf = FileSystem::LoadFile(path)) {
 			static const GLchar version[] = "#version 100\n";
@@ -176,6 +217,7 @@ namespace {
 			  "#define SCALE_BONE_WEIGHT(w) ((w) * (1.0 / 255.0))\n"
 			  "#define SCALE_TEXCOORD(c) ((c) * (1.0 / 65535.0))\n"
 			  "#define M_PI (3.1415926535897932384626433832795)\n"
+			  "#define DECODE_NORMAL_Z(xy) sqrt(max(1.0 - dot((xy), (xy)), 0.0))\n"
 			  ;
 			shader = glCreateShader(shaderType);
 			if (!shader) {
@@ -185,12 +227,14 @@ namespace {
 			  version,
 			  defineList,
 			  additionalDefineList.data(),
+			  library.data(),
 			  reinterpret_cast<GLchar*>(static_cast<void*>(&(*buf)[0])),
 			};
 			const GLint srcSize[] = {
 			  sizeof(version) - 1,
 			  sizeof(defineList) - 1,
 			  static_cast<GLint>(additionalDefineList.size()),
+			  static_cast<GLint>(library.size()),
 			  static_cast<GLint>(buf->size()),
 			};
 			glShaderSource(shader, sizeof(pSrc)/sizeof(pSrc[0]), pSrc, srcSize);
@@ -215,13 +259,13 @@ namespace {
 		return shader;
 	}
 
-	boost::optional<Shader> CreateShaderProgram(const char* name, const char* vshPath, const char* fshPath, const std::string& additionalDefineList) {
-		GLuint vertexShader = LoadShader(GL_VERTEX_SHADER, vshPath, additionalDefineList);
+	boost::optional<Shader> CreateShaderProgram(const char* name, const char* vshPath, const char* fshPath, const std::string& additionalDefineList, const std::string& fragmentLibrary) {
+		GLuint vertexShader = LoadShader(GL_VERTEX_SHADER, vshPath, additionalDefineList, std::string());
 		if (!vertexShader) {
 			return boost::none;
 		}
 
-		GLuint pixelShader = LoadShader(GL_FRAGMENT_SHADER, fshPath, additionalDefineList);
+		GLuint pixelShader = LoadShader(GL_FRAGMENT_SHADER, fshPath, additionalDefineList, fragmentLibrary);
 		if (!pixelShader) {
 			return boost::none;
 		}
@@ -265,16 +309,21 @@ namespace {
 		s.materialColor = glGetUniformLocation(program, "materialColor");
 		s.materialMetallicAndRoughness = glGetUniformLocation(program, "metallicAndRoughness");
 		s.dynamicRangeFactor = glGetUniformLocation(program, "dynamicRangeFactor");
+		s.lodBias = glGetUniformLocation(program, "lodBias");
 		s.texDiffuse = glGetUniformLocation(program, "texDiffuse");
 		s.texNormal = glGetUniformLocation(program, "texNormal");
 		s.texMetalRoughness = glGetUniformLocation(program, "texMetalRoughness");
 		s.texIBL = glGetUniformLocation(program, "texIBL");
 		s.texShadow = glGetUniformLocation(program, "texShadow");
+		s.texBRDF = glGetUniformLocation(program, "texBRDF");
+		s.shIrradiance = glGetUniformLocation(program, "shIrradiance");
 		s.texSource = glGetUniformLocation(program, "texSource");
 		s.unitTexCoord = glGetUniformLocation(program, "unitTexCoord");
 		s.matView = glGetUniformLocation(program, "matView");
 		s.matProjection = glGetUniformLocation(program, "matProjection");
 		s.bones = glGetUniformLocation(program, "boneMatrices");
+		s.boneDualQuaternions = glGetUniformLocation(program, "boneDualQuaternions");
+		s.matModel = glGetUniformLocation(program, "matModel");
 		s.lightDirForShadow = glGetUniformLocation(program, "lightDirForShadow");
 		s.matLightForShadow = glGetUniformLocation(program, "matLightForShadow");
 		s.cloudColor = glGetUniformLocation(program, "cloudColor");
@@ -287,8 +336,8 @@ namespace {
 		return s;
 	}
 
-	/** ˉes쐬.
-	  gluPerspectiveƓs񂪍쐬.
+	/** 射影行列を作成する.
+	  gluPerspectiveと同じ行列が作成される.
 	*/
 	Matrix4x4 Perspective(float fov, float width, float height, float nearPlane, float farPlane)
 	{
@@ -354,13 +403,13 @@ Matrix4x4 LookAt(const Position3F& eyePos, const Position3F& targetPos, const Ve
   return m;
 }
 
-/** ShaderfXgN^.
+/** Shaderデストラクタ.
 */
 Shader::~Shader()
 {
 }
 
-/** RotTrans4x3sɕϊ.
+/** RotTransを4x3行列に変換する.
 */
 Matrix4x3 ToMatrix(const RotTrans& rt) {
 	Matrix4x3 m = ToMatrix(rt.rot);
@@ -370,98 +419,106 @@ Matrix4x3 ToMatrix(const RotTrans& rt) {
 	return m;
 }
 
-/** NH[^jI̋ʐ`
+/** Start the cross-fade to the animation.
 
-  @ref http://www.willperone.net/Code/quaternion.php
+  The current animation is moved to the fade layer. If all fade layers are used,
+  the oldest one is discarded.
+
+  @param p         The next animation.
+  @param duration  The time to change the weight from 0 to 1 in seconds.
+                   If it is 0 or less, the animation is changed immediately.
 */
-Quaternion Sleap(const Quaternion& qa, const Quaternion& qb, float t)
+void AnimationPlayer::CrossFade(const Animation* p, float duration)
 {
-	Quaternion tmp;
-	float cosHalfTheta = qa.Dot(qb);
-	if (cosHalfTheta < 0.0f) {
-	  cosHalfTheta = -cosHalfTheta;
-	  tmp = -qb;
-	} else {
-	  tmp = qb;
-	}
-	if (cosHalfTheta < 0.95f) {
-	  const float halfTheta = std::acos(cosHalfTheta);
-	  const float sinHalfTheta = std::sin(halfTheta);
-	  const float ratioA = std::sin((1.0f - t) * halfTheta) / sinHalfTheta;
-	  const float ratioB = std::sin(t * halfTheta) / sinHalfTheta;
-	  return (qa * ratioA + tmp * ratioB).Normalize();
-	} else {
-	  return (qa * (1.0f - t) + tmp * t).Normalize();
+	if (duration <= 0.0f || !pAnime) {
+	  SetAnimation(p);
+	  return;
 	}
+	// shift the layers without the allocation. the sampler of the discarded layer is reused.
+	const size_t count = std::min(fadeLayerCount + 1, maxFadeLayerCount);
+	std::rotate(fadeLayerList.begin(), fadeLayerList.begin() + count - 1, fadeLayerList.begin() + count);
+	FadeLayer& layer = fadeLayerList[0];
+	layer.currentTime = currentTime;
+	layer.pAnime = pAnime;
+	layer.weight = weight;
+	layer.fadeSpeed = fadeSpeed;
+	std::swap(layer.sampler, sampler);
+	fadeLayerCount = count;
+
+	pAnime = p;
+	currentTime = 0.0f;
+	weight = 0.0f;
+	fadeSpeed = 1.0f / duration;
 }
 
-/** w肳ꂽԂ̒OƒɂAj[Vf[^̃yA擾.
+/** 指定された時間だけアニメーションを進める.
+
+  @param t  The delta time.
 */
-Animation::ElementPair Animation::GetElementByTime(int index, float t) const
+void AnimationPlayer::Advance(float t)
 {
-	static const Element defaultElem = { { Quaternion(0, 0, 0, 1), Vector3F(0, 0, 0)}, 0 };
-
-	const std::vector<ElementList>::const_iterator itrList = std::lower_bound(
-		data.begin(), data.end(), index, [](const ElementList& lhs, int rhs) { return lhs.first < rhs; });
-	if (itrList == data.end() || itrList->first != index) {
-		return ElementPair(&defaultElem, &defaultElem);
+	const auto advanceTime = [t](const Animation* p, float& time) {
+	  if (p) {
+		time += t;
+		if (p->loopFlag) {
+		  time = std::fmod(time, p->totalTime);
+		}
+	  }
+	};
+	advanceTime(pAnime, currentTime);
+	if (!fadeLayerCount) {
+	  return;
 	}
-	const ElementList& list = *itrList;
-	if (list.second.size() == 0) {
-		return ElementPair(&defaultElem, &defaultElem);
+	weight = std::min(1.0f, weight + fadeSpeed * t);
+	if (weight >= 1.0f) {
+	  fadeLayerCount = 0;
+	  return;
 	}
-	const ElementList::second_type::const_iterator itrElem = std::upper_bound(
-		list.second.begin(), list.second.end(), t, [](float lhs, const Element& rhs) { return lhs < rhs.time; });
-	if (itrElem == list.second.begin()) {
-		return ElementPair(&defaultElem, &*itrElem);
-	} else if (itrElem == list.second.end()) {
-		return ElementPair(&*(itrElem - 1), &*(itrElem - 1));
+	// the layers older than the completely faded in layer are hidden.
+	for (size_t i = 0; i < fadeLayerCount; ++i) {
+	  FadeLayer& layer = fadeLayerList[i];
+	  advanceTime(layer.pAnime, layer.currentTime);
+	  layer.weight = std::min(1.0f, layer.weight + layer.fadeSpeed * t);
+	  if (layer.weight >= 1.0f) {
+		fadeLayerCount = i + 1;
+		break;
+	  }
 	}
-	return ElementPair(&*(itrElem - 1), &*itrElem);
 }
 
-/** w肳ꂽԂAj[Vi߂.
+/** Get the pose at the current time.
+
+  If the cross-fade is in progress, each animation is blended over the pose
+  of the older animations by its weight, from the oldest one to the current one.
+
+  @param jointList  The joints of the mesh.
+  @param cache      The pose cache shared by all objects.
+
+  @return The pose of each joint. It is valid until the next access to \e cache or this player.
 */
-std::vector<RotTrans> AnimationPlayer::Update(const JointList& jointList, float t)
+const PoseBuffer& AnimationPlayer::GetPose(const JointList& jointList, PoseCache& cache)
 {
-	std::vector<RotTrans> result;
-	if (!pAnime) {
-		result.resize(jointList.size(), RotTrans::Unit());
-		return result;
-	}
-	currentTime += t;
-	if (pAnime->loopFlag) {
-	  currentTime = std::fmod(currentTime, pAnime->totalTime);
-	}
-	result.reserve(jointList.size());
-	for (int i = 0; i < static_cast<int>(jointList.size()); ++i) {
-		const Animation::ElementPair p = pAnime->GetElementByTime(i, currentTime);
-		const float timeRange = p.second->time - p.first->time;
-		const float ratio = timeRange > 0.0f ? (currentTime - p.first->time) / timeRange : 0.0f;
-		result.push_back(Interporation(p.first->pose, p.second->pose, ratio));
-	}
-	return result;
+	const size_t jointCount = jointList.size();
+	if (!fadeLayerCount) {
+	  return cache.Get(pAnime, currentTime, sampler, jointCount);
+	}
+	FadeLayer& oldest = fadeLayerList[fadeLayerCount - 1];
+	const PoseBuffer& oldestPose = cache.Get(oldest.pAnime, oldest.currentTime, oldest.sampler, jointCount);
+	blendPose.Resize(jointCount);
+	std::copy(oldestPose.rot.begin(), oldestPose.rot.end(), blendPose.rot.begin());
+	std::copy(oldestPose.trans.begin(), oldestPose.trans.end(), blendPose.trans.begin());
+	for (size_t i = fadeLayerCount - 1; i > 0; --i) {
+	  FadeLayer& layer = fadeLayerList[i - 1];
+	  BlendPose(blendPose, cache.Get(layer.pAnime, layer.currentTime, layer.sampler, jointCount), layer.weight);
+	}
+	BlendPose(blendPose, cache.Get(pAnime, currentTime, sampler, jointCount), weight);
+	return blendPose;
 }
 
-void UpdateJointRotTrans(std::vector<RotTrans>& rtList, const Joint* root, const Joint* joint, const RotTrans& parentRT)
-{
-	RotTrans& rtBuf = rtList[joint - root];
-#if 0
-	RotTrans rt = rtBuf * joint->initialPose;
-	rt *= parentRT;
-	rtBuf = rt * joint->invBindPose;
-#elif 0
-	rtBuf = joint->invBindPose * rtBuf;
-#endif
-	if (joint->offChild) {
-		UpdateJointRotTrans(rtList, root, joint + joint->offChild, rtBuf);
-	}
-	if (joint->offSibling) {
-		UpdateJointRotTrans(rtList, root, joint + joint->offSibling, parentRT);
-	}
-}
+/** オブジェクト状態を更新する.
 
-/** IuWFNgԂXV.
+  The pose is sampled according to the animation LOD. If it isn't sampled,
+  the bones are rebuilt from the kept pose only when the model matrix is changed.
 */
 void Object::Update(float t)
 {
@@ -471,7 +528,8 @@ void Object::Update(float t)
   if (const Mesh::Mesh* mesh = GetMesh()) {
 	if (!mesh->jointList.empty()) {
 	  if (const Animation* pAnime = pRenderer->GetAnimation(animationPlayer.id.c_str())) {
-		const Matrix4x3 m0 = ToMatrix(rotTrans) * Matrix4x3 {
+		const Vector3F scale = Scale();
+		const Matrix4x3 m0 = ToMatrix(RotTrans()) * Matrix4x3 {
 		  {
 			scale.x, 0, 0, 0,
 			  0, scale.y, 0, 0,
@@ -479,40 +537,120 @@ void Object::Update(float t)
 		  }
 		};
 		animationPlayer.pAnime = pAnime;
-		std::vector<Mai::RotTrans> rtList = animationPlayer.Update(mesh->jointList, t);
-		UpdateJointRotTrans(rtList, &mesh->jointList[0], &mesh->jointList[0], Mai::RotTrans::Unit());
-		std::transform(rtList.begin(), rtList.end(), bones.begin(), [&m0](const Mai::RotTrans& rt) {
-		  const Matrix4x3 m = ToMatrix(rt);
-		  return m0 * m;
-		});
+		animationPlayer.Advance(t);
+
+		AnimationLod lod = AnimationLod_Full;
+		if (BoundingRadius() > 0.0f) {
+		  lod = pRenderer->SelectAnimationLod(Position(), BoundingRadius());
+		}
+		bool doesSample;
+		switch (lod) {
+		case AnimationLod_Full:
+		  doesSample = true;
+		  break;
+		case AnimationLod_Reduced:
+		  doesSample = animationLod != AnimationLod_Reduced || ++animationLodFrame >= Renderer::animationLodInterval;
+		  break;
+		default:
+		  doesSample = animationLod == AnimationLod_Count;
+		  break;
+		}
+		const bool isEnteringReducedLod = lod == AnimationLod_Reduced && animationLod != AnimationLod_Reduced;
+		animationLod = lod;
+		const bool isModelMatrixChanged = !std::equal(m0.f, m0.f + 4 * 3, modelMatrix.f);
+		modelMatrix = m0;
+
+		PoseCache& cache = pRenderer->GetPoseCache();
+		if (doesSample) {
+		  // the phase is seeded from the ID, so the objects that enter AnimationLod_Reduced
+		  // in the same frame sample their poses in the different frames.
+		  animationLodFrame = isEnteringReducedLod ? static_cast<int>(GetId() % Renderer::animationLodInterval) : 0;
+		  const PoseBuffer& pose = animationPlayer.GetPose(mesh->jointList, cache);
+		  if (lod == AnimationLod_Full) {
+			hasLodPose = false;
+			UpdateBones(pose, m0);
+		  } else {
+			lodPose = pose;
+			hasLodPose = true;
+			UpdateBones(lodPose, m0);
+		  }
+		} else if (isModelMatrixChanged) {
+		  const Shader* pShader = GetShader();
+		  if (pShader && pShader->boneDualQuaternions >= 0) {
+			pStore->boneModelMatrixList[id] = m0;
+		  } else {
+			if (!hasLodPose) {
+			  lodPose = animationPlayer.GetPose(mesh->jointList, cache);
+			  hasLodPose = true;
+			}
+			UpdateBones(lodPose, m0);
+		  }
+		}
 	  }
 	}
   }
 }
 
+/** Update the bones by the pose.
+
+  @param pose  The pose of each joint.
+  @param m0    The model matrix.
+*/
+void Object::UpdateBones(const PoseBuffer& pose, const Matrix4x3& m0)
+{
+  const Shader* pShader = GetShader();
+  if (pShader && pShader->boneDualQuaternions >= 0) {
+	// the model matrix has the scale, so it is applied after blending the dual quaternions.
+	pStore->boneModelMatrixList[id] = m0;
+	ToDualQuaternions(pose, &pStore->boneDualQuaternionList[id][0]);
+  } else {
+	std::vector<Matrix4x3>& bones = pStore->boneList[id];
+	for (size_t i = 0; i < pose.Size(); ++i) {
+	  const Matrix4x3 m = ToMatrix(Mai::RotTrans{ pose.rot[i], pose.trans[i] });
+	  bones[i] = m0 * m;
+	}
+  }
+}
+
 /** Get a mesh object.
 
+  The mesh is found by the name only if the cached handle is reset.
+
   @return A pointer to the mesh object if it is exists in the renderer,
           otherwise nullptr.
 */
 const Mesh::Mesh* Object::GetMesh() const {
-  return pRenderer->GetMesh(meshId);
+  if (const Mesh::Mesh* p = pStore->meshList[id]) {
+	return p;
+  }
+  const Mesh::Mesh* p = pRenderer->GetMesh(pStore->meshIdList[id]);
+  if (p) {
+	pStore->SetMesh(id, p);
+  }
+  return p;
 }
 
 /** Get a shader object.
 
+  The shader is found by the name only if the cached handle is reset.
+
   @return A pointer to the shader object if it is exists in the renderer,
           otherwise nullptr.
 */
 const ::Mai::Shader* Object::GetShader() const {
-  return pRenderer->GetShader(shaderId);
+  if (const Shader* p = pStore->shaderList[id]) {
+	return p;
+  }
+  const Shader* p = pRenderer->GetShader(pStore->shaderIdList[id]);
+  pStore->shaderList[id] = p;
+  return p;
 }
 
-/** V[ɑΉ鑾ž擾.
+/** シーンに対応する太陽光線の向きを取得する.
 
-  @param  timeOfScene  V[̎.
+  @param  timeOfScene  シーンの種類.
 
-  @return timeOfSceneɑΉ鑾ž.
+  @return timeOfSceneに対応する太陽光線の向き.
 */
 Vector3F GetSunRayDirection(TimeOfScene timeOfScene) {
   static const Vector3F baseAxis(0.25f, 0, -1.0f);
@@ -536,18 +674,21 @@ Vector3F GetSunRayDirection(TimeOfScene timeOfScene) {
 #endif
 }
 
-/** RXgN^.
+/** コンストラクタ.
 */
 Renderer::Renderer()
   : isInitialized(false)
   , doesDrawSkybox(true)
   , hasIBLTextures(false)
+  , landscapeGeneration(0)
   , isAdreno205(false)
+  , pWindow(nullptr)
   , width(480 * 8 / 10)
   , height(640 * 8 / 10)
   , isOddFrame(0)
   , blurScale(1.0f)
   , texBaseDir("Textures/Others/")
+  , normalMapSwizzle("ra")
   , random(static_cast<uint32_t>(time(nullptr)))
   , timeOfScene(TimeOfScene_Noon)
   , shadowLightPos(0, 2000, 0)
@@ -555,8 +696,21 @@ Renderer::Renderer()
   , shadowNear(10)
   ,	shadowFar(2000)
   , shadowScale(1, 1)
+  , cameraPos(0, 0, 0)
+  , cameraDir(0, 0, -1)
+  , cameraUp(0, 1, 0)
+  , cameraFov(60)
   , depth(0)
+  , depthByteSize(2)
+  , hasDiscardFramebuffer(false)
+  , discardedByteSize(0)
+  , hasGPUTimer(false)
+  , prevFrameTime(0)
+  , vboParticle(0)
+  , iboParticle(0)
   , animationTick(0.0)
+  , bonePaletteSize(32)
+  , dualQuaternionBonePaletteSize(46)
   , filterMode(FILTERMODE_NONE)
   , filterColor(0, 0, 0, 0)
   , filterTimer(0.0f)
@@ -564,9 +718,11 @@ Renderer::Renderer()
   for (auto& e : fbo) {
 	e = 0;
   }
+  animationLodCountList.fill(0);
+  animationLodCounter.fill(0);
 }
 
-/** fXgN^.
+/** デストラクタ.
 */
 Renderer::~Renderer()
 {
@@ -628,11 +784,69 @@ Renderer::FBOInfo Renderer::GetFBOInfo(int id) const
 	return { fboNameList[id].name, fboNameList[id].width, fboNameList[id].height, p };
 }
 
-/** `̏ݒ.
-* OpenGL̍č\zKvɂȂꍇA̓sx̊֐ĂяoKv.
+/** Tell the driver that the previous contents of the current FBO are not needed.
+
+  This should be called just after binding the FBO that will be overwritten entirely.
+  The tile based GPU can skip loading the attachments from the system memory.
+  If GL_EXT_discard_framebuffer is not supported, the attachments are cleared instead.
+
+  @param id    The index of the FBO that is bound. It is used to estimate the byte size.
+  @param mask  The bitwise OR of GL_COLOR_BUFFER_BIT and GL_DEPTH_BUFFER_BIT.
+*/
+void Renderer::BeginRenderTarget(int id, GLbitfield mask)
+{
+	if (hasDiscardFramebuffer) {
+	  EndRenderTarget(id, mask);
+	} else {
+	  glClear(mask);
+	  const FBOInfo info = GetFBOInfo(id);
+	  const size_t pixels = info.width * info.height;
+	  if (mask & GL_COLOR_BUFFER_BIT) {
+		discardedByteSize += pixels * 4;
+	  }
+	  if ((mask & GL_DEPTH_BUFFER_BIT) && (id == FBO_Main || id == FBO_Shadow)) {
+		discardedByteSize += pixels * depthByteSize;
+	  }
+	}
+}
+
+/** Tell the driver that the attachments of the current FBO are never read after this.
+
+  The tile based GPU can skip storing the attachments to the system memory.
+  If GL_EXT_discard_framebuffer is not supported, this function does nothing.
+
+  @param id    The index of the FBO that is bound. It is used to estimate the byte size.
+  @param mask  The bitwise OR of GL_COLOR_BUFFER_BIT and GL_DEPTH_BUFFER_BIT.
+*/
+void Renderer::EndRenderTarget(int id, GLbitfield mask)
+{
+	if (!hasDiscardFramebuffer) {
+	  return;
+	}
+	const FBOInfo info = GetFBOInfo(id);
+	const size_t pixels = info.width * info.height;
+	GLenum attachments[2];
+	GLsizei count = 0;
+	if (mask & GL_COLOR_BUFFER_BIT) {
+	  attachments[count++] = GL_COLOR_ATTACHMENT0;
+	  discardedByteSize += pixels * 4;
+	}
+	// Only FBO_Main_Internal has the depth buffer.
+	if ((mask & GL_DEPTH_BUFFER_BIT) && (id == FBO_Main || id == FBO_Shadow)) {
+	  attachments[count++] = GL_DEPTH_ATTACHMENT;
+	  discardedByteSize += pixels * depthByteSize;
+	}
+	if (count) {
+	  Local::glDiscardFramebufferEXT(GL_FRAMEBUFFER, count, attachments);
+	}
+}
+
+/** 描画環境の初期設定.
+* OpenGL環境の再構築が必要になった場合、その都度この関数を呼び出す必要がある.
 */
 void Renderer::Initialize(const Window& window)
 {
+	pWindow = &window;
 	display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
 	eglInitialize(display, 0, 0);
 
@@ -722,9 +936,6 @@ void Renderer::Initialize(const Window& window)
 	  MAKE_TEX_ID_PAIR(GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG)
 	};
 	for (const auto id : formatArray) {
-	  if (id == GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD) {
-		texBaseDir.assign("Textures/Adreno/");
-	  }
 	  bool isLogged = false;
 	  for (const auto* i = texInfoList; i != texInfoList + sizeof(texInfoList) / sizeof(texInfoList[0]); ++i) {
 		if (i->id == id) {
@@ -738,10 +949,29 @@ void Renderer::Initialize(const Window& window)
 	  }
 	}
 
+	// The uncompressed textures are transcoded to the compressed format that the device supports.
+	const Texture::TranscodeTarget transcodeTarget = formatArray.empty() ? Texture::TranscodeTarget::None : Texture::SelectTranscodeTarget(&formatArray[0], static_cast<int>(formatArray.size()));
+	Texture::SetTranscodeTarget(transcodeTarget, pWindow);
+	Texture::SetSupportedCompressedFormats(formatArray.data(), static_cast<int>(formatArray.size()));
+	if (transcodeTarget == Texture::TranscodeTarget::ATITC) {
+	  // X is stored in the RGB block, Y is stored in the interpolated alpha block.
+	  normalMapSwizzle = "ga";
+	}
+
 	LOG_SHADER_INFO(GL_MAX_TEXTURE_IMAGE_UNITS);
 	LOG_SHADER_INFO(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS);
+	{
+	  // a bone matrix is 3 vectors. the bone ID is 8bit, so the palette can't exceed 256 bones.
+	  GLint maxVertexUniformVectors;
+	  glGetIntegerv(GL_MAX_VERTEX_UNIFORM_VECTORS, &maxVertexUniformVectors);
+	  bonePaletteSize = std::min<size_t>(256, std::max<GLint>(0, maxVertexUniformVectors - reservedVertexUniformVectors) / 3);
+	  // a dual quaternion is 2 vectors, and the model matrix applied after the blending is 3 vectors.
+	  dualQuaternionBonePaletteSize = std::min<size_t>(256, std::max<GLint>(0, maxVertexUniformVectors - reservedVertexUniformVectors - 3) / 2);
+	  LOGI("GL_MAX_VERTEX_UNIFORM_VECTORS: %d, bone palette size: %d, DQ: %d", maxVertexUniformVectors, static_cast<int>(bonePaletteSize), static_cast<int>(dualQuaternionBonePaletteSize));
+	}
 
 	bool hasNVfenceExtension = false;
+	bool hasDiscardFramebufferExtension = false;
 	GLenum depthComponentType = GL_DEPTH_COMPONENT16;
 	{
 	  LOGI("GL_EXTENTIONS:");
@@ -752,6 +982,9 @@ void Renderer::Initialize(const Window& window)
 		if (e == "GL_NV_fence") {
 		  hasNVfenceExtension = true;
 		}
+		if (e == "GL_EXT_discard_framebuffer") {
+		  hasDiscardFramebufferExtension = true;
+		}
 		if (e == "GL_OES_depth32") {
 		  depthComponentType = GL_DEPTH_COMPONENT32_OES;
 		} else if (depthComponentType != GL_DEPTH_COMPONENT32_OES) {
@@ -767,15 +1000,17 @@ void Renderer::Initialize(const Window& window)
 	  static const struct {
 		GLenum id;
 		const char* str;
+		uint8_t byteSize;
 	  } depthInfo[] = {
-		{ GL_DEPTH_COMPONENT32_OES, "32" },
-		{ GL_DEPTH_COMPONENT24_OES, "24" },
-		{ GL_DEPTH24_STENCIL8_OES, "24/8" },
-		{ GL_DEPTH_COMPONENT16, "16" },
+		{ GL_DEPTH_COMPONENT32_OES, "32", 4 },
+		{ GL_DEPTH_COMPONENT24_OES, "24", 4 },
+		{ GL_DEPTH24_STENCIL8_OES, "24/8", 4 },
+		{ GL_DEPTH_COMPONENT16, "16", 2 },
 	  };
 	  for (const auto& e : depthInfo) {
 		if (e.id == depthComponentType) {
 		  LOGI("Depth buffer precision: %s", e.str);
+		  depthByteSize = e.byteSize;
 		  break;
 		}
 	  }
@@ -783,7 +1018,14 @@ void Renderer::Initialize(const Window& window)
 #undef MAKE_TEX_ID_PAIR
 #undef LOG_SHADER_INFO
 
-	InitNVFenceExtention(hasNVfenceExtension);
+	hasGPUTimer = InitNVFenceExtention(hasNVfenceExtension);
+	qualityGovernor.Reset(1.0f / 30.0f);
+	Texture::SetResidencyBudget(textureBudgetByteSize);
+	// the GL thread also runs, so the one hardware thread is left for it.
+	assetLoader.Start(GetHardwareThreadCount() - 1);
+	Texture::SetAssetLoader(&assetLoader);
+	prevFrameTime = 0;
+	hasDiscardFramebuffer = InitDiscardFramebufferExtension(hasDiscardFramebufferExtension);
 
 	glGetIntegerv(GL_VIEWPORT, viewport);
 	LOGI("viewport: %dx%d", viewport[2], viewport[3]);
@@ -809,38 +1051,79 @@ void Renderer::Initialize(const Window& window)
 	  LOGI("FBO MAIN: %dx%d", fboMainInfo.width, fboMainInfo.height);
 	  additionalDefineList << "#define MAIN_RENDERING_PATH_WIDTH (" << fboMainInfo.width << ".0)\n";
 	  additionalDefineList << "#define MAIN_RENDERING_PATH_HEIGHT (" << fboMainInfo.height << ".0)\n";
+	  // the tangent space normal map has only XY, and Z is rebuilt by DECODE_NORMAL_Z.
+	  // the LUMINANCE_ALPHA map for Others has X in L, the ATITC map for Adreno has X in G.
+	  additionalDefineList << "#define NORMAL_MAP_XY " << normalMapSwizzle << "\n";
+	  additionalDefineList << "#define BONE_PALETTE_SIZE " << bonePaletteSize << "\n";
+	  additionalDefineList << "#define DQ_BONE_PALETTE_SIZE " << dualQuaternionBonePaletteSize << "\n";
+	}
+
+	// the PBR fragment shaders share the IBL functions in the library.
+	// USE_BRDF_LUT is selected for each shader. the main objects use the precomputed table,
+	// and the sea and the background landscape that cover the wide area use the analytic fresnel term.
+	std::string iblLibrary;
+	if (auto buf = FileSystem::LoadFile("Shaders/ibl.glsl")) {
+	  iblLibrary.assign(buf->begin(), buf->end());
+	} else {
+	  LOGE("Can't load Shaders/ibl.glsl");
 	}
-
+	static const char brdfLUTDefine[] = "#define USE_BRDF_LUT\n";
 	static const struct {
 	  ShaderType type;
 	  const char* name;
+	  const char* defineList;
+	  bool useIBL;
 	} shaderInfoList[] = {
-	  { ShaderType::Complex3D, "default" },
-	  { ShaderType::Complex3D, "defaultWithAlpha" },
-	  { ShaderType::Complex3D, "default2D" },
-	  { ShaderType::Complex3D, "cloud" },
-	  { ShaderType::Simple3D, "solidmodel" },
-	  { ShaderType::Simple3D, "sea" },
-	  { ShaderType::Complex3D, "emission" },
-	  { ShaderType::Complex3D, "skybox" },
-	  { ShaderType::Complex3D, "shadow" },
-	  { ShaderType::Complex3D, "bilinear4x4" },
-	  { ShaderType::Complex3D, "sample4" },
-	  { ShaderType::Complex3D, "reduceLum" },
-	  { ShaderType::Complex3D, "hdrdiff" },
-	  { ShaderType::Complex3D, "applyhdr" },
-	  { ShaderType::Complex3D, "tbn" },
-	  { ShaderType::Complex3D, "font" },
+	  { ShaderType::Complex3D, "default", brdfLUTDefine, true },
+	  { ShaderType::Complex3D, "defaultWithAlpha", brdfLUTDefine, true },
+	  { ShaderType::Complex3D, "default2D", "", false },
+	  { ShaderType::Complex3D, "cloud", "", false },
+	  { ShaderType::Simple3D, "solidmodel", "", true },
+	  { ShaderType::Simple3D, "sea", "", true },
+	  { ShaderType::Complex3D, "emission", "", false },
+	  { ShaderType::Complex3D, "skybox", "", false },
+	  { ShaderType::Complex3D, "shadow", "", false },
+	  { ShaderType::Complex3D, "bilinear4x4", "", false },
+	  { ShaderType::Complex3D, "sample4", "", false },
+	  { ShaderType::Complex3D, "reduceLum", "", false },
+	  { ShaderType::Complex3D, "hdrdiff", "", false },
+	  { ShaderType::Complex3D, "applyhdr", "", false },
+	  { ShaderType::Complex3D, "tbn", "", false },
+	  { ShaderType::Complex3D, "font", "", false },
+	  { ShaderType::Complex3D, "particle", "", false },
 	};
 	for (const auto e : shaderInfoList) {
 		const std::string vert = std::string("Shaders/") + std::string(e.name) + std::string(".vert");
 		const std::string frag = std::string("Shaders/") + std::string(e.name) + std::string(".frag");
-		if (boost::optional<Shader> s = CreateShaderProgram(e.name, vert.c_str(), frag.c_str(), additionalDefineList.str())) {
+		if (boost::optional<Shader> s = CreateShaderProgram(e.name, vert.c_str(), frag.c_str(), additionalDefineList.str() + e.defineList, e.useIBL ? iblLibrary : std::string())) {
+			s->type = e.type;
+			shaderList.insert({ s->id, *s });
+		}
+	}
+	// the variants are compiled from the same source with the additional definitions.
+	static const struct {
+	  ShaderType type;
+	  const char* name;
+	  const char* source;
+	  const char* defineList;
+	  bool useIBL;
+	} shaderVariantList[] = {
+	  { ShaderType::Complex3D, "defaultDQ", "default", "#define USE_DUAL_QUATERNION_SKINNING\n#define USE_BRDF_LUT\n", true },
+	  { ShaderType::Complex3D, "shadowDQ", "shadow", "#define USE_DUAL_QUATERNION_SKINNING\n", false },
+	};
+	for (const auto e : shaderVariantList) {
+		const std::string vert = std::string("Shaders/") + std::string(e.source) + std::string(".vert");
+		const std::string frag = std::string("Shaders/") + std::string(e.source) + std::string(".frag");
+		if (boost::optional<Shader> s = CreateShaderProgram(e.name, vert.c_str(), frag.c_str(), additionalDefineList.str() + e.defineList, e.useIBL ? iblLibrary : std::string())) {
 			s->type = e.type;
 			shaderList.insert({ s->id, *s });
 		}
 	}
 
+	{
+	  const std::vector<uint8_t> lut = LoadBRDFLUT(window);
+	  textureList.insert({ "brdfLUT", Texture::Create2D(brdfLUTSize, brdfLUTSize, GL_LUMINANCE_ALPHA, &lut[0]) });
+	}
 	InitTexture();
 
 	{
@@ -859,6 +1142,25 @@ void Renderer::Initialize(const Window& window)
 		fontRenderingInfoList.clear();
 		fontRenderingInfoList.reserve(MAX_FONT_RENDERING_COUNT / 8);
 
+		glGenBuffers(1, &vboParticle);
+		glBindBuffer(GL_ARRAY_BUFFER, vboParticle);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(ParticleVertex) * ParticleSystem::maxVertexCount, 0, GL_STREAM_DRAW);
+		particleVertexList.resize(ParticleSystem::maxVertexCount);
+		{
+		  // all materials share the same indices, because the vertex pointer is moved to the first vertex of each material.
+		  std::vector<GLushort> indices;
+		  indices.reserve(ParticleSystem::maxParticleCount * 6);
+		  for (GLushort i = 0; i < ParticleSystem::maxParticleCount * 4; i += 4) {
+			static const GLushort offsetList[] = { 0, 1, 2, 2, 1, 3 };
+			for (auto e : offsetList) {
+			  indices.push_back(i + e);
+			}
+		  }
+		  glGenBuffers(1, &iboParticle);
+		  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboParticle);
+		  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), &indices[0], GL_STATIC_DRAW);
+		}
+
 		glGenBuffers(1, &ibo);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, iboBufferSize, 0, GL_STATIC_DRAW);
@@ -871,9 +1173,6 @@ void Renderer::Initialize(const Window& window)
 #endif // SHOW_TANGENT_SPACE
 		InitMesh();
 
-		LOGI("VBO: %03.1f%%", static_cast<float>(vboEnd * 100) / static_cast<float>(vboBufferSize));
-		LOGI("IBO: %03.1f%%", static_cast<float>(iboEnd * 100) / static_cast<float>(iboBufferSize));
-
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
@@ -1095,7 +1394,210 @@ void Renderer::DrawFontFoo()
   glEnable(GL_CULL_FACE);
 }
 
+namespace {
+
+/** Upload the bone transformations of the skinned object.
+
+  @param shader     The shader that receives the bone transformations.
+  @param store      The storage that has the bone transformations.
+  @param id         The ID of the object.
+  @param boneCount  The number of the bones to upload.
+*/
+void UploadBones(const Shader& shader, const ObjectStore& store, ObjectId id, size_t boneCount)
+{
+  if (shader.boneDualQuaternions >= 0) {
+	glUniform4fv(shader.boneDualQuaternions, boneCount * 2, &store.boneDualQuaternionList[id][0].x);
+	glUniform4fv(shader.matModel, 3, store.boneModelMatrixList[id].f);
+  } else {
+	glUniform4fv(shader.bones, boneCount * 3, store.boneList[id][0].f);
+  }
+}
+
+/** Get the model matrix of the object without the bones.
+
+  The world transforms must be updated by ObjectStore::UpdateTransforms().
+
+  @param store  The storage of the objects.
+  @param id     The ID of the object.
+
+  @return The matrix that has the scale, the rotation and the translation.
+*/
+Matrix4x3 GetModelMatrix(const ObjectStore& store, ObjectId id)
+{
+  const Vector3F& scale = store.scaleList[id];
+  Matrix4x3 mScale = Matrix4x3::Unit();
+  mScale.Set(0, 0, scale.x);
+  mScale.Set(1, 1, scale.y);
+  mScale.Set(2, 2, scale.z);
+  return ToMatrix(store.rotTransList[id]) * mScale;
+}
+
+/** Upload the transformation of the object without the bones.
+
+  @param shader  The shader that receives the transformation.
+  @param m       The model matrix of the object.
+*/
+void UploadModelMatrix(const Shader& shader, const Matrix4x3& m)
+{
+  if (shader.boneDualQuaternions >= 0) {
+	static const Vector4F unitDualQuaternion[2] = { Vector4F(0, 0, 0, 1), Vector4F(0, 0, 0, 0) };
+	glUniform4fv(shader.boneDualQuaternions, 2, &unitDualQuaternion[0].x);
+	glUniform4fv(shader.matModel, 3, m.f);
+  } else {
+	glUniform4fv(shader.bones, 3, m.f);
+  }
+}
+
+} // unnamed namespace
+
+/** Upload the bone matrices that the material of the split mesh refers.
+
+  The mesh must have the bone palettes.
+
+  @param shader    The shader that receives the bone matrices.
+  @param id        The ID of the object that has the bone matrices.
+  @param material  The material to draw.
+*/
+void Renderer::UploadBonePalette(const Shader& shader, ObjectId id, const Mesh::Mesh::MeshMaterial& material)
+{
+  const Mesh::Mesh::BonePalette& palette = objectStore.meshList[id]->bonePaletteList[material.bonePalette];
+  if (shader.boneDualQuaternions >= 0) {
+	bonePaletteDualQuaternionBuffer.resize(palette.size() * 2);
+	for (size_t i = 0; i < palette.size(); ++i) {
+	  const Vector4F* p = &objectStore.boneDualQuaternionList[id][palette[i] * 2];
+	  bonePaletteDualQuaternionBuffer[i * 2] = p[0];
+	  bonePaletteDualQuaternionBuffer[i * 2 + 1] = p[1];
+	}
+	if (!bonePaletteDualQuaternionBuffer.empty()) {
+	  glUniform4fv(shader.boneDualQuaternions, bonePaletteDualQuaternionBuffer.size(), &bonePaletteDualQuaternionBuffer[0].x);
+	}
+	glUniform4fv(shader.matModel, 3, objectStore.boneModelMatrixList[id].f);
+	return;
+  }
+  bonePaletteBuffer.resize(palette.size());
+  for (size_t i = 0; i < palette.size(); ++i) {
+	bonePaletteBuffer[i] = objectStore.boneList[id][palette[i]];
+  }
+  if (!bonePaletteBuffer.empty()) {
+	glUniform4fv(shader.bones, bonePaletteBuffer.size() * 3, bonePaletteBuffer[0].f);
+  }
+}
+
+/** Render all particles.
+
+  The vertices of all particles are written to the streaming buffer at once, and
+  the particles of each material are drawn by one draw call.
+  The depth test is enabled but the depth buffer is not updated.
+
+  @param mView              The view matrix.
+  @param mProj              The projection matrix.
+  @param dynamicRangeFactor The scale factor to store the color into the color path.
+*/
+void Renderer::DrawParticles(const Matrix4x4& mView, const Matrix4x4& mProj, float dynamicRangeFactor)
+{
+  const Vector3F right(mView.f[0], mView.f[4], mView.f[8]);
+  const Vector3F up(mView.f[1], mView.f[5], mView.f[9]);
+  ParticleSystem::DrawRangeList rangeList;
+  const size_t vertexCount = particleSystem.BuildVertices(&particleVertexList[0], right, up, rangeList);
+  if (!vertexCount) {
+	return;
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, vboParticle);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(ParticleVertex) * ParticleSystem::maxVertexCount, 0, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(ParticleVertex) * vertexCount, &particleVertexList[0]);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboParticle);
+
+  const Shader& shader = shaderList["particle"];
+  glUseProgram(shader.program);
+  glUniformMatrix4fv(shader.matProjection, 1, GL_FALSE, mProj.f);
+  glUniformMatrix4fv(shader.matView, 1, GL_FALSE, mView.f);
+  glUniform1f(shader.dynamicRangeFactor, dynamicRangeFactor);
+  glDepthMask(GL_FALSE);
+  glDisable(GL_CULL_FACE);
+
+  for (int i = 0; i < VertexAttribLocation_Max; ++i) {
+	glDisableVertexAttribArray(i);
+  }
+  glEnableVertexAttribArray(VertexAttribLocation_Position);
+  glEnableVertexAttribArray(VertexAttribLocation_TexCoord01);
+  glEnableVertexAttribArray(VertexAttribLocation_Color);
+  static const int32_t stride = sizeof(ParticleVertex);
+  for (int i = 0; i < ParticleMaterial_Count; ++i) {
+	const ParticleSystem::DrawRange& range = rangeList[i];
+	if (!range.particleCount) {
+	  continue;
+	}
+	if (i == ParticleMaterial_Additive) {
+	  glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+	} else {
+	  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+	const size_t base = range.first * stride;
+	glVertexAttribPointer(VertexAttribLocation_Position, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(base + offsetof(ParticleVertex, position)));
+	glVertexAttribPointer(VertexAttribLocation_TexCoord01, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, reinterpret_cast<void*>(base + offsetof(ParticleVertex, texCoord)));
+	glVertexAttribPointer(VertexAttribLocation_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<void*>(base + offsetof(ParticleVertex, color)));
+	glDrawElements(GL_TRIANGLES, range.particleCount * 6, GL_UNSIGNED_SHORT, 0);
+  }
+  glDisableVertexAttribArray(VertexAttribLocation_Color);
+
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glDepthMask(GL_TRUE);
+  glEnable(GL_CULL_FACE);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+}
+
+/** Resolve the mesh and the shader of the object if they are reset.
+
+  @param id  The ID of the object.
+
+  @retval true   the object can be drawn.
+  @retval false  the object has no mesh or no shader.
+*/
+bool Renderer::ResolveHandles(ObjectId id)
+{
+  if (!objectStore.validList[id]) {
+	return false;
+  }
+  if (!objectStore.meshList[id]) {
+	const Mesh::Mesh* p = GetMesh(objectStore.meshIdList[id]);
+	if (!p) {
+	  return false;
+	}
+	objectStore.SetMesh(id, p);
+  }
+  if (!objectStore.shaderList[id]) {
+	objectStore.shaderList[id] = GetShader(objectStore.shaderIdList[id]);
+  }
+  return objectStore.shaderList[id] != nullptr;
+}
+
+/** Render the objects.
+
+  @param begin  The first object to render.
+  @param end    The object next to the last one.
+
+  @sa Render(const std::vector<ObjectId>&)
+*/
 void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
+{
+	renderIdList.clear();
+	for (const ObjectPtr* itr = begin; itr != end; ++itr) {
+		renderIdList.push_back((*itr)->GetId());
+	}
+	Render(renderIdList);
+}
+
+/** Render the objects.
+
+  The objects are given by the IDs, so the culling and the submission read the arrays
+  of ObjectStore without chasing the pointers.
+  The objects must be alive until it returns.
+
+  @param idList  The IDs of the objects to render.
+*/
+void Renderer::Render(const std::vector<ObjectId>& idList)
 {
 	static const int32_t stride = sizeof(Vertex);
 	static const void* const offPosition = reinterpret_cast<void*>(offsetof(Vertex, position));
@@ -1111,20 +1613,49 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 
 	LOG_GL_ERROR("Begin");
 
+	if (assetLoader.ProcessUploads(assetUploadTimeBudget) && assetLoader.IsCompleted()) {
+	  LOGI("VBO: %03.1f%%", static_cast<float>(vboEnd * 100) / static_cast<float>(vboBufferSize));
+	  LOGI("IBO: %03.1f%%", static_cast<float>(iboEnd * 100) / static_cast<float>(iboBufferSize));
+	}
+	Texture::UpdateResidency();
+	Texture::UpdateStreaming(textureStreamingByteBudget);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	discardedByteSize = 0;
+	animationLodCountList = animationLodCounter;
+	animationLodCounter.fill(0);
+	objectStore.UpdateTransforms();
+	drawIdList.clear();
+	for (ObjectId id : idList) {
+		if (ResolveHandles(id)) {
+			drawIdList.push_back(id);
+		}
+	}
+	const ObjectStore& store = objectStore;
 
-	// Ƃ肠KȃJf[^r[sݒ.
+	// the quality features selected by the governor.
+	const int64_t frameStartTime = GetCurrentTime();
+	const float frameTime = prevFrameTime ? static_cast<float>(frameStartTime - prevFrameTime) * (1.0f / 1000000000.0f) : 0.0f;
+	prevFrameTime = frameStartTime;
+	const bool useShadowBlur = qualityGovernor.IsEnabled(QualityFeature_ShadowBlur);
+	const int shadowMapScale = qualityGovernor.IsEnabled(QualityFeature_ShadowMapSize) ? 1 : 2;
+	const bool useBloom = qualityGovernor.IsEnabled(QualityFeature_Bloom);
+	const bool useFullCloud = qualityGovernor.IsEnabled(QualityFeature_CloudResolution);
+	const float lodBias = qualityGovernor.IsEnabled(QualityFeature_LodBias) ? 0.0f : 1.0f;
+	const float renderScale = qualityGovernor.IsEnabled(QualityFeature_RenderScale) ? 1.0f : 0.75f;
+
+	// とりあえず適当なカメラデータからビュー行列を設定.
 	const Position3F eye = cameraPos;
 	const Position3F at = cameraPos + cameraDir;
 	const Matrix4x4 mView = LookAt(eye, at, cameraUp);
 
-	// 9:16̂Ƃ60ƂAAXyNgɉĕύXB
+	// 9:16のときを60をとし、アスペクト比に応じて変更する。
 	static const float baseAspectRatio = 9.0f / 16.0f;
 	const float aspectRatio = static_cast<float>(viewport[2]) / static_cast<float>(viewport[3]);
 	const float fov = 60.0f / baseAspectRatio * aspectRatio;
+	cameraFov = fov;
 
-	// ptH[}Xv.
+	// パフォーマンス計測準備.
 	static const int FENCE_ID_SHADOW_PATH = 0;
 	static const int FENCE_ID_SHADOW_FILTER_PATH = 1;
 	static const int FENCE_ID_COLOR_PATH = 2;
@@ -1149,8 +1680,8 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	  const Vector2F ca = c - a;
 	  const Position2F p = a + ca * 0.5f;
 	  const Vector2F v = Vector2F(-ca.y, ca.x).Normalize();
-	  const float distance = p.y + p.x * v.y; // _王̊Oډ~̒S܂ł̋.
-	  //const float r = (a - Position2F(0, distance)).Length(); // ̊Oډ~̔a.
+	  const float distance = p.y + p.x * v.y; // 視点から視錐台の外接円の中心までの距離.
+	  //const float r = (a - Position2F(0, distance)).Length(); // 視錐台の外接円の半径.
 
 	  const Vector3F vEye = (at - eye).Normalize();
 	  const Position3F frustumCenter = eye + (vEye * distance);
@@ -1192,24 +1723,41 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 		glCullFace(GL_BACK);
 		glBlendFunc(GL_ONE, GL_ZERO);
 
-		glViewport(0, 0, fboShadowInfo.width, fboShadowInfo.height);
+		glViewport(0, 0, fboShadowInfo.width / shadowMapScale, fboShadowInfo.height / shadowMapScale);
 		glClearColor(1.0f, 0.0f, 0.0f, 0.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// the objects of the dual quaternion skinning are drawn by its variant.
+		const auto itrShadowDQ = shaderList.find("shadowDQ");
+		const Shader* pShadowDQ = itrShadowDQ != shaderList.end() ? &itrShadowDQ->second : nullptr;
+		if (pShadowDQ) {
+		  glUseProgram(pShadowDQ->program);
+		  glUniform3f(pShadowDQ->lightDirForShadow, shadowLightDir.x, shadowLightDir.y, shadowLightDir.z);
+		  glUniformMatrix4fv(pShadowDQ->matLightForShadow, 1, GL_FALSE, mVPForShadow.f);
+		}
 		const Shader& shader = shaderList["shadow"];
 		glUseProgram(shader.program);
 		glUniform3f(shader.lightDirForShadow, shadowLightDir.x, shadowLightDir.y, shadowLightDir.z);
 		glUniformMatrix4fv(shader.matLightForShadow, 1, GL_FALSE, mVPForShadow.f);
 
-		for (const ObjectPtr* itr = begin; itr != end; ++itr) {
-			const Object& obj = *itr->get();
-			if (!obj.IsValid() || obj.shadowCapability == ShadowCapability::Disable) {
+		GLuint currentProgram = shader.program;
+		for (ObjectId id : drawIdList) {
+			if (store.shadowCapabilityList[id] == ShadowCapability::Disable) {
 				continue;
 			}
+			const bool useDualQuaternion = store.shaderList[id]->boneDualQuaternions >= 0;
+			if (useDualQuaternion && !pShadowDQ) {
+				continue;
+			}
+			const Shader& shadowShader = useDualQuaternion ? *pShadowDQ : shader;
+			if (shadowShader.program != currentProgram) {
+				glUseProgram(shadowShader.program);
+				currentProgram = shadowShader.program;
+			}
 
 #ifdef USE_ALPHA_TEST_IN_SHADOW_RENDERING
 			{
-			  const Mesh::Mesh& mesh = *obj.GetMesh();
+			  const Mesh::Mesh& mesh = *store.meshList[id];
 			  if (mesh.texDiffuse) {
 				SetTexture(GL_TEXTURE0, GL_TEXTURE_2D, mesh.texDiffuse);
 			  } else {
@@ -1218,18 +1766,29 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 			}
 #endif // USE_ALPHA_TEST_IN_SHADOW_RENDERING
 
-			const size_t boneCount = std::min(obj.GetBoneCount(), static_cast<size_t>(32));
+			const Mesh::Mesh& mesh = *store.meshList[id];
+			if (!mesh.bonePaletteList.empty()) {
+			  // the split mesh uploads the palette of each batch.
+			  int currentPalette = -1;
+			  for (const auto& e : mesh.materialList) {
+				if (e.bonePalette != currentPalette) {
+				  UploadBonePalette(shadowShader, id, e);
+				  currentPalette = e.bonePalette;
+				}
+				glDrawElements(GL_TRIANGLES, e.iboSize, GL_UNSIGNED_SHORT, reinterpret_cast<GLvoid*>(e.iboOffset));
+			  }
+			  continue;
+			}
+			const size_t boneCount = std::min(store.boneList[id].size(), GetBonePaletteSize(shadowShader));
 			if (boneCount) {
-				glUniform4fv(shader.bones, boneCount * 3, obj.GetBoneMatirxArray());
+				UploadBones(shadowShader, store, id, boneCount);
 			} else {
-			  Matrix4x3 mScale = Matrix4x3::Unit();
-			  mScale.Set(0, 0, obj.Scale().x);
-			  mScale.Set(1, 1, obj.Scale().y);
-			  mScale.Set(2, 2, obj.Scale().z);
-			  const Matrix4x3 m =  ToMatrix(obj.RotTrans()) * mScale;
-			  glUniform4fv(shader.bones, 3, m.f);
+			  UploadModelMatrix(shadowShader, GetModelMatrix(store, id));
 			}
-			obj.GetMesh()->Draw();
+			mesh.Draw();
+		}
+		if (currentProgram != shader.program) {
+		  glUseProgram(shader.program);
 		}
 		if(0){
 		  glCullFace(GL_BACK);
@@ -1242,8 +1801,8 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 		  const Vector2F ca = c - a;
 		  const Position2F p = a + ca * 0.5f;
 		  const Vector2F v = Vector2F(-ca.y, ca.x).Normalize();
-		  const float distance = p.y + p.x * v.y; // _王̊Oډ~̒S܂ł̋.
-		  const float r = (a - Position2F(0, distance)).Length(); // ̊Oډ~̔a.
+		  const float distance = p.y + p.x * v.y; // 視点から視錐台の外接円の中心までの距離.
+		  const float r = (a - Position2F(0, distance)).Length(); // 視錐台の外接円の半径.
 
 		  const Vector3F vEye = (at - eye).Normalize();
 		  const Position3F frustumCenter = eye + (vEye * distance);
@@ -1254,6 +1813,8 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 		  glUniform4fv(shader.bones, 3, m.f);
 		  meshList["Sphere"].Draw();
 		}
+		// the depth of shadow is not needed any more, because it is stored to the color buffer.
+		EndRenderTarget(FBO_Shadow, GL_DEPTH_BUFFER_BIT);
 
 		Local::glSetFenceNV(fences[FENCE_ID_SHADOW_PATH], GL_ALL_COMPLETED_NV);
 	}
@@ -1267,12 +1828,14 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 
 		const FBOInfo fboShadow1Info = GetFBOInfo(FBO_Shadow1);
 		glBindFramebuffer(GL_FRAMEBUFFER, *fboShadow1Info.p);
+		BeginRenderTarget(FBO_Shadow1, GL_COLOR_BUFFER_BIT);
 		glViewport(0, 0, fboShadow1Info.width, fboShadow1Info.height);
 		glDisable(GL_DEPTH_TEST);
 		glDisable(GL_CULL_FACE);
 		glBlendFunc(GL_ONE, GL_ZERO);
 
-		const Shader& shader = shaderList["bilinear4x4"];
+		// copy only if the blur is disabled by the quality governor.
+		const Shader& shader = shaderList[useShadowBlur ? "bilinear4x4" : "default2D"];
 		glUseProgram(shader.program);
 
 		static float scaleY = 1.0f;
@@ -1280,8 +1843,20 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 		mtx.Scale(1.0f, scaleY, 1.0f);
 		glUniformMatrix4fv(shader.matProjection, 1, GL_FALSE, mtx.f);
 		glUniformMatrix4fv(shader.matView, 1, GL_FALSE, Matrix4x4::Unit().f);
+		glUniform4f(shader.materialColor, 1.0f, 1.0f, 1.0f, 1.0f);
+
+		const FBOInfo fboMainInternalInfo = GetFBOInfo(FBO_Main_Internal);
+		const FBOInfo fboShadowInfo = GetFBOInfo(FBO_Shadow);
+		glUniform4f(
+		  shader.unitTexCoord,
+		  static_cast<float>(fboShadowInfo.width / shadowMapScale) / static_cast<float>(fboMainInternalInfo.width),
+		  static_cast<float>(fboShadowInfo.height / shadowMapScale) / static_cast<float>(fboMainInternalInfo.height),
+		  0.0f,
+		  0.0f
+		);
 
 		glUniform1i(shader.texShadow, 0);
+		glUniform1i(shader.texDiffuse, 0);
 		SetTexture(GL_TEXTURE0, GL_TEXTURE_2D, textureList[GetFBOInfo(FBO_Main).name]);
 
 		meshList["board2D"].Draw();
@@ -1294,7 +1869,9 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	// color path.
 	const FBOInfo fboMainInfo = GetFBOInfo(FBO_Main);
 	glBindFramebuffer(GL_FRAMEBUFFER, *fboMainInfo.p);
-	glViewport(0, 0, fboMainInfo.width, fboMainInfo.height);
+	const GLsizei colorPathWidth = static_cast<GLsizei>(fboMainInfo.width * renderScale);
+	const GLsizei colorPathHeight = static_cast<GLsizei>(fboMainInfo.height * renderScale);
+	glViewport(0, 0, colorPathWidth, colorPathHeight);
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LESS);
 	glEnable(GL_CULL_FACE);
@@ -1337,7 +1914,7 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	};
 	const float dynamicRangeFactor = iblDynamicRangeArray[timeOfScene].range;
 
-	// KɃCguĂ݂.
+	// 適当にライトを置いてみる.
 	const Vector4F lightPos(50, 50, 50, 1.0);
 	const Vector3F lightColor(7000.0f, 6000.0f, 5000.0f);
 #if 1
@@ -1369,18 +1946,50 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	const GLuint seaProgramId = shaderList["sea"].program;
 	GLuint currentProgramId = 0;
 	const int iblSourceSize = iblSpecularSourceList.size() - 1;
-	for (const ObjectPtr* itr = begin; itr != end; ++itr) {
-		const Object& obj = *itr->get();
-		if (!obj.IsValid() || obj.shadowCapability == ShadowCapability::ShadowOnly || !hasIBLTextures) {
+
+	// sort the opaque objects by the textures to reduce the texture binding.
+	// the sorting is limited in the run of the objects that have the same shader,
+	// because the drawing order of the translucent objects and the shaders must be kept.
+	for (auto runBegin = drawIdList.begin(); runBegin != drawIdList.end();) {
+		const auto isSortable = [&store](ObjectId id) { return store.materialList[id].color.a == 255; };
+		auto runEnd = runBegin + 1;
+		if (isSortable(*runBegin)) {
+			const Shader* pShader = store.shaderList[*runBegin];
+			while (runEnd != drawIdList.end() && isSortable(*runEnd) && store.shaderList[*runEnd] == pShader) {
+				++runEnd;
+			}
+			std::stable_sort(runBegin, runEnd, [&store](ObjectId lhs, ObjectId rhs) {
+				const Mesh::Mesh& l = *store.meshList[lhs];
+				const Mesh::Mesh& r = *store.meshList[rhs];
+				if (l.texDiffuse != r.texDiffuse) {
+					return l.texDiffuse < r.texDiffuse;
+				}
+				return l.texNormal < r.texNormal;
+			});
+		}
+		runBegin = runEnd;
+	}
+	// the texture cache to skip the redundant binding. ~0 means unknown.
+	GLuint boundTextureId[3] = { ~0U, ~0U, ~0U };
+	int textureBindCount = 0;
+
+	for (ObjectId id : drawIdList) {
+		if (store.shadowCapabilityList[id] == ShadowCapability::ShadowOnly || !hasIBLTextures) {
 			continue;
 		}
 
-		const Shader& shader = *obj.GetShader();
+		const Shader& shader = *store.shaderList[id];
+		// skip the half of clouds by the object id, so the same clouds are skipped in every frame
+		// regardless of the drawing order.
+		if (shader.program == cloudProgramId && !useFullCloud && (id & 1)) {
+			continue;
+		}
 		if (shader.program && shader.program != currentProgramId) {
 			glUseProgram(shader.program);
 			currentProgramId = shader.program;
 
 			glUniform1f(shader.dynamicRangeFactor, dynamicRangeFactor);
+			glUniform1f(shader.lodBias, lodBias);
 
 			glUniformMatrix4fv(shader.matProjection, 1, GL_FALSE, mProj.f);
 			glUniformMatrix4fv(shader.matView, 1, GL_FALSE, mView.f);
@@ -1392,11 +2001,14 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 
 			glUniform1i(shader.texDiffuse, 0);
 			glUniform1i(shader.texNormal, 1);
-			static const int texIBLId[] = { 2, 3, 4 };
-			glUniform1iv(shader.texIBL, 3, texIBLId);
+			static const int texIBLId[] = { 2, 3 };
+			glUniform1iv(shader.texIBL, 2, texIBLId);
 			glUniform1i(shader.texShadow, 5);
+			glUniform1i(shader.texBRDF, 6);
+			glUniform3fv(shader.shIrradiance, 9, &irradianceSH[0].x);
 
 
+			boundTextureId[2] = ~0U;
 			if (shader.program == cloudProgramId) {
 				for (int i = 0; i < 4; ++i) {
 					ResetTexture(GL_TEXTURE2 + i, GL_TEXTURE_2D);
@@ -1404,11 +2016,11 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 				glDepthMask(GL_FALSE);
 				glDisable(GL_CULL_FACE);
 			} else {
-				// IBLpeNX`ݒ.
+				// IBL用テクスチャを設定.
 				SetTexture(GL_TEXTURE2, GL_TEXTURE_CUBE_MAP, iblSpecularSourceList[0]);
 				SetTexture(GL_TEXTURE3, GL_TEXTURE_CUBE_MAP, iblSpecularSourceList[3]);
-				SetTexture(GL_TEXTURE4, GL_TEXTURE_CUBE_MAP, iblDiffuseSourceList);
 				SetTexture(GL_TEXTURE5, GL_TEXTURE_2D, textureList["fboShadow1"]);
+				SetTexture(GL_TEXTURE6, GL_TEXTURE_2D, textureList["brdfLUT"]);
 				glDepthMask(GL_TRUE);
 				glEnable(GL_CULL_FACE);
 			}
@@ -1418,7 +2030,8 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 #endif // SUNNYSIDEUP_DEBUG
 		}
 
-		const Vector4F materialColor = obj.Color().ToVector4F();
+		const Material& material = store.materialList[id];
+		const Vector4F materialColor = material.color.ToVector4F();
 		if (shader.program == cloudProgramId) {
 		  const auto& e = iblDynamicRangeArray[timeOfScene];
 		  const Vector3F color0 = e.cloudColorMain * e.range * e.inverse;
@@ -1428,38 +2041,59 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 		} else {
 		  glUniform4fv(shader.materialColor, 1, &materialColor.x);
 		}
-		const float metallic = obj.Metallic();
-		const float roughness = obj.Roughness();
+		const float metallic = material.metallic.To<float>();
+		const float roughness = material.roughness.To<float>();
 		if (shader.program == seaProgramId) {
 		  glUniform3f(shader.materialMetallicAndRoughness, metallic, roughness, animationTick);
 		} else {
 		  glUniform2f(shader.materialMetallicAndRoughness, metallic, roughness);
 		}
 
-		const Mesh::Mesh& mesh = *obj.GetMesh();
+		const Mesh::Mesh& mesh = *store.meshList[id];
 		{
+			// request the finer mip level for the nearer object.
+			int mipLevel = 0;
+			for (float d = (store.rotTransList[id].trans.ToPosition3F() - eye).Length(); d > textureStreamingDistance; d *= 0.5f) {
+				++mipLevel;
+			}
 			if (mesh.texDiffuse) {
-				SetTexture(GL_TEXTURE0, GL_TEXTURE_2D, mesh.texDiffuse);
-			} else {
-				ResetTexture(GL_TEXTURE0, GL_TEXTURE_2D);
+				Texture::RequestMipLevel(mesh.texDiffuse, mipLevel);
 			}
 			if (mesh.texNormal) {
-				SetTexture(GL_TEXTURE1, GL_TEXTURE_2D, mesh.texNormal);
-			} else {
-				ResetTexture(GL_TEXTURE1, GL_TEXTURE_2D);
+				Texture::RequestMipLevel(mesh.texNormal, mipLevel);
+			}
+			const GLuint diffuseId = mesh.texDiffuse ? mesh.texDiffuse->TextureId() : 0;
+			if (diffuseId != boundTextureId[0]) {
+				if (mesh.texDiffuse) {
+					SetTexture(GL_TEXTURE0, GL_TEXTURE_2D, mesh.texDiffuse);
+				} else {
+					ResetTexture(GL_TEXTURE0, GL_TEXTURE_2D);
+				}
+				boundTextureId[0] = diffuseId;
+				++textureBindCount;
+			}
+			const GLuint normalId = mesh.texNormal ? mesh.texNormal->TextureId() : 0;
+			if (normalId != boundTextureId[1]) {
+				if (mesh.texNormal) {
+					SetTexture(GL_TEXTURE1, GL_TEXTURE_2D, mesh.texNormal);
+				} else {
+					ResetTexture(GL_TEXTURE1, GL_TEXTURE_2D);
+				}
+				boundTextureId[1] = normalId;
+				++textureBindCount;
 			}
+			glUniform4fv(shader.unitTexCoord, 1, &mesh.texCoordScaleOffset.x);
 		}
 
-		const size_t boneCount = std::min(obj.GetBoneCount(), static_cast<size_t>(32));
+		const size_t boneCount = std::min(store.boneList[id].size(), GetBonePaletteSize(shader));
 		if (boneCount) {
-			glUniform4fv(shader.bones, boneCount * 3, obj.GetBoneMatirxArray());
+			// the split mesh uploads the palette of each batch.
+			if (mesh.bonePaletteList.empty()) {
+				UploadBones(shader, store, id, boneCount);
+			}
 		} else {
-		  Matrix4x3 mScale = Matrix4x3::Unit();
-		  mScale.Set(0, 0, obj.Scale().x);
-		  mScale.Set(1, 1, obj.Scale().y);
-		  mScale.Set(2, 2, obj.Scale().z);
-		  const Matrix4x3 m = ToMatrix(obj.RotTrans()) * mScale;
-		  glUniform4fv(shader.bones, 3, m.f);
+		  const Matrix4x3 m = GetModelMatrix(store, id);
+		  UploadModelMatrix(shader, m);
 		  if (shader.type == ShaderType::Simple3D) {
 			Matrix4x4 mm;
 			mm.SetVector(0, Vector4F(m.f[0], m.f[1], m.f[2], 0.0f));
@@ -1471,11 +2105,20 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 			glUniform3f(shader.eyePos, invEye.x, invEye.y, invEye.z);
 		  }
 		}
+		int currentPalette = -1;
 		for (auto& e : mesh.materialList) {
+			if (!mesh.bonePaletteList.empty() && e.bonePalette != currentPalette) {
+			  UploadBonePalette(shader, id, e);
+			  currentPalette = e.bonePalette;
+			}
 			const float m = std::min(1.0f, std::max(0.0f, e.material.metallic.To<float>() - metallic));
 			const float r = std::min(1.0f, std::max(0.0f, e.material.roughness.To<float>() + roughness));
 			const int index = std::min(iblSourceSize, std::max(0, static_cast<int>(r * static_cast<float>(iblSourceSize) + 0.5f)));
-			SetTexture(GL_TEXTURE2, GL_TEXTURE_CUBE_MAP, iblSpecularSourceList[index]);
+			if (iblSpecularSourceList[index]->TextureId() != boundTextureId[2]) {
+				SetTexture(GL_TEXTURE2, GL_TEXTURE_CUBE_MAP, iblSpecularSourceList[index]);
+				boundTextureId[2] = iblSpecularSourceList[index]->TextureId();
+				++textureBindCount;
+			}
 			if (shader.program == seaProgramId) {
 			  glUniform3f(shader.materialMetallicAndRoughness, m, r, m > 0.5f ? animationTick * 0.25f : 0.0f);
 			} else {
@@ -1488,6 +2131,11 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	glEnable(GL_CULL_FACE);
 	LOG_GL_ERROR("Color");
 
+	if (hasIBLTextures) {
+	  DrawParticles(mView, mProj, dynamicRangeFactor);
+	  LOG_GL_ERROR("Particle");
+	}
+
 #ifdef SHOW_TANGENT_SPACE
 	static bool showTangentSpace = true;
 	if (showTangentSpace) {
@@ -1510,23 +2158,15 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	  glUseProgram(shader.program);
 	  glUniformMatrix4fv(shader.matProjection, 1, GL_FALSE, mProj.f);
 	  glUniformMatrix4fv(shader.matView, 1, GL_FALSE, mView.f);
-	  for (const ObjectPtr* itr = begin; itr != end; ++itr) {
-		const Object& obj = *itr->get();
-		if (!obj.IsValid()) {
-		  continue;
-		}
-		const size_t boneCount = std::min(obj.GetBoneCount(), static_cast<size_t>(32));
+	  for (ObjectId id : drawIdList) {
+		const size_t boneCount = std::min(store.boneList[id].size(), bonePaletteSize);
 		if (boneCount) {
-		  glUniform4fv(shader.bones, boneCount * 3, obj.GetBoneMatirxArray());
+		  glUniform4fv(shader.bones, boneCount * 3, store.boneList[id][0].f);
 		} else {
-		  Matrix4x3 mScale = Matrix4x3::Unit();
-		  mScale.Set(0, 0, obj.Scale().x);
-		  mScale.Set(1, 1, obj.Scale().y);
-		  mScale.Set(2, 2, obj.Scale().z);
-		  const Matrix4x3 m = ToMatrix(obj.RotTrans()) * mScale;
+		  const Matrix4x3 m = GetModelMatrix(store, id);
 		  glUniform4fv(shader.bones, 3, m.f);
 		}
-		const Mesh::Mesh& mesh = *obj.GetMesh();
+		const Mesh::Mesh& mesh = *store.meshList[id];
 		if (mesh.vboTBNCount) {
 		  glDrawArrays(GL_LINES, mesh.vboTBNOffset, mesh.vboTBNCount);
 		}
@@ -1536,6 +2176,8 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 #endif // SHOW_TANGENT_SPACE
 #endif
+	// the depth of color path is not needed by the post effects.
+	EndRenderTarget(FBO_Main, GL_DEPTH_BUFFER_BIT);
 
 #ifdef USE_HDR_BLOOM
 	// hdr path.
@@ -1556,6 +2198,7 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	{
 	  const FBOInfo fboSubInfo = GetFBOInfo(FBO_Sub);
 	  glBindFramebuffer(GL_FRAMEBUFFER, *fboSubInfo.p);
+	  BeginRenderTarget(FBO_Sub, GL_COLOR_BUFFER_BIT);
 	  glViewport(0, 0, fboSubInfo.width, fboSubInfo.height);
 	  glDisable(GL_DEPTH_TEST);
 	  glDisable(GL_CULL_FACE);
@@ -1567,15 +2210,24 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	  Matrix4x4 mtx = Matrix4x4::Unit();
 	  mtx.Scale(1.0f, -1.0f, 1.0f);
 	  glUniformMatrix4fv(shader.matProjection, 1, GL_FALSE, mtx.f);
+	  const FBOInfo fboMainInternalInfo = GetFBOInfo(FBO_Main_Internal);
+	  glUniform4f(
+		shader.unitTexCoord,
+		static_cast<float>(colorPathWidth) / static_cast<float>(fboMainInternalInfo.width),
+		static_cast<float>(colorPathHeight) / static_cast<float>(fboMainInternalInfo.height),
+		1.0f / static_cast<float>(fboMainInternalInfo.width),
+		1.0f / static_cast<float>(fboMainInternalInfo.height)
+	  );
 
 	  glUniform1i(shader.texDiffuse, 0);
 	  SetTexture(GL_TEXTURE0, GL_TEXTURE_2D, textureList[GetFBOInfo(FBO_Main).name]);
 	  meshList["board2D"].Draw();
 	}
 	// fboSub ->(hdrdiff)-> fboHDR[1]
-	{
+	if (useBloom) {
 	  const FBOInfo fboHDR1Info = GetFBOInfo(FBO_HDR1);
 	  glBindFramebuffer(GL_FRAMEBUFFER, *fboHDR1Info.p);
+	  BeginRenderTarget(FBO_HDR1, GL_COLOR_BUFFER_BIT);
 	  glViewport(0, 0, fboHDR1Info.width, fboHDR1Info.height);
 
 	  const Shader& shader = shaderList["hdrdiff"];
@@ -1589,12 +2241,18 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	  glUniform1i(shader.texDiffuse, 0);
 	  SetTexture(GL_TEXTURE0, GL_TEXTURE_2D, textureList[GetFBOInfo(FBO_Sub).name]);
 	  meshList["board2D"].Draw();
+	} else {
+	  // the bloom is disabled by the quality governor. applyhdr adds nothing.
+	  const FBOInfo fboHDR1Info = GetFBOInfo(FBO_HDR1);
+	  glBindFramebuffer(GL_FRAMEBUFFER, *fboHDR1Info.p);
+	  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	  glClear(GL_COLOR_BUFFER_BIT);
 	}
 
 	static const bool useWideBloom = false;
 
 	// fboHDR[1] ->(sample4)-> fboHDR[0] ... fboHDR[4]
-	{
+	if (useBloom) {
 	  const Shader& shader = shaderList["sample4"];
 	  glUseProgram(shader.program);
 	  Matrix4x4 mtx = Matrix4x4::Unit();
@@ -1642,6 +2300,7 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 		for (int i = FBO_HDR1; i < FBO_HDR5; ++i) {
 		  const FBOInfo fboInfoDest = GetFBOInfo(i + 1);
 		  glBindFramebuffer(GL_FRAMEBUFFER, *fboInfoDest.p);
+		  BeginRenderTarget(i + 1, GL_COLOR_BUFFER_BIT);
 		  glViewport(0, 0, fboInfoDest.width, fboInfoDest.height);
 
 		  const FBOInfo fboInfoSrc = GetFBOInfo(i);
@@ -1653,7 +2312,7 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	  }
 	}
 	// fboHDR[4] ->(default2D)-> fboHDR[4] ... fboHDR[0]
-	{
+	if (useBloom) {
 	  const Shader& shader = shaderList["default2D"];
 	  glUseProgram(shader.program);
 
@@ -1735,6 +2394,12 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	// final path.
 	{
 	  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	  if (hasDiscardFramebuffer) {
+		// the window surface is overwritten entirely by the final path.
+		static const GLenum attachments[] = { GL_COLOR_EXT };
+		Local::glDiscardFramebufferEXT(GL_FRAMEBUFFER, 1, attachments);
+		discardedByteSize += width * height * 4;
+	  }
 	  glViewport(0, 0, width, height);
 	  glDisable(GL_DEPTH_TEST);
 	  glDisable(GL_CULL_FACE);
@@ -1758,6 +2423,14 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	  Matrix4x4 mtx = Matrix4x4::Unit();
 	  mtx.Scale(1.0f, -1.0f, 1.0f);
 	  glUniformMatrix4fv(shader.matProjection, 1, GL_FALSE, mtx.f);
+	  const FBOInfo fboMainInternalInfo = GetFBOInfo(FBO_Main_Internal);
+	  glUniform4f(
+		shader.unitTexCoord,
+		static_cast<float>(colorPathWidth) / static_cast<float>(fboMainInternalInfo.width),
+		static_cast<float>(colorPathHeight) / static_cast<float>(fboMainInternalInfo.height),
+		0.0f,
+		0.0f
+	  );
 
 	  const Vector4F color = filterColor.ToVector4F();
 	  glUniform4f(shader.materialColor, color.x, color.y, color.z, color.w);
@@ -1830,9 +2503,12 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	}
 #endif // SSU_ENABLE_DISPLAY_LOG
 
-#ifndef NDEBUG
-	// ptH[}Xv.
-	{
+	// パフォーマンス計測.
+	// the pass times are measured in the release build too, for QualityGovernor.
+	float passTimeList[QualityPass_Count];
+	static_assert(QualityPass_Count == fenceCount, "QualityPass should be same as the fence list");
+	int64_t diffTimes[fenceCount + 1];
+	if (hasGPUTimer) {
 	  int64_t fenceTimes[fenceCount + 1];
 	  fenceTimes[0] = GetCurrentTime();
 	  for (int i = 0; i < fenceCount; ++i) {
@@ -1846,11 +2522,19 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	  // Thus, discard this error, tentatively.
 	  glGetError();
 
-	  int64_t diffTimes[fenceCount + 1];
 	  for (int i = 0; i < fenceCount; ++i) {
 		diffTimes[i] = std::max<int64_t>(fenceTimes[i + 1] - fenceTimes[i], 0);
+		passTimeList[i] = static_cast<float>(diffTimes[i]) * (1.0f / 1000000000.0f);
 	  }
 	  diffTimes[fenceCount] = std::accumulate(diffTimes, diffTimes + fenceCount, static_cast<int64_t>(0));
+	  Local::glDeleteFencesNV(fenceCount, fences);
+	} else {
+	  std::fill(diffTimes, diffTimes + fenceCount + 1, static_cast<int64_t>(0));
+	}
+	qualityGovernor.Update(frameTime, hasGPUTimer ? passTimeList : nullptr);
+
+#ifndef NDEBUG
+	{
 	  static const char* const fenceNameList[] = {
 		"SHADOW:",
 		"FILTER:",
@@ -1871,7 +2555,67 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 //		s += boost::lexical_cast<std::string>(diffTimes[i]);
 		DrawFont(Position2F(viewport[2] * 0.025f, static_cast<float>(viewport[3] - (16 * 8) + 16 * i)), s.c_str());
 	  }
-	  Local::glDeleteFencesNV(5, fences);
+	  {
+		// the estimated byte size of load/store that is skipped by discarding or clearing.
+		std::string s("DISCARD:");
+		const int kb = std::min<int>(static_cast<int>(discardedByteSize / 1024), 99999);
+		s += '0' + kb / 10000;
+		s += '0' + (kb % 10000) / 1000;
+		s += '0' + (kb % 1000) / 100;
+		s += '0' + (kb % 100) / 10;
+		s += '0' + kb % 10;
+		s += "KB";
+		// the number of the objects in each animation LOD.
+		s += " ANIM:";
+		for (int n : animationLodCountList) {
+		  n = std::min(n, 99);
+		  s += '0' + n / 10;
+		  s += '0' + n % 10;
+		  s += ' ';
+		}
+		DrawFont(Position2F(viewport[2] * 0.025f, static_cast<float>(viewport[3] - (16 * 8) + 16 * (fenceCount + 1))), s.c_str());
+	  }
+	  {
+		// the number of the living particles.
+		std::string s("PARTICLE:");
+		const int n = std::min<int>(static_cast<int>(particleSystem.ParticleCount()), 9999);
+		s += '0' + n / 1000;
+		s += '0' + (n % 1000) / 100;
+		s += '0' + (n % 100) / 10;
+		s += '0' + n % 10;
+		// the number of the texture binding in the color pass.
+		s += " BIND:";
+		const int bind = std::min(textureBindCount, 999);
+		s += '0' + bind / 100;
+		s += '0' + (bind % 100) / 10;
+		s += '0' + bind % 10;
+		// the hit rate of the pose cache.
+		s += " POSE:";
+		const int hitRate = std::min(static_cast<int>(poseCache.GetHitRate() * 100.0f), 99);
+		s += '0' + hitRate / 10;
+		s += '0' + hitRate % 10;
+		DrawFont(Position2F(viewport[2] * 0.025f, static_cast<float>(viewport[3] - (16 * 8) + 16 * (fenceCount + 2))), s.c_str());
+	  }
+	  {
+		// the texture residency. the resident size, the reload count and the eviction count.
+		const Texture::ResidencyStats stats = Texture::GetResidencyStats();
+		std::string s("TEXTURE:");
+		const int kb = std::min<int>(static_cast<int>(stats.totalByteSize / 1024), 99999);
+		s += '0' + kb / 10000;
+		s += '0' + (kb % 10000) / 1000;
+		s += '0' + (kb % 1000) / 100;
+		s += '0' + (kb % 100) / 10;
+		s += '0' + kb % 10;
+		s += "KB M";
+		const int miss = std::min(stats.missCount, 99);
+		s += '0' + miss / 10;
+		s += '0' + miss % 10;
+		s += " E";
+		const int eviction = std::min(stats.evictionCount, 99);
+		s += '0' + eviction / 10;
+		s += '0' + eviction % 10;
+		DrawFont(Position2F(viewport[2] * 0.025f, static_cast<float>(viewport[3] - (16 * 8) + 16 * (fenceCount + 3))), s.c_str());
+	  }
 	}
 
 	{
@@ -1904,7 +2648,8 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	LOG_GL_ERROR("Information");
 #endif // NDEBUG
 
-	// eNX`̃oCh.
+	// テクスチャのバインドを解除.
+	ResetTexture(GL_TEXTURE6, GL_TEXTURE_2D);
 	ResetTexture(GL_TEXTURE5, GL_TEXTURE_2D);
 	ResetTexture(GL_TEXTURE4, GL_TEXTURE_CUBE_MAP);
 	ResetTexture(GL_TEXTURE3, GL_TEXTURE_CUBE_MAP);
@@ -1912,7 +2657,7 @@ void Renderer::Render(const ObjectPtr* begin, const ObjectPtr* end)
 	ResetTexture(GL_TEXTURE1, GL_TEXTURE_2D);
 	ResetTexture(GL_TEXTURE0, GL_TEXTURE_2D);
 
-	// obt@IuWFNg̃oCh.
+	// バッファオブジェクトのバインドを解除.
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
@@ -1927,6 +2672,8 @@ void Renderer::Update(float dTime, const Position3F& pos, const Vector3F& dir, c
   cameraDir = dir;
   cameraUp = up;
 
+  particleSystem.Update(dTime);
+
   if (filterMode != FILTERMODE_NONE) {
 	filterTimer += dTime;
 	if (filterTimer >= filterTargetTime) {
@@ -1945,6 +2692,8 @@ void Renderer::Update(float dTime, const Position3F& pos, const Vector3F& dir, c
 
 void Renderer::Unload()
 {
+	Texture::SetAssetLoader(nullptr);
+	assetLoader.Stop();
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	for (int i = FBO_End - 1; i >= 0; --i) {
@@ -1955,6 +2704,8 @@ void Renderer::Unload()
 	  }
 	}
 
+	poseCache.Clear();
+	objectStore.ResetHandles();
 	animationList.clear();
 	meshList.clear();
 	textureList.clear();
@@ -1977,6 +2728,15 @@ void Renderer::Unload()
 		glDeleteBuffers(1, &ibo);
 		ibo = 0;
 	}
+	if (vboParticle) {
+	  glDeleteBuffers(1, &vboParticle);
+	  vboParticle = 0;
+	}
+	if (iboParticle) {
+	  glDeleteBuffers(1, &iboParticle);
+	  iboParticle = 0;
+	}
+	particleSystem.Clear();
 #ifdef SHOW_TANGENT_SPACE
 	if (vboTBN) {
 	  glDeleteBuffers(1, &vboTBN);
@@ -2031,78 +2791,193 @@ namespace {
 	}
 }
 
-void Renderer::LoadFBX(const char* filename, const char* diffuse, const char* normal, bool showTBN)
+/** Load the mesh file asynchronously.
+
+  The file is read and parsed on the worker thread, and the mesh is registered when it is
+  uploaded on the GL thread. The textures are linked by the names at that time, so they
+  should be requested before the mesh.
+
+  @param filename  The MSH file name.
+  @param diffuse   The name of the albedo texture.
+  @param normal    The name of the normal texture.
+  @param showTBN   true if the tangent space of the mesh is visualized(SHOW_TANGENT_SPACE only).
+
+  @return The handle to poll the state of the loading.
+*/
+AssetHandle Renderer::LoadMeshAsync(const char* filename, const char* diffuse, const char* normal, bool showTBN)
 {
-  if (auto pBuf = FileSystem::LoadFile(filename)) {
+  const std::string file(filename);
+  const std::string diffuseName(diffuse);
+  const std::string normalName(normal);
+  return assetLoader.Add(filename, [this, file, diffuseName, normalName, showTBN]() -> AssetRequest::UploadFunc {
+	auto pBuf = FileSystem::LoadFile(file.c_str());
+	if (!pBuf) {
+	  return nullptr;
+	}
+	const std::shared_ptr<RawBuffer> data = std::make_shared<RawBuffer>(std::move(*pBuf));
+	const std::shared_ptr<Mesh::ParsedMesh> parsed = std::make_shared<Mesh::ParsedMesh>(Mesh::ParseMesh(*data, bonePaletteSize));
+	return [this, file, diffuseName, normalName, showTBN, data, parsed]() {
+	  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 #ifdef SHOW_TANGENT_SPACE
-	Mesh::ImportMeshResult result = Mesh::ImportMesh(*pBuf, vbo, vboEnd, ibo, iboEnd, (showTBN ? vboTBN : 0), vboTBNEnd);
+	  Mesh::ImportMeshResult result = Mesh::UploadMesh(*data, *parsed, vbo, vboEnd, ibo, iboEnd, (showTBN ? vboTBN : 0), vboTBNEnd);
 #else
-	Mesh::ImportMeshResult result = Mesh::ImportMesh(*pBuf, vbo, vboEnd, ibo, iboEnd);
+	  Mesh::ImportMeshResult result = Mesh::UploadMesh(*data, *parsed, vbo, vboEnd, ibo, iboEnd);
 #endif // SHOW_TANGENT_SPACE
-	if (result.result == Mesh::Result::success) {
+	  if (result.result != Mesh::Result::success) {
+		static const char* const errorDescList[] = {
+		  "success",
+		  "invalidHeader",
+		  "noData",
+		  "invalidMeshInfo",
+		  "invalidIBO",
+		  "invalidVBO",
+		  "invalidJointInfo",
+		  "invalidAnimationInfo",
+		  "indexOverflow"
+		};
+		LOGE("ImportMesh fail by %s: '%s'", errorDescList[static_cast<int>(result.result)], file.c_str());
+		return false;
+	  }
+	  // the diffuse and normal textures must share the same region in the atlas.
+	  const auto itrRegion = texCoordScaleOffsetList.find(diffuseName);
+	  const auto itrRegionNml = texCoordScaleOffsetList.find(normalName);
+	  Vector4F scaleOffset(1, 1, 0, 0);
+	  if (itrRegion != texCoordScaleOffsetList.end()) {
+		if (itrRegionNml != texCoordScaleOffsetList.end() && itrRegionNml->second == itrRegion->second) {
+		  scaleOffset = itrRegion->second;
+		} else {
+		  LOGE("'%s' isn't packed with '%s' in the atlas: '%s'", normalName.c_str(), diffuseName.c_str(), file.c_str());
+		}
+	  }
 	  for (auto m : result.meshes) {
-		const auto itr = textureList.find(diffuse);
+		const auto itr = textureList.find(diffuseName);
 		if (itr != textureList.end()) {
 		  m.texDiffuse = itr->second;
 		}
-		const auto itrNml = textureList.find(normal);
+		const auto itrNml = textureList.find(normalName);
 		if (itrNml != textureList.end()) {
 		  m.texNormal = itrNml->second;
 		}
+		m.texCoordScaleOffset = scaleOffset;
 		meshList.insert({ m.id, m });
 	  }
 	  for (auto e : result.animations) {
 		animationList.insert({ e.id, e });
 	  }
-	} else {
-	  static const char* const errorDescList[] = {
-		"success",
-		"invalidHeader",
-		"noData",
-		"invalidMeshInfo",
-		"invalidIBO",
-		"invalidVBO",
-		"invalidJointInfo",
-		"invalidAnimationInfo",
-		"indexOverflow"
-	  };
-	  LOGE("ImportMesh fail by %s: '%s'", errorDescList[static_cast<int>(result.result)], filename);
-	}
-  }
+	  return true;
+	};
+  });
+}
+
+/** Load the KTX texture file asynchronously.
+
+  The file is read and parsed on the worker thread, and the texture is registered when it is
+  uploaded on the GL thread.
+
+  @param name       The name of the texture.
+  @param filename   The KTX file name.
+  @param streaming  true if the texture should be loaded with the progressive mip streaming.
+
+  @return The handle to poll the state of the loading.
+*/
+AssetHandle Renderer::LoadTextureAsync(const char* name, const char* filename, bool streaming)
+{
+  const std::string id(name);
+  const std::string file(filename);
+  return assetLoader.Add(filename, [this, id, file, streaming]() -> AssetRequest::UploadFunc {
+	const Texture::PreparedKTXPtr prepared = Texture::PrepareKTX(file.c_str(), false, streaming);
+	if (!prepared) {
+	  return nullptr;
+	}
+	return [this, id, prepared]() {
+	  const Texture::TexturePtr p = Texture::UploadPreparedKTX(prepared);
+	  if (!p) {
+		return false;
+	  }
+	  textureList.insert({ id, p });
+	  return true;
+	};
+  });
+}
+
+/** Load the small texture pairs into the texture atlases asynchronously.
+
+  The pairs that have the same format and no mipmap are packed into the atlas,
+  and the others are loaded as the separate textures.
+  The meshes loaded after this request use the atlas region by the texture name.
+  @sa LoadMeshAsync(), Texture::PrepareAtlas().
+
+  @param infoList  The texture pairs.
+
+  @return The handle to poll the state of the loading.
+*/
+AssetHandle Renderer::LoadTextureAtlasAsync(const std::vector<AtlasTextureInfo>& infoList)
+{
+  return assetLoader.Add("TextureAtlas", [this, infoList]() -> AssetRequest::UploadFunc {
+	std::vector<Texture::AtlasSource> sourceList;
+	sourceList.reserve(infoList.size());
+	for (const AtlasTextureInfo& e : infoList) {
+	  // the texture that isn't packed is uploaded with the mip streaming.
+	  sourceList.push_back({
+		e.diffuseName, Texture::PrepareKTX(e.diffuseFile.c_str(), false, true),
+		e.normalName, Texture::PrepareKTX(e.normalFile.c_str(), false, true)
+	  });
+	}
+	const Texture::PreparedAtlasPtr prepared = Texture::PrepareAtlas(sourceList, textureAtlasSize, textureAtlasMaxTileSize);
+	return [this, prepared]() {
+	  const std::vector<Texture::AtlasRegion> regionList = Texture::UploadPreparedAtlas(prepared);
+	  for (const Texture::AtlasRegion& e : regionList) {
+		if (e.diffuse) {
+		  textureList.insert({ e.diffuseName, e.diffuse });
+		}
+		if (e.normal) {
+		  textureList.insert({ e.normalName, e.normal });
+		}
+		const Vector4F scaleOffset(e.scaleOffset[0], e.scaleOffset[1], e.scaleOffset[2], e.scaleOffset[3]);
+		if (scaleOffset != Vector4F(1, 1, 0, 0)) {
+		  texCoordScaleOffsetList.insert({ e.diffuseName, scaleOffset });
+		  texCoordScaleOffsetList.insert({ e.normalName, scaleOffset });
+		}
+	  }
+	  return true;
+	};
+  });
 }
 
-/** `ɕKvȃ|SbV̏.
-* |SbVǂݍ݁Aobt@IuWFNgɊi[.
-* Initialize()Ăяo邽߁AIɌĂяoKv͂Ȃ.
+/** 描画に必要なポリゴンメッシュの初期化.
+* ポリゴンメッシュを読み込み、バッファオブジェクトに格納する.
+* Initialize()から呼び出されるため、明示的に呼び出す必要はない.
+* The mesh files are loaded asynchronously. @sa LoadMeshAsync(), IsLoadingCompleted().
 */
 void Renderer::InitMesh()
 {
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	LoadFBX("Meshes/sphere.msh", "Sphere", "Sphere_nml");
-	LoadFBX("Meshes/flyingrock.msh", "flyingrock", "flyingrock_nml");
-	LoadFBX("Meshes/brokenegg.msh", "brokenegg", "brokenegg_nml");
-	LoadFBX("Meshes/accelerator.msh", "accelerator", "accelerator_nml");
-	LoadFBX("Meshes/sunnysideup.msh", "sunnysideup", "sunnysideup_nml");
-	LoadFBX("Meshes/SunnySideUp01.msh", "sunnysideup01", "sunnysideup01_nml");
-	LoadFBX("Meshes/SunnySideUp02.msh", "sunnysideup02", "sunnysideup02_nml");
-	LoadFBX("Meshes/SunnySideUp03.msh", "sunnysideup03", "sunnysideup03_nml");
-	LoadFBX("Meshes/SunnySideUp04.msh", "sunnysideup04", "sunnysideup04_nml");
-	LoadFBX("Meshes/OverMedium.msh", "overmedium", "overmedium_nml");
-	LoadFBX("Meshes/block1.msh", "block1", "block1_nml");
-	LoadFBX("Meshes/flyingpan.msh", "flyingpan", "flyingpan_nml");
-	LoadFBX("Meshes/TargetCursor.msh", "dummy", "dummy");
-	LoadFBX("Meshes/chickenegg.msh", "chickenegg", "chickenegg_nml");
-	LoadFBX("Meshes/titlelogo.msh", "titlelogo", "titlelogo_nml");
-	LoadFBX("Meshes/rock_collection.msh", "rock_s", "rock_s_nml");
-	LoadFBX("Meshes/landscape.msh", "floor", "floor_nml");
-	LoadFBX("Meshes/Coast.msh", "ls_coast", "ls_coast_nml");
-	LoadFBX("Meshes/building00.msh", "building00", "building00_nml", true);
-	LoadFBX("Meshes/building01.msh", "building01", "building01_nml", true);
-	LoadFBX("Meshes/tower00.msh", "tower00", "tower00_nml", true);
-	LoadFBX("Meshes/CoastTown.msh", "building01", "building01_nml");
-	LoadFBX("Meshes/EggPack.msh", "EggPack", "EggPack_nml");
-	LoadFBX("Meshes/CheckPoint.msh", "checkpoint", "checkpoint_nml");
+	LoadMeshAsync("Meshes/sphere.msh", "Sphere", "Sphere_nml");
+	LoadMeshAsync("Meshes/flyingrock.msh", "flyingrock", "flyingrock_nml");
+	LoadMeshAsync("Meshes/brokenegg.msh", "brokenegg", "brokenegg_nml");
+	LoadMeshAsync("Meshes/accelerator.msh", "accelerator", "accelerator_nml");
+	LoadMeshAsync("Meshes/sunnysideup.msh", "sunnysideup", "sunnysideup_nml");
+	LoadMeshAsync("Meshes/SunnySideUp01.msh", "sunnysideup01", "sunnysideup01_nml");
+	LoadMeshAsync("Meshes/SunnySideUp02.msh", "sunnysideup02", "sunnysideup02_nml");
+	LoadMeshAsync("Meshes/SunnySideUp03.msh", "sunnysideup03", "sunnysideup03_nml");
+	LoadMeshAsync("Meshes/SunnySideUp04.msh", "sunnysideup04", "sunnysideup04_nml");
+	LoadMeshAsync("Meshes/OverMedium.msh", "overmedium", "overmedium_nml");
+	LoadMeshAsync("Meshes/block1.msh", "block1", "block1_nml");
+	LoadMeshAsync("Meshes/flyingpan.msh", "flyingpan", "flyingpan_nml");
+	LoadMeshAsync("Meshes/TargetCursor.msh", "dummy", "dummy");
+	LoadMeshAsync("Meshes/chickenegg.msh", "chickenegg", "chickenegg_nml");
+	LoadMeshAsync("Meshes/titlelogo.msh", "titlelogo", "titlelogo_nml");
+	LoadMeshAsync("Meshes/rock_collection.msh", "rock_s", "rock_s_nml");
+	LoadMeshAsync("Meshes/landscape.msh", "floor", "floor_nml");
+	LoadMeshAsync("Meshes/Coast.msh", "ls_coast", "ls_coast_nml");
+	LoadMeshAsync("Meshes/building00.msh", "building00", "building00_nml", true);
+	LoadMeshAsync("Meshes/building01.msh", "building01", "building01_nml", true);
+	LoadMeshAsync("Meshes/tower00.msh", "tower00", "tower00_nml", true);
+	LoadMeshAsync("Meshes/CoastTown.msh", "building01", "building01_nml");
+	LoadMeshAsync("Meshes/EggPack.msh", "EggPack", "EggPack_nml");
+	LoadMeshAsync("Meshes/CheckPoint.msh", "checkpoint", "checkpoint_nml");
 
 	CreateSkyboxMesh();
 	CreateUnitBoxMesh();
@@ -2420,10 +3295,10 @@ void Renderer::CreateAsciiMesh(const char* id)
   iboEnd += indices.size() * sizeof(GLushort);
 }
 
-/** _̃bV쐬AbVXgɓo^.
+/** 雲のメッシュを作成し、メッシュリストに登録する.
 
-  @param id bVID. ̃bVƔȂj[NIDw肷邱.
-  @param scale  _̑傫(P:[g).
+  @param id メッシュのID. 他のメッシュと被らないユニークなIDを指定すること.
+  @param scale  雲の大きさ(単位:メートル).
 */
 void Renderer::CreateCloudMesh(const char* id, const Vector3F& scale)
 {
@@ -2581,6 +3456,11 @@ void Renderer::CreateCloudMesh(const char* id, const Vector3F& scale)
   iboEnd += indices.size() * sizeof(GLushort);
 }
 
+/** Initialize the textures.
+
+  The textures for the loading screen are loaded immediately, and the others are loaded
+  asynchronously. @sa LoadTextureAsync(), IsLoadingCompleted().
+*/
 void Renderer::InitTexture()
 {
 	for (int i = FBO_Begin; i < FBO_End; ++i) {
@@ -2593,65 +3473,60 @@ void Renderer::InitTexture()
 	textureList.insert({ "dummy_nml", Texture::CreateDummyNormal() });
 	textureList.insert({ "ascii", Texture::LoadKTX("Textures/Common/ascii.ktx") });
 
-	textureList.insert({ "wood", Texture::LoadKTX((texBaseDir + "wood.ktx").c_str()) });
-	textureList.insert({ "wood_nml", Texture::LoadKTX((texBaseDir + "woodNR.ktx").c_str()) });
-	textureList.insert({ "Sphere", Texture::LoadKTX((texBaseDir + "sphere.ktx").c_str()) });
-	textureList.insert({ "Sphere_nml", Texture::LoadKTX((texBaseDir + "sphereNR.ktx").c_str()) });
-//	textureList.insert({ "floor", Texture::LoadKTX((texBaseDir + "floor.ktx").c_str()) });
-//	textureList.insert({ "floor_nml", Texture::LoadKTX((texBaseDir + "floorNR.ktx").c_str()) });
-	textureList.insert({ "floor", Texture::LoadKTX("Textures/Common/landscape.ktx") });
-	textureList.insert({ "floor_nml", Texture::LoadKTX("Textures/Common/landscapeNR.ktx") });
-
-	textureList.insert({ "ls_coast", Texture::LoadKTX("Textures/Common/coast.ktx") });
-	textureList.insert({ "ls_coast_nml", Texture::LoadKTX("Textures/Common/coastNR.ktx") });
-	textureList.insert({ "building00", Texture::LoadKTX("Textures/Common/building00.ktx") });
-	textureList.insert({ "building00_nml", Texture::LoadKTX((texBaseDir + "building00NR.ktx").c_str()) });
-	textureList.insert({ "building01", Texture::LoadKTX("Textures/Common/building01.ktx") });
-	textureList.insert({ "building01_nml", Texture::LoadKTX((texBaseDir + "building01NR.ktx").c_str()) });
-	textureList.insert({ "tower00", Texture::LoadKTX("Textures/Common/tower00.ktx") });
-	textureList.insert({ "tower00_nml", Texture::LoadKTX((texBaseDir + "tower00NR.ktx").c_str()) });
-
-	textureList.insert({ "EggPack", Texture::LoadKTX("Textures/Common/EggPack.ktx") });
-	textureList.insert({ "EggPack_nml", Texture::LoadKTX((texBaseDir + "EggPackNR.ktx").c_str()) });
-
-	textureList.insert({ "flyingrock", Texture::LoadKTX((texBaseDir + "flyingrock.ktx").c_str()) });
-	textureList.insert({ "flyingrock_nml", Texture::LoadKTX((texBaseDir + "flyingrockNR.ktx").c_str()) });
-	textureList.insert({ "block1", Texture::LoadKTX("Textures/Common/block1.ktx") });
-	textureList.insert({ "block1_nml", Texture::LoadKTX("Textures/Common/block1NR.ktx") });
-	textureList.insert({ "chickenegg", Texture::LoadKTX((texBaseDir + "chickenegg.ktx").c_str()) });
-	textureList.insert({ "chickenegg_nml", Texture::LoadKTX((texBaseDir + "chickeneggNR.ktx").c_str()) });
-	textureList.insert({ "sunnysideup", Texture::LoadKTX("Textures/Common/SunnySideUp.ktx") });
-	textureList.insert({ "sunnysideup_nml", Texture::LoadKTX((texBaseDir + "SunnySideUpNR.ktx").c_str()) });
-	textureList.insert({ "sunnysideup01", Texture::LoadKTX("Textures/Common/SunnySideUp01.ktx") });
-	textureList.insert({ "sunnysideup01_nml", Texture::LoadKTX((texBaseDir + "SunnySideUp01NR.ktx").c_str()) });
-	textureList.insert({ "sunnysideup02", Texture::LoadKTX("Textures/Common/SunnySideUp02.ktx") });
-	textureList.insert({ "sunnysideup02_nml", Texture::LoadKTX((texBaseDir + "SunnySideUp02NR.ktx").c_str()) });
-	textureList.insert({ "sunnysideup03", Texture::LoadKTX("Textures/Common/SunnySideUp03.ktx") });
-	textureList.insert({ "sunnysideup03_nml", Texture::LoadKTX((texBaseDir + "SunnySideUp03NR.ktx").c_str()) });
-	textureList.insert({ "sunnysideup04", Texture::LoadKTX("Textures/Common/SunnySideUp04.ktx") });
-	textureList.insert({ "sunnysideup04_nml", Texture::LoadKTX((texBaseDir + "SunnySideUp04NR.ktx").c_str()) });
-	textureList.insert({ "overmedium", Texture::LoadKTX("Textures/Common/OverMedium.ktx") });
-	textureList.insert({ "overmedium_nml", Texture::LoadKTX((texBaseDir + "OverMediumNR.ktx").c_str()) });
-	textureList.insert({ "brokenegg", Texture::LoadKTX((texBaseDir + "brokenegg.ktx").c_str()) });
-	textureList.insert({ "brokenegg_nml", Texture::LoadKTX((texBaseDir + "brokeneggNR.ktx").c_str()) });
-	textureList.insert({ "flyingpan", Texture::LoadKTX((texBaseDir + "flyingpan.ktx").c_str()) });
-	textureList.insert({ "flyingpan_nml", Texture::LoadKTX((texBaseDir + "flyingpanNR.ktx").c_str()) });
-	textureList.insert({ "accelerator", Texture::LoadKTX((texBaseDir + "accelerator.ktx").c_str()) });
-	textureList.insert({ "accelerator_nml", Texture::LoadKTX((texBaseDir + "acceleratorNR.ktx").c_str()) });
-	textureList.insert({ "rock_s", Texture::LoadKTX((texBaseDir + "rock_s.ktx").c_str()) });
-	textureList.insert({ "rock_s_nml", Texture::LoadKTX((texBaseDir + "rock_s_NR.ktx").c_str()) });
-	textureList.insert({ "cloud", Texture::LoadKTX("Textures/Common/cloud.ktx") });
-	textureList.insert({ "titlelogo", Texture::LoadKTX("Textures/Common/titlelogo.ktx") });
-	textureList.insert({ "titlelogo_nml", Texture::LoadKTX("Textures/Common/titlelogoNR.ktx") });
+	LoadTextureAsync("wood", (texBaseDir + "wood.ktx").c_str(), true);
+	LoadTextureAsync("wood_nml", (texBaseDir + "woodNR.ktx").c_str(), true);
+	LoadTextureAsync("Sphere", (texBaseDir + "sphere.ktx").c_str(), true);
+	LoadTextureAsync("Sphere_nml", (texBaseDir + "sphereNR.ktx").c_str(), true);
+//	LoadTextureAsync("floor", (texBaseDir + "floor.ktx").c_str(), true);
+//	LoadTextureAsync("floor_nml", (texBaseDir + "floorNR.ktx").c_str(), true);
+	LoadTextureAsync("floor", "Textures/Common/landscape.ktx", true);
+	LoadTextureAsync("floor_nml", "Textures/Common/landscapeNR.ktx", true);
+
+	LoadTextureAsync("ls_coast", "Textures/Common/coast.ktx", true);
+	LoadTextureAsync("ls_coast_nml", "Textures/Common/coastNR.ktx", true);
+	LoadTextureAsync("building00", "Textures/Common/building00.ktx", true);
+	LoadTextureAsync("building00_nml", (texBaseDir + "building00NR.ktx").c_str(), true);
+	LoadTextureAsync("building01", "Textures/Common/building01.ktx", true);
+	LoadTextureAsync("building01_nml", (texBaseDir + "building01NR.ktx").c_str(), true);
+	LoadTextureAsync("tower00", "Textures/Common/tower00.ktx", true);
+	LoadTextureAsync("tower00_nml", (texBaseDir + "tower00NR.ktx").c_str(), true);
+
+	LoadTextureAsync("flyingrock", (texBaseDir + "flyingrock.ktx").c_str(), true);
+	LoadTextureAsync("flyingrock_nml", (texBaseDir + "flyingrockNR.ktx").c_str(), true);
+	LoadTextureAsync("block1", "Textures/Common/block1.ktx", true);
+	LoadTextureAsync("block1_nml", "Textures/Common/block1NR.ktx", true);
+	LoadTextureAsync("chickenegg", (texBaseDir + "chickenegg.ktx").c_str(), true);
+	LoadTextureAsync("chickenegg_nml", (texBaseDir + "chickeneggNR.ktx").c_str(), true);
+	LoadTextureAsync("overmedium", "Textures/Common/OverMedium.ktx", true);
+	LoadTextureAsync("overmedium_nml", (texBaseDir + "OverMediumNR.ktx").c_str(), true);
+	LoadTextureAsync("flyingpan", (texBaseDir + "flyingpan.ktx").c_str(), true);
+	LoadTextureAsync("flyingpan_nml", (texBaseDir + "flyingpanNR.ktx").c_str(), true);
+	LoadTextureAsync("rock_s", (texBaseDir + "rock_s.ktx").c_str(), true);
+	LoadTextureAsync("rock_s_nml", (texBaseDir + "rock_s_NR.ktx").c_str(), true);
+	// the small textures of the items are packed into the atlas.
+	LoadTextureAtlasAsync({
+	  { "sunnysideup", "Textures/Common/SunnySideUp.ktx", "sunnysideup_nml", texBaseDir + "SunnySideUpNR.ktx" },
+	  { "sunnysideup01", "Textures/Common/SunnySideUp01.ktx", "sunnysideup01_nml", texBaseDir + "SunnySideUp01NR.ktx" },
+	  { "sunnysideup02", "Textures/Common/SunnySideUp02.ktx", "sunnysideup02_nml", texBaseDir + "SunnySideUp02NR.ktx" },
+	  { "sunnysideup03", "Textures/Common/SunnySideUp03.ktx", "sunnysideup03_nml", texBaseDir + "SunnySideUp03NR.ktx" },
+	  { "sunnysideup04", "Textures/Common/SunnySideUp04.ktx", "sunnysideup04_nml", texBaseDir + "SunnySideUp04NR.ktx" },
+	  { "brokenegg", texBaseDir + "brokenegg.ktx", "brokenegg_nml", texBaseDir + "brokeneggNR.ktx" },
+	  { "checkpoint", "Textures/Common/CheckPoint.ktx", "checkpoint_nml", texBaseDir + "CheckPointNR.ktx" },
+	  { "accelerator", texBaseDir + "accelerator.ktx", "accelerator_nml", texBaseDir + "acceleratorNR.ktx" },
+	  { "EggPack", "Textures/Common/EggPack.ktx", "EggPack_nml", texBaseDir + "EggPackNR.ktx" },
+	});
+	LoadTextureAsync("cloud", "Textures/Common/cloud.ktx");
+	LoadTextureAsync("titlelogo", "Textures/Common/titlelogo.ktx");
+	LoadTextureAsync("titlelogo_nml", "Textures/Common/titlelogoNR.ktx");
 	textureList.insert({ "font", Texture::LoadKTX("Textures/Common/font.ktx") });
-	textureList.insert({ "checkpoint", Texture::LoadKTX("Textures/Common/CheckPoint.ktx") });
-	textureList.insert({ "checkpoint_nml", Texture::LoadKTX((texBaseDir + "CheckPointNR.ktx").c_str()) });
 
 	LoadLandscape(LandscapeOfScene_Default, TimeOfScene_Noon);
 }
 
-/**
-* Load the textures for IBL.
+/** Load the textures for IBL asynchronously.
+
+  The source file is read, and the specular IBL and the irradiance SH are computed or loaded
+  from the cache on the worker thread. The current textures are used until the new ones are uploaded.
 */
 void Renderer::LoadLandscape(LandscapeOfScene type, TimeOfScene time) {
   static const char* const nameList[] = {
@@ -2664,15 +3539,55 @@ void Renderer::LoadLandscape(LandscapeOfScene type, TimeOfScene time) {
 	"night",
   };
 
-  UnloadLandscape();
-  const bool decompressing = texBaseDir != "Textures/Adreno/";
-  const std::string iblSourcePath = std::string("Textures/IBL/") + nameList[type] + "/ibl_";
-  for (char i = '1'; i <= '7'; ++i) {
-	iblSpecularSourceList[i - '1'] = Texture::LoadKTX((iblSourcePath + timeList[time] + "_" + i + ".ktx").c_str(), decompressing);
+  const uint32_t generation = ++landscapeGeneration;
+  if (!pWindow) {
+	UnloadLandscape();
+	return;
   }
-  iblDiffuseSourceList = Texture::LoadKTX((iblSourcePath + timeList[time] + "Irr.ktx").c_str(), decompressing);
 
-  hasIBLTextures = true;
+  // all IBL sources are made from the sharpest radiance map.
+  const std::string sourceFilename = std::string("Textures/IBL/") + nameList[type] + "/ibl_" + timeList[time] + "_1.ktx";
+  const std::string cacheSuffix = std::string(nameList[type]) + "_" + timeList[time] + ".bin";
+  assetLoader.Add(sourceFilename.c_str(), [this, generation, sourceFilename, cacheSuffix]() -> AssetRequest::UploadFunc {
+	// the sharpest level is the source file itself, so it is uploaded in the authored compressed format.
+	// it is decompressed only if the GPU doesn't support the format.
+	Texture::ImageData source;
+	const Texture::PreparedKTXPtr prepared = Texture::PrepareKTXImage(sourceFilename.c_str(), source);
+	if (!prepared) {
+	  LOGE("Can't load the IBL source:'%s'", sourceFilename.c_str());
+	  return nullptr;
+	}
+	const uint32_t sourceHash = HashImage(source);
+	const std::shared_ptr<CubeMapLevelList> levelList = std::make_shared<CubeMapLevelList>();
+	if (!LoadSpecularIBL(*pWindow, ("specular_" + cacheSuffix).c_str(), source, sourceHash, iblSourceRoughnessCount, *levelList)) {
+	  LOGE("Can't make the specular IBL:'%s'", sourceFilename.c_str());
+	  return nullptr;
+	}
+	IrradianceSH sh;
+	if (!LoadIrradianceSH(*pWindow, ("irradiance_" + cacheSuffix).c_str(), source, sourceHash, sh)) {
+	  LOGE("Can't load the irradiance SH:'%s'", sourceFilename.c_str());
+	  for (auto& e : sh) {
+		e = Vector3F(0, 0, 0);
+	  }
+	}
+	const int size = source.width;
+	return [this, generation, prepared, levelList, sh, size]() {
+	  // the newer request or UnloadLandscape() overrides this request.
+	  if (generation != landscapeGeneration) {
+		return true;
+	  }
+	  iblSpecularSourceList[0] = Texture::UploadPreparedKTX(prepared);
+	  if (!iblSpecularSourceList[0]) {
+		iblSpecularSourceList[0] = Texture::CreateCubeMap(size, &(*levelList)[0][0]);
+	  }
+	  for (size_t i = 1; i < iblSourceRoughnessCount; ++i) {
+		iblSpecularSourceList[i] = Texture::CreateCubeMap(std::max(1, size >> i), &(*levelList)[i][0]);
+	  }
+	  irradianceSH = sh;
+	  hasIBLTextures = true;
+	  return true;
+	};
+  });
 }
 
 /**
@@ -2680,11 +3595,11 @@ void Renderer::LoadLandscape(LandscapeOfScene type, TimeOfScene time) {
 */
 void Renderer::UnloadLandscape() {
   hasIBLTextures = false;
+  ++landscapeGeneration;
 
   for (char i = '1'; i <= '7'; ++i) {
 	iblSpecularSourceList[i - '1'].reset();
   }
-  iblDiffuseSourceList.reset();
 }
 
 ObjectPtr Renderer::CreateObject(const char* meshName, const Material& m, const char* shaderName, ShadowCapability sc)
@@ -2703,7 +3618,45 @@ ObjectPtr Renderer::CreateObject(const char* meshName, const Material& m, const
 	} else {
 	  LOGI("Shader '%s' not found.", shaderName);
 	}
-	return ObjectPtr(new Object(this, RotTrans::Unit(), pMesh, m, pShader, sc));
+	return ObjectPtr(new Object(this, objectStore, RotTrans::Unit(), pMesh, m, pShader, sc));
+}
+
+const float Renderer::animationLodScreenSize = 0.05f;
+
+/** Select the animation LOD of the object.
+
+  The camera and the field of view of the latest frame are used, because the objects
+  are updated before the current frame is rendered.
+
+  @param center  The center of the bounding sphere of the object.
+  @param radius  The radius of the bounding sphere of the object.
+
+  @return The animation LOD. It is counted for the profiling.
+*/
+AnimationLod Renderer::SelectAnimationLod(const Position3F& center, float radius)
+{
+  static const float farPlane = 5000.0f;
+  // the bind pose doesn't contain the animated vertices, so the sphere is expanded.
+  static const float boundsMargin = 1.5f;
+  AnimationLod lod = AnimationLod_Full;
+  const float r = radius * boundsMargin;
+  const Vector3F v = center - cameraPos;
+  const float distance = v.Length();
+  if (distance > r) {
+	const float tanHalfFov = std::tan(degreeToRadian(cameraFov * 0.5f));
+	const float aspectRatio = static_cast<float>(viewport[2]) / static_cast<float>(std::max(1, viewport[3]));
+	// test the sphere against the cone around the view frustum.
+	const float coneAngle = std::atan(tanHalfFov * std::sqrt(1.0f + aspectRatio * aspectRatio));
+	const float angle = std::acos(std::max(-1.0f, std::min(1.0f, Dot(v, Normalize(cameraDir)) / distance)));
+	// the radius is compared with the height of the view frustum at the distance, that is distance * tanHalfFov * 2.
+	if (distance - r > farPlane || angle - std::asin(r / distance) > coneAngle) {
+	  lod = AnimationLod_Hidden;
+	} else if (r / (distance * tanHalfFov * 2.0f) < animationLodScreenSize) {
+	  lod = AnimationLod_Reduced;
+	}
+  }
+  ++animationLodCounter[lod];
+  return lod;
 }
 
 const Animation* Renderer::GetAnimation(const char* name)
@@ -6,6 +6,12 @@
 #include "../../Shared/Matrix.h"
 #include "texture.h"
 #include "Mesh.h"
+#include "QualityGovernor.h"
+#include "ParticleSystem.h"
+#include "ImageBasedLighting.h"
+#include "AssetLoader.h"
+#include "AnimationSampler.h"
+#include "ObjectStore.h"
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
 #include <boost/random/mersenne_twister.hpp>
@@ -28,20 +34,68 @@ namespace Mai {
 #define USE_HDR_BLOOM
 //#define USE_ALPHA_TEST_IN_SHADOW_RENDERING
 
+  /** The level of detail of the animation.
+
+    It is selected by Renderer::SelectAnimationLod() from the projected size and the visibility.
+  */
+  enum AnimationLod {
+	AnimationLod_Full, ///< Sample the pose every frame.
+	AnimationLod_Reduced, ///< Sample the pose every Renderer::animationLodInterval frames.
+	AnimationLod_Hidden, ///< Off-screen. Advance the clock only.
+	AnimationLod_Count,
+  };
+
+  /** The animation player.
+
+    The current animation is cross-faded with the previous animations by CrossFade().
+	Each animation fades in over the blended pose of the older ones, so interrupting
+	the cross-fade doesn't pop. The older animations are kept in the fade layers until
+	a newer animation is faded in completely.
+	All layers have their own samplers and share the pose buffer for the blending,
+	so changing the animation doesn't allocate the memory once the buffers are allocated.
+  */
   struct AnimationPlayer {
-	AnimationPlayer() : currentTime(0), pAnime(nullptr) {}
-	void SetAnimation(const Animation* p) { pAnime = p; currentTime = 0.0f; }
+	static const size_t maxFadeLayerCount = 3; ///< The maximum number of the previous animations in the cross-fade.
+
+	/** The previous animation.
+	*/
+	struct FadeLayer {
+	  FadeLayer() : currentTime(0), pAnime(nullptr), weight(0), fadeSpeed(0) {}
+	  float currentTime;
+	  const Animation* pAnime;
+	  float weight; ///< The weight over the older animations.
+	  float fadeSpeed; ///< The increase of the weight per second.
+	  AnimationSampler sampler;
+	};
+
+	AnimationPlayer() : currentTime(0), pAnime(nullptr), weight(1), fadeSpeed(0), fadeLayerCount(0) {}
+	void SetAnimation(const Animation* p) {
+	  pAnime = p;
+	  currentTime = 0.0f;
+	  weight = 1.0f;
+	  fadeLayerCount = 0;
+	}
+	void CrossFade(const Animation* p, float duration);
 	void SetCurrentTime(float t) { currentTime = t; }
 	float GetCurrentTime() const { return currentTime; }
-	std::vector<RotTrans> Update(const JointList& jointList, float t);
+	bool IsFading() const { return fadeLayerCount > 0; }
+	void Advance(float t);
+	const PoseBuffer& GetPose(const JointList& jointList, PoseCache& cache);
 	float currentTime;
 	const Animation* pAnime;
 	std::string id;
+	AnimationSampler sampler;
+
+	float weight; ///< The weight of the current animation over the previous animations.
+	float fadeSpeed; ///< The increase of the weight of the current animation per second.
+	std::array<FadeLayer, maxFadeLayerCount> fadeLayerList; ///< The previous animations. The newer one has the smaller index.
+	size_t fadeLayerCount;
+	PoseBuffer blendPose; ///< The work buffer of the blending.
   };
 
 #ifdef SHOW_TANGENT_SPACE
   /**
-  * _TBN(Tangent/Bitangent/Normal)mFp̒_f[^.
+  * 頂点のTBN(Tangent/Bitangent/Normal)確認用の頂点データ.
   */
   struct TBNVertex {
 	TBNVertex(const Position3F& p, Color4B c, const uint8_t* b, const uint8_t* w)
@@ -56,11 +110,11 @@ namespace Mai {
 	GLubyte boneID[4];
   };
 
-  /// TBNmFp̒_f[^obt@̃oCgTCY.
+  /// TBN確認用の頂点データバッファのバイトサイズ.
   static const size_t vboTBNBufferSize = sizeof(TBNVertex) * 1024 * 11 * 3 * 2;
 #endif // SHOW_TANGENT_SPACE
 
-  /** VF[_̎.
+  /** シェーダの種類.
   */
   enum class ShaderType : int {
 	Simple3D,
@@ -69,11 +123,11 @@ namespace Mai {
 
 
   /**
-  * VF[_.
+  * シェーダ制御情報.
   */
   struct Shader
   {
-	Shader() : program(0), type(ShaderType::Complex3D) {}
+	Shader() : program(0), boneDualQuaternions(-1), matModel(-1), type(ShaderType::Complex3D) {}
 	~Shader();
 
 	GLuint program;
@@ -84,12 +138,15 @@ namespace Mai {
 	GLint materialColor;
 	GLint materialMetallicAndRoughness;
 	GLint dynamicRangeFactor;
+	GLint lodBias;
 
 	GLint texDiffuse;
 	GLint texNormal;
 	GLint texMetalRoughness;
 	GLint texIBL;
 	GLint texShadow;
+	GLint texBRDF;
+	GLint shIrradiance;
 	GLint texSource;
 
 	GLint unitTexCoord;
@@ -97,6 +154,8 @@ namespace Mai {
 	GLint matView;
 	GLint matProjection;
 	GLint bones;
+	GLint boneDualQuaternions; ///< -1 if the shader uses the matrix skinning.
+	GLint matModel; ///< The model matrix applied after the dual quaternion skinning.
 
 	GLint lightDirForShadow;
 	GLint matLightForShadow;
@@ -124,92 +183,105 @@ namespace Mai {
 	VertexAttribLocation_Max,
   };
 
-  /// V[̎ݒ.
+  /// シーンの時刻設定.
   enum TimeOfScene {
-    TimeOfScene_Noon, ///< .
-    TimeOfScene_Sunset, ///< [.
-    TimeOfScene_Night, ///< .
+    TimeOfScene_Noon, ///< 昼.
+    TimeOfScene_Sunset, ///< 夕方.
+    TimeOfScene_Night, ///< 夜.
   };
   static const size_t TimeOfScene_Count = 3;
   Vector3F GetSunRayDirection(TimeOfScene);
 
-  /// V[̒n`.
+  /// シーンの地形.
   enum LandscapeOfScene {
 	LandscapeOfScene_Default,
 	LandscapeOfScene_Coast,
   };
 
-  /// e𐶐\̗͂L.
-  enum class ShadowCapability : int8_t {
-	Disable, ///< Shadow passŕ`悳Ȃ.
-	Enable, ///< Shadow passŕ`悳.
-	ShadowOnly, ///< Shadow passł̂ݕ`悳.
-  };
-
   /**
-  * `pIuWFNg.
+  * 描画用オブジェクト.
+  *
+  * The transform, the material, the mesh/shader handles and the bones are kept in ObjectStore,
+  * and this class is the handle of them with the animation state.
   */
   class Object
   {
   public:
-	Object() : isValid(false) {}
-	Object(Renderer* r, const RotTrans& rt, const Mesh::Mesh* m, const ::Mai::Material& mat, const ::Mai::Shader* s, ShadowCapability sc = ShadowCapability::Enable)
-	  : shadowCapability(sc)
-	  , isValid(m && s)
-	  , pRenderer(r)
-	  , material(mat)
-	  , meshId(m ? m->id : "")
-	  , shaderId(s ? s->id : "")
-	  , rotTrans(rt)
-	  , scale(Vector3F(1, 1, 1))
+	Object(Renderer* r, ObjectStore& store, const RotTrans& rt, const Mesh::Mesh* m, const ::Mai::Material& mat, const ::Mai::Shader* s, ShadowCapability sc = ShadowCapability::Enable)
+	  : pRenderer(r)
+	  , pStore(&store)
+	  , id(store.Add(rt, m, mat, s, s ? s->id : std::string(), sc))
+	  , modelMatrix(Matrix4x3::Unit())
+	  , animationLod(AnimationLod_Count)
+	  , animationLodFrame(0)
+	  , hasLodPose(false)
 	{
-	  if (m) {
-		bones.resize(m->jointList.size(), Matrix4x3::Unit());
-	  }
 	}
-	void Color(Color4B c) { material.color = c; }
-	Color4B Color() const { return material.color; }
-	float Metallic() const { return material.metallic.To<float>(); }
-	float Roughness() const { return material.roughness.To<float>(); }
-	void SetRoughness(float r) { material.roughness.Set(r); }
-	void SetMetallic(float r) { material.metallic.Set(r); }
-	const ::Mai::RotTrans& RotTrans() const { return rotTrans; }
+	~Object() { pStore->Remove(id); }
+	Object(const Object&) = delete;
+	Object& operator=(const Object&) = delete;
+	void Color(Color4B c) { pStore->materialList[id].color = c; }
+	Color4B Color() const { return pStore->materialList[id].color; }
+	float Metallic() const { return pStore->materialList[id].metallic.To<float>(); }
+	float Roughness() const { return pStore->materialList[id].roughness.To<float>(); }
+	void SetRoughness(float r) { pStore->materialList[id].roughness.Set(r); }
+	void SetMetallic(float r) { pStore->materialList[id].metallic.Set(r); }
+	::Mai::RotTrans RotTrans() const { return pStore->GetRotTrans(id); }
 	const Mesh::Mesh* GetMesh() const;
 	const ::Mai::Shader* GetShader() const;
-	const GLfloat* GetBoneMatirxArray() const { return bones[0].f; }
-	size_t GetBoneCount() const { return bones.size(); }
-	bool IsValid() const { return isValid; }
+	bool IsValid() const { return pStore->validList[id] != 0; }
+	bool HasAnimation() const { return !animationPlayer.id.empty(); }
+	ObjectId GetId() const { return id; }
+	float BoundingRadius() const { return pStore->boundingRadiusList[id]; }
 	void Update(float t);
 	void SetAnimation(const Animation* p) {
 	  animationPlayer.SetAnimation(p);
 	  animationPlayer.id = p ? p->id : "";
+	  animationLod = AnimationLod_Count;
+	}
+	void CrossFadeAnimation(const Animation* p, float duration) {
+	  animationPlayer.CrossFade(p, duration);
+	  animationPlayer.id = p ? p->id : "";
+	  animationLod = AnimationLod_Count;
 	}
 	void SetCurrentTime(float t) { animationPlayer.SetCurrentTime(t); }
 	float GetCurrentTime() const { return animationPlayer.GetCurrentTime(); }
-	void SetRotation(const Quaternion& r) { rotTrans.rot = r; }
+	void SetRotation(const Quaternion& r) { pStore->GetLocalRotTrans(id).rot = r; }
 	void SetRotation(float x, float y, float z) {
-	  (Matrix4x4::RotationZ(z) * Matrix4x4::RotationY(y) * Matrix4x4::RotationX(x)).Decompose(&rotTrans.rot, nullptr, nullptr);
+	  (Matrix4x4::RotationZ(z) * Matrix4x4::RotationY(y) * Matrix4x4::RotationX(x)).Decompose(&pStore->GetLocalRotTrans(id).rot, nullptr, nullptr);
 	}
-	void SetTranslation(const Vector3F& t) { rotTrans.trans = t; }
-	void SetScale(const Vector3F& s) { scale = s; }
-	Position3F Position() const { return rotTrans.trans.ToPosition3F(); }
-	const Vector3F& Scale() const { return scale; }
+	void SetTranslation(const Vector3F& t) { pStore->GetLocalRotTrans(id).trans = t; }
+	void SetScale(const Vector3F& s) { pStore->SetScale(id, s); }
+	/** Set the parent. The rotation and the translation become relative to the parent.
 
-  public:
-	ShadowCapability shadowCapability;
+	  @param p  The parent object. nullptr detaches the object.
+
+	  @retval false  \e p is this object or its descendant.
+	*/
+	bool SetParent(const Object* p) { return pStore->SetParent(id, p ? p->id : invalidObjectId); }
+	Position3F Position() const { return pStore->GetRotTrans(id).trans.ToPosition3F(); }
+	Vector3F Scale() const { return pStore->scaleList[id]; }
 
   private:
-	bool isValid;
 	Renderer* pRenderer;
-	Material material;
-	std::string meshId;
-	std::string shaderId;
+	ObjectStore* pStore; ///< The storage of the transform, the material and the handles.
+	ObjectId id;
 
-	::Mai::RotTrans rotTrans;
-	Vector3F scale;
 	AnimationPlayer animationPlayer;
-	std::vector<Matrix4x3>  bones;
+
+	void UpdateBones(const PoseBuffer& pose, const Matrix4x3& m0);
+	Matrix4x3 modelMatrix; ///< The model matrix used by the latest bones.
+	AnimationLod animationLod; ///< The LOD of the previous update. AnimationLod_Count means that the bones aren't evaluated yet.
+	int animationLodFrame; ///< The frame count since the pose was sampled in AnimationLod_Reduced. It starts from the phase of the ID.
+	bool hasLodPose; ///< true if lodPose is the pose of the latest bones.
+	PoseBuffer lodPose; ///< The pose kept to rebuild the bones when the pose isn't sampled.
   };
+  /** The shared handle of Object.
+
+    All ObjectPtrs must be released before the Renderer that created them, because Object
+	releases its slot of ObjectStore owned by the Renderer. Engine destroys the scenes before
+	the renderer, so the scenes may keep them until their destruction.
+  */
   typedef std::shared_ptr<Object> ObjectPtr;
 
   class DebugStringObject
@@ -221,7 +293,7 @@ namespace Mai {
   };
 
   /**
-  * `揈NX.
+  * 描画処理クラス.
   */
   class Renderer
   {
@@ -244,6 +316,14 @@ namespace Mai {
 	  FONTOPTION_KEEPCOLOR = 0x04,
 	};
 
+	/// The diffuse and normal texture pair for LoadTextureAtlasAsync().
+	struct AtlasTextureInfo {
+	  const char* diffuseName;
+	  std::string diffuseFile;
+	  const char* normalName;
+	  std::string normalFile;
+	};
+
   public:
 	Renderer();
 	~Renderer();
@@ -251,12 +331,19 @@ namespace Mai {
 	const Animation* GetAnimation(const char* name);
 	void Initialize(const Window&);
 	void Render(const ObjectPtr*, const ObjectPtr*);
+	void Render(const std::vector<ObjectId>&);
 	void Update(float dTime, const Position3F&, const Vector3F&, const Vector3F&);
 	void Unload();
 	void InitMesh();
 	void InitTexture();
 	void LoadLandscape(LandscapeOfScene, TimeOfScene);
 	void UnloadLandscape();
+	AssetHandle LoadTextureAsync(const char* name, const char* filename, bool streaming = false);
+	AssetHandle LoadTextureAtlasAsync(const std::vector<AtlasTextureInfo>&);
+	AssetHandle LoadMeshAsync(const char* filename, const char* diffuse, const char* normal, bool showTBN = false);
+	float GetLoadingProgress() const { return assetLoader.Progress(); }
+	bool IsLoadingCompleted() const { return assetLoader.IsCompleted(); }
+	void FinishLoading() { assetLoader.Flush(); }
 
 	const Mesh::Mesh* GetMesh(const std::string& id) const;
 	const Shader* GetShader(const std::string& id) const;
@@ -301,6 +388,15 @@ namespace Mai {
 	bool DoesDrawSkybox() const { return doesDrawSkybox; }
 	void DoesDrawSkybox(bool b) { doesDrawSkybox = b; }
 	void SetBlurScale(float f) { blurScale = f; }
+	const QualityGovernor& GetQualityGovernor() const { return qualityGovernor; }
+	ParticleSystem& GetParticleSystem() { return particleSystem; }
+	PoseCache& GetPoseCache() { return poseCache; }
+	const PoseCache& GetPoseCache() const { return poseCache; }
+	AnimationLod SelectAnimationLod(const Position3F& center, float radius);
+	const std::array<int, AnimationLod_Count>& GetAnimationLodCountList() const { return animationLodCountList; }
+
+	static const int animationLodInterval = 4; ///< The sampling interval of AnimationLod_Reduced in frames.
+	static const float animationLodScreenSize; ///< The minimum projected radius of AnimationLod_Full in the screen height.
 
   private:
 	/** The index for identifying each FBO.
@@ -342,7 +438,8 @@ namespace Mai {
 	};
 
 	FBOInfo GetFBOInfo(int) const;
-	void LoadFBX(const char* filename, const char* diffuse, const char* normal, bool showTBN = false);
+	void BeginRenderTarget(int, GLbitfield);
+	void EndRenderTarget(int, GLbitfield);
 	void CreateSkyboxMesh();
 	void CreateUnitBoxMesh();
 	void CreateOctahedronMesh();
@@ -352,12 +449,22 @@ namespace Mai {
 	void CreateCloudMesh(const char*, const Vector3F&);
 	void DrawFont(const Position2F&, const char*);
 	void DrawFontFoo();
+	void DrawParticles(const Matrix4x4& mView, const Matrix4x4& mProj, float dynamicRangeFactor);
+	void UploadBonePalette(const Shader& shader, ObjectId id, const Mesh::Mesh::MeshMaterial& material);
+	bool ResolveHandles(ObjectId id);
+	/// Get the maximum number of the bones in a draw call of the shader.
+	size_t GetBonePaletteSize(const Shader& shader) const {
+	  return shader.boneDualQuaternions >= 0 ? dualQuaternionBonePaletteSize : bonePaletteSize;
+	}
 
   private:
+	ObjectStore objectStore; ///< It is declared first, because it must outlive the objects held by the renderer.
 	bool isInitialized;
 	bool doesDrawSkybox;
 	bool hasIBLTextures;
+	uint32_t landscapeGeneration; ///< The latest request of LoadLandscape(). The older requests are discarded.
 	bool isAdreno205; ///< Adreno 205 has only poor pixel fill rate. Thus, we must reduce the scale of render buffer.
+	const Window* pWindow; ///< The window to access the user files.
 
 	EGLDisplay display;
 	EGLSurface surface;
@@ -370,6 +477,8 @@ namespace Mai {
 	float blurScale;
 
 	std::string texBaseDir;
+	/// The swizzle to fetch the XY of the two channel normal map. It depends on the transcode target.
+	const char* normalMapSwizzle;
 
 	boost::random::mt19937 random;
 
@@ -383,9 +492,17 @@ namespace Mai {
 	Position3F cameraPos;
 	Vector3F cameraDir;
 	Vector3F cameraUp;
+	float cameraFov; ///< The vertical field of view in degrees used by the latest frame.
 
 	std::array<GLuint, FBO_End - FBO_Begin> fbo;
 	GLuint depth;
+	uint8_t depthByteSize; ///< The byte size per pixel of the depth buffer.
+	bool hasDiscardFramebuffer; ///< true if GL_EXT_discard_framebuffer is available.
+	size_t discardedByteSize; ///< The estimated byte size that needs not load/store from the tile memory in the current frame.
+
+	QualityGovernor qualityGovernor;
+	bool hasGPUTimer; ///< true if the pass time can be measured by GL_NV_fence.
+	int64_t prevFrameTime; ///< The time when the previous frame was started(unit:nsec).
 
 	GLuint vbo;
 	GLintptr vboEnd;
@@ -401,8 +518,23 @@ namespace Mai {
 	};
 	std::vector<FontRenderingInfo> fontRenderingInfoList;
 
+	ParticleSystem particleSystem;
+	PoseCache poseCache; ///< The sampled poses shared by the objects.
+	std::array<int, AnimationLod_Count> animationLodCountList; ///< The number of the objects in each animation LOD in the latest frame.
+	std::array<int, AnimationLod_Count> animationLodCounter; ///< The number of the objects in each animation LOD in the current frame.
+	GLuint vboParticle; ///< The streaming buffer for the particle vertices. It is orphaned in each frame.
+	GLuint iboParticle; ///< The static index buffer for the particle rectangles.
+	std::vector<ParticleVertex> particleVertexList;
+
 	float animationTick;
 
+	/// The number of the uniform vectors used by the skinning shaders except the bone matrices.
+	static const GLint reservedVertexUniformVectors = 16;
+	size_t bonePaletteSize; ///< The maximum number of the bone matrices in a draw call.
+	size_t dualQuaternionBonePaletteSize; ///< The maximum number of the bone dual quaternions in a draw call.
+	std::vector<Matrix4x3> bonePaletteBuffer; ///< The work buffer to upload the bone palette.
+	std::vector<Vector4F> bonePaletteDualQuaternionBuffer; ///< The work buffer to upload the bone palette of the dual quaternion skinning.
+
 	FilterMode filterMode;
 	Color4B filterColor;
 	float filterTimer;
@@ -417,10 +549,28 @@ namespace Mai {
 	std::map<std::string, Mesh::Mesh> meshList;
 	std::map<std::string, Animation> animationList;
 	std::map<std::string, Texture::TexturePtr> textureList;
+	/// The texture byte size budget. The least recently used textures are evicted over it.
+	static const uint64_t textureBudgetByteSize = 24 * 1024 * 1024;
+	/// The maximum byte size uploaded by the texture streaming in each frame.
+	static const uint32_t textureStreamingByteBudget = 256 * 1024;
+
+	/// The texture coordinate transforms of the textures packed into the atlas. xy: scale, zw: offset.
+	std::map<std::string, Vector4F> texCoordScaleOffsetList;
+	/// The maximum size of the texture atlas.
+	static const int textureAtlasSize = 512;
+	/// The maximum size of the texture packed into the atlas.
+	static const int textureAtlasMaxTileSize = 256;
+	std::vector<ObjectId> renderIdList; ///< The IDs of the objects given by Render(const ObjectPtr*, const ObjectPtr*).
+	/// The objects whose mesh and shader are resolved. The color pass sorts them by the texture to reduce the texture binding.
+	std::vector<ObjectId> drawIdList;
+
+	AssetLoader assetLoader;
+	/// The maximum time to upload the assets in each frame(unit:nsec).
+	static const int64_t assetUploadTimeBudget = 4 * 1000 * 1000;
 
 	static const size_t iblSourceRoughnessCount = 7;
 	std::array<Texture::TexturePtr, iblSourceRoughnessCount> iblSpecularSourceList;
-	Texture::TexturePtr iblDiffuseSourceList;
+	IrradianceSH irradianceSH; ///< The diffuse IBL source projected from iblSpecularSourceList[0].
 
 	std::vector<DebugStringObject> debugStringList;
   };
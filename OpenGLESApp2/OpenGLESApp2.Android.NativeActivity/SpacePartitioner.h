@@ -15,16 +15,25 @@ namespace Mai {
 	Position3F max;
   };
 
+  /** The mobility of the object in SpacePartitioner.
+  */
+  enum class ObjectMobility {
+	Static, ///< Updated only when the animation is set, or its rigid body is moved.
+	Dynamic, ///< Updated every frame.
+  };
+
   struct Obj {
 	ObjectPtr object;
 	Collision::RigidBodyPtr collision;
 	Vector3F offset;
+	ObjectMobility mobility;
   };
 
   struct Cell
   {
 	Region region;
 	std::list<Obj> objects;
+	std::vector<ObjectId> idList; ///< The IDs of the objects, to pass them to Renderer::Render() without chasing the pointers.
   };
 
   class SpacePartitioner
@@ -35,6 +44,8 @@ namespace Mai {
 	typedef CellListType::const_iterator const_iterator;
 
 	SpacePartitioner(const Position3F& min, const Position3F& max, float uy, int /*maxObjects*/)
+	  : objectCount(0)
+	  , updatedCount(0)
 	{
 	  cells.resize(static_cast<size_t>(std::ceil((max.y - min.y) / uy)));
 	  rootRegion.min = min;
@@ -45,13 +56,32 @@ namespace Mai {
 		cells[i].region.max = Position3F(max.x, min.y + (i + 1) * unitY, max.z);
 	  }
 	}
-	void Insert(const ObjectPtr& obj, const Collision::RigidBodyPtr& c = Collision::RigidBodyPtr(), const Vector3F& offset = Vector3F::Unit()) {
+	/** Insert the object.
+
+	  The animated or dynamic object is added to the active list. The static object
+	  with the rigid body is added to the sleeping list, and others are never updated.
+	  So the animation of the static object must be set before it is inserted.
+
+	  @param obj       The object.
+	  @param c         The rigid body of the object.
+	  @param offset    The offset of the object from the rigid body.
+	  @param mobility  The mobility of the object.
+	*/
+	void Insert(const ObjectPtr& obj, const Collision::RigidBodyPtr& c = Collision::RigidBodyPtr(), const Vector3F& offset = Vector3F::Unit(), ObjectMobility mobility = ObjectMobility::Static) {
 	  const float y = obj->Position().y;
 	  Cell& cell = GetCell(y);
-	  cell.objects.push_back({ obj, c, offset });
+	  cell.objects.push_back({ obj, c, offset, mobility });
+	  cell.idList.push_back(obj->GetId());
+	  Obj* p = &cell.objects.back();
+	  if (mobility == ObjectMobility::Dynamic || obj->HasAnimation()) {
+		activeList.push_back(p);
+	  } else if (c) {
+		sleepingList.push_back(p);
+	  }
 	  if (c) {
 		world.Insert(c);
 	  }
+	  ++objectCount;
 	}
 	int GetCellId(float y) const {
 	  return std::max<int>(
@@ -64,30 +94,58 @@ namespace Mai {
 	}
 	Cell& GetCell(float y) { return cells[GetCellId(y)]; }
 	const Cell& GetCell(float y) const { return cells[GetCellId(y)]; }
+	/** Update the physics and the objects.
+
+	  Only the active objects, and the sleeping objects whose rigid body has moved
+	  in this step, are updated.
+
+	  @param f  The delta time.
+	*/
 	void Update(float f) {
 	  world.Step(f);
-	  for (auto& c : cells) {
-		for (auto& e : c.objects) {
-		  if (e.collision) {
-			const Position3F pos = e.collision->Position() + e.collision->ApplyRotation(e.offset);
-			e.object->SetTranslation(Vector3F(pos));
-		  }
-		  Object* p = e.object.get();
-		  p->Update(f);
+	  updatedCount = 0;
+	  for (Obj* e : activeList) {
+		UpdateObject(*e, f);
+	  }
+	  for (Obj* e : sleepingList) {
+		if (e->collision->hasMoved) {
+		  UpdateObject(*e, f);
 		}
 	  }
 	}
+	size_t GetObjectCount() const { return objectCount; } ///< The number of the inserted objects.
+	size_t GetUpdatedCount() const { return updatedCount; } ///< The number of the updated objects in the latest Update().
+	size_t GetSkippedCount() const { return objectCount - updatedCount; } ///< The number of the skipped objects in the latest Update().
 	iterator Begin() { return cells.begin(); }
 	iterator End() { return cells.end(); }
 	const_iterator Begin() const { return cells.begin(); }
 	const_iterator End() const { return cells.end(); }
-	void Clear() { cells.clear(); }
+	void Clear() {
+	  cells.clear();
+	  activeList.clear();
+	  sleepingList.clear();
+	  objectCount = 0;
+	  updatedCount = 0;
+	}
 
   private:
+	void UpdateObject(Obj& e, float f) {
+	  if (e.collision) {
+		const Position3F pos = e.collision->Position() + e.collision->ApplyRotation(e.offset);
+		e.object->SetTranslation(Vector3F(pos));
+	  }
+	  e.object->Update(f);
+	  ++updatedCount;
+	}
+
 	Collision::World world;
 	Region rootRegion;
 	float unitY;
 	std::vector<Cell> cells;
+	std::vector<Obj*> activeList; ///< The objects updated every frame.
+	std::vector<Obj*> sleepingList; ///< The static objects updated only when their rigid body has moved.
+	size_t objectCount;
+	size_t updatedCount;
   };
 
 } // namespace Mai
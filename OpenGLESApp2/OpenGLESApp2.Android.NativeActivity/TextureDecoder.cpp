@@ -0,0 +1,580 @@
+#include "TextureDecoder.h"
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <algorithm>
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+// The ETC2 formats of OpenGL ES 3.0. They are decompressed on CPU in OpenGL ES 2.0.
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9276
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+
+namespace Texture {
+
+  namespace {
+
+	bool Color1555To888(uint16_t color1555, uint32_t* pColor888) {
+	  const uint32_t r = ((color1555 & 0x00007C00) >> 7) | ((color1555 & 0x00007000) >> 12);
+	  const uint32_t g = ((color1555 & 0x000003E0) >> 2) | ((color1555 & 0x00000380) >> 7);
+	  const uint32_t b = ((color1555 & 0x0000001F) << 3) | ((color1555 & 0x0000001C) >> 2);
+	  *pColor888 = (b << 16) | (g << 8) | r;
+
+	  return (color1555 & 0x8000) != 0;
+	}
+
+	void Color565To888(uint16_t color565, uint32_t* pColor888) {
+	  const uint32_t r = ((color565 & 0x0000F800) >> 8) | ((color565 & 0x0000E000) >> 13);
+	  const uint32_t g = ((color565 & 0x000007E0) >> 3) | ((color565 & 0x00000600) >> 9);
+	  const uint32_t b = ((color565 & 0x0000001F) << 3) | ((color565 & 0x0000001C) >> 2);
+	  *pColor888 = (b << 16) | (g << 8) | r;
+	}
+
+	template<uint32_t RightShift, uint32_t Mask = 0xff, typename R = uint32_t>
+	R Elem(uint32_t rgba) { return static_cast<R>((rgba >> RightShift) & Mask); }
+
+	void GetColors(uint16_t color0, uint16_t color1, uint32_t* col) {
+	  static int      iColorLow = 0;
+	  static int      iColorMedLow = 1;
+	  static int      iColorMedHigh = 2;
+	  static int      iColorHigh = 3;
+
+	  const bool hasBlackTrick = Color1555To888(color0, &col[iColorLow]);
+	  Color565To888(color1, &col[iColorHigh]);
+
+	  if (hasBlackTrick) {
+		col[iColorMedHigh] = col[iColorLow];
+
+		col[iColorMedLow] = static_cast<uint32_t>(std::max(Elem<16, 0xff, int32_t>(col[iColorMedHigh]) - Elem<18, 0x3f, int32_t>(col[iColorHigh]), 0)) << 16;
+		col[iColorMedLow] |= static_cast<uint32_t>(std::max(Elem<8, 0xff, int32_t>(col[iColorMedHigh]) - Elem<10, 0x3f, int32_t>(col[iColorHigh]), 0)) < 8;
+		col[iColorMedLow] |= static_cast<uint32_t>(std::max(Elem<0, 0xff, int32_t>(col[iColorMedHigh]) - Elem<2, 0x3f, int32_t>(col[iColorHigh]), 0));
+
+		col[iColorLow] = 0;
+	  } else {
+		col[iColorMedHigh] = (Elem<16>(col[iColorHigh]) * 5 + Elem<16>(col[iColorLow]) * 3) >> 3 << 16;
+		col[iColorMedHigh] |= (Elem<8>(col[iColorHigh]) * 5 + Elem<8>(col[iColorLow]) * 3) >> 3 << 8;
+		col[iColorMedHigh] |= (Elem<0>(col[iColorHigh]) * 5 + Elem<0>(col[iColorLow]) * 3) >> 3;
+
+		col[iColorMedLow] = (Elem<16>(col[iColorHigh]) * 3 + Elem<16>(col[iColorLow]) * 5) >> 3 << 16;
+		col[iColorMedLow] |= (Elem<8>(col[iColorHigh]) * 3 + Elem<8>(col[iColorLow]) * 5) >> 3 << 8;
+		col[iColorMedLow] |= (Elem<0>(col[iColorHigh]) * 3 + Elem<0>(col[iColorLow]) * 5) >> 3;
+	  }
+	}
+
+	struct ColorBlock {
+	  uint16_t color0;
+	  uint16_t color1;
+	  uint8_t pixels[4]; ///< The 2 bit color indices of each row.
+	};
+
+	struct ExplicitAlphaBlock {
+	  uint8_t pixels[8]; ///< The 4 bit alpha values of each row.
+
+	  /** Get the alpha channel of 16 pixels in the row major order.
+
+	    The odd columns keep the low nibble zero as the original decoder did,
+		so that the result is bit-identical to the previous version.
+	  */
+	  void Get(uint8_t* alpha) const {
+		for (int i = 0; i < 8; ++i) {
+		  *(alpha++) = static_cast<uint8_t>((pixels[i] & 0x0f) * 0x11);
+		  *(alpha++) = static_cast<uint8_t>(pixels[i] & 0xf0);
+		}
+	  }
+	};
+
+	struct InterporatedAlphaBlock {
+	  uint8_t alpha0;
+	  uint8_t alpha1;
+	  uint8_t pixels[6];
+
+	  void GetCompressedAlphaRamp(uint8_t* result) const {
+		result[0] = alpha0;
+		result[1] = alpha1;
+
+		if (alpha0 > alpha1) {
+		  // 8-alpha block:  derive the other six alphas.
+		  // Bit code 000 = alpha_0, 001 = alpha_1, others are interpolated.
+		  result[2] = static_cast<uint8_t>((6 * alpha0 + 1 * alpha1 + 3) / 7);    // bit code 010
+		  result[3] = static_cast<uint8_t>((5 * alpha0 + 2 * alpha1 + 3) / 7);    // bit code 011
+		  result[4] = static_cast<uint8_t>((4 * alpha0 + 3 * alpha1 + 3) / 7);    // bit code 100
+		  result[5] = static_cast<uint8_t>((3 * alpha0 + 4 * alpha1 + 3) / 7);    // bit code 101
+		  result[6] = static_cast<uint8_t>((2 * alpha0 + 5 * alpha1 + 3) / 7);    // bit code 110
+		  result[7] = static_cast<uint8_t>((1 * alpha0 + 6 * alpha1 + 3) / 7);    // bit code 111
+		} else {
+		  // 6-alpha block.
+		  // Bit code 000 = alpha_0, 001 = alpha_1, others are interpolated.
+		  result[2] = static_cast<uint8_t>((4 * alpha0 + 1 * alpha1 + 2) / 5);  // Bit code 010
+		  result[3] = static_cast<uint8_t>((3 * alpha0 + 2 * alpha1 + 2) / 5);  // Bit code 011
+		  result[4] = static_cast<uint8_t>((2 * alpha0 + 3 * alpha1 + 2) / 5);  // Bit code 100
+		  result[5] = static_cast<uint8_t>((1 * alpha0 + 4 * alpha1 + 2) / 5);  // Bit code 101
+		  result[6] = 0;                                      // Bit code 110
+		  result[7] = 255;                                    // Bit code 111
+		}
+	  }
+
+	  /** Get the alpha channel of 16 pixels in the row major order.
+	  */
+	  void Get(uint8_t* alpha) const {
+		uint8_t ramp[8];
+		GetCompressedAlphaRamp(ramp);
+		// The 3 bit indices of 16 pixels are packed into 48 bits in the little endian order.
+		uint64_t bits = 0;
+		for (int i = 5; i >= 0; --i) {
+		  bits = (bits << 8) | pixels[i];
+		}
+		for (int i = 0; i < 16; ++i, bits >>= 3) {
+		  alpha[i] = ramp[bits & 7];
+		}
+	  }
+	};
+
+	struct ExplicitBlock {
+	  ExplicitAlphaBlock alpha;
+	  ColorBlock color;
+	};
+
+	struct InterporatedBlock {
+	  InterporatedAlphaBlock alpha;
+	  ColorBlock color;
+	};
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__SSSE3__)
+	/// The byte shuffle masks that expand the 4 color indices of a row to the RGBA8888 pixels.
+	struct ColorIndexShuffleTable {
+	  uint8_t mask[256][16];
+
+	  ColorIndexShuffleTable() {
+		for (int i = 0; i < 256; ++i) {
+		  for (int x = 0; x < 4; ++x) {
+			const int index = (i >> (x * 2)) & 3;
+			for (int c = 0; c < 4; ++c) {
+			  mask[i][x * 4 + c] = static_cast<uint8_t>(index * 4 + c);
+			}
+		  }
+		}
+	  }
+	};
+	const ColorIndexShuffleTable colorIndexShuffleTable;
+#endif
+
+	/** Expand the color indices of a row in ColorBlock to 4 pixels.
+
+	  NEON and SSSE3 look up the palette by the byte shuffle of the whole row.
+	  The other CPUs use the scalar lookup.
+
+	  @param palette  The 4 colors made by GetColors().
+	  @param indices  The 2 bit color indices of the row.
+	  @param out      The 4 pixels are stored.
+	*/
+	void ExpandColorRow(const uint32_t* palette, uint8_t indices, uint32_t* out) {
+#if defined(__aarch64__)
+	  const uint8x16_t pal = vld1q_u8(reinterpret_cast<const uint8_t*>(palette));
+	  vst1q_u8(reinterpret_cast<uint8_t*>(out), vqtbl1q_u8(pal, vld1q_u8(colorIndexShuffleTable.mask[indices])));
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+	  const uint8x8x2_t pal = { { vld1_u8(reinterpret_cast<const uint8_t*>(palette)), vld1_u8(reinterpret_cast<const uint8_t*>(palette + 2)) } };
+	  const uint8x16_t mask = vld1q_u8(colorIndexShuffleTable.mask[indices]);
+	  vst1q_u8(reinterpret_cast<uint8_t*>(out), vcombine_u8(vtbl2_u8(pal, vget_low_u8(mask)), vtbl2_u8(pal, vget_high_u8(mask))));
+#elif defined(__SSSE3__)
+	  const __m128i pal = _mm_loadu_si128(reinterpret_cast<const __m128i*>(palette));
+	  const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colorIndexShuffleTable.mask[indices]));
+	  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(pal, mask));
+#else
+	  for (int x = 0; x < 4; ++x) {
+		out[x] = palette[(indices >> (x * 2)) & 3];
+	  }
+#endif
+	}
+
+
+	/** Expand the color indices of a row to 4 pixels with 2 palettes.
+
+	  The left 2 pixels look up the first palette, and the right 2 pixels look up the second.
+	  It is used by the ETC blocks whose sub blocks are split vertically.
+
+	  @param left     The palette of the left 2 pixels.
+	  @param right    The palette of the right 2 pixels.
+	  @param indices  The 2 bit color indices of the row.
+	  @param out      The 4 pixels are stored.
+	*/
+	void ExpandColorRow(const uint32_t* left, const uint32_t* right, uint8_t indices, uint32_t* out) {
+#if defined(__aarch64__)
+	  const uint8x16_t mask = vld1q_u8(colorIndexShuffleTable.mask[indices]);
+	  const uint8x8_t l = vget_low_u8(vqtbl1q_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(left)), mask));
+	  const uint8x8_t r = vget_high_u8(vqtbl1q_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(right)), mask));
+	  vst1q_u8(reinterpret_cast<uint8_t*>(out), vcombine_u8(l, r));
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+	  const uint8x8x2_t l = { { vld1_u8(reinterpret_cast<const uint8_t*>(left)), vld1_u8(reinterpret_cast<const uint8_t*>(left + 2)) } };
+	  const uint8x8x2_t r = { { vld1_u8(reinterpret_cast<const uint8_t*>(right)), vld1_u8(reinterpret_cast<const uint8_t*>(right + 2)) } };
+	  const uint8x16_t mask = vld1q_u8(colorIndexShuffleTable.mask[indices]);
+	  vst1q_u8(reinterpret_cast<uint8_t*>(out), vcombine_u8(vtbl2_u8(l, vget_low_u8(mask)), vtbl2_u8(r, vget_high_u8(mask))));
+#elif defined(__SSSE3__)
+	  const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colorIndexShuffleTable.mask[indices]));
+	  const __m128i l = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left)), mask);
+	  const __m128i r = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(right)), mask);
+	  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_castpd_si128(_mm_shuffle_pd(_mm_castsi128_pd(l), _mm_castsi128_pd(r), 2)));
+#else
+	  for (int x = 0; x < 4; ++x) {
+		out[x] = (x < 2 ? left : right)[(indices >> (x * 2)) & 3];
+	  }
+#endif
+	}
+
+	/// The modifier tables of ETC1, and of the individual and differential modes of ETC2.
+	/// The index is the pixel index (MSB, LSB).
+	const int etcModifierTable[8][4] = {
+	  { 2, 8, -2, -8 }, { 5, 17, -5, -17 }, { 9, 29, -9, -29 }, { 13, 42, -13, -42 },
+	  { 18, 60, -18, -60 }, { 24, 80, -24, -80 }, { 33, 106, -33, -106 }, { 47, 183, -47, -183 },
+	};
+
+	/// The distance table of the T and H modes of ETC2.
+	const int etcDistanceTable[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+	/// The modifier tables of the EAC alpha block.
+	const int eacModifierTable[16][8] = {
+	  { -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+	  { -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+	  { -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 },
+	  { -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+	  { -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 },
+	  { -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+	  { -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 },
+	  { -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 },
+	};
+
+	uint32_t Clamp255(int v) { return static_cast<uint32_t>(std::min(255, std::max(0, v))); }
+
+	/// Make RGBA8888 from the unclamped color. The layout is the same as DecompressATITC().
+	uint32_t MakeRGBA(int r, int g, int b, uint32_t a = 255) {
+	  return Clamp255(r) | (Clamp255(g) << 8) | (Clamp255(b) << 16) | (a << 24);
+	}
+
+	/// Add the same value to each channel of RGBA8888 with saturation.
+	uint32_t AddLuminance(uint32_t rgba, int d) {
+	  return MakeRGBA(Elem<0, 0xff, int>(rgba) + d, Elem<8, 0xff, int>(rgba) + d, Elem<16, 0xff, int>(rgba) + d, rgba >> 24);
+	}
+
+
+	/** Make the palettes of 2 sub blocks of the ETC block.
+
+	  NEON and SSE compute each channel of 8 colors at once, and the saturating narrow
+	  clamps them to [0, 255].
+
+	  @param base      The base color of each sub block.
+	  @param modifier  The modifiers of each sub block. [0, 4) for the first sub block.
+	  @param palette   The 8 colors are stored. [0, 4) for the first sub block.
+	*/
+	void MakeSubBlockPalettes(const int (*base)[3], const int16_t* modifier, uint32_t* palette) {
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+	  const int16x8_t m = vld1q_s16(modifier);
+	  uint8x8x4_t v;
+	  for (int c = 0; c < 3; ++c) {
+		v.val[c] = vqmovun_s16(vaddq_s16(vcombine_s16(vdup_n_s16(base[0][c]), vdup_n_s16(base[1][c])), m));
+	  }
+	  v.val[3] = vdup_n_u8(255);
+	  vst4_u8(reinterpret_cast<uint8_t*>(palette), v);
+#elif defined(__SSSE3__)
+	  const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(modifier));
+	  __m128i v[3];
+	  for (int c = 0; c < 3; ++c) {
+		const int16_t b0 = static_cast<int16_t>(base[0][c]);
+		const int16_t b1 = static_cast<int16_t>(base[1][c]);
+		v[c] = _mm_packus_epi16(_mm_add_epi16(_mm_setr_epi16(b0, b0, b0, b0, b1, b1, b1, b1), m), _mm_setzero_si128());
+	  }
+	  const __m128i rg = _mm_unpacklo_epi8(v[0], v[1]);
+	  const __m128i ba = _mm_unpacklo_epi8(v[2], _mm_set1_epi8(-1));
+	  _mm_storeu_si128(reinterpret_cast<__m128i*>(palette), _mm_unpacklo_epi16(rg, ba));
+	  _mm_storeu_si128(reinterpret_cast<__m128i*>(palette + 4), _mm_unpackhi_epi16(rg, ba));
+#else
+	  for (int i = 0; i < 8; ++i) {
+		const int* b = base[i / 4];
+		palette[i] = MakeRGBA(b[0] + modifier[i], b[1] + modifier[i], b[2] + modifier[i]);
+	  }
+#endif
+	}
+
+	/// Spread 4 bits to the even bits of the byte.
+	const uint8_t evenBitTable[16] = {
+	  0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15, 0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55,
+	};
+
+	/** Get the pixel indices of a row of the ETC block in the layout of ColorBlock.
+
+	  The indices of ETC are stored in the column major order as the bit planes of MSB and LSB.
+	  The bits of the row are gathered by the multiplication, and interleaved by the table.
+
+	  @param lo  The lower 32 bits of the block.
+	  @param y   The row.
+
+	  @return The 2 bit indices of 4 pixels. The index of x is at the bit (x * 2).
+	*/
+	uint8_t GetETCRowIndices(uint32_t lo, int y) {
+	  const uint32_t lsb = ((((lo >> y) & 0x1111) * 0x1248) >> 12) & 15;
+	  const uint32_t msb = ((((lo >> (16 + y)) & 0x1111) * 0x1248) >> 12) & 15;
+	  return static_cast<uint8_t>(evenBitTable[lsb] | (evenBitTable[msb] << 1));
+	}
+
+	/** Decode the ETC1/ETC2 RGB block.
+
+	  The palette of the block is built at first, and then each row of the pixels is expanded
+	  by the byte shuffle as same as ATITC. The palettes of the individual and differential modes
+	  are built by MakeSubBlockPalettes().
+
+	  @param block         The 8 bytes color block.
+	  @param isETC2        false if the block is ETC1, that has no T, H and planar modes.
+	  @param punchthrough  true if the block is GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2.
+	  @param rgba          The 4x4 pixels are stored in the row major order.
+	*/
+	void DecodeETCBlock(const uint8_t* block, bool isETC2, bool punchthrough, uint32_t* rgba) {
+	  const uint32_t hi = (block[0] << 24) | (block[1] << 16) | (block[2] << 8) | block[3];
+	  const uint32_t lo = (block[4] << 24) | (block[5] << 16) | (block[6] << 8) | block[7];
+	  // In the punchthrough block, the diff bit is the opaque bit and the individual mode isn't available.
+	  const bool isDifferential = punchthrough || (hi & 2);
+	  const bool isOpaque = !punchthrough || (hi & 2);
+
+	  uint32_t palette[2][4];
+	  bool hasSubBlocks = true;
+	  const int cw[2] = { static_cast<int>(hi >> 5) & 7, static_cast<int>(hi >> 2) & 7 };
+	  if (!isDifferential) {
+		int base[2][3];
+		int16_t modifier[8];
+		for (int i = 0; i < 2; ++i) {
+		  base[i][0] = ((hi >> (28 - i * 4)) & 15) * 17;
+		  base[i][1] = ((hi >> (20 - i * 4)) & 15) * 17;
+		  base[i][2] = ((hi >> (12 - i * 4)) & 15) * 17;
+		  for (int j = 0; j < 4; ++j) {
+			modifier[i * 4 + j] = static_cast<int16_t>(etcModifierTable[cw[i]][j]);
+		  }
+		}
+		MakeSubBlockPalettes(base, modifier, palette[0]);
+	  } else {
+		const int r = (hi >> 27) & 31, dr = static_cast<int>(((hi >> 24) & 7) ^ 4) - 4;
+		const int g = (hi >> 19) & 31, dg = static_cast<int>(((hi >> 16) & 7) ^ 4) - 4;
+		const int b = (hi >> 11) & 31, db = static_cast<int>(((hi >> 8) & 7) ^ 4) - 4;
+		if (isETC2 && (r + dr < 0 || r + dr > 31)) {
+		  // T mode.
+		  hasSubBlocks = false;
+		  const int r1 = ((hi >> 25) & 12) | ((hi >> 24) & 3);
+		  const uint32_t c1 = MakeRGBA(r1 * 17, ((hi >> 20) & 15) * 17, ((hi >> 16) & 15) * 17);
+		  const uint32_t c2 = MakeRGBA(((hi >> 12) & 15) * 17, ((hi >> 8) & 15) * 17, ((hi >> 4) & 15) * 17);
+		  const int d = etcDistanceTable[((hi >> 1) & 6) | (hi & 1)];
+		  palette[0][0] = c1;
+		  palette[0][1] = AddLuminance(c2, d);
+		  palette[0][2] = c2;
+		  palette[0][3] = AddLuminance(c2, -d);
+		} else if (isETC2 && (g + dg < 0 || g + dg > 31)) {
+		  // H mode.
+		  hasSubBlocks = false;
+		  const uint32_t r1 = (hi >> 27) & 15;
+		  const uint32_t g1 = ((hi >> 23) & 14) | ((hi >> 20) & 1);
+		  const uint32_t b1 = ((hi >> 16) & 8) | ((hi >> 15) & 7);
+		  const uint32_t r2 = (hi >> 11) & 15;
+		  const uint32_t g2 = (hi >> 7) & 15;
+		  const uint32_t b2 = (hi >> 3) & 15;
+		  const uint32_t order = ((r1 << 8) | (g1 << 4) | b1) >= ((r2 << 8) | (g2 << 4) | b2) ? 1 : 0;
+		  const int d = etcDistanceTable[((hi >> 0) & 4) | ((hi << 1) & 2) | order];
+		  const uint32_t c1 = MakeRGBA(r1 * 17, g1 * 17, b1 * 17);
+		  const uint32_t c2 = MakeRGBA(r2 * 17, g2 * 17, b2 * 17);
+		  palette[0][0] = AddLuminance(c1, d);
+		  palette[0][1] = AddLuminance(c1, -d);
+		  palette[0][2] = AddLuminance(c2, d);
+		  palette[0][3] = AddLuminance(c2, -d);
+		} else if (isETC2 && (b + db < 0 || b + db > 31)) {
+		  // Planar mode. It has no pixel index, and it is always opaque.
+		  const int ro = (hi >> 25) & 63;
+		  const int go = ((hi >> 18) & 64) | ((hi >> 17) & 63);
+		  const int bo = ((hi >> 11) & 32) | ((hi >> 8) & 24) | ((hi >> 7) & 7);
+		  const int rh = ((hi >> 1) & 62) | (hi & 1);
+		  const int gh = (lo >> 25) & 127;
+		  const int bh = (lo >> 19) & 63;
+		  const int rv = (lo >> 13) & 63;
+		  const int gv = (lo >> 6) & 127;
+		  const int bv = lo & 63;
+		  const int o[3] = { (ro << 2) | (ro >> 4), (go << 1) | (go >> 6), (bo << 2) | (bo >> 4) };
+		  const int h[3] = { (rh << 2) | (rh >> 4), (gh << 1) | (gh >> 6), (bh << 2) | (bh >> 4) };
+		  const int v[3] = { (rv << 2) | (rv >> 4), (gv << 1) | (gv >> 6), (bv << 2) | (bv >> 4) };
+		  for (int y = 0; y < 4; ++y) {
+			for (int x = 0; x < 4; ++x) {
+			  *(rgba++) = MakeRGBA(
+				(x * (h[0] - o[0]) + y * (v[0] - o[0]) + 4 * o[0] + 2) >> 2,
+				(x * (h[1] - o[1]) + y * (v[1] - o[1]) + 4 * o[1] + 2) >> 2,
+				(x * (h[2] - o[2]) + y * (v[2] - o[2]) + 4 * o[2] + 2) >> 2);
+			}
+		  }
+		  return;
+		} else {
+		  const int base[2][3] = {
+			{ (r << 3) | (r >> 2), (g << 3) | (g >> 2), (b << 3) | (b >> 2) },
+			{ ((r + dr) << 3) | ((r + dr) >> 2), ((g + dg) << 3) | ((g + dg) >> 2), ((b + db) << 3) | ((b + db) >> 2) },
+		  };
+		  int16_t modifier[8];
+		  for (int i = 0; i < 2; ++i) {
+			for (int j = 0; j < 4; ++j) {
+			  // Without the opaque bit, the pixel index 0 has no modification, and 2 is transparent.
+			  modifier[i * 4 + j] = static_cast<int16_t>((!isOpaque && !(j & 1)) ? 0 : etcModifierTable[cw[i]][j]);
+			}
+		  }
+		  MakeSubBlockPalettes(base, modifier, palette[0]);
+		  if (!isOpaque) {
+			palette[0][2] = 0;
+			palette[1][2] = 0;
+		  }
+		}
+		if (!hasSubBlocks && !isOpaque) {
+		  palette[0][2] = 0;
+		}
+	  }
+
+	  // The sub block is split by the flip bit. The T and H modes use only the first palette.
+	  const bool flip = (hi & 1) != 0;
+	  for (int y = 0; y < 4; ++y, rgba += 4) {
+		const uint8_t indices = GetETCRowIndices(lo, y);
+		if (!hasSubBlocks) {
+		  ExpandColorRow(palette[0], indices, rgba);
+		} else if (flip) {
+		  ExpandColorRow(palette[y >> 1], indices, rgba);
+		} else {
+		  ExpandColorRow(palette[0], palette[1], indices, rgba);
+		}
+	  }
+	}
+
+
+	/** Decode the EAC alpha block and store it to the alpha channel of the pixels.
+
+	  @param block  The 8 bytes alpha block.
+	  @param rgba   The 4x4 pixels in the row major order.
+	*/
+	void DecodeEACAlphaBlock(const uint8_t* block, uint32_t* rgba) {
+	  const int base = block[0];
+	  const int multiplier = block[1] >> 4;
+	  const int* modifier = eacModifierTable[block[1] & 15];
+	  uint32_t ramp[8];
+	  for (int i = 0; i < 8; ++i) {
+		ramp[i] = Clamp255(base + modifier[i] * multiplier) << 24;
+	  }
+	  uint64_t bits = 0;
+	  for (int i = 2; i < 8; ++i) {
+		bits = (bits << 8) | block[i];
+	  }
+	  for (int k = 0; k < 16; ++k) {
+		const int x = k / 4;
+		const int y = k % 4;
+		uint32_t& pixel = rgba[y * 4 + x];
+		pixel = (pixel & 0x00ffffff) | ramp[(bits >> (45 - k * 3)) & 7];
+	  }
+	}
+
+  } // unnamed namespace
+
+	bool IsETCFormat(uint32_t format) {
+	  switch (format) {
+	  case GL_ETC1_RGB8_OES:
+	  case GL_COMPRESSED_RGB8_ETC2:
+	  case GL_COMPRESSED_RGBA8_ETC2_EAC:
+	  case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		return true;
+	  default:
+		return false;
+	  }
+	}
+
+	/// Check whether the compressed format can be decompressed on CPU.
+	bool CanDecompress(uint32_t format) {
+	  return IsETCFormat(format) || format == GL_ATC_RGBA_EXPLICIT_ALPHA_AMD || format == GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD;
+	}
+
+
+	/** Convert the block rows of ATITC to RGBA8888.
+
+	  @param pImage         The compressed image.
+	  @param w              The width of the image.
+	  @param h              The height of the image.
+	  @param format         GL_ATC_RGBA_EXPLICIT_ALPHA_AMD or GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD.
+	  @param blockRowBegin  The first block row to decompress.
+	  @param blockRowEnd    The block row next to the last one.
+	  @param result         The image that has w * h pixels.
+
+	  @sa https://github.com/GPUOpen-Tools/Compressonator
+	*/
+	void DecompressATITC(const uint8_t* pImage, uint32_t w, uint32_t h, uint32_t format, uint32_t blockRowBegin, uint32_t blockRowEnd, uint32_t* result) {
+	  static_assert(sizeof(ExplicitBlock) == 16 && sizeof(InterporatedBlock) == 16, "ATITC block must be 16 bytes");
+	  const bool isExplicit = format == GL_ATC_RGBA_EXPLICIT_ALPHA_AMD;
+	  const uint32_t xcount = (w + 3) / 4;
+	  for (uint32_t by = blockRowBegin; by < blockRowEnd; ++by) {
+		const uint8_t* p = pImage + by * xcount * 16;
+		for (uint32_t bx = 0; bx < xcount; ++bx, p += 16) {
+		  const ColorBlock& color = *reinterpret_cast<const ColorBlock*>(p + 8);
+		  uint32_t palette[4];
+		  GetColors(color.color0, color.color1, palette);
+		  uint32_t rgba[16];
+		  for (int y = 0; y < 4; ++y) {
+			ExpandColorRow(palette, color.pixels[y], rgba + y * 4);
+		  }
+		  uint8_t alpha[16];
+		  if (isExplicit) {
+			reinterpret_cast<const ExplicitAlphaBlock*>(p)->Get(alpha);
+		  } else {
+			reinterpret_cast<const InterporatedAlphaBlock*>(p)->Get(alpha);
+		  }
+		  // The blocks at the right and bottom edges of the small mip levels are clipped.
+		  const uint32_t ww = std::min<uint32_t>(4, w - bx * 4);
+		  const uint32_t hh = std::min<uint32_t>(4, h - by * 4);
+		  for (uint32_t yy = 0; yy < hh; ++yy) {
+			uint32_t* pDest = result + (by * 4 + yy) * w + bx * 4;
+			for (uint32_t xx = 0; xx < ww; ++xx) {
+			  pDest[xx] = rgba[yy * 4 + xx] | (static_cast<uint32_t>(alpha[yy * 4 + xx]) << 24);
+			}
+		  }
+		}
+	  }
+	}
+
+
+	/** Convert the block rows of ETC1/ETC2 to RGBA8888.
+
+	  @param pImage         The compressed image.
+	  @param w              The width of the image.
+	  @param h              The height of the image.
+	  @param format         The compressed format.
+	  @param blockRowBegin  The first block row to decompress.
+	  @param blockRowEnd    The block row next to the last one.
+	  @param result         The image that has w * h pixels.
+	*/
+	void DecompressETC(const uint8_t* pImage, uint32_t w, uint32_t h, uint32_t format, uint32_t blockRowBegin, uint32_t blockRowEnd, uint32_t* result) {
+	  const bool isETC2 = format != GL_ETC1_RGB8_OES;
+	  const bool hasAlphaBlock = format == GL_COMPRESSED_RGBA8_ETC2_EAC;
+	  const bool punchthrough = format == GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+	  const uint32_t blockByteSize = hasAlphaBlock ? 16 : 8;
+	  const uint32_t xcount = (w + 3) / 4;
+	  for (uint32_t by = blockRowBegin; by < blockRowEnd; ++by) {
+		const uint8_t* p = pImage + by * xcount * blockByteSize;
+		for (uint32_t bx = 0; bx < xcount; ++bx, p += blockByteSize) {
+		  uint32_t rgba[16];
+		  DecodeETCBlock(hasAlphaBlock ? p + 8 : p, isETC2, punchthrough, rgba);
+		  if (hasAlphaBlock) {
+			DecodeEACAlphaBlock(p, rgba);
+		  }
+		  // The blocks at the right and bottom edges of the small mip levels are clipped.
+		  const uint32_t ww = std::min<uint32_t>(4, w - bx * 4);
+		  const uint32_t hh = std::min<uint32_t>(4, h - by * 4);
+		  for (uint32_t yy = 0; yy < hh; ++yy) {
+			for (uint32_t xx = 0; xx < ww; ++xx) {
+			  result[(by * 4 + yy) * w + (bx * 4 + xx)] = rgba[yy * 4 + xx];
+			}
+		  }
+		}
+	  }
+	}
+
+
+} // namespace Texture
@@ -0,0 +1,20 @@
+#ifndef TEXTUREDECODER_H_INCLUDED
+#define TEXTUREDECODER_H_INCLUDED
+#include <stdint.h>
+
+namespace Texture {
+
+  /** The decoders of the compressed formats that the GPU may not support.
+
+    They are pure CPU code, so they can be built and checked on the host.
+	The result is RGBA8888, that has R in the lowest byte.
+	@sa CanDecompress().
+  */
+  bool IsETCFormat(uint32_t format);
+  bool CanDecompress(uint32_t format);
+  void DecompressETC(const uint8_t* pImage, uint32_t w, uint32_t h, uint32_t format, uint32_t blockRowBegin, uint32_t blockRowEnd, uint32_t* result);
+  void DecompressATITC(const uint8_t* pImage, uint32_t w, uint32_t h, uint32_t format, uint32_t blockRowBegin, uint32_t blockRowEnd, uint32_t* result);
+
+} // namespace Texture
+
+#endif // TEXTUREDECODER_H_INCLUDED
@@ -0,0 +1,278 @@
+#include "TextureLZ4.h"
+#ifdef __ANDROID__
+#include <android/log.h>
+#endif // __ANDROID__
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <string.h>
+#include <stdio.h>
+
+#ifdef __ANDROID__
+#define LOGW(...) ((void)__android_log_print(ANDROID_LOG_WARN, "TextureLZ4.cpp", __VA_ARGS__))
+#else
+#define LOGW(...) ((void)printf("TextureLZ4.cpp" __VA_ARGS__), (void)printf("\n"))
+#endif // __ANDROID__
+
+namespace Texture {
+
+	/** Get the 32 bit value in the byte order of the KTX file.
+	*/
+	uint32_t GetValue(const uint32_t* pBuf, Endian e) {
+		const uint8_t* p = reinterpret_cast<const uint8_t*>(pBuf);
+		if (e == Endian_Little) {
+			return p[3] * 0x1000000 + p[2] * 0x10000 + p[1] * 0x100 + p[0];
+		}
+		return p[0] * 0x1000000 + p[1] * 0x10000 + p[2] * 0x100 + p[3];
+	}
+
+	/** Decompress the LZ4 block.
+
+	  @param src      The compressed block.
+	  @param srcSize  The byte size of src.
+	  @param dst      The decompressed bytes are stored.
+	  @param dstSize  The byte size of the decompressed block.
+
+	  @retval true   success.
+	  @retval false  the block is broken.
+	*/
+	bool DecompressLZ4Block(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) {
+		const uint8_t* const srcEnd = src + srcSize;
+		uint8_t* const dstBegin = dst;
+		uint8_t* const dstEnd = dst + dstSize;
+		for (;;) {
+			if (src >= srcEnd) {
+				return false;
+			}
+			const uint8_t token = *(src++);
+			size_t literalLength = token >> 4;
+			if (literalLength == 15) {
+				uint8_t n;
+				do {
+					if (src >= srcEnd) {
+						return false;
+					}
+					n = *(src++);
+					literalLength += n;
+				} while (n == 255);
+			}
+			if (literalLength > static_cast<size_t>(srcEnd - src) || literalLength > static_cast<size_t>(dstEnd - dst)) {
+				return false;
+			}
+			memcpy(dst, src, literalLength);
+			src += literalLength;
+			dst += literalLength;
+			if (src == srcEnd) {
+				// The last sequence has only the literals.
+				return dst == dstEnd;
+			}
+			if (srcEnd - src < 2) {
+				return false;
+			}
+			const size_t offset = src[0] | (src[1] << 8);
+			src += 2;
+			if (offset == 0 || offset > static_cast<size_t>(dst - dstBegin)) {
+				return false;
+			}
+			size_t matchLength = (token & 15) + 4;
+			if ((token & 15) == 15) {
+				uint8_t n;
+				do {
+					if (src >= srcEnd) {
+						return false;
+					}
+					n = *(src++);
+					matchLength += n;
+				} while (n == 255);
+			}
+			if (matchLength > static_cast<size_t>(dstEnd - dst)) {
+				return false;
+			}
+			const uint8_t* match = dst - offset;
+			if (offset >= matchLength) {
+				memcpy(dst, match, matchLength);
+			} else {
+				// The match overlaps the output, so it repeats the last offset bytes.
+				for (size_t i = 0; i < matchLength; ++i) {
+					dst[i] = match[i];
+				}
+			}
+			dst += matchLength;
+		}
+	}
+
+	/// The key of the KTX key/value data that marks the LZ4 chunked KTX file.
+	const char lz4ChunkKey[] = "Mai.LZ4Chunk";
+
+	/** The maximum ratio of the decompressed size to the compressed size of LZ4.
+
+	  A sequence of LZ4 makes at most 255 bytes from each byte of the match length.
+	  The decompressed size that exceeds it is broken, so it is rejected before the allocation.
+	*/
+	const uint64_t lz4MaxRatio = 255;
+
+	/** Find the LZ4 chunk parameters in the KTX key/value data.
+
+	  @param kv         The key/value data.
+	  @param endianness The endianness of the KTX file.
+	  @param chunkSize  The decompressed byte size of the chunk is stored.
+	  @param imageByteSize  The byte size of all images in the decompressed KTX file is stored.
+
+	  @retval true   the file is the LZ4 chunked KTX file.
+	  @retval false  the file is the plain KTX file.
+	*/
+	bool FindLZ4ChunkKey(const std::vector<uint8_t>& kv, Endian endianness, uint32_t& chunkSize, uint32_t& imageByteSize) {
+		size_t offset = 0;
+		while (offset + 4 <= kv.size()) {
+			uint32_t size;
+			memcpy(&size, &kv[offset], 4);
+			size = GetValue(&size, endianness);
+			offset += 4;
+			if (size > kv.size() - offset) {
+				break;
+			}
+			if (size == sizeof(lz4ChunkKey) + 8 && memcmp(&kv[offset], lz4ChunkKey, sizeof(lz4ChunkKey)) == 0) {
+				memcpy(&chunkSize, &kv[offset + sizeof(lz4ChunkKey)], 4);
+				memcpy(&imageByteSize, &kv[offset + sizeof(lz4ChunkKey) + 4], 4);
+				chunkSize = GetValue(&chunkSize, endianness);
+				imageByteSize = GetValue(&imageByteSize, endianness);
+				return chunkSize > 0;
+			}
+			offset += (size + 3) & ~3;
+		}
+		return false;
+	}
+
+	/** Read the images of the LZ4 chunked KTX file and decompress them into the plain KTX layout.
+
+	  The file has the key "Mai.LZ4Chunk" whose value is the decompressed chunk size and
+	  the total byte size of the decompressed images. Each level is stored as:
+	  - uint32_t imageSize: the decompressed byte size of one face, as the plain KTX.
+	  - for each face: uint32_t chunkCount, uint32_t compressedSize[chunkCount], the chunks
+	    and the padding to 4 bytes. The chunk whose compressed size equals its decompressed
+	    size is stored without compression.
+
+	  The chunks are decompressed on the other thread while the following chunks are read,
+	  directly into the buffer that will be uploaded.
+
+	  @param file           The file whose position is at the first level.
+	  @param endianness     The endianness of the KTX file.
+	  @param mipCount       The number of the levels.
+	  @param faceCount      The number of the faces.
+	  @param chunkSize      The decompressed byte size of the chunk.
+	  @param filename       The file name for the error message.
+	  @param data           The decompressed images are stored from offset.
+	  @param offset         The offset of the first level in data.
+
+	  @retval true   success.
+	  @retval false  the file is broken.
+	*/
+	bool ReadLZ4Chunks(Mai::File& file, Endian endianness, int mipCount, int faceCount, uint32_t chunkSize, const char* filename, std::vector<uint8_t>& data, size_t offset) {
+		struct Chunk {
+			std::vector<uint8_t> src;
+			size_t dstOffset;
+			size_t dstSize;
+		};
+		std::deque<Chunk> queue;
+		std::mutex queueMutex;
+		std::condition_variable queueCondition;
+		bool isReadFinished = false;
+		bool hasError = false;
+		std::thread decoder([&]() {
+			for (;;) {
+				Chunk chunk;
+				{
+					std::unique_lock<std::mutex> lock(queueMutex);
+					queueCondition.wait(lock, [&]() { return !queue.empty() || isReadFinished; });
+					if (queue.empty()) {
+						return;
+					}
+					chunk.src.swap(queue.front().src);
+					chunk.dstOffset = queue.front().dstOffset;
+					chunk.dstSize = queue.front().dstSize;
+					queue.pop_front();
+				}
+				uint8_t* const pDst = &data[chunk.dstOffset];
+				bool result = true;
+				if (chunk.src.size() == chunk.dstSize) {
+					memcpy(pDst, chunk.src.data(), chunk.dstSize);
+				} else {
+					result = DecompressLZ4Block(chunk.src.data(), chunk.src.size(), pDst, chunk.dstSize);
+				}
+				if (!result) {
+					std::lock_guard<std::mutex> lock(queueMutex);
+					hasError = true;
+				}
+			}
+		});
+
+		bool result = true;
+		for (int mipLevel = 0; result && mipLevel < mipCount; ++mipLevel) {
+			uint32_t imageSize;
+			if (file.Read(&imageSize, 4) < 0 || offset + 4 > data.size()) {
+				result = false;
+				break;
+			}
+			memcpy(&data[offset], &imageSize, 4);
+			offset += 4;
+			imageSize = GetValue(&imageSize, endianness);
+			const uint32_t imageSizeWithPadding = (imageSize + 3) & ~3;
+			for (int faceIndex = 0; faceIndex < faceCount; ++faceIndex) {
+				uint32_t chunkCount;
+				if (file.Read(&chunkCount, 4) < 0) {
+					result = false;
+					break;
+				}
+				chunkCount = GetValue(&chunkCount, endianness);
+				if (chunkCount != (imageSize + chunkSize - 1) / chunkSize || offset + imageSizeWithPadding > data.size()) {
+					result = false;
+					break;
+				}
+				std::vector<uint32_t> sizeList(chunkCount);
+				if (chunkCount && file.Read(&sizeList[0], chunkCount * 4) < 0) {
+					result = false;
+					break;
+				}
+				size_t compressedByteSize = 0;
+				for (uint32_t i = 0; i < chunkCount; ++i) {
+					const uint32_t srcSize = GetValue(&sizeList[i], endianness);
+					if (srcSize > file.Size() - file.Position()) {
+						result = false;
+						break;
+					}
+					Chunk chunk;
+					chunk.src.resize(srcSize);
+					chunk.dstOffset = offset + i * chunkSize;
+					chunk.dstSize = std::min(chunkSize, imageSize - i * chunkSize);
+					if (chunk.src.empty() || file.Read(&chunk.src[0], chunk.src.size()) < 0) {
+						result = false;
+						break;
+					}
+					compressedByteSize += chunk.src.size();
+					std::lock_guard<std::mutex> lock(queueMutex);
+					queue.push_back(std::move(chunk));
+					queueCondition.notify_one();
+				}
+				if (!result) {
+					break;
+				}
+				file.Seek(file.Position() + (((compressedByteSize + 3) & ~3) - compressedByteSize));
+				offset += imageSizeWithPadding;
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			isReadFinished = true;
+			queueCondition.notify_one();
+		}
+		decoder.join();
+		if (!result || hasError || offset != data.size()) {
+			LOGW("broken LZ4 chunk:'%s'", filename);
+			return false;
+		}
+		return true;
+	}
+
+} // namespace Texture
@@ -0,0 +1,30 @@
+#ifndef TEXTURELZ4_H_INCLUDED
+#define TEXTURELZ4_H_INCLUDED
+#include "../../Shared/File.h"
+#include <vector>
+#include <stdint.h>
+
+namespace Texture {
+
+  /// The byte order of the KTX file.
+  enum Endian {
+	Endian_Little,
+	Endian_Big,
+	Endian_Unknown,
+  };
+
+  uint32_t GetValue(const uint32_t* pBuf, Endian e);
+
+  /** The reader of the LZ4 chunked KTX file made by asset_works/texture/ktx_lz4.py.
+
+    It doesn't need the GL context, so it can be built and checked on the host.
+	@sa ReadKTXFile().
+  */
+  extern const uint64_t lz4MaxRatio;
+  bool DecompressLZ4Block(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+  bool FindLZ4ChunkKey(const std::vector<uint8_t>& kv, Endian endianness, uint32_t& chunkSize, uint32_t& imageByteSize);
+  bool ReadLZ4Chunks(Mai::File& file, Endian endianness, int mipCount, int faceCount, uint32_t chunkSize, const char* filename, std::vector<uint8_t>& data, size_t offset);
+
+} // namespace Texture
+
+#endif // TEXTURELZ4_H_INCLUDED
@@ -0,0 +1,364 @@
+#include "TextureTranscoder.h"
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <algorithm>
+#include <limits>
+#include <stdlib.h>
+
+namespace Texture {
+
+  namespace {
+
+	/// The RGBA8 color to encode.
+	struct Color {
+	  int r, g, b, a;
+	};
+
+	Color ToColor(uint32_t rgba) {
+	  return { static_cast<int>(rgba & 0xff), static_cast<int>((rgba >> 8) & 0xff), static_cast<int>((rgba >> 16) & 0xff), static_cast<int>(rgba >> 24) };
+	}
+
+	int ColorError(int r0, int g0, int b0, int r1, int g1, int b1) {
+	  return (r0 - r1) * (r0 - r1) + (g0 - g1) * (g0 - g1) + (b0 - b1) * (b0 - b1);
+	}
+
+	/** Fetch the 4x4 block.
+
+	  The pixels out of the image are clamped to the edge, so the level smaller than
+	  the block can be encoded.
+	*/
+	void FetchBlock(const uint32_t* pixels, int width, int height, int x, int y, Color* block) {
+	  for (int yy = 0; yy < 4; ++yy) {
+		const int sy = std::min(y + yy, height - 1);
+		for (int xx = 0; xx < 4; ++xx) {
+		  const int sx = std::min(x + xx, width - 1);
+		  block[yy * 4 + xx] = ToColor(pixels[sy * width + sx]);
+		}
+	  }
+	}
+
+	int Expand4(int c) { return (c << 4) | c; }
+	int Expand5(int c) { return (c << 3) | (c >> 2); }
+	int Expand6(int c) { return (c << 2) | (c >> 4); }
+	int Quantize(int c, int maxValue) { return (c * maxValue + 127) / 255; }
+
+	/// The modifier tables of ETC1. The negative values are [2] and [3].
+	const int etc1ModifierTable[8][2] = {
+	  { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 },
+	};
+
+	/// The result of the ETC1 sub block encoding.
+	struct ETC1SubBlock {
+	  int table;
+	  int error;
+	  int index[8]; ///< The modifier index of each pixel in the order of the sub block.
+	};
+
+	/** Find the best modifier table for the sub block with the base color.
+	*/
+	ETC1SubBlock EncodeETC1SubBlock(const Color* const* pixels, int r, int g, int b) {
+	  ETC1SubBlock best;
+	  best.error = std::numeric_limits<int>::max();
+	  for (int table = 0; table < 8; ++table) {
+		const int modifier[4] = {
+		  etc1ModifierTable[table][0], etc1ModifierTable[table][1], -etc1ModifierTable[table][0], -etc1ModifierTable[table][1]
+		};
+		ETC1SubBlock cur;
+		cur.table = table;
+		cur.error = 0;
+		for (int i = 0; i < 8; ++i) {
+		  const Color& c = *pixels[i];
+		  int minError = std::numeric_limits<int>::max();
+		  for (int m = 0; m < 4; ++m) {
+			const int rr = std::min(255, std::max(0, r + modifier[m]));
+			const int gg = std::min(255, std::max(0, g + modifier[m]));
+			const int bb = std::min(255, std::max(0, b + modifier[m]));
+			const int e = ColorError(c.r, c.g, c.b, rr, gg, bb);
+			if (e < minError) {
+			  minError = e;
+			  cur.index[i] = m;
+			}
+		  }
+		  cur.error += minError;
+		  if (cur.error >= best.error) {
+			break;
+		  }
+		}
+		if (cur.error < best.error) {
+		  best = cur;
+		}
+	  }
+	  return best;
+	}
+
+	/** Encode the 4x4 block to ETC1.
+
+	  Both orientations of the sub blocks, and both the individual and the differential mode
+	  are tried, and the one that has the least error is selected.
+	  The base color of each sub block is the average color.
+	*/
+	void EncodeETC1Block(const Color* block, uint8_t* out) {
+	  uint64_t bestBits = 0;
+	  int bestError = std::numeric_limits<int>::max();
+	  for (int flip = 0; flip < 2; ++flip) {
+		const Color* sub[2][8];
+		int sum[2][3] = {};
+		for (int y = 0; y < 4; ++y) {
+		  for (int x = 0; x < 4; ++x) {
+			const int s = flip ? y / 2 : x / 2;
+			// the index in the sub block that matches the order of the pixel indices.
+			const int i = flip ? x * 2 + (y & 1) : (x & 1) * 4 + y;
+			sub[s][i] = &block[y * 4 + x];
+			sum[s][0] += block[y * 4 + x].r;
+			sum[s][1] += block[y * 4 + x].g;
+			sum[s][2] += block[y * 4 + x].b;
+		  }
+		}
+		for (int diff = 0; diff < 2; ++diff) {
+		  int base[2][3];
+		  int code[2][3];
+		  bool isValid = true;
+		  for (int s = 0; s < 2; ++s) {
+			for (int c = 0; c < 3; ++c) {
+			  const int average = (sum[s][c] + 4) / 8;
+			  code[s][c] = diff ? Quantize(average, 31) : Quantize(average, 15);
+			}
+		  }
+		  if (diff) {
+			for (int c = 0; c < 3; ++c) {
+			  const int d = code[1][c] - code[0][c];
+			  if (d < -4 || d > 3) {
+				isValid = false;
+			  }
+			}
+		  }
+		  if (!isValid) {
+			continue;
+		  }
+		  for (int s = 0; s < 2; ++s) {
+			for (int c = 0; c < 3; ++c) {
+			  base[s][c] = diff ? Expand5(code[s][c]) : Expand4(code[s][c]);
+			}
+		  }
+		  const ETC1SubBlock result0 = EncodeETC1SubBlock(sub[0], base[0][0], base[0][1], base[0][2]);
+		  const ETC1SubBlock result1 = EncodeETC1SubBlock(sub[1], base[1][0], base[1][1], base[1][2]);
+		  const int error = result0.error + result1.error;
+		  if (error >= bestError) {
+			continue;
+		  }
+		  bestError = error;
+		  uint64_t bits = 0;
+		  if (diff) {
+			bits |= static_cast<uint64_t>(code[0][0]) << 59 | static_cast<uint64_t>((code[1][0] - code[0][0]) & 7) << 56;
+			bits |= static_cast<uint64_t>(code[0][1]) << 51 | static_cast<uint64_t>((code[1][1] - code[0][1]) & 7) << 48;
+			bits |= static_cast<uint64_t>(code[0][2]) << 43 | static_cast<uint64_t>((code[1][2] - code[0][2]) & 7) << 40;
+		  } else {
+			bits |= static_cast<uint64_t>(code[0][0]) << 60 | static_cast<uint64_t>(code[1][0]) << 56;
+			bits |= static_cast<uint64_t>(code[0][1]) << 52 | static_cast<uint64_t>(code[1][1]) << 48;
+			bits |= static_cast<uint64_t>(code[0][2]) << 44 | static_cast<uint64_t>(code[1][2]) << 40;
+		  }
+		  bits |= static_cast<uint64_t>(result0.table) << 37 | static_cast<uint64_t>(result1.table) << 34;
+		  bits |= static_cast<uint64_t>(diff) << 33 | static_cast<uint64_t>(flip) << 32;
+		  // the pixel index is stored in the column major order, MSB in the upper half.
+		  const ETC1SubBlock* results[2] = { &result0, &result1 };
+		  for (int y = 0; y < 4; ++y) {
+			for (int x = 0; x < 4; ++x) {
+			  const int s = flip ? y / 2 : x / 2;
+			  const int i = flip ? x * 2 + (y & 1) : (x & 1) * 4 + y;
+			  const int index = results[s]->index[i];
+			  const int bit = x * 4 + y;
+			  bits |= static_cast<uint64_t>(index >> 1) << (bit + 16);
+			  bits |= static_cast<uint64_t>(index & 1) << bit;
+			}
+		  }
+		  bestBits = bits;
+		}
+	  }
+	  for (int i = 0; i < 8; ++i) {
+		out[i] = static_cast<uint8_t>(bestBits >> (56 - i * 8));
+	  }
+	}
+
+	/** Encode the 4x4 block to ATITC with the interpolated alpha.
+
+	  The color end points are the inset bounding box of the block. The diagonal of the box
+	  is flipped for the channel that is inversely correlated with the green.
+	*/
+	void EncodeATITCBlock(const Color* block, uint8_t* out) {
+	  // the alpha block is same as DXT5.
+	  int alphaMin = 255, alphaMax = 0;
+	  for (int i = 0; i < 16; ++i) {
+		alphaMin = std::min(alphaMin, block[i].a);
+		alphaMax = std::max(alphaMax, block[i].a);
+	  }
+	  int alphaRamp[8] = { alphaMax, alphaMin };
+	  for (int i = 1; i < 7; ++i) {
+		alphaRamp[i + 1] = ((7 - i) * alphaMax + i * alphaMin + 3) / 7;
+	  }
+	  uint64_t alphaBits = 0;
+	  if (alphaMax != alphaMin) {
+		for (int i = 0; i < 16; ++i) {
+		  int bestIndex = 0;
+		  int bestError = 256;
+		  for (int k = 0; k < 8; ++k) {
+			const int e = std::abs(alphaRamp[k] - block[i].a);
+			if (e < bestError) {
+			  bestError = e;
+			  bestIndex = k;
+			}
+		  }
+		  alphaBits |= static_cast<uint64_t>(bestIndex) << (i * 3);
+		}
+	  }
+	  out[0] = static_cast<uint8_t>(alphaMax);
+	  out[1] = static_cast<uint8_t>(alphaMin);
+	  for (int i = 0; i < 6; ++i) {
+		out[2 + i] = static_cast<uint8_t>(alphaBits >> (i * 8));
+	  }
+
+	  Color low = { 255, 255, 255, 0 }, high = { 0, 0, 0, 0 };
+	  Color average = { 0, 0, 0, 0 };
+	  for (int i = 0; i < 16; ++i) {
+		low.r = std::min(low.r, block[i].r);
+		low.g = std::min(low.g, block[i].g);
+		low.b = std::min(low.b, block[i].b);
+		high.r = std::max(high.r, block[i].r);
+		high.g = std::max(high.g, block[i].g);
+		high.b = std::max(high.b, block[i].b);
+		average.r += block[i].r;
+		average.g += block[i].g;
+		average.b += block[i].b;
+	  }
+	  int covarianceRG = 0, covarianceBG = 0;
+	  for (int i = 0; i < 16; ++i) {
+		const int dg = block[i].g * 16 - average.g;
+		covarianceRG += (block[i].r * 16 - average.r) * dg / 16;
+		covarianceBG += (block[i].b * 16 - average.b) * dg / 16;
+	  }
+	  if (covarianceRG < 0) {
+		std::swap(low.r, high.r);
+	  }
+	  if (covarianceBG < 0) {
+		std::swap(low.b, high.b);
+	  }
+	  // inset the box by 1/16 to reduce the error of the end points.
+	  const Color inset = { (high.r - low.r) / 16, (high.g - low.g) / 16, (high.b - low.b) / 16, 0 };
+	  low.r += inset.r;
+	  low.g += inset.g;
+	  low.b += inset.b;
+	  high.r -= inset.r;
+	  high.g -= inset.g;
+	  high.b -= inset.b;
+
+	  // color0 is RGB555 without the black trick, color1 is RGB565.
+	  const int r0 = Quantize(low.r, 31), g0 = Quantize(low.g, 31), b0 = Quantize(low.b, 31);
+	  const int r1 = Quantize(high.r, 31), g1 = Quantize(high.g, 63), b1 = Quantize(high.b, 31);
+	  const uint16_t color0 = static_cast<uint16_t>((r0 << 10) | (g0 << 5) | b0);
+	  const uint16_t color1 = static_cast<uint16_t>((r1 << 11) | (g1 << 5) | b1);
+	  const Color c0 = { Expand5(r0), Expand5(g0), Expand5(b0), 0 };
+	  const Color c1 = { Expand5(r1), Expand6(g1), Expand5(b1), 0 };
+	  const Color palette[4] = {
+		c0,
+		{ (c1.r * 3 + c0.r * 5) >> 3, (c1.g * 3 + c0.g * 5) >> 3, (c1.b * 3 + c0.b * 5) >> 3, 0 },
+		{ (c1.r * 5 + c0.r * 3) >> 3, (c1.g * 5 + c0.g * 3) >> 3, (c1.b * 5 + c0.b * 3) >> 3, 0 },
+		c1,
+	  };
+	  out[8] = static_cast<uint8_t>(color0);
+	  out[9] = static_cast<uint8_t>(color0 >> 8);
+	  out[10] = static_cast<uint8_t>(color1);
+	  out[11] = static_cast<uint8_t>(color1 >> 8);
+	  for (int y = 0; y < 4; ++y) {
+		uint8_t bits = 0;
+		for (int x = 0; x < 4; ++x) {
+		  const Color& c = block[y * 4 + x];
+		  int bestIndex = 0;
+		  int bestError = std::numeric_limits<int>::max();
+		  for (int k = 0; k < 4; ++k) {
+			const int e = ColorError(c.r, c.g, c.b, palette[k].r, palette[k].g, palette[k].b);
+			if (e < bestError) {
+			  bestError = e;
+			  bestIndex = k;
+			}
+		  }
+		  bits |= static_cast<uint8_t>(bestIndex << (x * 2));
+		}
+		out[12 + y] = bits;
+	  }
+	}
+
+  } // unnamed namespace
+
+  /** Select the transcode target from the compressed formats of the device.
+
+    ATITC is preferred because it keeps the alpha channel.
+
+	@param formatList   The list of GL_COMPRESSED_TEXTURE_FORMATS.
+	@param formatCount  The number of the formats in formatList.
+
+	@return The transcode target.
+  */
+  TranscodeTarget SelectTranscodeTarget(const int32_t* formatList, int formatCount)
+  {
+	const int32_t* end = formatList + formatCount;
+	if (std::find(formatList, end, GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD) != end) {
+	  return TranscodeTarget::ATITC;
+	}
+	if (std::find(formatList, end, GL_ETC1_RGB8_OES) != end) {
+	  return TranscodeTarget::ETC1;
+	}
+	return TranscodeTarget::None;
+  }
+
+  /** Get the byte size of the transcoded image.
+  */
+  uint32_t GetTranscodedImageSize(TranscodeTarget target, int width, int height)
+  {
+	const uint32_t blockCount = ((width + 3) / 4) * ((height + 3) / 4);
+	switch (target) {
+	case TranscodeTarget::ETC1: return blockCount * 8;
+	case TranscodeTarget::ATITC: return blockCount * 16;
+	default: return 0;
+	}
+  }
+
+  /** Encode the RGBA8 image to ETC1.
+
+    The alpha channel is ignored.
+
+	@param pixels  The RGBA8 image.
+	@param width   The width of the image.
+	@param height  The height of the image.
+	@param out     The buffer to store the result. @sa GetTranscodedImageSize().
+  */
+  void EncodeETC1(const uint32_t* pixels, int width, int height, uint8_t* out)
+  {
+	for (int y = 0; y < height; y += 4) {
+	  for (int x = 0; x < width; x += 4) {
+		Color block[16];
+		FetchBlock(pixels, width, height, x, y, block);
+		EncodeETC1Block(block, out);
+		out += 8;
+	  }
+	}
+  }
+
+  /** Encode the RGBA8 image to ATITC with the interpolated alpha.
+
+	@param pixels  The RGBA8 image.
+	@param width   The width of the image.
+	@param height  The height of the image.
+	@param out     The buffer to store the result. @sa GetTranscodedImageSize().
+  */
+  void EncodeATITC(const uint32_t* pixels, int width, int height, uint8_t* out)
+  {
+	for (int y = 0; y < height; y += 4) {
+	  for (int x = 0; x < width; x += 4) {
+		Color block[16];
+		FetchBlock(pixels, width, height, x, y, block);
+		EncodeATITCBlock(block, out);
+		out += 16;
+	  }
+	}
+  }
+
+} // namespace Texture
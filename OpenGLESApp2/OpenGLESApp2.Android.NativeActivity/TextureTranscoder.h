@@ -0,0 +1,25 @@
+#ifndef TEXTURETRANSCODER_H_INCLUDED
+#define TEXTURETRANSCODER_H_INCLUDED
+#include <stdint.h>
+
+namespace Texture {
+
+  /** The compressed format that the uncompressed textures are transcoded to at load time.
+
+    It is selected from the compressed formats that the device reports.
+	@sa SelectTranscodeTarget().
+  */
+  enum class TranscodeTarget {
+	None, ///< The textures are uploaded as they are.
+	ETC1, ///< GL_ETC1_RGB8_OES. Only the opaque images are transcoded.
+	ATITC, ///< GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD.
+  };
+
+  TranscodeTarget SelectTranscodeTarget(const int32_t* formatList, int formatCount);
+  uint32_t GetTranscodedImageSize(TranscodeTarget, int width, int height);
+  void EncodeETC1(const uint32_t* pixels, int width, int height, uint8_t* out);
+  void EncodeATITC(const uint32_t* pixels, int width, int height, uint8_t* out);
+
+} // namespace Texture
+
+#endif // TEXTURETRANSCODER_H_INCLUDED
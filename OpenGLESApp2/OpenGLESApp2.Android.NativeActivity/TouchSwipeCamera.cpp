@@ -149,7 +149,7 @@ namespace Mai {
 	  break;
 	default:
 	case MoveDir_Newtral:
-	  // Ȃ.
+	  // 何もしない.
 	  break;
 	}
 
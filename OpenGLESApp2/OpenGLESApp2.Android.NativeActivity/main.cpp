@@ -1,17 +1,17 @@
 /*
 * Copyright (C) 2010 The Android Open Source Project
 *
-* Apache License Version 2.0 (u{CZXv) ɊÂăCZX܂B;
-* {CZXɏȂꍇ͂̃t@Cgpł܂B
-* {CZX̃Rs[́Aȉ̏ꏊł܂B
+* Apache License Version 2.0 (「本ライセンス」) に基づいてライセンスされます。;
+* 本ライセンスに準拠しない場合はこのファイルを使用できません。
+* 本ライセンスのコピーは、以下の場所から入手できます。
 *
 *      http://www.apache.org/licenses/LICENSE-2.0
 *
-* Kp@߂܂͏ʂł̓ӂɂĖȂA{CZXɊÂĔЕz\tgEFÁA
-* َ킸AȂۏ؂ȂɌ̂܂
-* Еz܂B
-* {CZXł̌ƐK肵ɂẮA
-* {CZXQƂĂB
+* 適用される法令または書面での同意によって命じられない限り、本ライセンスに基づいて頒布されるソフトウェアは、
+* 明示黙示を問わず、いかなる保証も条件もなしに現状のまま
+* 頒布されます。
+* 本ライセンスでの権利と制限を規定した文言については、
+* 本ライセンスを参照してください。
 *
 */
 
@@ -21,9 +21,9 @@
 #include "../../Shared/Scenes/Scene.h"
 
 /**
-* ́Aandroid_native_app_glue gpĂlCeBu AvP[V
-* ̃C Gg |CgłBꎩ̂̃XbhŃCxg [vɂĎsA
-* ̓Cxg󂯎葼̑s肵܂B
+* これは、android_native_app_glue を使用しているネイティブ アプリケーション
+* のメイン エントリ ポイントです。それ自体のスレッドでイベント ループによって実行され、
+* 入力イベントを受け取ったり他の操作を実行したりします。
 */
 void android_main(android_app* app) {
 
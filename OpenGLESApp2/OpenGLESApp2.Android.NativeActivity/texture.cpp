@@ -1,11 +1,22 @@
 #include "texture.h"
 #include "../../Shared/File.h"
+#include "../../Shared/Window.h"
+#include "Parallel.h"
+#include "AssetLoader.h"
+#include "TextureDecoder.h"
+#include "TextureLZ4.h"
 #ifdef __ANDROID__
 #include "android_native_app_glue.h"
 #include <android/log.h>
 #endif // __ANDROID__
 #include <vector>
+#include <string>
 #include <algorithm>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <string.h>
 
 #ifdef __ANDROID__
 #define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, "texture.cpp", __VA_ARGS__))
@@ -15,6 +26,17 @@
 #define LOGW(...) ((void)printf("texture.cpp" __VA_ARGS__), (void)printf("\n"))
 #endif // __ANDROID__
 
+// The ETC2 formats of OpenGL ES 3.0. They are decompressed on CPU in OpenGL ES 2.0.
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9276
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+
 namespace Texture {
 
   uint64_t totalByteSize = 0;
@@ -61,12 +83,6 @@ namespace Texture {
 		uint32_t bytesOfKeyValueData;
 	};
 
-	enum Endian {
-		Endian_Little,
-		Endian_Big,
-		Endian_Unknown,
-	};
-
 	Endian GetEndian(const KTXHeader& h) {
 		const uint8_t* p = reinterpret_cast<const uint8_t*>(&h.endianness);
 		if (p[0] == 0x01 && p[1] == 0x02 && p[2] == 0x03 && p[3] == 0x04) {
@@ -77,18 +93,11 @@ namespace Texture {
 		return Endian_Unknown;
 	}
 
-	uint32_t GetValue(const uint32_t* pBuf, Endian e) {
-		const uint8_t* p = reinterpret_cast<const uint8_t*>(pBuf);
-		if (e == Endian_Little) {
-			return p[3] * 0x1000000 + p[2] * 0x10000 + p[1] * 0x100 + p[0];
-		}
-		return p[0] * 0x1000000 + p[1] * 0x10000 + p[2] * 0x100 + p[3];
-	}
+	const uint8_t fileIdentifier[12] = {
+		0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+	};
 
 	bool IsKTXHeader(const KTXHeader& h) {
-		static const uint8_t fileIdentifier[12] = {
-			0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
-		};
 		for (int i = 0; i < sizeof(fileIdentifier); ++i) {
 			if (h.identifier[i] != fileIdentifier[i]) {
 				return false;
@@ -97,7 +106,67 @@ namespace Texture {
 		return true;
 	}
 
-	struct Texture : public ITexture {
+	/// The layout of the KTX file in the memory.
+	struct KTXLayout {
+		GLenum type;
+		GLenum format;
+		GLenum internalFormat;
+		int width;
+		int height;
+		int faceCount;
+		int mipCount;
+		std::vector<size_t> levelOffset; ///< The offset to the image of the first face in each level.
+		std::vector<uint32_t> levelSize; ///< The image size of one face in each level.
+		bool isFileLayout; ///< true if levelOffset is also the offset in the file, so each level can be read directly.
+	};
+
+	/** The state of the progressive mip streaming.
+
+	  The texture object holds only the levels from baseLevel to the smallest, and
+	  baseLevel is uploaded as the level 0. It emulates GL_TEXTURE_BASE_LEVEL that
+	  isn't available in OpenGL ES 2.0, so the missing levels are never sampled.
+	  The file isn't kept in the memory. The levels are read again when they are uploaded.
+	*/
+	struct StreamingState {
+		KTXLayout layout; ///< The layout of the file.
+		int initialLevel; ///< The level uploaded at first so that the texture is usable immediately.
+		int baseLevel; ///< The finest resident level.
+		int requestedLevel; ///< The finest level requested in the previous frame.
+		int nextRequestedLevel; ///< The finest level requested in the current frame.
+	};
+
+	/// The largest size of the level uploaded at first by the streaming.
+	const int streamingInitialSize = 32;
+
+	struct Texture;
+
+	/** The state of the texture residency.
+
+	  Only the textures loaded from the files are evictable, because they can be reloaded.
+	*/
+	struct Residency {
+	  Residency() : budgetByteSize(0), frame(0), missCount(0), lastMissCount(0), evictionCount(0), streamedByteSize(0), dropCount(0) {}
+	  std::vector<Texture*> evictableList;
+	  std::vector<Texture*> streamingList; ///< The textures that have StreamingState.
+	  uint64_t budgetByteSize; ///< 0 means unlimited.
+	  uint32_t frame; ///< The frame counter advanced by UpdateResidency().
+	  int missCount; ///< The number of the reloads in the current frame.
+	  int lastMissCount; ///< The number of the reloads in the previous frame.
+	  int evictionCount; ///< The number of the evictions in the last update.
+	  uint32_t streamedByteSize; ///< The byte size uploaded by the streaming in the last update.
+	  int dropCount; ///< The number of the textures whose top levels are dropped in the last update.
+	};
+	Residency residency;
+
+	/// The format that the uncompressed KTX files are transcoded to. @sa SetTranscodeTarget().
+	TranscodeTarget transcodeTarget = TranscodeTarget::None;
+
+	bool LoadLevels(Texture& tex, int baseLevel);
+
+	/// The loader to read the evicted and streamed levels on the worker threads. @sa SetAssetLoader().
+	Mai::AssetLoader* pAssetLoader = nullptr;
+
+	struct Texture : public ITexture, public std::enable_shared_from_this<Texture> {
 		GLuint texId;
 		GLenum internalFormat;
 		GLenum target;
@@ -106,10 +175,38 @@ namespace Texture {
 		uint32_t byteSize;
 		uint8_t mipCount;
 
-		Texture() : texId(0), mipCount(1) {}
+		// the parameters to reload the evicted texture.
+		std::string filename;
+		bool decompressing;
+		GLint minFilter;
+		GLint magFilter;
+		mutable uint32_t lastUsedFrame;
+		std::unique_ptr<StreamingState> streaming; ///< nullptr if the texture isn't streamed.
+		bool isLoading; ///< true while the levels are read by the asset loader.
+
+		Texture() : texId(0), mipCount(1), decompressing(false), minFilter(GL_LINEAR), magFilter(GL_LINEAR), lastUsedFrame(0), isLoading(false) {}
 		virtual ~Texture() {
+			Release();
+			if (!filename.empty()) {
+				auto itr = std::find(residency.evictableList.begin(), residency.evictableList.end(), this);
+				if (itr != residency.evictableList.end()) {
+					residency.evictableList.erase(itr);
+				}
+				itr = std::find(residency.streamingList.begin(), residency.streamingList.end(), this);
+				if (itr != residency.streamingList.end()) {
+					residency.streamingList.erase(itr);
+				}
+			}
+		}
+
+		/** Delete the texture object.
+
+		  The texture information is kept to reload it.
+		*/
+		void Release() {
 			if (texId) {
 				glDeleteTextures(1, &texId);
+				texId = 0;
 				if (totalByteSize < byteSize) {
 					LOGW("Total texture size mismatch: total/current(0x%llx/0x%x)", totalByteSize, byteSize);
 					totalByteSize = 0;
@@ -118,219 +215,122 @@ namespace Texture {
 				}
 			}
 		}
-		virtual GLuint TextureId() const { return texId; }
+
+		/** Get the texture object id.
+
+		  This is called when the texture is bound, so the last used frame is updated here.
+		  If the texture has been evicted, it is reloaded. The reload is asynchronous
+		  if the asset loader is set, and 0 is returned until it is uploaded.
+		*/
+		virtual GLuint TextureId() const {
+			if (!texId && !filename.empty() && !isLoading) {
+				Texture& self = const_cast<Texture&>(*this);
+				if (LoadLevels(self, streaming ? streaming->initialLevel : 0)) {
+					++residency.missCount;
+				}
+			}
+			lastUsedFrame = residency.frame;
+			return texId;
+		}
 		virtual GLenum InternalFormat() const { return internalFormat; }
 		virtual GLenum Target() const { return target; }
 		virtual GLsizei Width() const { return width; }
 		virtual GLsizei Height() const { return height; }
-		virtual GLint MipCount() const { return mipCount; }
+		virtual GLint MipCount() const { return streaming ? mipCount - streaming->baseLevel : mipCount; }
 	};
 
-	bool Color1555To888(uint16_t color1555, uint32_t* pColor888) {
-	  const uint32_t r = ((color1555 & 0x00007C00) >> 7) | ((color1555 & 0x00007000) >> 12);
-	  const uint32_t g = ((color1555 & 0x000003E0) >> 2) | ((color1555 & 0x00000380) >> 7);
-	  const uint32_t b = ((color1555 & 0x0000001F) << 3) | ((color1555 & 0x0000001C) >> 2);
-	  *pColor888 = (b << 16) | (g << 8) | r;
-
-	  return (color1555 & 0x8000) != 0;
-	}
-
-	void Color565To888(uint16_t color565, uint32_t* pColor888) {
-	  const uint32_t r = ((color565 & 0x0000F800) >> 8) | ((color565 & 0x0000E000) >> 13);
-	  const uint32_t g = ((color565 & 0x000007E0) >> 3) | ((color565 & 0x00000600) >> 9);
-	  const uint32_t b = ((color565 & 0x0000001F) << 3) | ((color565 & 0x0000001C) >> 2);
-	  *pColor888 = (b << 16) | (g << 8) | r;
-	}
-
-	template<uint32_t RightShift, uint32_t Mask = 0xff, typename R = uint32_t>
-	R Elem(uint32_t rgba) { return static_cast<R>((rgba >> RightShift) & Mask); }
-
-	void GetColors(uint16_t color0, uint16_t color1, uint32_t* col) {
-	  static int      iColorLow = 0;
-	  static int      iColorMedLow = 1;
-	  static int      iColorMedHigh = 2;
-	  static int      iColorHigh = 3;
-
-	  const bool hasBlackTrick = Color1555To888(color0, &col[iColorLow]);
-	  Color565To888(color1, &col[iColorHigh]);
-
-	  if (hasBlackTrick) {
-		col[iColorMedHigh] = col[iColorLow];
-
-		col[iColorMedLow] = static_cast<uint32_t>(std::max(Elem<16, 0xff, int32_t>(col[iColorMedHigh]) - Elem<18, 0x3f, int32_t>(col[iColorHigh]), 0)) << 16;
-		col[iColorMedLow] |= static_cast<uint32_t>(std::max(Elem<8, 0xff, int32_t>(col[iColorMedHigh]) - Elem<10, 0x3f, int32_t>(col[iColorHigh]), 0)) < 8;
-		col[iColorMedLow] |= static_cast<uint32_t>(std::max(Elem<0, 0xff, int32_t>(col[iColorMedHigh]) - Elem<2, 0x3f, int32_t>(col[iColorHigh]), 0));
-
-		col[iColorLow] = 0;
-	  } else {
-		col[iColorMedHigh] = (Elem<16>(col[iColorHigh]) * 5 + Elem<16>(col[iColorLow]) * 3) >> 3 << 16;
-		col[iColorMedHigh] |= (Elem<8>(col[iColorHigh]) * 5 + Elem<8>(col[iColorLow]) * 3) >> 3 << 8;
-		col[iColorMedHigh] |= (Elem<0>(col[iColorHigh]) * 5 + Elem<0>(col[iColorLow]) * 3) >> 3;
-
-		col[iColorMedLow] = (Elem<16>(col[iColorHigh]) * 3 + Elem<16>(col[iColorLow]) * 5) >> 3 << 16;
-		col[iColorMedLow] |= (Elem<8>(col[iColorHigh]) * 3 + Elem<8>(col[iColorLow]) * 5) >> 3 << 8;
-		col[iColorMedLow] |= (Elem<0>(col[iColorHigh]) * 3 + Elem<0>(col[iColorLow]) * 5) >> 3;
-	  }
-	}
-
-	struct ColorBlock {
-	  uint16_t color0;
-	  uint16_t color1;
-	  uint8_t pixels[4];
-
-	  void Get(uint32_t* rgba) const {
-		uint32_t col[4];
-		GetColors(color0, color1, col);
-		for (int y = 0; y < 4; ++y) {
-		  for (int x = 0; x < 4; ++x) {
-			const uint32_t bits = (pixels[y] & (0x03 << (x * 2))) >> (x * 2);
-			*(rgba++) = col[bits];
-		  }
-		}
-	  }
+	/// The compressed image to decompress.
+	struct CompressedImage {
+	  const uint8_t* pImage;
+	  uint32_t width;
+	  uint32_t height;
+	  GLenum format;
 	};
 
-	struct ExplicitAlphaBlock {
-	  uint8_t pixels[8];
+	/** Convert the compressed images to RGBA8888 on the multiple threads.
 
-	  void Get(uint32_t* rgba) const {
-		for (int y = 0; y < 4; ++y) {
-		  for (int x = 0; x < 4; ++x) {
-			const uint32_t a = pixels[y * 2 + ((x / 2) & 1)] & (0x0f << ((x & 1) * 4));
-			*(rgba++) = a | (a << 4);
-		  }
-		}
-	  }
-	};
+	  The images are split into the jobs of the same number of the block rows,
+	  so that the largest level doesn't occupy one thread.
 
-	struct InterporatedAlphaBlock {
-	  uint8_t alpha0;
-	  uint8_t alpha1;
-	  uint8_t pixels[6];
-
-	  void GetCompressedAlphaRamp(uint8_t* result) const {
-		result[0] = alpha0;
-		result[1] = alpha1;
-
-		if (alpha0 > alpha1) {
-		  // 8-alpha block:  derive the other six alphas.
-		  // Bit code 000 = alpha_0, 001 = alpha_1, others are interpolated.
-		  result[2] = static_cast<uint8_t>((6 * alpha0 + 1 * alpha1 + 3) / 7);    // bit code 010
-		  result[3] = static_cast<uint8_t>((5 * alpha0 + 2 * alpha1 + 3) / 7);    // bit code 011
-		  result[4] = static_cast<uint8_t>((4 * alpha0 + 3 * alpha1 + 3) / 7);    // bit code 100
-		  result[5] = static_cast<uint8_t>((3 * alpha0 + 4 * alpha1 + 3) / 7);    // bit code 101
-		  result[6] = static_cast<uint8_t>((2 * alpha0 + 5 * alpha1 + 3) / 7);    // bit code 110
-		  result[7] = static_cast<uint8_t>((1 * alpha0 + 6 * alpha1 + 3) / 7);    // bit code 111
-		} else {
-		  // 6-alpha block.
-		  // Bit code 000 = alpha_0, 001 = alpha_1, others are interpolated.
-		  result[2] = static_cast<uint8_t>((4 * alpha0 + 1 * alpha1 + 2) / 5);  // Bit code 010
-		  result[3] = static_cast<uint8_t>((3 * alpha0 + 2 * alpha1 + 2) / 5);  // Bit code 011
-		  result[4] = static_cast<uint8_t>((2 * alpha0 + 3 * alpha1 + 2) / 5);  // Bit code 100
-		  result[5] = static_cast<uint8_t>((1 * alpha0 + 4 * alpha1 + 2) / 5);  // Bit code 101
-		  result[6] = 0;                                      // Bit code 110
-		  result[7] = 255;                                    // Bit code 111
+	  @param imageList   The compressed images. Their formats must pass CanDecompress().
+	  @param resultList  The decompressed images are stored in the same order as imageList.
+	*/
+	void DecompressImageList(const std::vector<CompressedImage>& imageList, std::vector<std::vector<uint32_t>>& resultList) {
+	  static const uint32_t blockRowsPerJob = 16;
+	  struct Job {
+		size_t imageIndex;
+		uint32_t blockRowBegin;
+		uint32_t blockRowEnd;
+	  };
+	  std::vector<Job> jobList;
+	  resultList.resize(imageList.size());
+	  for (size_t i = 0; i < imageList.size(); ++i) {
+		const CompressedImage& e = imageList[i];
+		const uint32_t blockRowCount = (e.height + 3) / 4;
+		resultList[i].resize(e.width * e.height);
+		for (uint32_t row = 0; row < blockRowCount; row += blockRowsPerJob) {
+		  jobList.push_back({ i, row, std::min(row + blockRowsPerJob, blockRowCount) });
 		}
 	  }
-
-	  void Get(uint32_t* rgba) const {
-		uint8_t ramp[8];
-		GetCompressedAlphaRamp(ramp);
-		for (int y = 0; y < 4; ++y) {
-		  for (int x = 0; x < 4; ++x) {
-			uint32_t index;
-			const uint32_t i = (y * 4 + x);
-			const uint32_t i0 = (i * 3) / 8;
-			const uint32_t i1 = (i * 3 + 2) / 8;
-			if (i0 == i1) {
-			  index = (pixels[i0] >> ((i * 3) % 8)) & 0x7;
-			} else {
-			  index = ((pixels[i0] | (pixels[i1] << 8)) >> ((i * 3) % 8)) & 0x7;
-			}
-			*(rgba++) = ramp[index];
+	  Mai::ParallelFor(jobList.size(), [&imageList, &resultList, &jobList](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+		  const Job& job = jobList[i];
+		  const CompressedImage& e = imageList[job.imageIndex];
+		  if (IsETCFormat(e.format)) {
+			DecompressETC(e.pImage, e.width, e.height, e.format, job.blockRowBegin, job.blockRowEnd, resultList[job.imageIndex].data());
+		  } else {
+			DecompressATITC(e.pImage, e.width, e.height, e.format, job.blockRowBegin, job.blockRowEnd, resultList[job.imageIndex].data());
 		  }
 		}
-	  }
-	};
+	  });
+	}
 
-	struct ExplicitBlock {
-	  ExplicitAlphaBlock alpha;
-	  ColorBlock color;
+	/// The compressed formats that the GPU supports. @sa SetSupportedCompressedFormats().
+	std::vector<GLenum> supportedCompressedFormatList;
+	/// false until SetSupportedCompressedFormats() is called. Then all formats are assumed to be supported.
+	bool hasSupportedCompressedFormatList = false;
 
-	  void Get(uint32_t* rgba) const {
-		uint32_t rgb[16];
-		color.Get(rgb);
-		uint32_t a[16];
-		alpha.Get(a);
-		for (int i = 0; i < 16; ++i) {
-		  rgba[i] = rgb[i] | (a[i] << 24);
-		}
-	  }
-	};
+	/** Check whether the KTX image should be decompressed on CPU.
 
-	struct InterporatedBlock {
-	  InterporatedAlphaBlock alpha;
-	  ColorBlock color;
+	  @param layout         The layout of the KTX file.
+	  @param decompressing  true if the decompression is requested explicitly.
 
-	  void Get(uint32_t* rgba) const {
-		uint32_t rgb[16];
-		color.Get(rgb);
-		uint32_t a[16];
-		alpha.Get(a);
-		for (int i = 0; i < 16; ++i) {
-		  rgba[i] = rgb[i] | (a[i] << 24);
-		}
+	  @retval true   the image is compressed and decodable, and decompressing is true or the GPU doesn't support it.
+	  @retval false  the image should be uploaded as it is.
+	*/
+	bool IsDecompressionNeeded(const KTXLayout& layout, bool decompressing) {
+	  if (layout.type != 0 || !CanDecompress(layout.internalFormat)) {
+		return false;
 	  }
-	};
-
-	/**
-	* Convert ATITC to RGBBA8888.
-	*
-	* @sa https://github.com/GPUOpen-Tools/Compressonator
-	*/
-	std::vector<uint32_t> DecompressATITC(const uint8_t* pImage, uint32_t w, uint32_t h, GLenum format) {
-	  std::vector<uint32_t> result;
-	  result.resize(w * h);
-	  const uint32_t xcount = w / 4;
-	  switch (format) {
-	  case GL_ATC_RGBA_EXPLICIT_ALPHA_AMD: {
-		const ExplicitBlock* p = reinterpret_cast<const ExplicitBlock*>(pImage);
-		for (uint32_t y = 0; y < h; y += 4) {
-		  for (uint32_t x = 0; x < w; x += 4) {
-			const ExplicitBlock& cur = p[(y / 4) * xcount + x / 4];
-			uint32_t rgba[16];
-			cur.Get(rgba);
-			for (uint32_t yy = 0; yy < 4; ++yy) {
-			  for (uint32_t xx = 0; xx < 4; ++xx) {
-				result[(y + yy) * w + (x + xx)] = rgba[yy * 4 + xx];
-			  }
-			}
-		  }
-		}
-		break;
+	  if (decompressing) {
+		return true;
 	  }
-	  case GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD: {
-		const InterporatedBlock* p = reinterpret_cast<const InterporatedBlock*>(pImage);
-		for (uint32_t y = 0; y < h; y += 4) {
-		  for (uint32_t x = 0; x < w; x += 4) {
-			const InterporatedBlock& cur = p[(y / 4) * xcount + x / 4];
-			uint32_t rgba[16];
-			cur.Get(rgba);
-			for (uint32_t yy = 0; yy < 4; ++yy) {
-			  for (uint32_t xx = 0; xx < 4; ++xx) {
-				result[(y + yy) * w + (x + xx)] = rgba[yy * 4 + xx];
-			  }
-			}
-		  }
+	  return hasSupportedCompressedFormatList &&
+		std::find(supportedCompressedFormatList.begin(), supportedCompressedFormatList.end(), layout.internalFormat) == supportedCompressedFormatList.end();
+	}
+
+	/** Convert the levels of the compressed KTX image to RGBA8888.
+
+	  @param data        The whole KTX file.
+	  @param layout      The layout of data.
+	  @param baseLevel   The first level to decompress.
+	  @param resultList  The decompressed images for each level and face from baseLevel are stored.
+	*/
+	void DecompressLevels(const std::vector<uint8_t>& data, const KTXLayout& layout, int baseLevel, std::vector<std::vector<uint32_t>>& resultList) {
+	  std::vector<CompressedImage> imageList;
+	  imageList.reserve((layout.mipCount - baseLevel) * layout.faceCount);
+	  for (int mipLevel = baseLevel; mipLevel < layout.mipCount; ++mipLevel) {
+		const uint8_t* pImage = &data[layout.levelOffset[mipLevel]];
+		for (int faceIndex = 0; faceIndex < layout.faceCount; ++faceIndex) {
+		  imageList.push_back({ pImage, static_cast<uint32_t>(std::max(1, layout.width >> mipLevel)), static_cast<uint32_t>(std::max(1, layout.height >> mipLevel)), layout.internalFormat });
+		  pImage += (layout.levelSize[mipLevel] + 3) & ~3;
 		}
-		break;
-	  }
 	  }
-	  return result;
+	  DecompressImageList(imageList, resultList);
 	}
 
 
-	/** ̃eNX`쐬.
+	/** 空のテクスチャを作成する.
 	*/
 	TexturePtr CreateEmpty2D(int w, int h, GLint minFilter, GLint magFilter) {
 		TexturePtr p = std::make_shared<Texture>();
@@ -359,7 +359,48 @@ namespace Texture {
 		return p;
 	}
 
-	/** _~[2DeNX`쐬.
+	/** Create the 2D texture from the uncompressed image.
+
+	  @param w          The width of the image.
+	  @param h          The height of the image.
+	  @param format     The pixel format. GL_RGBA, GL_LUMINANCE_ALPHA or GL_LUMINANCE.
+	  @param pixels     The pointer to the image that has 8bit components.
+	  @param minFilter  The minification filter.
+	  @param magFilter  The magnification filter.
+
+	  @return The texture object.
+	*/
+	TexturePtr Create2D(int w, int h, GLenum format, const void* pixels, GLint minFilter, GLint magFilter) {
+		TexturePtr p = std::make_shared<Texture>();
+		Texture& tex = static_cast<Texture&>(*p);
+		tex.internalFormat = format;
+		tex.width = w;
+		tex.height = h;
+		tex.target = GL_TEXTURE_2D;
+
+		const int bytesPerPixel = format == GL_RGBA ? 4 : (format == GL_LUMINANCE_ALPHA ? 2 : 1);
+		glGenTextures(1, &tex.texId);
+		glBindTexture(tex.Target(), tex.texId);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, pixels);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		const GLenum result = glGetError();
+		if (result != GL_NO_ERROR) {
+		  LOGW("glTexImage2D error 0x%04x", result);
+		}
+		glTexParameteri(tex.Target(), GL_TEXTURE_MIN_FILTER, CorrectFilter(1, minFilter));
+		glTexParameteri(tex.Target(), GL_TEXTURE_MAG_FILTER, CorrectFilter(1, magFilter));
+		glTexParameteri(tex.Target(), GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(tex.Target(), GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		tex.byteSize = w * h * bytesPerPixel;
+		totalByteSize += tex.byteSize;
+
+		glBindTexture(tex.Target(), 0);
+		LOGI("Load %s %dx%d (ID:%x)(TOTAL:%lld).", "2D", w, h, tex.texId, totalByteSize);
+		return p;
+	}
+
+	/** ダミー2Dテクスチャを作成する.
 	*/
 	TexturePtr CreateDummy2D() {
 		TexturePtr p = std::make_shared<Texture>();
@@ -389,7 +430,7 @@ namespace Texture {
 		return p;
 	}
 
-	/** _~[@eNX`쐬.
+	/** ダミー法線テクスチャを作成する.
 	*/
 	TexturePtr CreateDummyNormal() {
 	  TexturePtr p = std::make_shared<Texture>();
@@ -418,7 +459,7 @@ namespace Texture {
 	  return p;
 	}
 
-	/** _~[L[u}bv쐬.
+	/** ダミーキューブマップを作成する.
 	*/
 	TexturePtr CreateDummyCubeMap() {
 		TexturePtr p = std::make_shared<Texture>();
@@ -465,75 +506,474 @@ namespace Texture {
 		return p;
 	}
 
-	/** KTXt@Cǂݍ.
+	/** Create the cube map from RGBA8 pixels.
+
+	  If the transcode target is ATITC, the faces are encoded to GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD
+	  on the worker threads, so the cube map has 1/4 of the RGBA8 size. The alpha is kept,
+	  thus the other targets that have no alpha use RGBA8.
+
+	  @param size       The width and height of each face.
+	  @param pixels     The pixels of 6 faces stored sequentially in the order of
+	                    GL_TEXTURE_CUBE_MAP_POSITIVE_X to NEGATIVE_Z.
+	  @param minFilter  The minifying filter.
+	  @param magFilter  The magnification filter.
 	*/
-	TexturePtr LoadKTX(const char* filename, bool decompressing, GLint minFilter, GLint magFilter) {
-		auto file = Mai::FileSystem::Open(filename);
-		if (!file) {
-			LOGW("cannot open:'%s'", filename);
-			return nullptr;
+	TexturePtr CreateCubeMap(int size, const uint32_t* pixels, GLint minFilter, GLint magFilter) {
+		TexturePtr p = std::make_shared<Texture>();
+		Texture& tex = static_cast<Texture&>(*p);
+		const bool isCompressed = transcodeTarget == TranscodeTarget::ATITC && size % 4 == 0;
+		tex.internalFormat = isCompressed ? GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD : GL_RGBA;
+		tex.width = size;
+		tex.height = size;
+		tex.target = GL_TEXTURE_CUBE_MAP;
+		const uint32_t faceByteSize = isCompressed ? GetTranscodedImageSize(transcodeTarget, size, size) : size * size * 4;
+		std::vector<uint8_t> encoded;
+		if (isCompressed) {
+			encoded.resize(faceByteSize * 6);
+			Mai::ParallelFor(6, [size, pixels, faceByteSize, &encoded](size_t begin, size_t end) {
+				for (size_t faceIndex = begin; faceIndex < end; ++faceIndex) {
+					EncodeATITC(pixels + size * size * faceIndex, size, size, &encoded[faceByteSize * faceIndex]);
+				}
+			});
 		}
+		glGenTextures(1, &tex.texId);
+		glBindTexture(tex.Target(), tex.texId);
+		for (int faceIndex = 0; faceIndex < 6; ++faceIndex) {
+			if (isCompressed) {
+				glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + faceIndex, 0, tex.internalFormat, size, size, 0, faceByteSize, &encoded[faceByteSize * faceIndex]);
+			} else {
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + faceIndex, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels + size * size * faceIndex);
+			}
+			const GLenum result = glGetError();
+			if (result != GL_NO_ERROR) {
+			  LOGW("glTexImage2D(face:%d) error 0x%04x", faceIndex, result);
+			}
+		}
+		glTexParameteri(tex.Target(), GL_TEXTURE_MIN_FILTER, CorrectFilter(1, minFilter));
+		glTexParameteri(tex.Target(), GL_TEXTURE_MAG_FILTER, CorrectFilter(1, magFilter));
+		glTexParameteri(tex.Target(), GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(tex.Target(), GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		tex.byteSize = faceByteSize * 6;
+		totalByteSize += tex.byteSize;
+
+		glBindTexture(tex.Target(), 0);
+		LOGI("Load %s %dx%d(0x%04x) (ID:%x)(TOTAL:%lld).", "CubeMap", size, size, tex.internalFormat, tex.texId, totalByteSize);
+		return p;
+	}
+
+	/** Get the layout of the KTX file image.
+
+	  @param data      The whole KTX file.
+	  @param filename  The file name for the error message.
+	  @param layout    The layout is stored.
 
-		const size_t size = file->Size();
-		if (size <= sizeof(KTXHeader)) {
+	  @retval true   success.
+	  @retval false  the data isn't a KTX file, or it is truncated.
+	*/
+	bool ParseKTX(const std::vector<uint8_t>& data, const char* filename, KTXLayout& layout) {
+		if (data.size() <= sizeof(KTXHeader)) {
 			LOGW("illegal size:'%s'", filename);
-			return nullptr;
+			return false;
 		}
 		KTXHeader header;
-		int result = file->Read(&header, sizeof(KTXHeader));
-		if (result < 0 || !IsKTXHeader(header)) {
+		memcpy(&header, &data[0], sizeof(KTXHeader));
+		if (!IsKTXHeader(header)) {
 			LOGW("illegal header:'%s'", filename);
-			return nullptr;
+			return false;
 		}
-		TexturePtr p = std::make_shared<Texture>();
-		Texture& tex = static_cast<Texture&>(*p);
 		const Endian endianness = GetEndian(header);
-		const GLenum type = GetValue(&header.glType, endianness);
-		const GLenum format = GetValue(type ? &header.glFormat : &header.glBaseInternalFormat, endianness);
-		const int faceCount = GetValue(&header.numberOfFaces, endianness);
-		const int mipCount = GetValue(&header.numberOfMipmapLevels, endianness);
-		tex.internalFormat = GetValue(type ? &header.glBaseInternalFormat : &header.glInternalFormat, endianness);
-		tex.width = GetValue(&header.pixelWidth, endianness);
-		tex.height = GetValue(&header.pixelHeight, endianness);
-		tex.target = faceCount == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
-		tex.byteSize = 0;
-		tex.mipCount = static_cast<uint8_t>(mipCount ? mipCount : 1);
-
-		const uint32_t off = GetValue(&header.bytesOfKeyValueData, endianness);
-		file->Seek(file->Position() + off);
-
-		glGenTextures(1, &tex.texId);
-		glBindTexture(tex.Target(), tex.texId);
-		std::vector<uint8_t> data;
-		GLsizei curWidth = tex.Width();
-		GLsizei curHeight = tex.Height();
-		for (int mipLevel = 0; mipLevel < tex.mipCount; ++mipLevel) {
-			uint32_t imageSize;
-			result = file->Read(&imageSize, 4);
-			if (result < 0) {
+		layout.type = GetValue(&header.glType, endianness);
+		layout.format = GetValue(layout.type ? &header.glFormat : &header.glBaseInternalFormat, endianness);
+		layout.internalFormat = GetValue(layout.type ? &header.glBaseInternalFormat : &header.glInternalFormat, endianness);
+		layout.width = GetValue(&header.pixelWidth, endianness);
+		layout.height = GetValue(&header.pixelHeight, endianness);
+		layout.faceCount = GetValue(&header.numberOfFaces, endianness);
+		const uint32_t mipCount = GetValue(&header.numberOfMipmapLevels, endianness);
+		if (mipCount > 32) {
+			LOGW("illegal mipmap count %u:'%s'", mipCount, filename);
+			return false;
+		}
+		layout.mipCount = std::max<int>(1, mipCount);
+		layout.levelOffset.resize(layout.mipCount);
+		layout.levelSize.resize(layout.mipCount);
+		layout.isFileLayout = false;
+		size_t offset = sizeof(KTXHeader) + GetValue(&header.bytesOfKeyValueData, endianness);
+		for (int mipLevel = 0; mipLevel < layout.mipCount; ++mipLevel) {
+			if (offset + 4 > data.size()) {
 				LOGW("can't read(miplevel=%d):'%s'", mipLevel, filename);
-				return nullptr;
+				return false;
 			}
+			uint32_t imageSize;
+			memcpy(&imageSize, &data[offset], 4);
 			imageSize = GetValue(&imageSize, endianness);
-			const uint32_t imageSizeWithPadding = (imageSize + 3) & ~3;
-			data.resize(imageSizeWithPadding * faceCount);
-			result = file->Read(&data[0], data.size());
-			if (result < 0) {
+			layout.levelOffset[mipLevel] = offset + 4;
+			layout.levelSize[mipLevel] = imageSize;
+			offset += 4 + ((imageSize + 3) & ~3) * layout.faceCount;
+			if (offset > data.size()) {
 				LOGW("can't read(miplevel=%d):'%s'", mipLevel, filename);
-				return nullptr;
-			}
-			const uint8_t* pImage = reinterpret_cast<const uint8_t*>(&data[0]);
-			const GLenum target = tex.Target() == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : GL_TEXTURE_2D;
-			for (int faceIndex = 0; faceIndex < faceCount; ++faceIndex) {
-				if (type == 0) {
-				  if (decompressing) {
-					std::vector<uint32_t> decompressedImage = DecompressATITC(pImage, curWidth, curHeight, tex.InternalFormat());
-					glTexImage2D(target + faceIndex, mipLevel, GL_RGBA, curWidth, curHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, decompressedImage.data());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** Read the KTX file into the memory.
+
+	  The LZ4 chunked KTX file is decompressed to the plain KTX file without the key/value data.
+
+	  @param filename  The file name.
+	  @param data      The whole plain KTX file is stored.
+	  @param layout    The layout of data is stored.
+
+	  @retval true   success.
+	  @retval false  the file can't be read, or it isn't a KTX file.
+	*/
+	bool ReadKTXFile(const char* filename, std::vector<uint8_t>& data, KTXLayout& layout) {
+		auto file = Mai::FileSystem::Open(filename);
+		if (!file) {
+			LOGW("cannot open:'%s'", filename);
+			return false;
+		}
+		KTXHeader header;
+		if (file->Size() <= sizeof(KTXHeader) || file->Read(&header, sizeof(KTXHeader)) < 0 || !IsKTXHeader(header)) {
+			LOGW("illegal header:'%s'", filename);
+			return false;
+		}
+		const Endian endianness = GetEndian(header);
+		std::vector<uint8_t> kv(GetValue(&header.bytesOfKeyValueData, endianness));
+		if (kv.size() > file->Size() - sizeof(KTXHeader) || (!kv.empty() && file->Read(&kv[0], kv.size()) < 0)) {
+			LOGW("can't read:'%s'", filename);
+			return false;
+		}
+		uint32_t chunkSize;
+		uint32_t imageByteSize;
+		const bool isChunked = FindLZ4ChunkKey(kv, endianness, chunkSize, imageByteSize);
+		if (isChunked) {
+			const uint64_t compressedByteSize = file->Size() - sizeof(KTXHeader) - kv.size();
+			if (imageByteSize > compressedByteSize * lz4MaxRatio) {
+				LOGW("illegal image size %u:'%s'", imageByteSize, filename);
+				return false;
+			}
+			header.bytesOfKeyValueData = 0;
+			data.resize(sizeof(KTXHeader) + imageByteSize);
+			memcpy(&data[0], &header, sizeof(KTXHeader));
+			const int mipCount = std::max<int>(1, GetValue(&header.numberOfMipmapLevels, endianness));
+			const int faceCount = GetValue(&header.numberOfFaces, endianness);
+			if (!ReadLZ4Chunks(*file, endianness, mipCount, faceCount, chunkSize, filename, data, sizeof(KTXHeader))) {
+				return false;
+			}
+		} else {
+			data.resize(file->Size());
+			memcpy(&data[0], &header, sizeof(KTXHeader));
+			if (!kv.empty()) {
+				memcpy(&data[sizeof(KTXHeader)], &kv[0], kv.size());
+			}
+			const size_t offset = sizeof(KTXHeader) + kv.size();
+			if (offset < data.size() && file->Read(&data[offset], data.size() - offset) < 0) {
+				LOGW("can't read:'%s'", filename);
+				return false;
+			}
+		}
+		if (!ParseKTX(data, filename, layout)) {
+			return false;
+		}
+		layout.isFileLayout = !isChunked;
+		return true;
+	}
+
+	/// The window that stores the transcoded files. nullptr means no cache.
+	const Mai::Window* pTranscodeCacheWindow = nullptr;
+	/// The lock of the transcode cache files, because the files are loaded on the loader thread.
+	std::mutex transcodeCacheMutex;
+
+	/** The version of the transcoded images.
+
+	  Increment it when the encoders or the cache format are changed, so the stale cache files are ignored.
+	*/
+	const uint32_t transcodeCacheVersion = 1;
+
+	/// The header of the transcode cache file. The transcoded KTX file follows it.
+	struct TranscodeCacheHeader {
+		char magic[4]; ///< "TCKT".
+		uint32_t version; ///< transcodeCacheVersion.
+		uint32_t sourceHash; ///< The FNV-1a hash of the source KTX file.
+		uint32_t target; ///< TranscodeTarget.
+	};
+
+	/** Convert the uncompressed image to RGBA8.
+
+	  @param pImage  The image in the KTX file. Each row is aligned to 4 bytes.
+	  @param layout  The layout of the KTX file.
+	  @param width   The width of the image.
+	  @param height  The height of the image.
+	  @param pixels  The converted pixels are stored.
+
+	  @retval true   success.
+	  @retval false  the pixel format isn't supported.
+	*/
+	bool ConvertToRGBA8(const uint8_t* pImage, const KTXLayout& layout, int width, int height, std::vector<uint32_t>& pixels) {
+		int pixelByteSize;
+		switch (layout.type) {
+		case GL_UNSIGNED_BYTE:
+			switch (layout.format) {
+			case GL_RGBA: pixelByteSize = 4; break;
+			case GL_RGB: pixelByteSize = 3; break;
+			case GL_LUMINANCE_ALPHA: pixelByteSize = 2; break;
+			case GL_LUMINANCE: pixelByteSize = 1; break;
+			default: return false;
+			}
+			break;
+		case GL_UNSIGNED_SHORT_5_5_5_1:
+		case GL_UNSIGNED_SHORT_4_4_4_4:
+		case GL_UNSIGNED_SHORT_5_6_5:
+			pixelByteSize = 2;
+			break;
+		default:
+			return false;
+		}
+		const size_t rowByteSize = (width * pixelByteSize + 3) & ~3;
+		pixels.resize(width * height);
+		for (int y = 0; y < height; ++y) {
+			const uint8_t* p = pImage + rowByteSize * y;
+			for (int x = 0; x < width; ++x, p += pixelByteSize) {
+				uint32_t r, g, b, a = 255;
+				if (layout.type == GL_UNSIGNED_BYTE) {
+					switch (pixelByteSize) {
+					case 4: r = p[0]; g = p[1]; b = p[2]; a = p[3]; break;
+					case 3: r = p[0]; g = p[1]; b = p[2]; break;
+					case 2: r = g = b = p[0]; a = p[1]; break;
+					default: r = g = b = p[0]; break;
+					}
+				} else {
+					// The packed pixels of the assets are little endian.
+					const uint32_t v = p[0] + p[1] * 0x100;
+					if (layout.type == GL_UNSIGNED_SHORT_5_5_5_1) {
+						r = (v >> 11) & 31; g = (v >> 6) & 31; b = (v >> 1) & 31;
+						r = (r << 3) | (r >> 2); g = (g << 3) | (g >> 2); b = (b << 3) | (b >> 2);
+						a = (v & 1) * 255;
+					} else if (layout.type == GL_UNSIGNED_SHORT_4_4_4_4) {
+						r = ((v >> 12) & 15) * 17; g = ((v >> 8) & 15) * 17; b = ((v >> 4) & 15) * 17; a = (v & 15) * 17;
+					} else {
+						r = (v >> 11) & 31; g = (v >> 5) & 63; b = v & 31;
+						r = (r << 3) | (r >> 2); g = (g << 2) | (g >> 4); b = (b << 3) | (b >> 2);
+					}
+				}
+				pixels[y * width + x] = r | (g << 8) | (b << 16) | (a << 24);
+			}
+		}
+		return true;
+	}
+
+	/** Transcode the uncompressed KTX file to the format of transcodeTarget.
+
+	  The result is saved to the user file, so each file is transcoded only once.
+	  When the image can't be transcoded, data and layout aren't changed.
+	  ETC1 has no alpha channel, so the images that have the translucent pixels stay uncompressed.
+	  This can be called on any thread.
+
+	  @param data      The whole KTX file. It is replaced by the transcoded KTX file.
+	  @param layout    The layout of data. It is replaced by the layout of the transcoded KTX file.
+	  @param filename  The file name of data.
+	*/
+	void TranscodeKTX(std::vector<uint8_t>& data, KTXLayout& layout, const char* filename) {
+		const TranscodeTarget target = transcodeTarget;
+		if (target == TranscodeTarget::None || layout.type == 0) {
+			return;
+		}
+
+		uint32_t sourceHash = 2166136261U;
+		for (uint8_t e : data) {
+			sourceHash = (sourceHash ^ e) * 16777619U;
+		}
+		static const char cacheMagic[4] = { 'T', 'C', 'K', 'T' };
+		std::string cacheName("transcoded_");
+		for (const char* p = filename; *p; ++p) {
+			cacheName += (*p == '/' || *p == '\\') ? '_' : *p;
+		}
+		if (pTranscodeCacheWindow) {
+			std::lock_guard<std::mutex> lock(transcodeCacheMutex);
+			const size_t fileSize = pTranscodeCacheWindow->GetUserFileSize(cacheName.c_str());
+			if (fileSize > sizeof(TranscodeCacheHeader)) {
+				std::vector<uint8_t> buf(fileSize);
+				if (pTranscodeCacheWindow->LoadUserFile(cacheName.c_str(), &buf[0], buf.size())) {
+					TranscodeCacheHeader header;
+					memcpy(&header, &buf[0], sizeof(TranscodeCacheHeader));
+					if (memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) == 0 && header.version == transcodeCacheVersion && header.sourceHash == sourceHash && header.target == static_cast<uint32_t>(target)) {
+						buf.erase(buf.begin(), buf.begin() + sizeof(TranscodeCacheHeader));
+						KTXLayout cachedLayout;
+						if (ParseKTX(buf, cacheName.c_str(), cachedLayout)) {
+							data.swap(buf);
+							layout = cachedLayout;
+							return;
+						}
+					}
+				}
+			}
+		}
+
+		std::vector<std::vector<uint32_t> > imageList;
+		imageList.reserve(layout.mipCount * layout.faceCount);
+		bool hasAlpha = false;
+		for (int mipLevel = 0; mipLevel < layout.mipCount; ++mipLevel) {
+			const int width = std::max(1, layout.width >> mipLevel);
+			const int height = std::max(1, layout.height >> mipLevel);
+			const size_t faceStride = (layout.levelSize[mipLevel] + 3) & ~3;
+			for (int face = 0; face < layout.faceCount; ++face) {
+				imageList.push_back(std::vector<uint32_t>());
+				if (!ConvertToRGBA8(&data[layout.levelOffset[mipLevel] + faceStride * face], layout, width, height, imageList.back())) {
+					LOGW("can't transcode(type=%x, format=%x):'%s'", layout.type, layout.format, filename);
+					return;
+				}
+				for (uint32_t e : imageList.back()) {
+					if ((e >> 24) != 255) {
+						hasAlpha = true;
+						break;
+					}
+				}
+			}
+		}
+		if (target == TranscodeTarget::ETC1 && hasAlpha) {
+			return;
+		}
+
+		KTXHeader header;
+		memcpy(header.identifier, fileIdentifier, sizeof(fileIdentifier));
+		header.endianness = 0x04030201;
+		header.glType = 0;
+		header.glTypeSize = 1;
+		header.glFormat = 0;
+		header.glInternalFormat = target == TranscodeTarget::ATITC ? GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD : GL_ETC1_RGB8_OES;
+		header.glBaseInternalFormat = target == TranscodeTarget::ATITC ? GL_RGBA : GL_RGB;
+		header.pixelWidth = layout.width;
+		header.pixelHeight = layout.height;
+		header.pixelDepth = 0;
+		header.numberOfArrayElements = 0;
+		header.numberOfFaces = layout.faceCount;
+		header.numberOfMipmapLevels = layout.mipCount;
+		header.bytesOfKeyValueData = 0;
+		std::vector<uint8_t> buf(sizeof(TranscodeCacheHeader) + sizeof(KTXHeader));
+		memcpy(&buf[sizeof(TranscodeCacheHeader)], &header, sizeof(KTXHeader));
+		auto itr = imageList.begin();
+		for (int mipLevel = 0; mipLevel < layout.mipCount; ++mipLevel) {
+			const int width = std::max(1, layout.width >> mipLevel);
+			const int height = std::max(1, layout.height >> mipLevel);
+			const uint32_t imageSize = GetTranscodedImageSize(target, width, height);
+			size_t offset = buf.size();
+			buf.resize(offset + 4 + imageSize * layout.faceCount);
+			memcpy(&buf[offset], &imageSize, 4);
+			offset += 4;
+			for (int face = 0; face < layout.faceCount; ++face, ++itr, offset += imageSize) {
+				if (target == TranscodeTarget::ATITC) {
+					EncodeATITC(&(*itr)[0], width, height, &buf[offset]);
+				} else {
+					EncodeETC1(&(*itr)[0], width, height, &buf[offset]);
+				}
+			}
+		}
+
+		if (pTranscodeCacheWindow) {
+			TranscodeCacheHeader cacheHeader;
+			memcpy(cacheHeader.magic, cacheMagic, sizeof(cacheMagic));
+			cacheHeader.version = transcodeCacheVersion;
+			cacheHeader.sourceHash = sourceHash;
+			cacheHeader.target = static_cast<uint32_t>(target);
+			memcpy(&buf[0], &cacheHeader, sizeof(TranscodeCacheHeader));
+			std::lock_guard<std::mutex> lock(transcodeCacheMutex);
+			if (!pTranscodeCacheWindow->SaveUserFile(cacheName.c_str(), &buf[0], buf.size())) {
+				LOGW("can't save:'%s'", cacheName.c_str());
+			}
+		}
+		buf.erase(buf.begin(), buf.begin() + sizeof(TranscodeCacheHeader));
+		KTXLayout newLayout;
+		if (!ParseKTX(buf, filename, newLayout)) {
+			return;
+		}
+		LOGI("Transcode %s(%x->%x).", filename, layout.format, newLayout.internalFormat);
+		data.swap(buf);
+		layout = newLayout;
+	}
+
+	/** Read the KTX file, and transcode it if needed.
+
+	  @param filename  The file name.
+	  @param data      The whole KTX file is stored.
+	  @param layout    The layout of data is stored.
+
+	  @retval true   success.
+	  @retval false  the file can't be read, or it isn't a KTX file.
+	*/
+	bool LoadKTXFile(const char* filename, std::vector<uint8_t>& data, KTXLayout& layout) {
+		if (!ReadKTXFile(filename, data, layout)) {
+			return false;
+		}
+		TranscodeKTX(data, layout, filename);
+		return true;
+	}
+
+	/** Get the byte size of the levels from baseLevel to the smallest in the video memory.
+	*/
+	uint32_t GetLevelChainByteSize(const KTXLayout& layout, int baseLevel, bool decompressing) {
+		uint32_t size = 0;
+		for (int mipLevel = baseLevel; mipLevel < layout.mipCount; ++mipLevel) {
+			if (IsDecompressionNeeded(layout, decompressing)) {
+				size += std::max(1, layout.width >> mipLevel) * std::max(1, layout.height >> mipLevel) * 4 * layout.faceCount;
+			} else {
+				size += ((layout.levelSize[mipLevel] + 3) & ~3) * layout.faceCount;
+			}
+		}
+		return size;
+	}
+
+	/** Create the texture object from the KTX file image.
+
+	  @param tex            The texture object to store the image.
+	  @param data           The whole KTX file.
+	  @param layout         The layout of data.
+	  @param baseLevel      The first level to upload. It becomes the level 0 of the texture object.
+	  @param decompressing  true if the compressed image should be decompressed.
+	  @param minFilter      The minification filter.
+	  @param magFilter      The magnification filter.
+	  @param decompressedList  The images decompressed in advance for each level and face from baseLevel.
+	                           nullptr if they should be decompressed here.
+	*/
+	void UploadKTXLevels(Texture& tex, const std::vector<uint8_t>& data, const KTXLayout& layout, int baseLevel, bool decompressing, GLint minFilter, GLint magFilter, const std::vector<std::vector<uint32_t>>* decompressedList = nullptr) {
+		tex.internalFormat = layout.internalFormat;
+		tex.width = layout.width;
+		tex.height = layout.height;
+		tex.target = layout.faceCount == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+		tex.mipCount = static_cast<uint8_t>(layout.mipCount);
+		tex.byteSize = GetLevelChainByteSize(layout, baseLevel, decompressing);
+		std::vector<std::vector<uint32_t>> localDecompressedList;
+		const bool isDecompressing = IsDecompressionNeeded(layout, decompressing);
+		if (isDecompressing && !decompressedList) {
+			DecompressLevels(data, layout, baseLevel, localDecompressedList);
+			decompressedList = &localDecompressedList;
+		}
+
+		// this can be called in the middle of the frame to reload the evicted texture,
+		// so the binding of the active unit is restored after the upload.
+		GLint prevTexId = 0;
+		glGetIntegerv(tex.Target() == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_BINDING_CUBE_MAP : GL_TEXTURE_BINDING_2D, &prevTexId);
+		glGenTextures(1, &tex.texId);
+		glBindTexture(tex.Target(), tex.texId);
+		const GLenum target = tex.Target() == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : GL_TEXTURE_2D;
+		for (int mipLevel = baseLevel; mipLevel < layout.mipCount; ++mipLevel) {
+			const GLint level = mipLevel - baseLevel;
+			const GLsizei curWidth = std::max(1, layout.width >> mipLevel);
+			const GLsizei curHeight = std::max(1, layout.height >> mipLevel);
+			const uint32_t imageSize = layout.levelSize[mipLevel];
+			const uint32_t imageSizeWithPadding = (imageSize + 3) & ~3;
+			const uint8_t* pImage = &data[layout.levelOffset[mipLevel]];
+			for (int faceIndex = 0; faceIndex < layout.faceCount; ++faceIndex) {
+				if (layout.type == 0) {
+				  if (isDecompressing) {
+					const std::vector<uint32_t>& decompressedImage = (*decompressedList)[level * layout.faceCount + faceIndex];
+					glTexImage2D(target + faceIndex, level, GL_RGBA, curWidth, curHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, decompressedImage.data());
 				  } else {
-					glCompressedTexImage2D(target + faceIndex, mipLevel, tex.InternalFormat(), curWidth, curHeight, 0, imageSize, pImage);
+					glCompressedTexImage2D(target + faceIndex, level, tex.InternalFormat(), curWidth, curHeight, 0, imageSize, pImage);
 				  }
 				} else {
-					glTexImage2D(target + faceIndex, mipLevel, tex.InternalFormat(), curWidth, curHeight, 0, format, type, pImage);
+					glTexImage2D(target + faceIndex, level, tex.InternalFormat(), curWidth, curHeight, 0, layout.format, layout.type, pImage);
 				}
 				const GLenum result = glGetError();
 				switch(result) {
@@ -548,18 +988,800 @@ namespace Texture {
 				}
 				pImage += imageSizeWithPadding;
 			}
-			tex.byteSize += imageSizeWithPadding * faceCount;
-			curWidth = std::max(1, curWidth / 2);
-			curHeight = std::max(1, curHeight / 2);
 		}
-		glTexParameteri(tex.Target(), GL_TEXTURE_MIN_FILTER, CorrectFilter(mipCount, minFilter));
+		glTexParameteri(tex.Target(), GL_TEXTURE_MIN_FILTER, CorrectFilter(layout.mipCount - baseLevel, minFilter));
 		glTexParameteri(tex.Target(), GL_TEXTURE_MAG_FILTER, CorrectFilter(1, magFilter));
 		glTexParameteri(tex.Target(), GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameteri(tex.Target(), GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		totalByteSize += tex.byteSize;
 
-		glBindTexture(tex.Target(), 0);
-		LOGI("Load %s(ID:%x)(TOTAL:%lld).", filename, tex.texId, totalByteSize);
+		glBindTexture(tex.Target(), static_cast<GLuint>(prevTexId));
+	}
+
+	/** Read the levels of the KTX file from baseLevel to the smallest.
+
+	  If the layout is same as the file, only the byte range of the levels is read.
+	  Otherwise, the LZ4 chunked or transcoded file is read wholly.
+
+	  @param filename    The KTX file name.
+	  @param layout      The layout of the file.
+	  @param baseLevel   The first level to read.
+	  @param data        The levels are stored.
+	  @param dataLayout  The layout of data is stored. The offsets of the levels before baseLevel are invalid.
+
+	  @retval true   success.
+	  @retval false  the file can't be read.
+	*/
+	bool ReadKTXLevels(const char* filename, const KTXLayout& layout, int baseLevel, std::vector<uint8_t>& data, KTXLayout& dataLayout) {
+		if (!layout.isFileLayout) {
+			return LoadKTXFile(filename, data, dataLayout);
+		}
+		auto file = Mai::FileSystem::Open(filename);
+		if (!file) {
+			LOGW("cannot open:'%s'", filename);
+			return false;
+		}
+		const int lastLevel = layout.mipCount - 1;
+		const size_t begin = layout.levelOffset[baseLevel];
+		const size_t end = layout.levelOffset[lastLevel] + ((layout.levelSize[lastLevel] + 3) & ~3) * layout.faceCount;
+		if (end > file->Size()) {
+			LOGW("can't read(miplevel=%d):'%s'", baseLevel, filename);
+			return false;
+		}
+		data.resize(end - begin);
+		file->Seek(begin);
+		if (file->Read(&data[0], data.size()) < 0) {
+			LOGW("can't read(miplevel=%d):'%s'", baseLevel, filename);
+			return false;
+		}
+		dataLayout = layout;
+		for (int mipLevel = 0; mipLevel < layout.mipCount; ++mipLevel) {
+			dataLayout.levelOffset[mipLevel] = mipLevel < baseLevel ? 0 : layout.levelOffset[mipLevel] - begin;
+		}
+		return true;
+	}
+
+	/// The levels of the KTX file read by ReadLevels().
+	struct LoadedLevels {
+		std::vector<uint8_t> data;
+		KTXLayout layout;
+		std::vector<std::vector<uint32_t>> decompressedList; ///< The decompressed images of each level and face from baseLevel.
+	};
+
+	/** Read the levels of the evictable texture, and decompress them if needed.
+
+	  This can be called on any thread.
+
+	  @param filename         The KTX file name.
+	  @param pStreamingLayout The layout of the streaming texture. nullptr if the texture isn't streamed.
+	  @param baseLevel        The first level to read.
+	  @param decompressing    true if the compressed image should be decompressed.
+	  @param levels           The read levels are stored.
+
+	  @retval true   success.
+	  @retval false  the file can't be read.
+	*/
+	bool ReadLevels(const std::string& filename, const KTXLayout* pStreamingLayout, int baseLevel, bool decompressing, LoadedLevels& levels) {
+		if (pStreamingLayout) {
+			if (!ReadKTXLevels(filename.c_str(), *pStreamingLayout, baseLevel, levels.data, levels.layout)) {
+				return false;
+			}
+		} else if (!LoadKTXFile(filename.c_str(), levels.data, levels.layout)) {
+			return false;
+		}
+		if (IsDecompressionNeeded(levels.layout, decompressing)) {
+			DecompressLevels(levels.data, levels.layout, baseLevel, levels.decompressedList);
+		}
+		return true;
+	}
+
+	/** Rebuild the texture object with the read levels.
+
+	  The texture object is recreated because OpenGL ES 2.0 can't change the base level
+	  of the existing texture object.
+	*/
+	void UploadLevels(Texture& tex, const LoadedLevels& levels, int baseLevel) {
+		tex.Release();
+		UploadKTXLevels(tex, levels.data, levels.layout, baseLevel, tex.decompressing, tex.minFilter, tex.magFilter, levels.decompressedList.empty() ? nullptr : &levels.decompressedList);
+		if (tex.streaming) {
+			tex.streaming->baseLevel = baseLevel;
+		}
+		LOGI("Load %s(ID:%x)(LEVEL:%d)(TOTAL:%lld).", tex.filename.c_str(), tex.texId, baseLevel, totalByteSize);
+	}
+
+	/** Load the levels of the evictable texture from baseLevel to the smallest.
+
+	  If the asset loader is set, the file is read, transcoded and decompressed on the worker
+	  threads, and the texture is rebuilt by AssetLoader::ProcessUploads() on the GL thread.
+	  The texture keeps the current levels until then. Otherwise, it is done immediately.
+	  The read data is released after the upload.
+
+	  @param tex        The evictable texture.
+	  @param baseLevel  The new base level. It must be 0 if the texture isn't streamed.
+
+	  @retval true   the levels are loaded, or the request is added.
+	  @retval false  the file can't be read, or the texture is being loaded.
+	*/
+	bool LoadLevels(Texture& tex, int baseLevel) {
+		if (tex.isLoading) {
+			return false;
+		}
+		const std::string filename = tex.filename;
+		const bool decompressing = tex.decompressing;
+		const std::shared_ptr<const KTXLayout> streamingLayout = tex.streaming ? std::make_shared<KTXLayout>(tex.streaming->layout) : nullptr;
+		if (!pAssetLoader) {
+			LoadedLevels levels;
+			if (!ReadLevels(filename, streamingLayout.get(), baseLevel, decompressing, levels)) {
+				return false;
+			}
+			UploadLevels(tex, levels, baseLevel);
+			return true;
+		}
+		tex.isLoading = true;
+		const std::weak_ptr<Texture> weakTexture = tex.shared_from_this();
+		pAssetLoader->Add(filename.c_str(), [weakTexture, filename, streamingLayout, baseLevel, decompressing]() -> Mai::AssetRequest::UploadFunc {
+			const std::shared_ptr<LoadedLevels> levels = std::make_shared<LoadedLevels>();
+			const bool result = ReadLevels(filename, streamingLayout.get(), baseLevel, decompressing, *levels);
+			// the upload step is returned even if it fails, to clear isLoading.
+			return [weakTexture, levels, baseLevel, result]() {
+				const std::shared_ptr<Texture> p = weakTexture.lock();
+				if (!p) {
+					return true;
+				}
+				p->isLoading = false;
+				if (!result) {
+					return false;
+				}
+				UploadLevels(*p, *levels, baseLevel);
+				return true;
+			};
+		});
+		return true;
+	}
+
+	/** Set the parameters to reload the texture, and register it as the evictable texture.
+	*/
+	void RegisterEvictable(Texture& tex, const char* filename, bool decompressing, GLint minFilter, GLint magFilter) {
+		tex.filename = filename;
+		tex.decompressing = decompressing;
+		tex.minFilter = minFilter;
+		tex.magFilter = magFilter;
+		tex.lastUsedFrame = residency.frame;
+		residency.evictableList.push_back(&tex);
+	}
+
+	/** The KTX file read and parsed in the main memory.
+
+	  It is created by PrepareKTX() that doesn't need the GL context, and it is
+	  converted to the texture object by UploadPreparedKTX() on the GL thread.
+	*/
+	struct PreparedKTX {
+		std::string filename;
+		bool decompressing;
+		bool streaming;
+		int baseLevel; ///< The first level to upload.
+		std::vector<uint8_t> data; ///< The whole KTX file.
+		KTXLayout layout;
+		std::vector<std::vector<uint32_t>> decompressedList; ///< The decompressed images of each level and face from baseLevel.
+	};
+
+	/** Get the first level uploaded by the streaming.
+	*/
+	int GetStreamingInitialLevel(const KTXLayout& layout) {
+		for (int mipLevel = 0; mipLevel < layout.mipCount; ++mipLevel) {
+			if (std::max(layout.width >> mipLevel, layout.height >> mipLevel) <= streamingInitialSize) {
+				return mipLevel;
+			}
+		}
+		return layout.mipCount - 1;
+	}
+
+	/** Read and parse the KTX file without the GL context.
+
+	  This can be called on any thread. If the compressed images should be decompressed,
+	  the levels that will be uploaded at first are also decompressed here on the multiple threads.
+
+	  @param filename       The KTX file name.
+	  @param decompressing  true if the compressed image should be decompressed.
+	  @param streaming      true if the texture should be streamed. @sa LoadKTXStreaming().
+
+	  @return The prepared KTX file. nullptr if failed.
+	*/
+	PreparedKTXPtr PrepareKTX(const char* filename, bool decompressing, bool streaming) {
+		PreparedKTXPtr p = std::make_shared<PreparedKTX>();
+		if (!LoadKTXFile(filename, p->data, p->layout)) {
+			return nullptr;
+		}
+		p->filename = filename;
+		p->decompressing = decompressing;
+		p->streaming = streaming && p->layout.mipCount > 1;
+		p->baseLevel = p->streaming ? GetStreamingInitialLevel(p->layout) : 0;
+		if (IsDecompressionNeeded(p->layout, decompressing)) {
+			DecompressLevels(p->data, p->layout, p->baseLevel, p->decompressedList);
+		}
+		return p;
+	}
+
+	/** Create the texture object from the prepared KTX file.
+
+	  This must be called on the GL thread. The data of the prepared file is moved
+	  to the texture, so it can't be uploaded twice.
+	  The texture is evictable by the residency budget. @sa SetResidencyBudget().
+
+	  @param prepared   The KTX file prepared by PrepareKTX().
+	  @param minFilter  The minification filter.
+	  @param magFilter  The magnification filter.
+
+	  @return The texture object. nullptr if failed.
+	*/
+	TexturePtr UploadPreparedKTX(const PreparedKTXPtr& prepared, GLint minFilter, GLint magFilter) {
+		if (!prepared || prepared->data.empty()) {
+			return nullptr;
+		}
+		PreparedKTX& src = *prepared;
+		const std::vector<std::vector<uint32_t>>* decompressedList = src.decompressedList.empty() ? nullptr : &src.decompressedList;
+		std::shared_ptr<Texture> p = std::make_shared<Texture>();
+		RegisterEvictable(*p, src.filename.c_str(), src.decompressing, minFilter, magFilter);
+		if (!src.streaming) {
+			UploadKTXLevels(*p, src.data, src.layout, 0, src.decompressing, minFilter, magFilter, decompressedList);
+			std::vector<uint8_t>().swap(src.data);
+			LOGI("Load %s(ID:%x)(TOTAL:%lld).", src.filename.c_str(), p->texId, totalByteSize);
+			return p;
+		}
+		std::unique_ptr<StreamingState> s(new StreamingState);
+		s->layout = src.layout;
+		s->initialLevel = src.baseLevel;
+		s->baseLevel = src.baseLevel;
+		s->requestedLevel = s->layout.mipCount - 1;
+		s->nextRequestedLevel = s->layout.mipCount - 1;
+		UploadKTXLevels(*p, src.data, s->layout, s->baseLevel, src.decompressing, minFilter, magFilter, decompressedList);
+		std::vector<uint8_t>().swap(src.data);
+		p->streaming = std::move(s);
+		residency.streamingList.push_back(p.get());
+		LOGI("Load %s(ID:%x)(LEVEL:%d)(TOTAL:%lld).", src.filename.c_str(), p->texId, p->streaming->baseLevel, totalByteSize);
+		return p;
+	}
+
+	/** KTXファイルを読み込む.
+
+	  The loaded texture is evictable by the residency budget. @sa SetResidencyBudget().
+	*/
+	TexturePtr LoadKTX(const char* filename, bool decompressing, GLint minFilter, GLint magFilter) {
+		return UploadPreparedKTX(PrepareKTX(filename, decompressing, false), minFilter, magFilter);
+	}
+
+	/** Load KTX file with the progressive mip streaming.
+
+	  At first, only the levels smaller than or equal to streamingInitialSize are uploaded,
+	  so the texture is usable immediately. The finer levels are uploaded by UpdateStreaming()
+	  in the subsequent frames. If the file has no mipmap, it is loaded as same as LoadKTX().
+
+	  @param filename       The KTX file name.
+	  @param decompressing  true if the compressed image should be decompressed.
+	  @param minFilter      The minification filter.
+	  @param magFilter      The magnification filter.
+
+	  @return The texture object. nullptr if failed.
+	*/
+	TexturePtr LoadKTXStreaming(const char* filename, bool decompressing, GLint minFilter, GLint magFilter) {
+		return UploadPreparedKTX(PrepareKTX(filename, decompressing, true), minFilter, magFilter);
+	}
+
+	/** The size of the pixel block of the image.
+
+	  The uncompressed image is regarded as the 1x1 block.
+	*/
+	struct BlockInfo {
+		int size; ///< The width and height of the block.
+		uint32_t byteSize;
+	};
+
+	/** Get the block information of the level 0 image.
+
+	  @param layout  The layout of the KTX file.
+	  @param info    The block information is stored.
+
+	  @retval true   success.
+	  @retval false  the image can't be copied by the blocks.
+	*/
+	bool GetBlockInfo(const KTXLayout& layout, BlockInfo& info) {
+		info.size = layout.type == 0 ? 4 : 1;
+		if (layout.width % info.size || layout.height % info.size) {
+			return false;
+		}
+		const uint32_t blockCount = (layout.width / info.size) * (layout.height / info.size);
+		if (!blockCount || layout.levelSize[0] % blockCount) {
+			return false;
+		}
+		info.byteSize = layout.levelSize[0] / blockCount;
+		// the rows of the uncompressed image must not be padded.
+		return layout.type == 0 || (layout.width * info.byteSize) % 4 == 0;
+	}
+
+	bool IsSameFormat(const KTXLayout& lhs, const KTXLayout& rhs) {
+		return lhs.type == rhs.type && lhs.format == rhs.format && lhs.internalFormat == rhs.internalFormat;
+	}
+
+	/// The page of the texture atlas in the main memory.
+	struct AtlasPage {
+		KTXLayout layout[2]; ///< The layouts of the diffuse and normal atlas.
+		std::vector<uint8_t> data[2]; ///< The images of the diffuse and normal atlas.
+	};
+
+	/// The texture atlas prepared by PrepareAtlas().
+	struct PreparedAtlas {
+		/// The source texture pair and its region in the atlas.
+		struct Entry {
+			std::string name[2];
+			PreparedKTXPtr source[2]; ///< It is released when the pair is packed.
+			int page; ///< The index of the page. -1 if the pair isn't packed.
+			GLfloat scaleOffset[4];
+		};
+		std::vector<AtlasPage> pageList;
+		std::vector<Entry> entryList;
+	};
+
+	/** Check whether the texture pair can be packed into the atlas.
+	*/
+	bool IsPackable(const PreparedAtlas::Entry& e, int maxTileSize) {
+		for (const auto& src : e.source) {
+			BlockInfo info;
+			if (!src || src->layout.faceCount != 1 || src->layout.mipCount != 1 || IsDecompressionNeeded(src->layout, src->decompressing) || !GetBlockInfo(src->layout, info)) {
+				return false;
+			}
+			if (src->layout.width > maxTileSize || src->layout.height > maxTileSize) {
+				return false;
+			}
+		}
+		return e.source[0]->layout.width == e.source[1]->layout.width && e.source[0]->layout.height == e.source[1]->layout.height;
+	}
+
+	/** Copy the level 0 image to the rectangle in the atlas page.
+	*/
+	void CopyBlocks(const PreparedKTX& src, AtlasPage& page, int index, int x, int y) {
+		BlockInfo info;
+		GetBlockInfo(src.layout, info);
+		const size_t srcRowByteSize = (src.layout.width / info.size) * info.byteSize;
+		const size_t dstRowByteSize = (page.layout[index].width / info.size) * info.byteSize;
+		const uint8_t* s = &src.data[src.layout.levelOffset[0]];
+		uint8_t* d = &page.data[index][(y / info.size) * dstRowByteSize + (x / info.size) * info.byteSize];
+		for (int row = 0; row < src.layout.height / info.size; ++row) {
+			memcpy(d, s, srcRowByteSize);
+			s += srcRowByteSize;
+			d += dstRowByteSize;
+		}
+	}
+
+	int NextPowerOfTwo(int n) {
+		int result = 1;
+		while (result < n) {
+			result *= 2;
+		}
+		return result;
+	}
+
+	/** Pack the texture pairs that have the same format by the shelf packing.
+
+	  The page that has only one pair isn't created, because it doesn't reduce the texture binding.
+
+	  @param atlas      The atlas to store the pages.
+	  @param group      The indices of the entries sorted by the height in descending order.
+	  @param pageSize   The maximum width and height of the page.
+	*/
+	void PackAtlasGroup(PreparedAtlas& atlas, const std::vector<size_t>& group, int pageSize) {
+		struct Tile {
+			size_t entry;
+			int x;
+			int y;
+		};
+		size_t i = 0;
+		while (i < group.size()) {
+			std::vector<Tile> tileList;
+			int x = 0, y = 0, shelfHeight = 0, usedWidth = 0;
+			for (; i < group.size(); ++i) {
+				const KTXLayout& layout = atlas.entryList[group[i]].source[0]->layout;
+				if (x + layout.width > pageSize) {
+					x = 0;
+					y += shelfHeight;
+					shelfHeight = 0;
+				}
+				if (y + layout.height > pageSize) {
+					break;
+				}
+				tileList.push_back({ group[i], x, y });
+				x += layout.width;
+				shelfHeight = std::max(shelfHeight, layout.height);
+				usedWidth = std::max(usedWidth, x);
+			}
+			if (tileList.size() < 2) {
+				continue;
+			}
+
+			AtlasPage page;
+			const int pageIndex = static_cast<int>(atlas.pageList.size());
+			const int width = NextPowerOfTwo(usedWidth);
+			const int height = NextPowerOfTwo(y + shelfHeight);
+			for (int k = 0; k < 2; ++k) {
+				const KTXLayout& srcLayout = atlas.entryList[tileList[0].entry].source[k]->layout;
+				BlockInfo info;
+				GetBlockInfo(srcLayout, info);
+				KTXLayout& layout = page.layout[k];
+				layout = srcLayout;
+				layout.width = width;
+				layout.height = height;
+				layout.levelOffset.assign(1, 0);
+				layout.levelSize.assign(1, (width / info.size) * (height / info.size) * info.byteSize);
+				page.data[k].resize(layout.levelSize[0]);
+			}
+			for (const Tile& tile : tileList) {
+				PreparedAtlas::Entry& e = atlas.entryList[tile.entry];
+				const int w = e.source[0]->layout.width;
+				const int h = e.source[0]->layout.height;
+				for (int k = 0; k < 2; ++k) {
+					CopyBlocks(*e.source[k], page, k, tile.x, tile.y);
+					e.source[k].reset();
+				}
+				// the half texel inset avoids the bleeding from the neighbor tiles.
+				e.page = pageIndex;
+				e.scaleOffset[0] = static_cast<GLfloat>(w - 1) / static_cast<GLfloat>(width);
+				e.scaleOffset[1] = static_cast<GLfloat>(h - 1) / static_cast<GLfloat>(height);
+				e.scaleOffset[2] = (static_cast<GLfloat>(tile.x) + 0.5f) / static_cast<GLfloat>(width);
+				e.scaleOffset[3] = (static_cast<GLfloat>(tile.y) + 0.5f) / static_cast<GLfloat>(height);
+			}
+			atlas.pageList.push_back(std::move(page));
+		}
+	}
+
+	/** Pack the small texture pairs into the texture atlases without the GL context.
+
+	  The diffuse and normal textures of each pair share the same region, so the mesh can
+	  sample both with one texture coordinate transform. The pairs are packed only if they
+	  have the same format and no mipmap, because the mipmap of the atlas bleeds between the tiles.
+	  The other pairs are uploaded as the separate textures.
+
+	  @param sourceList   The texture pairs prepared by PrepareKTX().
+	  @param pageSize     The maximum width and height of the atlas.
+	  @param maxTileSize  The maximum width and height of the packed texture.
+
+	  @return The prepared atlas.
+	*/
+	PreparedAtlasPtr PrepareAtlas(const std::vector<AtlasSource>& sourceList, int pageSize, int maxTileSize) {
+		PreparedAtlasPtr p = std::make_shared<PreparedAtlas>();
+		p->entryList.resize(sourceList.size());
+		std::vector<size_t> candidateList;
+		for (size_t i = 0; i < sourceList.size(); ++i) {
+			PreparedAtlas::Entry& e = p->entryList[i];
+			e.name[0] = sourceList[i].diffuseName;
+			e.name[1] = sourceList[i].normalName;
+			e.source[0] = sourceList[i].diffuse;
+			e.source[1] = sourceList[i].normal;
+			e.page = -1;
+			e.scaleOffset[0] = e.scaleOffset[1] = 1.0f;
+			e.scaleOffset[2] = e.scaleOffset[3] = 0.0f;
+			if (IsPackable(e, std::min(maxTileSize, pageSize))) {
+				candidateList.push_back(i);
+			}
+		}
+		while (!candidateList.empty()) {
+			const PreparedAtlas::Entry& key = p->entryList[candidateList[0]];
+			std::vector<size_t> group;
+			const auto itr = std::stable_partition(candidateList.begin(), candidateList.end(), [&](size_t i) {
+				const PreparedAtlas::Entry& e = p->entryList[i];
+				return !(IsSameFormat(e.source[0]->layout, key.source[0]->layout) && IsSameFormat(e.source[1]->layout, key.source[1]->layout));
+			});
+			group.assign(itr, candidateList.end());
+			candidateList.erase(itr, candidateList.end());
+			std::stable_sort(group.begin(), group.end(), [p](size_t lhs, size_t rhs) {
+				const KTXLayout& l = p->entryList[lhs].source[0]->layout;
+				const KTXLayout& r = p->entryList[rhs].source[0]->layout;
+				return l.height != r.height ? l.height > r.height : l.width > r.width;
+			});
+			PackAtlasGroup(*p, group, pageSize);
+		}
+		return p;
+	}
+
+	/** Create the texture objects from the prepared atlas.
+
+	  This must be called on the GL thread. The atlas textures aren't evictable,
+	  because they can't be reloaded from a file.
+
+	  @param prepared   The atlas prepared by PrepareAtlas().
+	  @param minFilter  The minification filter.
+	  @param magFilter  The magnification filter.
+
+	  @return The regions of all pairs passed to PrepareAtlas().
+	*/
+	std::vector<AtlasRegion> UploadPreparedAtlas(const PreparedAtlasPtr& prepared, GLint minFilter, GLint magFilter) {
+		std::vector<AtlasRegion> result;
+		if (!prepared) {
+			return result;
+		}
+		std::vector<std::shared_ptr<Texture>> pageTextureList;
+		pageTextureList.reserve(prepared->pageList.size() * 2);
+		for (AtlasPage& page : prepared->pageList) {
+			for (int k = 0; k < 2; ++k) {
+				std::shared_ptr<Texture> p = std::make_shared<Texture>();
+				UploadKTXLevels(*p, page.data[k], page.layout[k], 0, false, minFilter, magFilter);
+				LOGI("Load %s%d %dx%d (ID:%x)(TOTAL:%lld).", "Atlas", static_cast<int>(pageTextureList.size()), p->width, p->height, p->texId, totalByteSize);
+				pageTextureList.push_back(p);
+				std::vector<uint8_t>().swap(page.data[k]);
+			}
+		}
+		result.reserve(prepared->entryList.size());
+		for (const PreparedAtlas::Entry& e : prepared->entryList) {
+			AtlasRegion r;
+			r.diffuseName = e.name[0];
+			r.normalName = e.name[1];
+			if (e.page >= 0) {
+				r.diffuse = pageTextureList[e.page * 2];
+				r.normal = pageTextureList[e.page * 2 + 1];
+			} else {
+				r.diffuse = UploadPreparedKTX(e.source[0], minFilter, magFilter);
+				r.normal = UploadPreparedKTX(e.source[1], minFilter, magFilter);
+			}
+			std::copy(e.scaleOffset, e.scaleOffset + 4, r.scaleOffset);
+			result.push_back(r);
+		}
+		return result;
+	}
+
+	/** Request the finest level of the streaming texture in the current frame.
+
+	  The requests are gathered until the next UpdateStreaming(), and the finest one is used.
+	  It does nothing if the texture isn't streamed.
+
+	  @param p      The texture.
+	  @param level  The finest level that will be sampled.
+	*/
+	void RequestMipLevel(const TexturePtr& p, int level) {
+		Texture& tex = static_cast<Texture&>(*p);
+		if (tex.streaming) {
+			tex.streaming->nextRequestedLevel = std::min(tex.streaming->nextRequestedLevel, std::max(0, level));
+		}
+	}
+
+	/** Update the progressive mip streaming.
+
+	  This should be called once at the beginning of each frame, after UpdateResidency().
+	  The recently used textures get their next finer level first, until the uploaded byte size
+	  reaches the budget. At least one level is uploaded in each frame even if it exceeds the budget.
+	  When the total texture size exceeds the residency budget, the streaming is paused and the
+	  levels finer than the requested level are dropped. The drops rebuild the textures, so they
+	  share the same budget and the least recently used textures are dropped first.
+
+	  @param uploadByteBudget  The maximum byte size to upload in this frame.
+	*/
+	void UpdateStreaming(uint32_t uploadByteBudget) {
+		residency.streamedByteSize = 0;
+		residency.dropCount = 0;
+		const bool isMemoryTight = residency.budgetByteSize && totalByteSize > residency.budgetByteSize;
+		std::vector<Texture*> candidateList;
+		for (Texture* e : residency.streamingList) {
+			StreamingState& s = *e->streaming;
+			s.requestedLevel = s.nextRequestedLevel;
+			s.nextRequestedLevel = s.layout.mipCount - 1;
+			if (!e->texId || e->isLoading) {
+				continue;
+			}
+			if (isMemoryTight ? s.requestedLevel > s.baseLevel : s.requestedLevel < s.baseLevel) {
+				candidateList.push_back(e);
+			}
+		}
+		if (isMemoryTight) {
+			std::sort(candidateList.begin(), candidateList.end(), [](const Texture* lhs, const Texture* rhs) { return lhs->lastUsedFrame < rhs->lastUsedFrame; });
+		} else {
+			std::sort(candidateList.begin(), candidateList.end(), [](const Texture* lhs, const Texture* rhs) { return lhs->lastUsedFrame > rhs->lastUsedFrame; });
+		}
+		for (Texture* e : candidateList) {
+			const StreamingState& s = *e->streaming;
+			const int newLevel = isMemoryTight ? s.requestedLevel : s.baseLevel - 1;
+			const uint32_t byteSize = GetLevelChainByteSize(s.layout, newLevel, e->decompressing);
+			if (residency.streamedByteSize && residency.streamedByteSize + byteSize > uploadByteBudget) {
+				continue;
+			}
+			if (LoadLevels(*e, newLevel)) {
+				residency.streamedByteSize += byteSize;
+				if (isMemoryTight) {
+					LOGI("Drop %s(LEVEL:%d).", e->filename.c_str(), newLevel);
+					++residency.dropCount;
+				}
+			}
+		}
+	}
+
+	/** Set the byte size budget of the textures.
+
+	  @param byteSize  The budget. 0 means unlimited.
+	*/
+	void SetResidencyBudget(uint64_t byteSize) {
+		residency.budgetByteSize = byteSize;
+	}
+
+	/** Update the texture residency.
+
+	  This should be called once at the beginning of each frame.
+	  If the total texture size exceeds the budget, the least recently used textures that
+	  were not bound in the previous frame are evicted until the total fits in the budget.
+	*/
+	void UpdateResidency() {
+		residency.lastMissCount = residency.missCount;
+		residency.missCount = 0;
+		residency.evictionCount = 0;
+		++residency.frame;
+		if (!residency.budgetByteSize || totalByteSize <= residency.budgetByteSize) {
+			return;
+		}
+		std::vector<Texture*> candidateList;
+		candidateList.reserve(residency.evictableList.size());
+		for (Texture* e : residency.evictableList) {
+			if (e->texId && residency.frame - e->lastUsedFrame > 1) {
+				candidateList.push_back(e);
+			}
+		}
+		std::sort(candidateList.begin(), candidateList.end(), [](const Texture* lhs, const Texture* rhs) { return lhs->lastUsedFrame < rhs->lastUsedFrame; });
+		for (Texture* e : candidateList) {
+			if (totalByteSize <= residency.budgetByteSize) {
+				break;
+			}
+			LOGI("Evict %s(ID:%x)(%dKB).", e->filename.c_str(), e->texId, e->byteSize / 1024);
+			e->Release();
+			++residency.evictionCount;
+		}
+	}
+
+	/** Get the statistics of the texture residency.
+
+	  The miss count is the value in the previous frame.
+	  The streaming values are the results of the last UpdateStreaming().
+	*/
+	ResidencyStats GetResidencyStats() {
+		ResidencyStats stats;
+		stats.totalByteSize = totalByteSize;
+		stats.budgetByteSize = residency.budgetByteSize;
+		stats.evictableCount = static_cast<int>(residency.evictableList.size());
+		stats.residentCount = static_cast<int>(std::count_if(residency.evictableList.begin(), residency.evictableList.end(), [](const Texture* e) { return e->texId != 0; }));
+		stats.missCount = residency.lastMissCount;
+		stats.evictionCount = residency.evictionCount;
+		stats.streamingCount = static_cast<int>(std::count_if(residency.streamingList.begin(), residency.streamingList.end(), [](const Texture* e) { return e->streaming->baseLevel > e->streaming->requestedLevel; }));
+		stats.streamedByteSize = residency.streamedByteSize;
+		stats.dropCount = residency.dropCount;
+		return stats;
+	}
+
+	/** Set the format that the uncompressed KTX files are transcoded to at load time.
+
+	  It must be called before loading the textures.
+
+	  @param target        The transcode target. TranscodeTarget::None disables the transcoding.
+	  @param pCacheWindow  The window that stores the transcoded files. nullptr means no cache.
+	*/
+	void SetTranscodeTarget(TranscodeTarget target, const Mai::Window* pCacheWindow) {
+		transcodeTarget = target;
+		pTranscodeCacheWindow = pCacheWindow;
+	}
+
+	/** Set the loader to read the evicted and streamed levels on the worker threads.
+
+	  The upload steps are called by AssetLoader::ProcessUploads() on the GL thread.
+	  It must be reset to nullptr before the loader is stopped, because the discarded requests
+	  never finish.
+
+	  @param p  The asset loader. nullptr means that the levels are read on the GL thread.
+	*/
+	void SetAssetLoader(Mai::AssetLoader* p) {
+		pAssetLoader = p;
+		if (!p) {
+			for (Texture* e : residency.evictableList) {
+				e->isLoading = false;
+			}
+		}
+	}
+
+	/** Set the compressed formats that the GPU supports.
+
+	  The compressed textures of the other formats are decompressed on CPU at load time
+	  if the decoder is available. Until this is called, all formats are assumed to be supported.
+
+	  @param formatList   The list of GL_COMPRESSED_TEXTURE_FORMATS.
+	  @param formatCount  The number of the formats in formatList.
+	*/
+	void SetSupportedCompressedFormats(const int32_t* formatList, int formatCount) {
+		supportedCompressedFormatList.assign(formatList, formatList + formatCount);
+		hasSupportedCompressedFormatList = true;
+	}
+
+	/** Read the top level image of KTX file into the main memory.
+
+	  It is used to process the image on CPU.
+
+	  @param filename  The KTX file path.
+	  @param image     The decompressed image is stored.
+
+	  @retval true   success.
+	  @retval false  the file can't be read, or the format isn't supported.
+	                 Only the formats that can be decompressed on CPU and uncompressed RGBA are supported.
+	*/
+	/** Convert the first level of the KTX file to the uncompressed image.
+
+	  @param data      The whole KTX file.
+	  @param layout    The layout of data.
+	  @param filename  The file name of data.
+	  @param image     The converted image is stored.
+	*/
+	bool ConvertToImageData(const std::vector<uint8_t>& data, const KTXLayout& layout, const char* filename, ImageData& image) {
+		const GLenum type = layout.type;
+		const GLenum format = type ? layout.format : layout.internalFormat;
+		if (type ? (type != GL_UNSIGNED_BYTE || format != GL_RGBA) : !CanDecompress(format)) {
+			LOGW("unsupported format(0x%04x):'%s'", format, filename);
+			return false;
+		}
+		image.width = layout.width;
+		image.height = layout.height;
+		image.faceCount = layout.faceCount;
+		const uint8_t* pImage = &data[layout.levelOffset[0]];
+		const uint32_t imageSizeWithPadding = (layout.levelSize[0] + 3) & ~3;
+		const size_t pixelCount = image.width * image.height;
+		image.pixels.resize(pixelCount * image.faceCount);
+		if (type) {
+			for (int faceIndex = 0; faceIndex < image.faceCount; ++faceIndex) {
+				memcpy(&image.pixels[pixelCount * faceIndex], pImage + imageSizeWithPadding * faceIndex, pixelCount * 4);
+			}
+			return true;
+		}
+		std::vector<CompressedImage> imageList;
+		for (int faceIndex = 0; faceIndex < image.faceCount; ++faceIndex) {
+			imageList.push_back({ pImage + imageSizeWithPadding * faceIndex, static_cast<uint32_t>(image.width), static_cast<uint32_t>(image.height), format });
+		}
+		std::vector<std::vector<uint32_t>> decompressedList;
+		DecompressImageList(imageList, decompressedList);
+		for (int faceIndex = 0; faceIndex < image.faceCount; ++faceIndex) {
+			std::copy(decompressedList[faceIndex].begin(), decompressedList[faceIndex].end(), image.pixels.begin() + pixelCount * faceIndex);
+		}
+		return true;
+	}
+
+	bool LoadKTXImage(const char* filename, ImageData& image) {
+		std::vector<uint8_t> data;
+		KTXLayout layout;
+		if (!ReadKTXFile(filename, data, layout)) {
+			return false;
+		}
+		return ConvertToImageData(data, layout, filename, image);
+	}
+
+	/** Read the KTX file once for both the uncompressed image and the texture.
+
+	  The image is converted from the authored file, and the texture is uploaded by UploadPreparedKTX()
+	  in the compressed format if the GPU supports it. Otherwise, the first level of the texture is
+	  the converted image itself, so the file isn't decompressed twice.
+	  This can be called on any thread.
+
+	  @param filename  The KTX file name.
+	  @param image     The uncompressed image of the first level is stored.
+
+	  @return The prepared KTX file. nullptr if failed.
+	*/
+	PreparedKTXPtr PrepareKTXImage(const char* filename, ImageData& image) {
+		PreparedKTXPtr p = std::make_shared<PreparedKTX>();
+		if (!ReadKTXFile(filename, p->data, p->layout) || !ConvertToImageData(p->data, p->layout, filename, image)) {
+			return nullptr;
+		}
+		TranscodeKTX(p->data, p->layout, filename);
+		p->filename = filename;
+		p->decompressing = false;
+		p->streaming = false;
+		p->baseLevel = 0;
+		if (IsDecompressionNeeded(p->layout, false)) {
+			if (p->layout.mipCount == 1) {
+				const size_t pixelCount = image.width * image.height;
+				for (int faceIndex = 0; faceIndex < image.faceCount; ++faceIndex) {
+					p->decompressedList.emplace_back(image.pixels.begin() + pixelCount * faceIndex, image.pixels.begin() + pixelCount * (faceIndex + 1));
+				}
+			} else {
+				DecompressLevels(p->data, p->layout, 0, p->decompressedList);
+			}
+		}
 		return p;
 	}
-}
\ No newline at end of file
+}
@@ -1,10 +1,15 @@
 #ifndef ETC1_HEADER_INCLUDED
 #define ETC1_HEADER_INCLUDED
 #include <memory>
+#include <vector>
+#include <string>
+#include <stdint.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include "TextureTranscoder.h"
 
 struct android_app;
+namespace Mai { class Window; class AssetLoader; }
 
 namespace Texture {
 	class ITexture {
@@ -23,12 +28,75 @@ namespace Texture {
 	typedef std::shared_ptr<ITexture> TexturePtr;
 
 	TexturePtr CreateEmpty2D(int w, int h, GLint minFilter = GL_LINEAR, GLint magFilter = GL_LINEAR);
+	TexturePtr Create2D(int w, int h, GLenum format, const void* pixels, GLint minFilter = GL_LINEAR, GLint magFilter = GL_LINEAR);
 	TexturePtr CreateDummy2D();
 	TexturePtr CreateDummyNormal();
 	TexturePtr CreateDummyCubeMap();
+	TexturePtr CreateCubeMap(int size, const uint32_t* pixels, GLint minFilter = GL_LINEAR, GLint magFilter = GL_LINEAR);
 	TexturePtr LoadKTX(const char*, bool decompressing = false, GLint minFilter = GL_LINEAR, GLint magFilter = GL_LINEAR);
+	TexturePtr LoadKTXStreaming(const char*, bool decompressing = false, GLint minFilter = GL_LINEAR, GLint magFilter = GL_LINEAR);
+	void RequestMipLevel(const TexturePtr&, int level);
+
+	/// The KTX file read and parsed in the main memory.
+	struct PreparedKTX;
+	typedef std::shared_ptr<PreparedKTX> PreparedKTXPtr;
+	PreparedKTXPtr PrepareKTX(const char*, bool decompressing = false, bool streaming = false);
+	TexturePtr UploadPreparedKTX(const PreparedKTXPtr&, GLint minFilter = GL_LINEAR, GLint magFilter = GL_LINEAR);
+
+	/// The diffuse and normal texture pair packed into the atlas.
+	struct AtlasSource {
+		std::string diffuseName;
+		PreparedKTXPtr diffuse;
+		std::string normalName;
+		PreparedKTXPtr normal;
+	};
+
+	/// The region of the texture pair in the atlas.
+	struct AtlasRegion {
+		std::string diffuseName;
+		std::string normalName;
+		TexturePtr diffuse;
+		TexturePtr normal;
+		GLfloat scaleOffset[4]; ///< xy: the scale of the texture coordinates. zw: the offset.
+	};
+
+	/// The texture atlas built in the main memory.
+	struct PreparedAtlas;
+	typedef std::shared_ptr<PreparedAtlas> PreparedAtlasPtr;
+	PreparedAtlasPtr PrepareAtlas(const std::vector<AtlasSource>&, int pageSize, int maxTileSize);
+	std::vector<AtlasRegion> UploadPreparedAtlas(const PreparedAtlasPtr&, GLint minFilter = GL_LINEAR, GLint magFilter = GL_LINEAR);
+	void UpdateStreaming(uint32_t uploadByteBudget);
 
 	GLint CorrectFilter(int mipCount, GLint filter);
+
+	/// The statistics of the texture residency.
+	struct ResidencyStats {
+		uint64_t totalByteSize; ///< The byte size of all resident textures.
+		uint64_t budgetByteSize; ///< 0 means unlimited.
+		int evictableCount; ///< The number of the textures loaded from the files.
+		int residentCount; ///< The number of the resident textures in the evictable textures.
+		int missCount; ///< The number of the reloads of the evicted textures in the previous frame.
+		int evictionCount; ///< The number of the evictions in the last update.
+		int streamingCount; ///< The number of the streaming textures that don't have the requested level yet.
+		uint32_t streamedByteSize; ///< The byte size uploaded by the streaming in the last update.
+		int dropCount; ///< The number of the textures whose finer levels are dropped in the last update.
+	};
+	void SetResidencyBudget(uint64_t byteSize);
+	void UpdateResidency();
+	ResidencyStats GetResidencyStats();
+	void SetTranscodeTarget(TranscodeTarget target, const Mai::Window* pCacheWindow);
+	void SetSupportedCompressedFormats(const int32_t* formatList, int formatCount);
+	void SetAssetLoader(Mai::AssetLoader*);
+
+	/// The uncompressed image in the main memory.
+	struct ImageData {
+		int width;
+		int height;
+		int faceCount;
+		std::vector<uint32_t> pixels; ///< RGBA8 pixels. The faces are stored sequentially.
+	};
+	bool LoadKTXImage(const char* filename, ImageData& image);
+	PreparedKTXPtr PrepareKTXImage(const char* filename, ImageData& image);
 }
 
 #endif // ETC1_HEADER_INCLUDED
\ No newline at end of file
@@ -2,13 +2,13 @@ attribute highp   vec3 vPosition;
 attribute mediump vec4 vTexCoord01;
 
 uniform mat4 matProjection;
+uniform mediump vec4 unitTexCoord; // xy: the rendered color size / FBO size.
 
 varying mediump vec4 texCoord; // xy for main. zw for other.
 
 void main()
 {
-  const mediump vec2 scaleMain = vec2(MAIN_RENDERING_PATH_WIDTH / FBO_MAIN_WIDTH, MAIN_RENDERING_PATH_HEIGHT / FBO_MAIN_HEIGHT);
   texCoord.zw = SCALE_TEXCOORD(vTexCoord01.xy);
-  texCoord.xy = texCoord.zw * scaleMain;
+  texCoord.xy = texCoord.zw * unitTexCoord.xy;
   gl_Position = matProjection * vec4(vPosition, 1);
 }
@@ -10,11 +10,21 @@ attribute mediump vec4 vBoneID;
 uniform mat4 matView;
 uniform mat4 matProjection;
 uniform mat4 matLightForShadow;
+uniform mediump vec4 unitTexCoord; // xy: scale, zw: offset for the texture atlas.
 
+#ifdef USE_DUAL_QUATERNION_SKINNING
+/* The array of the dual quaternions. Each joint has the real part and the dual part.
+*/
+uniform vec4 boneDualQuaternions[DQ_BONE_PALETTE_SIZE * 2];
+/* The 3x4 model matrix applied after the blending. It can have the scale.
+*/
+uniform vec4 matModel[3];
+#else
 /* The arrey of 3x4 matrix.
 * Any matrix is the Model-View matrix.
 */
-uniform vec4 boneMatrices[32*3];
+uniform vec4 boneMatrices[BONE_PALETTE_SIZE * 3];
+#endif // USE_DUAL_QUATERNION_SKINNING
 
 uniform mediump vec3 lightPos; // in view space.
 uniform mediump vec3 eyePos; // in world space.
@@ -32,6 +42,41 @@ varying lowp vec3 color;
 
 void main()
 {
+#ifdef USE_DUAL_QUATERNION_SKINNING
+  vec4 bid = vBoneID * 2.0;
+  int b0 = int(bid.x);
+  int b1 = int(bid.y);
+  int b2 = int(bid.z);
+  int b3 = int(bid.w);
+  vec4 w = SCALE_BONE_WEIGHT(vWeight); // weight must be normalized, because it has 0-255.
+  vec4 r0 = boneDualQuaternions[b0];
+  vec4 r1 = boneDualQuaternions[b1];
+  vec4 r2 = boneDualQuaternions[b2];
+  vec4 r3 = boneDualQuaternions[b3];
+  // q and -q are the same rotation, so the weights are negated to blend in the same hemisphere.
+  w.yzw *= step(0.0, vec3(dot(r0, r1), dot(r0, r2), dot(r0, r3))) * 2.0 - 1.0;
+  vec4 real = r0 * w.x + r1 * w.y + r2 * w.z + r3 * w.w;
+  vec4 dual = boneDualQuaternions[b0 + 1] * w.x + boneDualQuaternions[b1 + 1] * w.y + boneDualQuaternions[b2 + 1] * w.z + boneDualQuaternions[b3 + 1] * w.w;
+  float invLength = 1.0 / length(real);
+  real *= invLength;
+  dual *= invLength;
+  vec3 trans = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+  vec3 xyz2 = real.xyz * 2.0;
+  vec3 x2 = real.xyz * xyz2.x; // 2 * (xx, xy, xz)
+  vec3 yz2 = real.yzz * xyz2.yyz; // 2 * (yy, yz, zz)
+  vec3 w2 = real.w * xyz2; // 2 * (wx, wy, wz)
+  mat4 m;
+  m[0] = vec4(1.0 - yz2.x - yz2.z, x2.y + w2.z, x2.z - w2.y, 0);
+  m[1] = vec4(x2.y - w2.z, 1.0 - x2.x - yz2.z, yz2.y + w2.x, 0);
+  m[2] = vec4(x2.z + w2.y, yz2.y - w2.x, 1.0 - x2.x - yz2.x, 0);
+  m[3] = vec4(trans, 1);
+  mat4 model;
+  model[0] = vec4(matModel[0].xyz, 0);
+  model[1] = vec4(matModel[1].xyz, 0);
+  model[2] = vec4(matModel[2].xyz, 0);
+  model[3] = vec4(matModel[0].w, matModel[1].w, matModel[2].w, 1);
+  m = model * m;
+#else
   vec4 bid = vBoneID * 3.0;
   int b0 = int(bid.x);
   int b1 = int(bid.y);
@@ -46,6 +91,7 @@ void main()
   m[1] = vec4(v1.xyz, 0);
   m[2] = vec4(v2.xyz, 0);
   m[3] = vec4(v0.w, v1.w, v2.w, 1);
+#endif // USE_DUAL_QUATERNION_SKINNING
 
   posForShadow = matLightForShadow * m * vec4(vPosition, 1);
   posForShadow.z = posForShadow.z * 0.5 + 0.5;
@@ -76,6 +122,7 @@ void main()
   halfVector = normalize(eyeVector + lightVectorAndDistance.xyz);
 
   texCoord = SCALE_TEXCOORD(vTexCoord01);
+  texCoord.xy = texCoord.xy * unitTexCoord.xy + unitTexCoord.zw;
   gl_Position = (matProjection * matView * m) * vec4(vPosition, 1);
   //color = vTangent * 0.5 + 0.5;
 }
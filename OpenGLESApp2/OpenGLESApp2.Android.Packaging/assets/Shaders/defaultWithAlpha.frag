@@ -7,10 +7,11 @@ uniform lowp vec3 lightColor;
 uniform lowp vec4 materialColor;
 uniform lowp vec2 metallicAndRoughness;
 uniform lowp float dynamicRangeFactor;
+uniform mediump float lodBias; // the mipmap LOD bias for reducing the texture bandwidth.
 
 uniform sampler2D texDiffuse;
 uniform sampler2D texNormal;
-uniform samplerCube texIBL[3];
+uniform samplerCube texIBL[2];
 uniform sampler2D texShadow;
 
 varying mediump vec4 lightVectorAndDistance;
@@ -22,41 +23,22 @@ varying mediump mat3 matTBN;
 varying mediump vec4 texCoord;
 varying mediump vec4 posForShadow;
 
-// [FGS]
-// F0 : fresnel refrectance of material.
-//      dielectric = 0.017-0.067(the average to 0.04)
-//      metal = 0.7-1.0
-// v  : eye vector.
-// h  : half vector. for IBL, this is equal to the normal.
-// F(v, h) = F0 + (1.0 - F0) * 2^(-5.55473*dot(v, h) - 6.98316)*dot(v, h)
-// reference:
-//   http://d.hatena.ne.jp/hanecci/20130727/p2
-//   https://seblagarde.wordpress.com/2011/08/17/hello-world/
-#define CalcF0(ret, col, metallic) lowp float isMetal = step(235.0 / 255.0, metallic); ret = isMetal * col * metallic + (1.0 - isMetal) * metallic
-
-#if 0
-#define FresnelSchlick(F0, dotEH) (F0 + (1.0 - F0) * exp2((-5.55473 * dotEH - 6.98316) * dotEH))
-#else
-#define FresnelSchlick(F0, dotEH) (F0 + (1.0 - F0) * exp2(-8.656170 * dotEH))
-#endif
-
 void main(void)
 {
-  lowp vec4 col = texture2D(texDiffuse, texCoord.xy) * materialColor;
+  lowp vec4 col = texture2D(texDiffuse, texCoord.xy, lodBias) * materialColor;
   if (col.a == 0.0) {
 	gl_FragColor = vec4(0, 0, 0, 0);
   } else {
 	mediump vec3 normal;
-	normal.xy = texture2D(texNormal, texCoord.xy).yw * 2.0 - 1.0;
-	normal.z = sqrt(1.0 - dot(normal.xy, normal.xy));
+	normal.xy = texture2D(texNormal, texCoord.xy, lodBias).NORMAL_MAP_XY * 2.0 - 1.0;
+	normal.z = DECODE_NORMAL_Z(normal.xy);
 	normal = normalize(matTBN * normal);
 	mediump vec3 eyeVectorW = normalize(eyePos - posW.xyz);
 	mediump vec3 refVector = reflect(eyeVectorW, normal);
 
 	// Diffuse
-	mediump vec4 diffuse = textureCube(texIBL[2], refVector);
-	diffuse.rgb *= dynamicRangeFactor / diffuse.a;
-	diffuse.rgb = diffuse.rgb * col.rgb * (1.0 - metallicAndRoughness.x);
+	mediump vec3 diffuse = max(IrradianceSH(refVector), 0.0) * dynamicRangeFactor;
+	diffuse = diffuse * col.rgb * (1.0 - metallicAndRoughness.x);
 
 	// Specular
 	mediump vec3 F0;
@@ -64,7 +46,7 @@ void main(void)
 	mediump float dotNV = max(dot(eyeVectorW, normal), 0.0001);
 	mediump vec4 specular = textureCube(texIBL[0], refVector);
 	specular.rgb *= dynamicRangeFactor / max(specular.a, 1.0 / 128.0);
-	specular.rgb = max(specular.rgb * FresnelSchlick(F0, dotNV), vec3(0.0, 0.0, 0.0));
+	specular.rgb = max(specular.rgb * EnvBRDF(F0, dotNV, metallicAndRoughness.y), vec3(0.0, 0.0, 0.0));
 
 	gl_FragColor.rgb = diffuse.rgb + specular.rgb;
 	gl_FragColor.a = max(col.a, dot(diffuse.rgb * col.a + specular.rgb, vec3(0.3, 0.6, 0.1)));
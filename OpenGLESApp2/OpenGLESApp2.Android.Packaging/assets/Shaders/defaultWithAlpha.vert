@@ -10,11 +10,12 @@ attribute mediump vec4 vBoneID;
 uniform mat4 matView;
 uniform mat4 matProjection;
 uniform mat4 matLightForShadow;
+uniform mediump vec4 unitTexCoord; // xy: scale, zw: offset for the texture atlas.
 
 /* The arrey of 3x4 matrix.
 * Any matrix is the Model-View matrix.
 */
-uniform vec4 boneMatrices[32*3];
+uniform vec4 boneMatrices[BONE_PALETTE_SIZE * 3];
 
 uniform mediump vec3 lightPos; // in view space.
 uniform mediump vec3 eyePos; // in world space.
@@ -74,5 +75,6 @@ void main()
   halfVector = normalize(eyeVector + lightVectorAndDistance.xyz);
 
   texCoord = SCALE_TEXCOORD(vTexCoord01);
+  texCoord.xy = texCoord.xy * unitTexCoord.xy + unitTexCoord.zw;
   gl_Position = (matProjection * matView * m) * vec4(vPosition, 1);
 }
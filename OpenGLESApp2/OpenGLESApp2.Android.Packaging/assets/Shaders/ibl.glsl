@@ -0,0 +1,47 @@
+// The image based lighting functions shared by the PBR fragment shaders.
+// This is inserted after the definitions by LoadShader(), so USE_BRDF_LUT is given by each shader.
+
+uniform mediump vec3 shIrradiance[9]; // the diffuse IBL.
+#ifdef USE_BRDF_LUT
+uniform sampler2D texBRDF; // the environment BRDF lookup table.
+#endif // USE_BRDF_LUT
+
+// [FGS]
+// F0 : fresnel refrectance of material.
+//      dielectric = 0.017-0.067(the average to 0.04)
+//      metal = 0.7-1.0
+// v  : eye vector.
+// h  : half vector. for IBL, this is equal to the normal.
+// F(v, h) = F0 + (1.0 - F0) * 2^(-5.55473*dot(v, h) - 6.98316)*dot(v, h)
+// reference:
+//   http://d.hatena.ne.jp/hanecci/20130727/p2
+//   https://seblagarde.wordpress.com/2011/08/17/hello-world/
+#define CalcF0(ret, col, metallic) lowp float isMetal = step(235.0 / 255.0, metallic); ret = isMetal * col * metallic + (1.0 - isMetal) * metallic
+
+#if 0
+#define FresnelSchlick(F0, dotEH) (F0 + (1.0 - F0) * exp2((-5.55473 * dotEH - 6.98316) * dotEH))
+#else
+#define FresnelSchlick(F0, dotEH) (F0 + (1.0 - F0) * exp2(-8.656170 * dotEH))
+#endif
+
+// The specular scale of the split sum approximation.
+// If USE_BRDF_LUT is defined, it is fetched from the table that is precomputed by GenerateBRDFLUT().
+mediump vec3 EnvBRDF(mediump vec3 F0, mediump float dotNV, lowp float roughness)
+{
+#ifdef USE_BRDF_LUT
+  lowp vec4 scaleAndBias = texture2D(texBRDF, vec2(dotNV, roughness));
+  return F0 * scaleAndBias.r + scaleAndBias.a;
+#else
+  return FresnelSchlick(F0, dotNV);
+#endif // USE_BRDF_LUT
+}
+
+// The diffuse irradiance from the 2nd order spherical harmonics.
+// The coefficients are projected from the radiance map by ProjectIrradianceSH().
+mediump vec3 IrradianceSH(mediump vec3 n)
+{
+  return shIrradiance[0]
+    + shIrradiance[1] * n.y + shIrradiance[2] * n.z + shIrradiance[3] * n.x
+    + shIrradiance[4] * (n.x * n.y) + shIrradiance[5] * (n.y * n.z) + shIrradiance[6] * (3.0 * n.z * n.z - 1.0)
+    + shIrradiance[7] * (n.x * n.z) + shIrradiance[8] * (n.x * n.x - n.y * n.y);
+}
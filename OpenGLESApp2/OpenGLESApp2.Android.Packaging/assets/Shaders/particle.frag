@@ -0,0 +1,12 @@
+uniform lowp float dynamicRangeFactor;
+
+varying mediump vec2 texCoord;
+varying lowp vec4 color;
+
+void main(void)
+{
+  // make the round soft sprite from the texture coordinate.
+  mediump vec2 v = texCoord * 2.0 - 1.0;
+  lowp float falloff = max(1.0 - dot(v, v), 0.0);
+  gl_FragColor = vec4(color.rgb * dynamicRangeFactor, color.a * falloff);
+}
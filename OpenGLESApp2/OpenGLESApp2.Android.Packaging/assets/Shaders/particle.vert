@@ -0,0 +1,17 @@
+attribute highp   vec3 vPosition;
+attribute mediump vec2 vTexCoord01;
+attribute lowp    vec4 vColor;
+
+uniform mat4 matView;
+uniform mat4 matProjection;
+
+varying mediump vec2 texCoord;
+varying lowp vec4 color;
+
+void main()
+{
+  // the particle vertices are already billboarded in world space by ParticleSystem.
+  texCoord = vTexCoord01.xy;
+  color = vColor;
+  gl_Position = matProjection * matView * vec4(vPosition, 1);
+}
@@ -3,10 +3,11 @@ uniform mediump vec3 eyePos; // in world space.
 uniform lowp vec4 materialColor;
 uniform lowp vec3 metallicAndRoughness;
 uniform lowp float dynamicRangeFactor;
+uniform mediump float lodBias; // the mipmap LOD bias for reducing the texture bandwidth.
 
 uniform sampler2D texDiffuse;
 uniform sampler2D texNormal;
-uniform samplerCube texIBL[3];
+uniform samplerCube texIBL[2];
 uniform sampler2D texShadow;
 
 varying mediump mat3 matTBN;
@@ -14,24 +15,6 @@ varying mediump vec3 eyeVectorW;
 varying mediump vec4 texCoord;
 varying mediump vec3 posForShadow;
 
-// [FGS]
-// F0 : fresnel refrectance of material.
-//      dielectric = 0.017-0.067(the average to 0.04)
-//      metal = 0.7-1.0
-// v  : eye vector.
-// h  : half vector. for IBL, this is equal to the normal.
-// F(v, h) = F0 + (1.0 - F0) * 2^(-5.55473*dot(v, h) - 6.98316)*dot(v, h)
-// reference:
-//   http://d.hatena.ne.jp/hanecci/20130727/p2
-//   https://seblagarde.wordpress.com/2011/08/17/hello-world/
-#define CalcF0(ret, col, metallic) lowp float isMetal = step(235.0 / 255.0, metallic); ret = isMetal * col * metallic + (1.0 - isMetal) * metallic
-
-#if 0
-#define FresnelSchlick(F0, dotEH) (F0 + (1.0 - F0) * exp2((-5.55473 * dotEH - 6.98316) * dotEH))
-#else
-#define FresnelSchlick(F0, dotEH) (F0 + (1.0 - F0) * exp2(-8.656170 * dotEH))
-#endif
-
 /**
 * Generate a random value.
 * The canonical "fract(sin(dot(co.xy ,vec2(12.9898,78.233))) * 43758.5453)" didn't work on Mali-400, so replaced sin() w/ approximation.
@@ -68,7 +51,7 @@ mediump vec3 vec_noise(mediump vec2 st) {
 
 void main(void)
 {
-  lowp vec3 col = texture2D(texDiffuse, texCoord.xy).rgb * materialColor.rgb;
+  lowp vec3 col = texture2D(texDiffuse, texCoord.xy, lodBias).rgb * materialColor.rgb;
 
   //mediump vec3 noiseVec = vec_noise(texCoord.xy * 1000.0 + metallicAndRoughness.z);
   //noiseVec += vec_noise(texCoord.xy * 381.0 + vec2(-1.0, 0.9) * metallicAndRoughness.z);
@@ -83,13 +66,12 @@ void main(void)
   //       Of course, it cannot pre-transform to the object space.
   //       Therefore, the object space normal mapping cannot increase efficiency of the shader
   //       that contrary to our expectations :(
-  mediump vec3 normal = normalize((texture2D(texNormal, texCoord.xy).xyz * 2.0 - 1.0) + noiseVec * max(0.0, dot(col, vec3(-2.0, 1.0, 1.0) * 2.0)));
+  mediump vec3 normal = normalize((texture2D(texNormal, texCoord.xy, lodBias).xyz * 2.0 - 1.0) + noiseVec * max(0.0, dot(col, vec3(-2.0, 1.0, 1.0) * 2.0)));
   mediump vec3 refVector = normalize(matTBN * reflect(eyeVectorW, normal.xyz));
 
   // Diffuse
-  mediump vec4 irradiance = textureCube(texIBL[2], refVector);
-  irradiance.rgb *= dynamicRangeFactor / irradiance.a;
-  gl_FragColor = vec4(irradiance.rgb * col * (1.0 - metallicAndRoughness.x), 1.0);
+  mediump vec3 irradiance = max(IrradianceSH(refVector), 0.0) * dynamicRangeFactor;
+  gl_FragColor = vec4(irradiance * col * (1.0 - metallicAndRoughness.x), 1.0);
 
   // Specular
   mediump vec3 F0;
@@ -97,7 +79,7 @@ void main(void)
   mediump float dotNV = dot(eyeVectorW, normal);
   mediump vec4 specular = textureCube(texIBL[0], refVector);
   specular.rgb *= dynamicRangeFactor / specular.a;
-  gl_FragColor.rgb += specular.rgb * FresnelSchlick(F0, dotNV);
+  gl_FragColor.rgb += specular.rgb * EnvBRDF(F0, dotNV, metallicAndRoughness.y);
 
   // Shadow
   const mediump float coef = 1.0 / 256.0;
@@ -10,6 +10,7 @@ attribute mediump vec4 vBoneID;
 uniform mat4 matView;
 uniform mat4 matProjection;
 uniform mat4 matLightForShadow;
+uniform mediump vec4 unitTexCoord; // xy: scale, zw: offset for the texture atlas.
 
 /* The arrey of 3x4 matrix.
 * Any matrix is the Model-View matrix.
@@ -39,5 +40,6 @@ void main()
   eyeVectorW = normalize(eyePos - vPosition);
 
   texCoord = SCALE_TEXCOORD(vTexCoord01);
+  texCoord.xy = texCoord.xy * unitTexCoord.xy + unitTexCoord.zw;
   gl_Position = (matProjection * matView * m) * vec4(vPosition, 1);
 }
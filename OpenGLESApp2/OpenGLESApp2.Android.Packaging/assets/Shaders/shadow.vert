@@ -10,7 +10,16 @@ attribute mediump vec4 vBoneID;
 
 uniform mediump vec3 lightDirForShadow;
 uniform highp mat4 matLightForShadow;
-uniform highp vec4 boneMatrices[32 * 3];
+#ifdef USE_DUAL_QUATERNION_SKINNING
+/* The array of the dual quaternions. Each joint has the real part and the dual part.
+*/
+uniform highp vec4 boneDualQuaternions[DQ_BONE_PALETTE_SIZE * 2];
+/* The 3x4 model matrix applied after the blending. It can have the scale.
+*/
+uniform highp vec4 matModel[3];
+#else
+uniform highp vec4 boneMatrices[BONE_PALETTE_SIZE * 3];
+#endif // USE_DUAL_QUATERNION_SKINNING
 
 #ifdef USE_ALPHA_TEST_IN_SHADOW_RENDERING
 varying mediump vec4 texCoord;
@@ -19,6 +28,41 @@ varying highp float depth;
 
 void main()
 {
+#ifdef USE_DUAL_QUATERNION_SKINNING
+	vec4 bid = vBoneID * 2.0;
+	int b0 = int(bid.x);
+	int b1 = int(bid.y);
+	int b2 = int(bid.z);
+	int b3 = int(bid.w);
+	vec4 w = SCALE_BONE_WEIGHT(vWeight); // weight must be normalized, because it has 0-255.
+	vec4 r0 = boneDualQuaternions[b0];
+	vec4 r1 = boneDualQuaternions[b1];
+	vec4 r2 = boneDualQuaternions[b2];
+	vec4 r3 = boneDualQuaternions[b3];
+	// q and -q are the same rotation, so the weights are negated to blend in the same hemisphere.
+	w.yzw *= step(0.0, vec3(dot(r0, r1), dot(r0, r2), dot(r0, r3))) * 2.0 - 1.0;
+	vec4 real = r0 * w.x + r1 * w.y + r2 * w.z + r3 * w.w;
+	vec4 dual = boneDualQuaternions[b0 + 1] * w.x + boneDualQuaternions[b1 + 1] * w.y + boneDualQuaternions[b2 + 1] * w.z + boneDualQuaternions[b3 + 1] * w.w;
+	float invLength = 1.0 / length(real);
+	real *= invLength;
+	dual *= invLength;
+	vec3 trans = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+	vec3 xyz2 = real.xyz * 2.0;
+	vec3 x2 = real.xyz * xyz2.x; // 2 * (xx, xy, xz)
+	vec3 yz2 = real.yzz * xyz2.yyz; // 2 * (yy, yz, zz)
+	vec3 w2 = real.w * xyz2; // 2 * (wx, wy, wz)
+	mat4 m;
+	m[0] = vec4(1.0 - yz2.x - yz2.z, x2.y + w2.z, x2.z - w2.y, 0);
+	m[1] = vec4(x2.y - w2.z, 1.0 - x2.x - yz2.z, yz2.y + w2.x, 0);
+	m[2] = vec4(x2.z + w2.y, yz2.y - w2.x, 1.0 - x2.x - yz2.x, 0);
+	m[3] = vec4(trans, 1);
+	mat4 model;
+	model[0] = vec4(matModel[0].xyz, 0);
+	model[1] = vec4(matModel[1].xyz, 0);
+	model[2] = vec4(matModel[2].xyz, 0);
+	model[3] = vec4(matModel[0].w, matModel[1].w, matModel[2].w, 1);
+	m = model * m;
+#else
 	vec4 bid = vBoneID * 3.0;
 	int b0 = int(bid.x);
 	int b1 = int(bid.y);
@@ -33,6 +77,7 @@ void main()
 	m[1] = vec4(v1.xyz, 0);
 	m[2] = vec4(v2.xyz, 0);
 	m[3] = vec4(v0.w, v1.w, v2.w, 1);
+#endif // USE_DUAL_QUATERNION_SKINNING
 
 	mediump vec3 normalW = normalize(mat3(m) * vNormal);
 	mediump float bias = 0.015 * clamp(1.0 - dot(normalW, -lightDirForShadow), 0.3, 1.0);
@@ -6,7 +6,7 @@ uniform lowp float dynamicRangeFactor;
 
 uniform sampler2D texDiffuse;
 uniform sampler2D texNormal;
-uniform samplerCube texIBL[3];
+uniform samplerCube texIBL[2];
 uniform sampler2D texShadow;
 
 varying mediump mat3 matTBN;
@@ -14,24 +14,6 @@ varying mediump vec3 eyeVectorW;
 varying mediump vec4 texCoord;
 varying mediump vec3 posForShadow;
 
-// [FGS]
-// F0 : fresnel refrectance of material.
-//      dielectric = 0.017-0.067(the average to 0.04)
-//      metal = 0.7-1.0
-// v  : eye vector.
-// h  : half vector. for IBL, this is equal to the normal.
-// F(v, h) = F0 + (1.0 - F0) * 2^(-5.55473*dot(v, h) - 6.98316)*dot(v, h)
-// reference:
-//   http://d.hatena.ne.jp/hanecci/20130727/p2
-//   https://seblagarde.wordpress.com/2011/08/17/hello-world/
-#define CalcF0(ret, col, metallic) lowp float isMetal = step(235.0 / 255.0, metallic); ret = isMetal * col * metallic + (1.0 - isMetal) * metallic
-
-#if 0
-#define FresnelSchlick(F0, dotEH) (F0 + (1.0 - F0) * exp2((-5.55473 * dotEH - 6.98316) * dotEH))
-#else
-#define FresnelSchlick(F0, dotEH) (F0 + (1.0 - F0) * exp2(-8.656170 * dotEH))
-#endif
-
 void main(void)
 {
   lowp vec3 col = texture2D(texDiffuse, texCoord.xy).rgb * materialColor.rgb;
@@ -46,9 +28,8 @@ void main(void)
   mediump vec3 refVector = normalize(matTBN * reflect(eyeVectorW, normal.xyz));
 
   // Diffuse
-  mediump vec4 irradiance = textureCube(texIBL[2], refVector);
-  irradiance.rgb *= dynamicRangeFactor / irradiance.a;
-  gl_FragColor = vec4(irradiance.rgb * col * (1.0 - metallicAndRoughness.x), 1.0);
+  mediump vec3 irradiance = max(IrradianceSH(refVector), 0.0) * dynamicRangeFactor;
+  gl_FragColor = vec4(irradiance * col * (1.0 - metallicAndRoughness.x), 1.0);
 
   // Specular
   mediump vec3 F0;
@@ -56,7 +37,7 @@ void main(void)
   mediump float dotNV = dot(eyeVectorW, normal);
   mediump vec4 specular = textureCube(texIBL[0], refVector);
   specular.rgb *= dynamicRangeFactor / specular.a;
-  gl_FragColor.rgb += specular.rgb * FresnelSchlick(F0, dotNV);
+  gl_FragColor.rgb += specular.rgb * EnvBRDF(F0, dotNV, metallicAndRoughness.y);
 
   // Shadow
   const mediump float coef = 1.0 / 256.0;
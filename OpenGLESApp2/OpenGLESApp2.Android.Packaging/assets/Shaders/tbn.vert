@@ -11,7 +11,7 @@ uniform mat4 matProjection;
 /* The arrey of 3x4 matrix.
 * Any matrix is the Model-View matrix.
 */
-uniform vec4 boneMatrices[32 * 3];
+uniform vec4 boneMatrices[BONE_PALETTE_SIZE * 3];
 
 varying lowp vec4 color;
 
@@ -77,6 +77,7 @@ namespace Mai {
 	, frames(0)
 	, latestFps(30)
 	, startTime(0)
+	, loadingFrames(0)
 
 	, commonDataDeleter(nullptr)
   {
@@ -200,18 +201,19 @@ namespace Mai {
 		continue;
 	  }
 
-	  // ̃V[̏.
-	  if (!pUnloadingScene && pNextScene) {
+	  // 次のシーンの準備.
+	  // the scene isn't prepared until the renderer finishes loading the assets.
+	  if (!pUnloadingScene && pNextScene && renderer.IsLoadingCompleted()) {
 		LOGI("[Mai::Engine] Prepare scene %p", pNextScene.get());
 		if (pNextScene->Load(*this)) {
-		  // ł̂ŁAÕV[A[hΏۂƂÃV[݂̃V[ɓo^.
+		  // 準備ができたので、前のシーンをアンロード対象とし、次のシーンを現在のシーンに登録する.
 		  pUnloadingScene = pCurrentScene;
 		  pCurrentScene = pNextScene;
 		  pNextScene.reset();
 		}
 	  }
 
-	  // ÕV[̔j.
+	  // 前のシーンの破棄.
 	  if (pUnloadingScene) {
 		LOGI("[Mai::Engine] Destroy scene %p", pUnloadingScene.get());
 		if (pUnloadingScene->Unload(*this)) {
@@ -219,7 +221,7 @@ namespace Mai {
 		}
 	  }
 
-	  // ݂̃V[s.
+	  // 現在のシーンを実行.
 	  static bool isFirstRun = true;
 	  if (pCurrentScene) {
 		switch (pCurrentScene->GetState()) {
@@ -238,7 +240,7 @@ namespace Mai {
 			latestFps = std::min(frames, 60);
 			startTime = curTime;
 			frames = 0;
-			if (latestFps > avgFps * 0.3f) { // ႷFPS̓mCYƂ݂Ȃ.
+			if (latestFps > avgFps * 0.3f) { // 低すぎるFPSはノイズとみなす.
 			  avgFps = (avgFps + latestFps) * 0.5f;
 			  deltaTime = (deltaTime + 1.0f / latestFps) * 0.5f;
 			}
@@ -284,11 +286,15 @@ namespace Mai {
   }
 
   /**
-  * ݂̕\ EGL ReLXg܂B
+  * 現在の表示の EGL コンテキストを初期化します。
   */
   void Engine::InitDisplay() {
-	// GL ̏Ԃ܂B
+	// GL の状態を初期化します。
 	renderer.Initialize(*pWindow);
+	if (pCurrentScene) {
+	  // the running scene needs all assets, e.g. when the window is recreated.
+	  renderer.FinishLoading();
+	}
 
 #ifdef SHOW_DEBUG_SENSOR_OBJECT
 	debugSensorObj = renderer.CreateObject("octahedron", Material(Color4B(255, 255, 255, 255), 0, 0), "default");
@@ -305,7 +311,7 @@ namespace Mai {
   }
   
   /**
-  * ݃fBXvCɊ֘AtĂ EGL ReLXg폜܂B
+  * 現在ディスプレイに関連付けられている EGL コンテキストを削除します。
   */
   void Engine::TermDisplay() {
 	initialized = false;
@@ -319,11 +325,11 @@ namespace Mai {
   }
 
   /**
-  * fBXvČ݂̃t[̂݁B
+  * ディスプレイ内の現在のフレームのみ。
   */
   void Engine::Draw() {
 	if (!renderer.HasDisplay() || !initialized) {
-	  // fBXvC܂B
+	  // ディスプレイがありません。
 	  return;
 	}
 
@@ -337,8 +343,26 @@ namespace Mai {
 #endif // NDEBUG
 	if (pCurrentScene) {
 	  pCurrentScene->Draw(*this);
+	} else if (!renderer.IsLoadingCompleted()) {
+	  DrawLoadingScreen();
 	}
 	renderer.Swap();
   }
 
+  /** Draw the progress of the asset loading.
+
+    It is drawn while there is no scene, because the renderer uploads the assets in Render().
+  */
+  void Engine::DrawLoadingScreen() {
+	++loadingFrames;
+	char buf[32];
+	const int dotCount = (loadingFrames / 15) % 4;
+	sprintf(buf, "LOADING %3d%%%.*s", static_cast<int>(renderer.GetLoadingProgress() * 100.0f), dotCount, "...");
+	const float scale = 1.0f;
+	const float w = renderer.GetStringWidth("LOADING 100%...") * scale;
+	renderer.AddString(0.5f - w * 0.5f, 0.5f, scale, Color4B(200, 200, 200, 255), buf, Renderer::FONTOPTION_OUTLINE);
+	renderer.Update(deltaTime, Position3F(0, 0, 0), Vector3F(0, 0, -1), Vector3F(0, 1, 0));
+	renderer.Render(nullptr, nullptr);
+  }
+
 } // namespace Mai
\ No newline at end of file
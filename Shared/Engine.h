@@ -77,6 +77,7 @@ namespace Mai {
   private:
 	State ProcessWindowEvent(Window&);
 	void Draw();
+	void DrawLoadingScreen();
 	bool SetNextScene(int);
 
   private:
@@ -92,6 +93,7 @@ namespace Mai {
 	int frames;
 	int latestFps;
 	int64_t startTime;
+	int loadingFrames; ///< The frame counter to animate the loading screen.
 
 	// scene control.
 	std::map<int, CreateSceneFunc> sceneCreatorList;
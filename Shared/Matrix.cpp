@@ -103,7 +103,7 @@ void Matrix4x4::Decompose(Quaternion* q, Vector3F* scale, Vector3F* trans) const
     *scale = s;
   }
   if (q) {
-    // (http://www.euclideanspace.com/maths/geometry/rotations/conversions/matrixToQuaternion/)Alternative Methodg.
+    // ここ(http://www.euclideanspace.com/maths/geometry/rotations/conversions/matrixToQuaternion/)のAlternative Methodを使う.
     v0 /= s.x;
     v1 /= s.y;
     v2 /= s.z;
@@ -195,7 +195,7 @@ Matrix4x3& Matrix4x3::operator*=(const Matrix4x3& rhs) {
 	return *this;
 }
 
-/** NH[^jI4x3sɕϊ.
+/** クォータニオンを4x3行列に変換する.
 */
 Matrix4x3 ToMatrix(const Quaternion& q) {
 	Matrix4x3 m;
@@ -6,7 +6,7 @@ namespace Mai {
 
 struct Quaternion;
 
-/** 4x4s.
+/** 4x4行列.
 */
 struct Matrix4x4 {
 	GLfloat f[4 * 4];
@@ -63,9 +63,9 @@ struct Matrix4x4 {
 	}
 };
 
-/** 3x3s + sړ.
-  sړvfeswɊi[Ă邱Ƃɒ. Matrix4x4֕ϊɂw4sڂɈړKv.
-  @todo ]usƂĒ`Ȃ.
+/** 3x3行列 + 平行移動.
+  平行移動要素が各行のwに格納されていることに注意. Matrix4x4へ変換するにはwを4行目に移動させる必要がある.
+  @todo 転置行列として定義しなおすこと.
 */
 struct Matrix4x3 {
 	GLfloat f[4 * 3];
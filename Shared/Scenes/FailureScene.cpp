@@ -90,14 +90,16 @@ namespace SunnySideUp {
 	  o1.SetTranslation(Vector3F(0, 1, 0));
 	  objList.push_back(obj1);
 	}
+	r.GetParticleSystem().AddEmitter(ParticleEffect_EggBreak, Position3F(0, 1.5f, 0));
 
 	loaded = true;
 	status = STATUSCODE_RUNNABLE;
 	return true;
   }
 
-  bool FailureScene::Unload(Engine&) {
+  bool FailureScene::Unload(Engine& engine) {
 	if (loaded) {
+	  engine.GetRenderer().GetParticleSystem().Clear();
 	  objList.clear();
 	  loaded = false;
 	}
@@ -114,17 +114,19 @@ namespace SunnySideUp {
 
 	/** Append collsion box list to the display object list.
 
-	  @param objList  The display object list.
-	                  It will send to the Renderer.
+	  @param idList  The ID list of the display objects.
+	                 It will send to the Renderer.
 
 	  @sa AddCollisionBoxShape()
 	*/
 #ifdef SSU_DEBUG_DISPLAY_COLLISION_BOX
-	void AppendCollisionBox(std::vector<ObjectPtr>& objList) {
-	  objList.insert(objList.end(), collisionBoxList.begin(), collisionBoxList.end());
+	void AppendCollisionBox(std::vector<ObjectId>& idList) {
+	  for (const ObjectPtr& e : collisionBoxList) {
+		idList.push_back(e->GetId());
+	  }
 	}
 #else
-	void AppendCollisionBox(std::vector<ObjectPtr>&) {}
+	void AppendCollisionBox(std::vector<ObjectId>&) {}
 #endif // SSU_DEBUG_DISPLAY_COLLISION_BOX
 
 	/** Set the mouse button press information.
@@ -246,7 +248,7 @@ namespace SunnySideUp {
 	void Clear() {}
 	void SetDebugObj(size_t, const ObjectPtr&) {}
 	void AddCollisionBoxShape(Renderer&, const Vector3F&, float, float, float, const Vector3F&) {}
-	void AppendCollisionBox(std::vector<ObjectPtr>&) {}
+	void AppendCollisionBox(std::vector<ObjectId>&) {}
 	void PressMouseButton(int, int) {}
 	void ReleaseMouseButton() {}
 	void MoveMouse(int, int) {}
@@ -450,6 +452,7 @@ namespace SunnySideUp {
 	  , countDownTimer(countDownTimerInitialTime)
 	  , stopWatch(0)
 	  , warningTransparency(0)
+	  , windEmitterId(ParticleSystem::invalidEmitterId)
 	  , updateFunc(&MainGameScene::DoUpdate)
 	  , debugData()
 	{
@@ -505,8 +508,9 @@ namespace SunnySideUp {
 	  }
 
 	  // The player character.
+	  // the dual quaternion skinning keeps the volume of the twisted joints, if the device can compile it.
 	  {
-		auto obj = renderer.CreateObject("ChickenEgg", Material(Color4B(255, 255, 255, 255), 0, 0), "default");
+		auto obj = renderer.CreateObject("ChickenEgg", Material(Color4B(255, 255, 255, 255), 0, 0), renderer.GetShader("defaultDQ") ? "defaultDQ" : "default");
 		Object& o = *obj;
 		o.SetAnimation(renderer.GetAnimation("Dive"));
 		const Vector3F trans(5, static_cast<GLfloat>(courseInfo.startHeight), 4.5f);
@@ -516,7 +520,7 @@ namespace SunnySideUp {
 		//o.SetScale(Vector3F(5, 5, 5));
 		Collision::RigidBodyPtr p(new Collision::SphereShape(trans.ToPosition3F(), 3.0f, 0.1f));
 		//p->thrust = Vector3F(0, 9.8f, 0);
-		pPartitioner->Insert(obj, p, Vector3F(0, 0, 0));
+		pPartitioner->Insert(obj, p, Vector3F(0, 0, 0), ObjectMobility::Dynamic);
 		rigidCamera = p;
 		objPlayer = obj;
 	  }
@@ -541,7 +545,8 @@ namespace SunnySideUp {
 		Object& o = *obj;
 		o.SetAnimation(renderer.GetAnimation("Rotation"));
 		o.SetScale(Vector3F(courseInfo.targetScale, courseInfo.targetScale, courseInfo.targetScale) * 2);
-		o.SetTranslation(objFlyingPan->Position() - Position3F(0, -10, 0));
+		o.SetParent(objFlyingPan.get());
+		o.SetTranslation(Vector3F(0, 10, 0));
 		pPartitioner->Insert(obj);
 	  }
 
@@ -754,6 +759,7 @@ namespace SunnySideUp {
 	  audio.LoadSE("countdown_1", "Audio/countdown_1.wav");
 	  audio.LoadSE("countdown_go", "Audio/countdown_go.wav");
 	  audio.PlayBGM("Audio/dive.mp3", 1.0f);
+	  windEmitterId = renderer.GetParticleSystem().AddEmitter(ParticleEffect_Wind, objPlayer->Position());
 	  status = STATUSCODE_RUNNABLE;
 	  initialized = true;
 	  return true;
@@ -764,6 +770,8 @@ namespace SunnySideUp {
 	  @param engine  The engine object.
 	*/
 	virtual bool Unload(Engine& engine) {
+	  engine.GetRenderer().GetParticleSystem().Clear();
+	  windEmitterId = ParticleSystem::invalidEmitterId;
 	  debugData.Clear();
 	  rigidCamera.reset();
 	  objPlayer.reset();
@@ -959,7 +967,11 @@ namespace SunnySideUp {
 		objPlayer->SetRotation(playerRotation.x, playerRotation.y, playerRotation.z);
 #endif // __ANDROID__
 
+		ParticleSystem& particleSystem = engine.GetRenderer().GetParticleSystem();
+		// emit the wind streaks ahead of the player, so that they flow past the camera.
+		particleSystem.SetEmitterPosition(windEmitterId, objPlayer->Position() + Vector3F(0, -30, 0));
 		if (DidPassCheckPoint()) {
+		  particleSystem.AddEmitter(ParticleEffect_CheckPoint, objPlayer->Position());
 		  engine.GetAudio().PlaySE("wind", 1.0f);
 		  rigidCamera->accel += Normalize(rigidCamera->accel) * 75.0f;
 		  LOGI("Pass CheckPoint");
@@ -1071,8 +1083,16 @@ namespace SunnySideUp {
 	  @param engine  The engine object.
 	*/
 	virtual void Draw(Engine& engine) {
-	  std::vector<ObjectPtr> objList;
-	  objList.reserve(10 * 10);
+#ifndef NDEBUG
+	  {
+		// the number of the updated and the skipped objects in the latest update.
+		char buf[32];
+		sprintf(buf, "UPD:%03d SKIP:%04d", static_cast<int>(pPartitioner->GetUpdatedCount()), static_cast<int>(pPartitioner->GetSkippedCount()));
+		engine.GetRenderer().AddDebugString(8, 40, buf);
+	  }
+#endif // NDEBUG
+	  std::vector<ObjectId> idList;
+	  idList.reserve(pPartitioner->GetObjectCount());
 #if 0
 	  float posY = debugCamera.Position().y;
 	  if (debugCamera.EyeVector().y >= 0.0f) {
@@ -1125,12 +1145,10 @@ namespace SunnySideUp {
 	  );
 #else
 	  for (auto itr = pPartitioner->Begin(); itr != pPartitioner->End(); ++itr) {
-		for (auto& e : itr->objects) {
-		  objList.push_back(e.object);
-		}
+		idList.insert(idList.end(), itr->idList.begin(), itr->idList.end());
 	  }
 #endif
-	  debugData.AppendCollisionBox(objList);
+	  debugData.AppendCollisionBox(idList);
 
 #ifdef SHOW_DEBUG_SENSOR_OBJECT
 	  {
@@ -1152,7 +1170,7 @@ namespace SunnySideUp {
 		Quaternion q;
 		mRot.Decompose(&q, nullptr, nullptr);
 		debugSensorObj->SetRotation(q);
-		objList.push_back(debugSensorObj);
+		idList.push_back(debugSensorObj->GetId());
 	  }
 #endif // SHOW_DEBUG_SENSOR_OBJECT
 
@@ -1237,7 +1255,7 @@ namespace SunnySideUp {
 		  renderer.AddString(0.5f - renderer.GetStringWidth(strTiltWarning) * 0.4f, 0.75f, 0.8f, Color4B(240, 16, 32, alpha), strTiltWarning);
 		}
 	  }
-	  renderer.Render(&objList[0], &objList[0] + objList.size());
+	  renderer.Render(idList);
 	}
 
   private:
@@ -1295,6 +1313,7 @@ namespace SunnySideUp {
 	float countDownTimer;
 	float stopWatch;
 	float warningTransparency;
+	int windEmitterId;
 	int(MainGameScene::*updateFunc)(Engine&, float);
 
 	std::array<bool, 4> directionKeyDownList;
@@ -462,7 +462,7 @@ namespace SunnySideUp {
 			  "Stand", "Wait0", "Wait1", "Walk", "Dive"
 			};
 			animeNo = (animeNo + 1) % 5;
-			objList[1]->SetAnimation(engine.GetRenderer().GetAnimation(animeNameList[animeNo]));
+			objList[1]->CrossFadeAnimation(engine.GetRenderer().GetAnimation(animeNameList[animeNo]), 0.25f);
 			break;
 		  }
 		  }
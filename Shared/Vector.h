@@ -11,7 +11,7 @@ struct Vector3F;
 struct Vector4F;
 
 /**
-* 3DW.
+* 3D座標.
 */
 struct Position3F {
 	GLfloat x, y, z;
@@ -34,7 +34,7 @@ struct Position3F {
 };
 
 /**
-* 2DW.
+* 2D座標.
 */
 struct Position2F {
 	GLfloat x, y;
@@ -48,7 +48,7 @@ struct Position2F {
 };
 
 /**
-* 2DW(short).
+* 2D座標(short).
 */
 struct Position2S {
 	GLushort x, y;
@@ -63,7 +63,7 @@ struct Position2S {
 };
 
 /**
-* xNg
+* ベクトル
 */
 struct Vector3S {
 	GLshort x, y, z;
@@ -0,0 +1,190 @@
+/** The comparison and the benchmark of AnimationSampler.
+
+  It is built on the host without OpenGL ES:
+
+    g++ -std=c++11 -O2 -I../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity AnimationSamplerBench.cpp ../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity/AnimationSampler.cpp ../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity/AnimationClip.cpp ../Shared/Matrix.cpp -o AnimationSamplerBench
+
+  The reference is the sampling before AnimationSampler was added. It searches the raw keys
+  of each joint by Animation::GetElementByTime(), interpolates them by Interporation(),
+  and returns the new vector in each frame.
+  At first, the poses of both paths are compared in the tolerance of the clip compression.
+  Then both paths are timed for 1, 100 and 1000 animated objects.
+*/
+#include "AnimationSampler.h"
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <stdio.h>
+
+using namespace Mai;
+
+namespace {
+
+  const int jointCount = 32;
+  const int keyCount = 60;
+  const float totalTime = 2.0f;
+  const int frameCount = 600;
+  const float deltaTime = 1.0f / 60.0f;
+
+  const float rotTolerance = 1.0e-3f; ///< The error of the quantized quaternion.
+  const float transTolerance = 1.0e-3f; ///< The distance error of the quantized translation.
+
+  typedef std::pair<const Animation::Element*, const Animation::Element*> ElementPair;
+
+  /** Get the pair of the raw keys just before and after the time.
+
+    This is Animation::GetElementByTime() before AnimationSampler was added.
+  */
+  ElementPair GetElementByTime(const std::vector<Animation::ElementList>& data, int index, float t)
+  {
+	static const Animation::Element defaultElem = { { Quaternion(0, 0, 0, 1), Vector3F(0, 0, 0) }, 0 };
+
+	const std::vector<Animation::ElementList>::const_iterator itrList = std::lower_bound(
+	  data.begin(), data.end(), index, [](const Animation::ElementList& lhs, int rhs) { return lhs.first < rhs; });
+	if (itrList == data.end() || itrList->first != index) {
+	  return ElementPair(&defaultElem, &defaultElem);
+	}
+	const Animation::ElementList& list = *itrList;
+	if (list.second.size() == 0) {
+	  return ElementPair(&defaultElem, &defaultElem);
+	}
+	const std::vector<Animation::Element>::const_iterator itrElem = std::upper_bound(
+	  list.second.begin(), list.second.end(), t, [](float lhs, const Animation::Element& rhs) { return lhs < rhs.time; });
+	if (itrElem == list.second.begin()) {
+	  return ElementPair(&defaultElem, &*itrElem);
+	} else if (itrElem == list.second.end()) {
+	  return ElementPair(&*(itrElem - 1), &*(itrElem - 1));
+	}
+	return ElementPair(&*(itrElem - 1), &*itrElem);
+  }
+
+  /** Sample all joints by the reference path.
+
+    This is AnimationPlayer::Update() before AnimationSampler was added.
+  */
+  std::vector<RotTrans> SampleReference(const std::vector<Animation::ElementList>& data, float t)
+  {
+	std::vector<RotTrans> result;
+	result.reserve(jointCount);
+	for (int i = 0; i < jointCount; ++i) {
+	  const ElementPair p = GetElementByTime(data, i, t);
+	  const float timeRange = p.second->time - p.first->time;
+	  const float ratio = timeRange > 0.0f ? (t - p.first->time) / timeRange : 0.0f;
+	  result.push_back(Interporation(p.first->pose, p.second->pose, ratio));
+	}
+	return result;
+  }
+
+  /// Make the animation that rotates and moves each joint along the sine curves.
+  Animation MakeAnimation()
+  {
+	Animation anime;
+	anime.id = "bench";
+	anime.totalTime = totalTime;
+	anime.loopFlag = true;
+	for (int joint = 0; joint < jointCount; ++joint) {
+	  Animation::ElementList list;
+	  list.first = joint;
+	  for (int key = 0; key < keyCount; ++key) {
+		const float time = totalTime * static_cast<float>(key + 1) / static_cast<float>(keyCount);
+		const float phase = time * 3.0f + static_cast<float>(joint) * 0.37f;
+		const Vector3F axis = Vector3F(std::sin(phase), 1.0f, std::cos(phase * 0.5f)).Normalize();
+		const Animation::Element e = {
+		  { Quaternion(axis, std::sin(phase) * 1.5f), Vector3F(std::sin(phase), std::cos(phase * 2.0f), static_cast<float>(joint) * 0.1f) },
+		  time
+		};
+		list.second.push_back(e);
+	  }
+	  anime.data.push_back(list);
+	}
+	return anime;
+  }
+
+  /// Get the distance between two rotations. q and -q are the same rotation.
+  float GetRotationError(const Quaternion& a, const Quaternion& b)
+  {
+	const float sign = a.Dot(b) < 0.0f ? -1.0f : 1.0f;
+	const float x = a.x - b.x * sign;
+	const float y = a.y - b.y * sign;
+	const float z = a.z - b.z * sign;
+	const float w = a.w - b.w * sign;
+	return std::sqrt(x * x + y * y + z * z + w * w);
+  }
+
+  /// Get the time of the object in the frame.
+  float GetTime(int object, int frame)
+  {
+	return std::fmod(static_cast<float>(object) * 0.013f + static_cast<float>(frame) * deltaTime, totalTime);
+  }
+
+} // unnamed namespace
+
+int main()
+{
+  Animation anime = MakeAnimation();
+  const std::vector<Animation::ElementList> rawData = anime.data;
+  anime.Compress(0.0f, 0.0f);
+
+  // the cursor sampler makes the same poses as the reference, including the backward jump of the loop.
+  int failed = 0;
+  float maxRotError = 0.0f;
+  float maxTransError = 0.0f;
+  {
+	AnimationSampler sampler;
+	sampler.Reset(&anime, jointCount);
+	PoseBuffer pose;
+	for (int frame = 0; frame < frameCount; ++frame) {
+	  const float t = GetTime(0, frame);
+	  sampler.Sample(t, pose);
+	  const std::vector<RotTrans> expected = SampleReference(rawData, t);
+	  for (int i = 0; i < jointCount; ++i) {
+		const float rotError = GetRotationError(pose.rot[i], expected[i].rot);
+		const float transError = (pose.trans[i] - expected[i].trans).Length();
+		maxRotError = std::max(maxRotError, rotError);
+		maxTransError = std::max(maxTransError, transError);
+	  }
+	}
+	if (maxRotError > rotTolerance || maxTransError > transTolerance) {
+	  printf("the poses don't match\n");
+	  ++failed;
+	}
+	printf("max error: rotation %.6f, translation %.6f\n", maxRotError, maxTransError);
+  }
+
+  typedef std::chrono::high_resolution_clock Clock;
+  static const int objectCountList[] = { 1, 100, 1000 };
+  for (int objectCount : objectCountList) {
+	// the reference allocates the result in each frame, as AnimationPlayer::Update() did.
+	float checksum = 0.0f;
+	const Clock::time_point referenceBegin = Clock::now();
+	for (int frame = 0; frame < frameCount; ++frame) {
+	  for (int object = 0; object < objectCount; ++object) {
+		const std::vector<RotTrans> result = SampleReference(rawData, GetTime(object, frame));
+		checksum += result[jointCount - 1].trans.x;
+	  }
+	}
+	const double referenceTime = std::chrono::duration<double, std::milli>(Clock::now() - referenceBegin).count();
+
+	// each object owns the sampler and the pose buffer, as Object does.
+	std::vector<AnimationSampler> samplerList(objectCount);
+	std::vector<PoseBuffer> poseList(objectCount);
+	for (AnimationSampler& e : samplerList) {
+	  e.Reset(&anime, jointCount);
+	}
+	const Clock::time_point cursorBegin = Clock::now();
+	for (int frame = 0; frame < frameCount; ++frame) {
+	  for (int object = 0; object < objectCount; ++object) {
+		samplerList[object].Sample(GetTime(object, frame), poseList[object]);
+		checksum -= poseList[object].trans[jointCount - 1].x;
+	  }
+	}
+	const double cursorTime = std::chrono::duration<double, std::milli>(Clock::now() - cursorBegin).count();
+
+	printf("objects: %4d, joints: %d, keys: %d (checksum %.3f)\n", objectCount, jointCount, keyCount, checksum);
+	printf("  GetElementByTime: %.4f ms/frame\n", referenceTime / frameCount);
+	printf("  AnimationSampler: %.4f ms/frame\n", cursorTime / frameCount);
+  }
+
+  printf("%s\n", failed ? "FAILED" : "PASSED");
+  return failed ? 1 : 0;
+}
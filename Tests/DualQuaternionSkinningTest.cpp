@@ -0,0 +1,191 @@
+/** The comparison of the matrix skinning and the dual quaternion skinning.
+
+  It is built on the host without OpenGL ES:
+
+    g++ -std=c++11 -O2 -I../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity DualQuaternionSkinningTest.cpp ../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity/AnimationSampler.cpp ../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity/AnimationClip.cpp ../Shared/Matrix.cpp -o DualQuaternionSkinningTest
+
+  The bones are made from the sample poses as Object::UpdateBones() does, and the vertices
+  are skinned by the ports of both paths of default.vert.
+  - The vertex of a single bone, and the blend of the bones that have the same rotation,
+    must be transformed to the same position by both paths.
+  - The blend of the twisted bones must keep the rigid transformation in the dual quaternion
+    skinning, while the matrix skinning shrinks it.
+*/
+#include "AnimationSampler.h"
+#include <cmath>
+#include <vector>
+#include <stdio.h>
+
+using namespace Mai;
+
+namespace {
+
+  const float tolerance = 1.0e-4f;
+
+  /// The column major 4x4 matrix, as mat4 of GLSL.
+  struct Mat4 {
+	float m[4][4];
+  };
+
+  Mat4 Multiply(const Mat4& a, const Mat4& b) {
+	Mat4 r;
+	for (int c = 0; c < 4; ++c) {
+	  for (int i = 0; i < 4; ++i) {
+		r.m[c][i] = a.m[0][i] * b.m[c][0] + a.m[1][i] * b.m[c][1] + a.m[2][i] * b.m[c][2] + a.m[3][i] * b.m[c][3];
+	  }
+	}
+	return r;
+  }
+
+  Vector3F Transform(const Mat4& a, const Vector3F& p) {
+	return Vector3F(
+	  a.m[0][0] * p.x + a.m[1][0] * p.y + a.m[2][0] * p.z + a.m[3][0],
+	  a.m[0][1] * p.x + a.m[1][1] * p.y + a.m[2][1] * p.z + a.m[3][1],
+	  a.m[0][2] * p.x + a.m[1][2] * p.y + a.m[2][2] * p.z + a.m[3][2]
+	);
+  }
+
+  /// Build mat4 from 3 vec4 uniforms, as "m[0] = vec4(v0.xyz, 0) ... m[3] = vec4(v0.w, v1.w, v2.w, 1)".
+  Mat4 FromRows(const Vector4F& v0, const Vector4F& v1, const Vector4F& v2) {
+	const Mat4 r = { {
+	  { v0.x, v0.y, v0.z, 0 },
+	  { v1.x, v1.y, v1.z, 0 },
+	  { v2.x, v2.y, v2.z, 0 },
+	  { v0.w, v1.w, v2.w, 1 },
+	} };
+	return r;
+  }
+
+  /// The vertex weighted by 4 bones.
+  struct SkinnedVertex {
+	Vector3F position;
+	int boneID[4];
+	float weight[4];
+  };
+
+  /// The matrix skinning of default.vert.
+  Mat4 SkinMatrix(const std::vector<Matrix4x3>& bones, const SkinnedVertex& v) {
+	Vector4F row[3];
+	for (int r = 0; r < 3; ++r) {
+	  row[r] = Vector4F(0, 0, 0, 0);
+	  for (int i = 0; i < 4; ++i) {
+		row[r] += bones[v.boneID[i]].GetVector(r) * v.weight[i];
+	  }
+	}
+	return FromRows(row[0], row[1], row[2]);
+  }
+
+  /// The dual quaternion skinning of default.vert with USE_DUAL_QUATERNION_SKINNING.
+  Mat4 SkinDualQuaternion(const std::vector<Vector4F>& boneDualQuaternions, const Matrix4x3& matModel, const SkinnedVertex& v) {
+	const Vector4F& r0 = boneDualQuaternions[v.boneID[0] * 2];
+	float w[4] = { v.weight[0], v.weight[1], v.weight[2], v.weight[3] };
+	// q and -q are the same rotation, so the weights are negated to blend in the same hemisphere.
+	for (int i = 1; i < 4; ++i) {
+	  w[i] *= r0.Dot(boneDualQuaternions[v.boneID[i] * 2]) >= 0.0f ? 1.0f : -1.0f;
+	}
+	Vector4F real(0, 0, 0, 0);
+	Vector4F dual(0, 0, 0, 0);
+	for (int i = 0; i < 4; ++i) {
+	  real += boneDualQuaternions[v.boneID[i] * 2] * w[i];
+	  dual += boneDualQuaternions[v.boneID[i] * 2 + 1] * w[i];
+	}
+	const float invLength = 1.0f / std::sqrt(real.Dot(real));
+	real *= invLength;
+	dual *= invLength;
+	const Vector3F rv(real.x, real.y, real.z);
+	const Vector3F dv(dual.x, dual.y, dual.z);
+	const Vector3F trans = (dv * real.w - rv * dual.w + rv.Cross(dv)) * 2.0f;
+	const Vector3F xyz2 = rv * 2.0f;
+	const Vector3F x2 = rv * xyz2.x; // 2 * (xx, xy, xz)
+	const Vector3F yz2(rv.y * xyz2.y, rv.z * xyz2.y, rv.z * xyz2.z); // 2 * (yy, yz, zz)
+	const Vector3F w2 = xyz2 * real.w; // 2 * (wx, wy, wz)
+	const Mat4 m = { {
+	  { 1.0f - yz2.x - yz2.z, x2.y + w2.z, x2.z - w2.y, 0 },
+	  { x2.y - w2.z, 1.0f - x2.x - yz2.z, yz2.y + w2.x, 0 },
+	  { x2.z + w2.y, yz2.y - w2.x, 1.0f - x2.x - yz2.x, 0 },
+	  { trans.x, trans.y, trans.z, 1 },
+	} };
+	const Mat4 model = FromRows(matModel.GetVector(0), matModel.GetVector(1), matModel.GetVector(2));
+	return Multiply(model, m);
+  }
+
+  /// The bone matrix of the joint, as ToMatrix(const RotTrans&).
+  Matrix4x3 ToBoneMatrix(const Quaternion& rot, const Vector3F& trans) {
+	Matrix4x3 m = ToMatrix(rot);
+	m.Set(0, 3, trans.x);
+	m.Set(1, 3, trans.y);
+	m.Set(2, 3, trans.z);
+	return m;
+  }
+
+  bool IsNear(const Vector3F& a, const Vector3F& b) {
+	return (a - b).Length() < tolerance;
+  }
+
+} // unnamed namespace
+
+int main()
+{
+  // the sample pose. joint 2 is twisted by 150 degrees against joint 1, joint 3 has the same rotation as joint 0
+  // in the opposite hemisphere.
+  PoseBuffer pose;
+  pose.Resize(4);
+  pose.rot[0] = Quaternion(Vector3F(0.3f, 1, 0.2f).Normalize(), 0.7f);
+  pose.trans[0] = Vector3F(1, 2, 3);
+  pose.rot[1] = Quaternion(Vector3F(1, 0, 0), 0.2f);
+  pose.trans[1] = Vector3F(0, 5, 0);
+  pose.rot[2] = Quaternion(Vector3F(1, 0, 0), 0.2f + 150.0f * 3.14159265f / 180.0f);
+  pose.trans[2] = Vector3F(0, 5, 0);
+  pose.rot[3] = -pose.rot[0];
+  pose.trans[3] = Vector3F(-2, 0, 1);
+
+  // the model matrix has the rotation, the translation and the scale, as Object::Update() makes.
+  Matrix4x3 m0 = ToBoneMatrix(Quaternion(Vector3F(0, 1, 0), 1.1f), Vector3F(10, -4, 7));
+  for (int r = 0; r < 3; ++r) {
+	for (int c = 0; c < 3; ++c) {
+	  m0.Set(r, c, m0.At(r, c) * 2.0f);
+	}
+  }
+
+  // the bones of both paths, as Object::UpdateBones() does.
+  std::vector<Matrix4x3> bones(pose.Size());
+  for (size_t i = 0; i < pose.Size(); ++i) {
+	bones[i] = m0 * ToBoneMatrix(pose.rot[i], pose.trans[i]);
+  }
+  std::vector<Vector4F> boneDualQuaternions(pose.Size() * 2);
+  ToDualQuaternions(pose, &boneDualQuaternions[0]);
+
+  int failed = 0;
+  const SkinnedVertex sameList[] = {
+	{ Vector3F(1, 2, 3), { 0, 0, 0, 0 }, { 1, 0, 0, 0 } },
+	{ Vector3F(-4, 0.5f, 2), { 1, 0, 0, 0 }, { 1, 0, 0, 0 } },
+	{ Vector3F(0, 1, -1), { 2, 0, 0, 0 }, { 1, 0, 0, 0 } },
+	{ Vector3F(3, -2, 0), { 0, 3, 0, 0 }, { 0.5f, 0.5f, 0, 0 } }, // the same rotation in the opposite hemisphere.
+	{ Vector3F(0.5f, 0.5f, 0.5f), { 0, 3, 0, 0 }, { 0.25f, 0.75f, 0, 0 } },
+  };
+  for (const SkinnedVertex& v : sameList) {
+	const Vector3F pm = Transform(SkinMatrix(bones, v), v.position);
+	const Vector3F pq = Transform(SkinDualQuaternion(boneDualQuaternions, m0, v), v.position);
+	if (!IsNear(pm, pq)) {
+	  printf("mismatch: matrix(%f, %f, %f) DQ(%f, %f, %f)\n", pm.x, pm.y, pm.z, pq.x, pq.y, pq.z);
+	  ++failed;
+	}
+  }
+
+  // the vertex blended by the joints twisted around the x axis keeps its distance from the axis only in the dual quaternion skinning.
+  {
+	const SkinnedVertex v = { Vector3F(0, 1, 2), { 1, 2, 0, 0 }, { 0.5f, 0.5f, 0, 0 } };
+	const SkinnedVertex rigid = { v.position, { 1, 0, 0, 0 }, { 1, 0, 0, 0 } };
+	const Vector3F axisPoint = Transform(SkinMatrix(bones, rigid), Vector3F(0, 0, 0));
+	const float expected = (Transform(SkinMatrix(bones, rigid), rigid.position) - axisPoint).Length();
+	const float matrixRadius = (Transform(SkinMatrix(bones, v), v.position) - axisPoint).Length();
+	const float dqRadius = (Transform(SkinDualQuaternion(boneDualQuaternions, m0, v), v.position) - axisPoint).Length();
+	printf("twisted joint radius: rigid %.4f, matrix %.4f, DQ %.4f\n", expected, matrixRadius, dqRadius);
+	if (std::abs(dqRadius - expected) > tolerance || matrixRadius > expected * 0.5f) {
+	  ++failed;
+	}
+  }
+
+  printf("%s\n", failed ? "FAILED" : "PASSED");
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+/** The hierarchy check and the benchmark of ObjectStore.
+
+  It is built on the host without OpenGL ES:
+
+    g++ -std=c++11 -O2 -I../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity ObjectStoreBench.cpp ../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity/ObjectStore.cpp -o ObjectStoreBench
+
+  At first, the world transforms of the children are compared with the product of the local
+  transforms. Then UpdateTransforms() is timed against recomputing every child in each frame,
+  when a part of the roots moves.
+*/
+#include "ObjectStore.h"
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <stdio.h>
+
+using namespace Mai;
+
+namespace {
+
+  const int rootCount = 1000;
+  const int depth = 4; ///< The number of the children under each root.
+  const int frameCount = 1000;
+  const int movingRootCount = 50; ///< The number of the roots moved in each frame.
+
+  /// Check whether two transforms are the same in the tolerance.
+  bool IsNear(const RotTrans& lhs, const RotTrans& rhs) {
+	const float e = 1.0e-4f;
+	return std::abs(lhs.rot.x - rhs.rot.x) < e && std::abs(lhs.rot.y - rhs.rot.y) < e
+	  && std::abs(lhs.rot.z - rhs.rot.z) < e && std::abs(lhs.rot.w - rhs.rot.w) < e
+	  && std::abs(lhs.trans.x - rhs.trans.x) < e && std::abs(lhs.trans.y - rhs.trans.y) < e
+	  && std::abs(lhs.trans.z - rhs.trans.z) < e;
+  }
+
+  /// Make the transform that has the rotation around the Y axis.
+  RotTrans MakeRotTrans(float angle, const Vector3F& trans) {
+	return RotTrans{ Quaternion(Vector3F(0, 1, 0), angle), trans };
+  }
+
+  /// Add an object without the mesh and the shader.
+  ObjectId AddObject(ObjectStore& store, const RotTrans& rt) {
+	return store.Add(rt, nullptr, Material(Color4B(255, 255, 255, 255), 0, 0), nullptr, std::string(), ShadowCapability::Enable);
+  }
+
+  /** Build the chains of the objects.
+
+	@param store    The storage of the objects.
+	@param rootList The roots are stored.
+	@param order    All children are stored in the order that the parent precedes its children.
+  */
+  void Build(ObjectStore& store, std::vector<ObjectId>& rootList, std::vector<ObjectId>& order) {
+	for (int i = 0; i < rootCount; ++i) {
+	  ObjectId parent = AddObject(store, MakeRotTrans(0.0f, Vector3F(static_cast<float>(i), 0, 0)));
+	  rootList.push_back(parent);
+	  for (int j = 0; j < depth; ++j) {
+		const ObjectId child = AddObject(store, RotTrans::Unit());
+		store.SetParent(child, parent);
+		store.GetLocalRotTrans(child) = MakeRotTrans(0.1f * static_cast<float>(j + 1), Vector3F(0, 1, 0));
+		order.push_back(child);
+		parent = child;
+	  }
+	}
+  }
+
+  /// Check the world transforms of all children against the product of the local transforms.
+  int CheckHierarchy(ObjectStore& store, const std::vector<ObjectId>& order) {
+	int failed = 0;
+	for (ObjectId id : order) {
+	  RotTrans expected = store.localRotTransList[id];
+	  for (ObjectId p = store.parentList[id]; p != invalidObjectId; p = store.parentList[p]) {
+		expected = (store.parentList[p] != invalidObjectId ? store.localRotTransList[p] : store.rotTransList[p]) * expected;
+	  }
+	  if (!IsNear(store.GetRotTrans(id), expected)) {
+		++failed;
+	  }
+	}
+	return failed;
+  }
+
+  /// Move the roots of the frame.
+  void MoveRoots(ObjectStore& store, const std::vector<ObjectId>& rootList, int frame) {
+	for (int i = 0; i < movingRootCount; ++i) {
+	  const ObjectId id = rootList[(frame * movingRootCount + i) % rootList.size()];
+	  store.GetLocalRotTrans(id).trans.y += 0.01f;
+	}
+  }
+
+} // unnamed namespace
+
+int main()
+{
+  int failed = 0;
+  ObjectStore store;
+  std::vector<ObjectId> rootList;
+  std::vector<ObjectId> order;
+  Build(store, rootList, order);
+
+  // the children follow the moved and rotated parent.
+  store.UpdateTransforms();
+  failed += CheckHierarchy(store, order);
+  store.GetLocalRotTrans(rootList[0]) = MakeRotTrans(1.0f, Vector3F(5, 6, 7));
+  store.GetLocalRotTrans(order[1]).trans = Vector3F(2, 0, 0);
+  store.UpdateTransforms();
+  failed += CheckHierarchy(store, order);
+
+  // the parent can't be its descendant.
+  if (store.SetParent(rootList[0], order[depth - 1])) {
+	printf("the cycle is not rejected\n");
+	++failed;
+  }
+
+  // the detached child keeps its world transform, and it becomes the local transform when attached.
+  {
+	const ObjectId id = order[depth - 1];
+	const RotTrans before = store.GetRotTrans(id);
+	store.SetParent(id, invalidObjectId);
+	if (!IsNear(before, store.GetRotTrans(id))) {
+	  printf("the detached child moved\n");
+	  ++failed;
+	}
+	store.SetParent(id, order[depth - 2]);
+	store.UpdateTransforms();
+	if (!IsNear(before, store.localRotTransList[id])) {
+	  printf("the attached child has the wrong local transform\n");
+	  ++failed;
+	}
+  }
+
+  // UpdateTransforms() recomputes only the children of the moved roots.
+  typedef std::chrono::high_resolution_clock Clock;
+  const Clock::time_point lazyBegin = Clock::now();
+  for (int frame = 0; frame < frameCount; ++frame) {
+	MoveRoots(store, rootList, frame);
+	store.UpdateTransforms();
+  }
+  const double lazyTime = std::chrono::duration<double, std::milli>(Clock::now() - lazyBegin).count();
+  failed += CheckHierarchy(store, order);
+
+  // the reference recomputes all children in each frame.
+  std::vector<RotTrans> world(store.rotTransList);
+  const Clock::time_point fullBegin = Clock::now();
+  for (int frame = 0; frame < frameCount; ++frame) {
+	MoveRoots(store, rootList, frame);
+	for (ObjectId id : rootList) {
+	  world[id] = store.rotTransList[id];
+	}
+	for (ObjectId id : order) {
+	  world[id] = world[store.parentList[id]] * store.localRotTransList[id];
+	}
+  }
+  const double fullTime = std::chrono::duration<double, std::milli>(Clock::now() - fullBegin).count();
+  store.UpdateTransforms();
+  for (ObjectId id : order) {
+	if (!IsNear(world[id], store.GetRotTrans(id))) {
+	  ++failed;
+	  break;
+	}
+  }
+
+  printf("objects: %d roots, %d children, %d roots moved in each frame\n", rootCount, rootCount * depth, movingRootCount);
+  printf("UpdateTransforms: %.4f ms/frame\n", lazyTime / frameCount);
+  printf("recompute all:    %.4f ms/frame\n", fullTime / frameCount);
+
+  for (ObjectId id : order) {
+	store.Remove(id);
+  }
+  for (ObjectId id : rootList) {
+	store.Remove(id);
+  }
+  printf("%s\n", failed ? "FAILED" : "PASSED");
+  return failed ? 1 : 0;
+}
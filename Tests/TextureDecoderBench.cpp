@@ -0,0 +1,142 @@
+/** The benchmark of the scalar and the SIMD paths of the ATITC decoder.
+
+  The same TextureDecoder.cpp is built twice, the scalar path in the renamed namespace:
+
+    g++ -std=c++11 -O2 -DTexture=ScalarTexture -c ../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity/TextureDecoder.cpp -o TextureDecoderScalar.o
+    g++ -std=c++11 -O2 -mssse3 -I../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity TextureDecoderBench.cpp ../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity/TextureDecoder.cpp TextureDecoderScalar.o -o TextureDecoderBench
+
+  Each IBL source cube map is decoded by both paths, and the results must be bit-identical.
+  The KTX files are given by the arguments, or the IBL sources in the asset directory are used.
+*/
+#include "TextureDecoder.h"
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <chrono>
+#include <vector>
+#include <string.h>
+#include <stdio.h>
+
+namespace ScalarTexture {
+  void DecompressATITC(const uint8_t* pImage, uint32_t w, uint32_t h, uint32_t format, uint32_t blockRowBegin, uint32_t blockRowEnd, uint32_t* result);
+}
+
+namespace {
+
+  const int repeatCount = 20;
+
+  const char* const defaultFileList[] = {
+	"../OpenGLESApp2/OpenGLESApp2.Android.Packaging/assets/Textures/IBL/Landscape/ibl_noon_1.ktx",
+	"../OpenGLESApp2/OpenGLESApp2.Android.Packaging/assets/Textures/IBL/Landscape/ibl_sunset_1.ktx",
+	"../OpenGLESApp2/OpenGLESApp2.Android.Packaging/assets/Textures/IBL/Landscape/ibl_night_1.ktx",
+	"../OpenGLESApp2/OpenGLESApp2.Android.Packaging/assets/Textures/IBL/Coast/ibl_noon_1.ktx",
+	"../OpenGLESApp2/OpenGLESApp2.Android.Packaging/assets/Textures/IBL/Coast/ibl_sunset_1.ktx",
+	"../OpenGLESApp2/OpenGLESApp2.Android.Packaging/assets/Textures/IBL/Coast/ibl_night_1.ktx",
+  };
+
+  /// The faces of the first level of the little endian KTX file.
+  struct CubeMap {
+	uint32_t format;
+	uint32_t width;
+	uint32_t height;
+	std::vector<const uint8_t*> faceList;
+	std::vector<uint8_t> data;
+  };
+
+  /// Read the first level of the compressed KTX file.
+  bool ReadCubeMap(const char* filename, CubeMap& cubeMap) {
+	FILE* fp = fopen(filename, "rb");
+	if (!fp) {
+	  printf("can't open: %s\n", filename);
+	  return false;
+	}
+	fseek(fp, 0, SEEK_END);
+	cubeMap.data.resize(ftell(fp));
+	fseek(fp, 0, SEEK_SET);
+	const size_t readSize = fread(&cubeMap.data[0], 1, cubeMap.data.size(), fp);
+	fclose(fp);
+	if (readSize != cubeMap.data.size() || cubeMap.data.size() < 68) {
+	  printf("can't read: %s\n", filename);
+	  return false;
+	}
+	uint32_t header[13];
+	memcpy(header, &cubeMap.data[12], sizeof(header));
+	cubeMap.format = header[4];
+	cubeMap.width = header[6];
+	cubeMap.height = header[7];
+	const uint32_t faceCount = header[10];
+	size_t offset = 64 + header[12];
+	uint32_t imageSize;
+	memcpy(&imageSize, &cubeMap.data[offset], 4);
+	offset += 4;
+	if (offset + static_cast<size_t>((imageSize + 3) & ~3) * faceCount > cubeMap.data.size()) {
+	  printf("illegal size: %s\n", filename);
+	  return false;
+	}
+	for (uint32_t i = 0; i < faceCount; ++i) {
+	  cubeMap.faceList.push_back(&cubeMap.data[offset + ((imageSize + 3) & ~3) * i]);
+	}
+	return true;
+  }
+
+  typedef void(*DecompressFunc)(const uint8_t*, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t*);
+
+  /// Decode all faces repeatedly, and return the time of a cube map in milliseconds.
+  double Decode(DecompressFunc func, const CubeMap& cubeMap, std::vector<uint32_t>& result) {
+	const uint32_t pixelCount = cubeMap.width * cubeMap.height;
+	result.resize(pixelCount * cubeMap.faceList.size());
+	typedef std::chrono::high_resolution_clock Clock;
+	const Clock::time_point begin = Clock::now();
+	for (int i = 0; i < repeatCount; ++i) {
+	  for (size_t face = 0; face < cubeMap.faceList.size(); ++face) {
+		func(cubeMap.faceList[face], cubeMap.width, cubeMap.height, cubeMap.format, 0, (cubeMap.height + 3) / 4, &result[pixelCount * face]);
+	  }
+	}
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count() / repeatCount;
+  }
+
+} // unnamed namespace
+
+int main(int argc, char** argv)
+{
+  std::vector<const char*> fileList;
+  for (int i = 1; i < argc; ++i) {
+	fileList.push_back(argv[i]);
+  }
+  if (fileList.empty()) {
+	for (const char* e : defaultFileList) {
+	  fileList.push_back(e);
+	}
+  }
+  int failed = 0;
+  double scalarTotal = 0;
+  double simdTotal = 0;
+  for (const char* filename : fileList) {
+	CubeMap cubeMap;
+	if (!ReadCubeMap(filename, cubeMap)) {
+	  ++failed;
+	  continue;
+	}
+	if (cubeMap.format != GL_ATC_RGBA_EXPLICIT_ALPHA_AMD && cubeMap.format != GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD) {
+	  printf("not ATITC(0x%04x): %s\n", cubeMap.format, filename);
+	  ++failed;
+	  continue;
+	}
+	std::vector<uint32_t> scalar;
+	std::vector<uint32_t> simd;
+	const double scalarTime = Decode(ScalarTexture::DecompressATITC, cubeMap, scalar);
+	const double simdTime = Decode(Texture::DecompressATITC, cubeMap, simd);
+	const bool isSame = scalar == simd;
+	if (!isSame) {
+	  ++failed;
+	}
+	scalarTotal += scalarTime;
+	simdTotal += simdTime;
+	printf("%s: %ux%u x%u faces, scalar %.3f ms, SIMD %.3f ms, %s\n", filename, cubeMap.width, cubeMap.height,
+	  static_cast<unsigned>(cubeMap.faceList.size()), scalarTime, simdTime, isSame ? "identical" : "DIFFERENT");
+  }
+  if (simdTotal > 0) {
+	printf("speedup: x%.2f\n", scalarTotal / simdTotal);
+  }
+  printf("%s\n", failed ? "FAILED" : "PASSED");
+  return failed ? 1 : 0;
+}
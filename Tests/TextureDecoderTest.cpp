@@ -0,0 +1,132 @@
+/** The golden block test of TextureDecoder.
+
+  It is built on the host without OpenGL ES, for both the scalar path and the SIMD path:
+
+    g++ -std=c++11 -O2 -I../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity TextureDecoderTest.cpp ../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity/TextureDecoder.cpp -o TextureDecoderTest
+    g++ -std=c++11 -O2 -mssse3 -I../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity TextureDecoderTest.cpp ../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity/TextureDecoder.cpp -o TextureDecoderTest
+
+  Each block covers a mode of the format. The pixels are RGBA8888 that has R in the lowest byte.
+  The expected pixels were made by the scalar decoder before the SIMD path was added.
+*/
+#include "TextureDecoder.h"
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <stdio.h>
+
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9276
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+
+namespace {
+
+  struct GoldenBlock {
+	const char* name;
+	uint32_t format;
+	uint8_t block[16];
+	uint32_t pixels[16];
+  };
+
+  const GoldenBlock goldenBlockList[] = {
+	  { "etc1 individual", GL_ETC1_RGB8_OES,
+		{ 0x8F, 0x40, 0x2E, 0x1C, 0x00, 0xFF, 0x55, 0x0F },
+		{
+		  0xff1a3c80, 0xff204286, 0xffffb7ff, 0xffffb7ff,
+		  0xff1a3c80, 0xff204286, 0xffff2fff, 0xffff2fff,
+		  0xff1a3c80, 0xff204286, 0xffffb7ff, 0xffffb7ff,
+		  0xff1a3c80, 0xff204286, 0xffff2fff, 0xffff2fff,
+		},
+	  },
+	  { "etc1 differential flip", GL_ETC1_RGB8_OES,
+		{ 0x81, 0x42, 0x23, 0x6B, 0xA5, 0x5A, 0x33, 0xCC },
+		{
+		  0xff2e4f91, 0xff143577, 0xff00185a, 0xff4b6cae,
+		  0xff143577, 0xff2e4f91, 0xff4b6cae, 0xff00185a,
+		  0xff566fa9, 0xff1c356f, 0xff304983, 0xff425b95,
+		  0xff1c356f, 0xff566fa9, 0xff425b95, 0xff304983,
+		},
+	  },
+	  { "etc2 t", GL_COMPRESSED_RGB8_ETC2,
+		{ 0xF8, 0x12, 0x34, 0x56, 0x1B, 0xE4, 0x1B, 0xE4 },
+		{
+		  0xff3a19ff, 0xff3a19ff, 0xff0000af, 0xff0000af,
+		  0xff3a19ff, 0xff1400e2, 0xff0000af, 0xff2839ff,
+		  0xff1400e2, 0xff1400e2, 0xff2839ff, 0xff2839ff,
+		  0xff3a19ff, 0xff1400e2, 0xff0000af, 0xff2839ff,
+		},
+	  },
+	  { "etc2 h", GL_COMPRESSED_RGB8_ETC2,
+		{ 0x00, 0xF8, 0x34, 0x56, 0x0F, 0xF0, 0xA5, 0x5A },
+		{
+		  0xff3aff09, 0xff14e200, 0xff00af00, 0xff28ff18,
+		  0xff4eff1d, 0xff28f600, 0xff00e700, 0xff60ff50,
+		  0xff3aff09, 0xff14e200, 0xff00af00, 0xff28ff18,
+		  0xff4eff1d, 0xff28f600, 0xff00e700, 0xff60ff50,
+		},
+	  },
+	  { "etc2 planar", GL_COMPRESSED_RGB8_ETC2,
+		{ 0x00, 0x00, 0xFC, 0x02, 0x12, 0x34, 0x56, 0x78 },
+		{
+		  0xffff0202, 0xfff70000, 0xffe00202, 0xffd60000,
+		  0xffff0202, 0xfff70000, 0xffd60000, 0xffe00202,
+		  0xfffd0000, 0xffff0808, 0xffe60808, 0xffe60808,
+		  0xffff0808, 0xffff0202, 0xffe00202, 0xffe00202,
+		},
+	  },
+	  { "etc2 punchthrough", GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2,
+		{ 0x81, 0x42, 0x23, 0x68, 0xFF, 0x00, 0x0F, 0xF0 },
+		{
+		  0xff214284, 0xff4b6cae, 0xff1c356f, 0x00000000,
+		  0xff214284, 0xff4b6cae, 0xff1c356f, 0x00000000,
+		  0xff214284, 0xff4b6cae, 0xff1c356f, 0x00000000,
+		  0xff214284, 0xff4b6cae, 0xff1c356f, 0x00000000,
+		},
+	  },
+	  { "etc2 eac", GL_COMPRESSED_RGBA8_ETC2_EAC,
+		{ 0x80, 0x3B, 0x05, 0x39, 0x77, 0x00, 0x12, 0x34, 0x8F, 0x40, 0x2E, 0x1C, 0x00, 0xFF, 0x55, 0x0F },
+		{
+		  0x7a1a3c80, 0x83204286, 0x7affb7ff, 0x71ffb7ff,
+		  0x711a3c80, 0x8c204286, 0x7aff2fff, 0x7aff2fff,
+		  0x6b1a3c80, 0x92204286, 0x7affb7ff, 0x92ffb7ff,
+		  0x621a3c80, 0x9b204286, 0x71ff2fff, 0x83ff2fff,
+		},
+	  },
+	  { "atitc interpolated", GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD,
+		{ 0xFF, 0x00, 0x88, 0xC6, 0xFA, 0x05, 0x39, 0x77, 0x1F, 0x7C, 0xE0, 0x83, 0xE4, 0x1B, 0x4E, 0xB1 },
+		{
+		  0xffff00ff, 0x009f2ed0, 0xdb5f4eb2, 0xb6007d84,
+		  0x92007d84, 0x6d5f4eb2, 0x499f2ed0, 0x24ff00ff,
+		  0x6d5f4eb2, 0xff007d84, 0x92ff00ff, 0x929f2ed0,
+		  0xb69f2ed0, 0x49ff00ff, 0x6d007d84, 0xb65f4eb2,
+		},
+	  },
+  };
+
+} // unnamed namespace
+
+int main()
+{
+  int failed = 0;
+  for (const GoldenBlock& e : goldenBlockList) {
+	uint32_t pixels[16];
+	if (Texture::IsETCFormat(e.format)) {
+	  Texture::DecompressETC(e.block, 4, 4, e.format, 0, 1, pixels);
+	} else {
+	  Texture::DecompressATITC(e.block, 4, 4, e.format, 0, 1, pixels);
+	}
+	for (int i = 0; i < 16; ++i) {
+	  if (pixels[i] != e.pixels[i]) {
+		printf("%s: pixel %d is 0x%08x, expected 0x%08x\n", e.name, i, pixels[i], e.pixels[i]);
+		++failed;
+		break;
+	  }
+	}
+  }
+  printf("%s\n", failed ? "FAILED" : "PASSED");
+  return failed ? 1 : 0;
+}
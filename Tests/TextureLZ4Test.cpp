@@ -0,0 +1,202 @@
+/** The round trip test and the benchmark of the LZ4 chunked KTX file.
+
+  It is built on the host without OpenGL ES:
+
+    g++ -std=c++11 -O2 -pthread -I../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity TextureLZ4Test.cpp ../OpenGLESApp2/OpenGLESApp2.Android.NativeActivity/TextureLZ4.cpp -o TextureLZ4Test
+
+  Each KTX file is converted by asset_works/texture/ktx_lz4.py, and read back by ReadLZ4Chunks().
+  The decompressed images must be the same as the images of the source file.
+  Then reading the source file is timed against reading and decompressing the converted file.
+  The KTX files are given by the arguments, or the skybox and the IBL sources in the asset directory are used.
+*/
+#include "TextureLZ4.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+namespace {
+
+  const int repeatCount = 20;
+  const size_t ktxHeaderSize = 64;
+  const char assetDir[] = "../OpenGLESApp2/OpenGLESApp2.Android.Packaging/assets/";
+
+  const char* const defaultFileList[] = {
+	"Textures/Others/skybox_high.ktx",
+	"Textures/Others/skybox_low.ktx",
+	"Textures/IBL/Landscape/ibl_noon_1.ktx",
+	"Textures/IBL/Landscape/ibl_sunset_1.ktx",
+	"Textures/IBL/Landscape/ibl_night_1.ktx",
+	"Textures/IBL/Coast/ibl_noon_1.ktx",
+	"Textures/IBL/Coast/ibl_sunset_1.ktx",
+	"Textures/IBL/Coast/ibl_night_1.ktx",
+  };
+
+  /// The file read by stdio, as Mai::File on the device.
+  class StdioFile : public Mai::File {
+  public:
+	explicit StdioFile(const char* filename) : fp(fopen(filename, "rb")), size(0) {
+	  if (fp) {
+		fseek(fp, 0, SEEK_END);
+		size = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+	  }
+	}
+	virtual ~StdioFile() { Close(); }
+	virtual size_t Size() const { return size; }
+	virtual size_t Position() const { return fp ? ftell(fp) : 0; }
+	virtual void Seek(size_t n) {
+	  if (fp) {
+		fseek(fp, n, SEEK_SET);
+	  }
+	}
+	virtual int Read(void* p, size_t n) { return fp && fread(p, n, 1, fp) == 1 ? static_cast<int>(n) : -1; }
+	virtual void Close() {
+	  if (fp) {
+		fclose(fp);
+		fp = nullptr;
+	  }
+	}
+	bool IsOpen() const { return fp != nullptr; }
+
+  private:
+	FILE* fp;
+	size_t size;
+  };
+
+  /// Read the whole plain KTX file.
+  bool ReadPlain(const char* filename, std::vector<uint8_t>& data) {
+	StdioFile file(filename);
+	if (!file.IsOpen() || file.Size() <= ktxHeaderSize) {
+	  return false;
+	}
+	data.resize(file.Size());
+	return file.Read(&data[0], data.size()) >= 0;
+  }
+
+  /** Read the LZ4 chunked KTX file as ReadKTXFile() does.
+
+    @param filename  The LZ4 chunked KTX file.
+	@param data      The plain KTX file without the key/value data is stored.
+	@param truncate  The byte size removed from the end of the file to make it broken.
+  */
+  bool ReadLZ4(const char* filename, std::vector<uint8_t>& data, size_t truncate = 0) {
+	StdioFile file(filename);
+	if (!file.IsOpen() || file.Size() <= ktxHeaderSize) {
+	  return false;
+	}
+	uint32_t header[16];
+	if (file.Read(header, ktxHeaderSize) < 0) {
+	  return false;
+	}
+	const Texture::Endian endianness = header[3] == 0x04030201 ? Texture::Endian_Little : Texture::Endian_Big;
+	std::vector<uint8_t> kv(Texture::GetValue(&header[15], endianness));
+	if (!kv.empty() && file.Read(&kv[0], kv.size()) < 0) {
+	  return false;
+	}
+	uint32_t chunkSize;
+	uint32_t imageByteSize;
+	if (!Texture::FindLZ4ChunkKey(kv, endianness, chunkSize, imageByteSize)) {
+	  printf("no LZ4 chunk key: %s\n", filename);
+	  return false;
+	}
+	data.resize(ktxHeaderSize + imageByteSize);
+	header[15] = 0;
+	memcpy(&data[0], header, ktxHeaderSize);
+	const int faceCount = Texture::GetValue(&header[13], endianness);
+	const int mipCount = std::max<int>(1, Texture::GetValue(&header[14], endianness));
+	if (!truncate) {
+	  return Texture::ReadLZ4Chunks(file, endianness, mipCount, faceCount, chunkSize, filename, data, ktxHeaderSize);
+	}
+	// the broken file is read from the memory, because Mai::File has no way to shorten the file.
+	std::vector<uint8_t> body(file.Size() - file.Position());
+	file.Read(&body[0], body.size());
+	body.resize(body.size() - truncate);
+	const std::string brokenFilename = std::string(filename) + ".broken";
+	if (FILE* fp = fopen(brokenFilename.c_str(), "wb")) {
+	  fwrite(header, ktxHeaderSize, 1, fp);
+	  header[15] = static_cast<uint32_t>(kv.size());
+	  fseek(fp, 0, SEEK_SET);
+	  fwrite(header, ktxHeaderSize, 1, fp);
+	  fwrite(kv.data(), kv.size(), 1, fp);
+	  fwrite(body.data(), body.size(), 1, fp);
+	  fclose(fp);
+	}
+	const bool result = ReadLZ4(brokenFilename.c_str(), data);
+	remove(brokenFilename.c_str());
+	return result;
+  }
+
+  /// Get the file size.
+  size_t GetFileSize(const char* filename) {
+	StdioFile file(filename);
+	return file.Size();
+  }
+
+} // unnamed namespace
+
+int main(int argc, char** argv)
+{
+  std::vector<std::string> fileList;
+  for (int i = 1; i < argc; ++i) {
+	fileList.push_back(argv[i]);
+  }
+  if (fileList.empty()) {
+	for (const char* e : defaultFileList) {
+	  fileList.push_back(std::string(assetDir) + e);
+	}
+  }
+
+  typedef std::chrono::high_resolution_clock Clock;
+  int failed = 0;
+  for (const std::string& filename : fileList) {
+	std::vector<uint8_t> plain;
+	if (!ReadPlain(filename.c_str(), plain)) {
+	  printf("can't read: %s\n", filename.c_str());
+	  ++failed;
+	  continue;
+	}
+	const std::string lz4Filename = filename.substr(filename.find_last_of('/') + 1) + ".lz4";
+	const std::string command = "python3 ../asset_works/texture/ktx_lz4.py " + filename + " " + lz4Filename + " > /dev/null";
+	if (system(command.c_str()) != 0) {
+	  printf("can't convert: %s\n", filename.c_str());
+	  ++failed;
+	  continue;
+	}
+
+	// the decompressed images are the same as the images of the source file.
+	std::vector<uint8_t> decompressed;
+	uint32_t kvSize;
+	memcpy(&kvSize, &plain[60], 4);
+	const bool isSame = ReadLZ4(lz4Filename.c_str(), decompressed) && decompressed.size() + kvSize == plain.size() &&
+	  memcmp(&decompressed[ktxHeaderSize], &plain[ktxHeaderSize + kvSize], decompressed.size() - ktxHeaderSize) == 0;
+	if (!isSame) {
+	  ++failed;
+	}
+	// the truncated file is rejected.
+	std::vector<uint8_t> broken;
+	if (ReadLZ4(lz4Filename.c_str(), broken, 16)) {
+	  printf("the truncated file is accepted: %s\n", lz4Filename.c_str());
+	  ++failed;
+	}
+
+	const Clock::time_point plainBegin = Clock::now();
+	for (int i = 0; i < repeatCount; ++i) {
+	  ReadPlain(filename.c_str(), plain);
+	}
+	const double plainTime = std::chrono::duration<double, std::milli>(Clock::now() - plainBegin).count() / repeatCount;
+	const Clock::time_point lz4Begin = Clock::now();
+	for (int i = 0; i < repeatCount; ++i) {
+	  ReadLZ4(lz4Filename.c_str(), decompressed);
+	}
+	const double lz4Time = std::chrono::duration<double, std::milli>(Clock::now() - lz4Begin).count() / repeatCount;
+
+	printf("%s: %u -> %u bytes, plain %.3f ms, LZ4 %.3f ms, %s\n", filename.c_str() + filename.find_last_of('/', filename.find_last_of('/') - 1) + 1,
+	  static_cast<unsigned>(plain.size()), static_cast<unsigned>(GetFileSize(lz4Filename.c_str())), plainTime, lz4Time, isSame ? "identical" : "DIFFERENT");
+	remove(lz4Filename.c_str());
+  }
+  printf("%s\n", failed ? "FAILED" : "PASSED");
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Convert the KTX files to the LZ4 chunked KTX files.
+
+The images of each level and face are split into the chunks, and each chunk is
+compressed to the independent LZ4 block, so that the loader can decompress them
+while it reads the following chunks. The chunk that doesn't become smaller is
+stored without compression.
+
+The key "Mai.LZ4Chunk" is added to the key/value data. Its value is the chunk size
+and the total byte size of the decompressed images (uint32_t each).
+Each level is stored as:
+  uint32_t imageSize (the decompressed byte size of one face)
+  for each face:
+    uint32_t chunkCount
+    uint32_t compressedSize[chunkCount]
+    the chunks, and the padding to 4 bytes
+
+usage: ktx_lz4.py [-c chunk_size] input.ktx output.ktx
+"""
+import argparse
+import struct
+import sys
+
+KTX_IDENTIFIER = b'\xabKTX 11\xbb\r\n\x1a\n'
+LZ4_CHUNK_KEY = b'Mai.LZ4Chunk\x00'
+MIN_MATCH = 4
+LAST_LITERALS = 5
+MF_LIMIT = 12
+
+
+def write_length(out, n):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def write_sequence(out, literal, offset, match_length):
+    lit_len = len(literal)
+    token = (min(lit_len, 15) << 4)
+    if offset:
+        token |= min(match_length - MIN_MATCH, 15)
+    out.append(token)
+    if lit_len >= 15:
+        write_length(out, lit_len - 15)
+    out += literal
+    if offset:
+        out += struct.pack('<H', offset)
+        if match_length - MIN_MATCH >= 15:
+            write_length(out, match_length - MIN_MATCH - 15)
+
+
+def compress_lz4_block(src):
+    """Compress the bytes to the LZ4 block by the greedy hash matching."""
+    out = bytearray()
+    table = {}
+    anchor = 0
+    pos = 0
+    limit = len(src) - MF_LIMIT
+    while pos < limit:
+        key = src[pos:pos + 4]
+        candidate = table.get(key)
+        table[key] = pos
+        if candidate is None or pos - candidate > 0xffff:
+            pos += 1
+            continue
+        length = MIN_MATCH
+        max_length = len(src) - LAST_LITERALS - pos
+        while length < max_length and src[candidate + length] == src[pos + length]:
+            length += 1
+        write_sequence(out, src[anchor:pos], pos - candidate, length)
+        pos += length
+        anchor = pos
+    write_sequence(out, src[anchor:], 0, 0)
+    return bytes(out)
+
+
+def convert(src, chunk_size):
+    if src[:12] != KTX_IDENTIFIER:
+        raise ValueError('not a KTX file')
+    endian = '<' if struct.unpack('<I', src[12:16])[0] == 0x04030201 else '>'
+    header = list(struct.unpack(endian + '13I', src[12:64]))
+    faces = header[10]
+    mips = max(1, header[11])
+    kv_size = header[12]
+    kv = src[64:64 + kv_size]
+
+    offset = 64 + kv_size
+    body = bytearray()
+    image_byte_size = 0
+    for _ in range(mips):
+        image_size = struct.unpack(endian + 'I', src[offset:offset + 4])[0]
+        offset += 4
+        padded = (image_size + 3) & ~3
+        body += struct.pack(endian + 'I', image_size)
+        image_byte_size += 4 + padded * faces
+        for _ in range(faces):
+            image = src[offset:offset + image_size]
+            offset += padded
+            chunks = []
+            for i in range(0, image_size, chunk_size):
+                raw = image[i:i + chunk_size]
+                compressed = compress_lz4_block(raw)
+                chunks.append(compressed if len(compressed) < len(raw) else raw)
+            body += struct.pack(endian + 'I', len(chunks))
+            body += struct.pack(endian + '%dI' % len(chunks), *[len(c) for c in chunks])
+            for c in chunks:
+                body += c
+            body += b'\x00' * (-sum(len(c) for c in chunks) & 3)
+
+    value = struct.pack(endian + '2I', chunk_size, image_byte_size)
+    entry = LZ4_CHUNK_KEY + value
+    kv = bytes(kv) + struct.pack(endian + 'I', len(entry)) + entry + b'\x00' * (-len(entry) & 3)
+    header[12] = len(kv)
+    return KTX_IDENTIFIER + struct.pack(endian + '13I', *header) + kv + bytes(body)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert the KTX file to the LZ4 chunked KTX file.')
+    parser.add_argument('-c', '--chunk-size', type=int, default=65536)
+    parser.add_argument('input')
+    parser.add_argument('output')
+    args = parser.parse_args()
+    with open(args.input, 'rb') as f:
+        src = f.read()
+    result = convert(src, args.chunk_size)
+    with open(args.output, 'wb') as f:
+        f.write(result)
+    print('%s: %d -> %d bytes' % (args.output, len(src), len(result)))
+
+
+if __name__ == '__main__':
+    sys.exit(main())
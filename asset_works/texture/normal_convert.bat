@@ -0,0 +1,37 @@
+@setlocal
+
+@rem Convert the tangent space normal maps to the two channel normal maps.
+@rem X is stored in the color channels, Y is stored in the alpha channel, and Z is rebuilt in the shader.
+@rem
+@rem usage: normal_convert.bat sphereNR.png woodNR.png ...
+
+set IMAGE_MAGICK=c:\usr\local\bin\ImageMagick-6.9.3-7-portable-Q16-x64\convert.exe
+set TMP_DIR=.\converted\
+set OUT_DIR_FOR_OTHERS=.\to_others\
+
+set CONV_FOR_OTHERS=C:\Imagination\PowerVR_Graphics\PowerVR_Tools\PVRTexTool\CLI\Windows_x86_64\PVRTexToolCLI.exe
+@rem LUMINANCE_ALPHA. it is sampled by NORMAL_MAP_XY=ra, or by NORMAL_MAP_XY=ga after transcoded to ATITC at load time.
+set FMT_FOR_OTHERS=l8a8,UBN
+
+:loop
+if "%~1"=="" goto :end
+call :convert "%~1" "%~n1"
+shift
+goto :loop
+
+:convert
+%IMAGE_MAGICK% %1 -channel R -separate %TMP_DIR%tmp_x.png
+%IMAGE_MAGICK% %1 -channel G -separate %TMP_DIR%tmp_y.png
+%IMAGE_MAGICK% %TMP_DIR%tmp_x.png %TMP_DIR%tmp_x.png %TMP_DIR%tmp_x.png %TMP_DIR%tmp_y.png -channel RGBA -combine %TMP_DIR%tmp_xy.png
+if errorlevel 0 goto :success_xy
+pause
+exit 1
+:success_xy
+%CONV_FOR_OTHERS% -f %FMT_FOR_OTHERS% -i %TMP_DIR%tmp_xy.png -o %OUT_DIR_FOR_OTHERS%%~2.ktx
+del %TMP_DIR%tmp_x.png
+del %TMP_DIR%tmp_y.png
+del %TMP_DIR%tmp_xy.png
+exit /b
+
+:end
+@endlocal